@@ -6,6 +6,7 @@
 
 #include "chunk.h"
 
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -17,15 +18,41 @@
 
 static VERTEX_LIGHT_STRUCT_T *defaultLight = NULL;
 
+// row occupancy masks store 1 bit per block along x
+#if CHUNK_SIZE != 16
+#error "chunk dense storage expects CHUNK_SIZE == 16"
+#endif
+
+// blocks of a chunk using CHUNK_STORAGE_DENSE, indexed by _chunk_dense_index
+typedef struct {
+    Block blocks[CHUNK_SIZE_CUBE]; /* 4096 bytes */
+    // for each (y, z) row, bit x is set if block (x, y, z) is solid
+    uint16_t rows[CHUNK_SIZE_SQR]; /* 512 bytes */
+} _ChunkDenseBlocks;
+
+// reference count of a block or lighting buffer shared by copies of a chunk, see chunk_new_copy.
+// Chunks referencing the same counter use the same buffer, a chunk writes to its buffer only if it
+// is the last reference, otherwise it clones it first w/ a new counter. Atomic, since the same
+// chunk can be copied from several threads at once
+typedef struct {
+    _Atomic uint32_t refCount; /* 4 bytes */
+} _ChunkShared;
+
 // chunk structure definition
 struct _Chunk {
     // 26 possible chunk neighbors used for fast access
     // when updating chunk data/vertices
     Chunk *neighbors[CHUNK_NEIGHBORS_COUNT]; /* 8 bytes */
-    // octree partitioning this chunk's blocks
+    // octree partitioning this chunk's blocks, w/ dense storage it is only derived from the block
+    // array when requested, and NULL until then
     Octree *octree; /* 8 bytes */
+    // block array, NULL unless chunk uses dense storage
+    _ChunkDenseBlocks *dense; /* 8 bytes */
     // NULL if chunk does not use lighting
     VERTEX_LIGHT_STRUCT_T *lightingData; /* 8 bytes */
+    // references to blocks storage (octree or dense) & lighting, shared w/ copies of this chunk
+    _ChunkShared *sharedBlocks;   /* 8 bytes */
+    _ChunkShared *sharedLighting; /* 8 bytes */
     // reference to shape chunks rtree leaf node, used for removal
     void *rtreeLeaf; /* 8 bytes */
     // first opaque/transparent vbma reserved for that chunk, this can be chained across several vb
@@ -37,15 +64,95 @@ struct _Chunk {
     SHAPE_COORDS_INT3_T origin; /* 3 x 2 bytes */
     // model axis-aligned bounding box (bbMax - 1 is the max block)
     CHUNK_COORDS_INT3_T bbMin, bbMax; /* 6 x 1 byte */
+    // number of block faces & of quads written for them, they differ w/ greedy meshing
+    uint16_t nbFaces; /* 2 bytes */
+    uint16_t nbQuads; /* 2 bytes */
     // whether vertices need to be refreshed
     bool dirty; /* 1 byte */
+    ChunkStorage storage; /* 1 byte */
+
+    char pad[2];
+};
+
+// a uniform face (same AO & light on all 4 vertices) gathered for greedy meshing
+typedef struct {
+    ATLAS_COLOR_INDEX_INT_T color;     /* 4 bytes */
+    VERTEX_LIGHT_STRUCT_T vlight;      /* 2 bytes */
+    FACE_AMBIENT_OCCLUSION_STRUCT_T ao; /* 1 byte */
+    bool transparent;                  /* 1 byte */
+    bool visible;                      /* 1 byte */
+
+    char pad[3];
+} _GreedyFace;
+
+// a face computed by chunk_compute_mesh, sizes are in blocks
+typedef struct {
+    ATLAS_COLOR_INDEX_INT_T color;      /* 4 bytes */
+    VERTEX_LIGHT_STRUCT_T vlight[4];    /* 8 bytes */
+    SHAPE_COORDS_INT3_T coords;         /* 6 bytes */
+    uint8_t width, height, depth;       /* 3 bytes */
+    FACE_INDEX_INT_T face;              /* 1 byte */
+    FACE_AMBIENT_OCCLUSION_STRUCT_T ao; /* 1 byte */
+    bool transparent;                   /* 1 byte */
+} _ChunkFace;
+
+struct _ChunkMesh {
+    _ChunkFace *faces; /* 8 bytes */
+    size_t count;      /* 8 bytes */
+    size_t capacity;   /* 8 bytes */
+    bool vLighting;    /* 1 byte */
 
     char pad[7];
 };
 
+// state shared by all faces computed in chunk_compute_mesh
+typedef struct {
+    Chunk *chunk;
+    ChunkMesh *mesh;
+    // faces indexed by face and block coordinates, NULL if greedy meshing is disabled
+    _GreedyFace *greedyFaces;
+    bool vLighting;
+} _ChunkWriteContext;
+
 // MARK: private functions prototypes
 
 Octree *_chunk_new_octree(void);
+_ChunkDenseBlocks *_chunk_new_dense_blocks(void);
+
+static inline size_t _chunk_dense_index(const CHUNK_COORDS_INT_T x,
+                                        const CHUNK_COORDS_INT_T y,
+                                        const CHUNK_COORDS_INT_T z) {
+    return ((size_t)z * CHUNK_SIZE + (size_t)y) * CHUNK_SIZE + (size_t)x;
+}
+
+/// block lookup for either storage, coordinates must be within chunk
+static inline Block *_chunk_get_block_unchecked(const Chunk *chunk,
+                                                const CHUNK_COORDS_INT_T x,
+                                                const CHUNK_COORDS_INT_T y,
+                                                const CHUNK_COORDS_INT_T z) {
+    if (chunk->dense != NULL) {
+        return &chunk->dense->blocks[_chunk_dense_index(x, y, z)];
+    }
+    return (Block *)
+        octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
+}
+
+/// builds the octree of a chunk using dense storage from its block array
+void _chunk_dense_build_octree(Chunk *chunk);
+static _ChunkShared *_chunk_shared_new(void);
+/// drops a reference, returns true if it was the last one & the buffer must be freed
+static bool _chunk_shared_release(_ChunkShared *shared);
+static bool _chunk_shared_is_last(const _ChunkShared *shared);
+/// frees blocks storage, the octree of a chunk using dense storage is always its own
+static void _chunk_free_blocks(Chunk *c, const bool storage);
+/// clones shared blocks before they are modified, returns false if they couldn't be cloned, the
+/// chunk is then unchanged & must not be modified
+static bool _chunk_own_blocks(Chunk *c);
+/// clones shared lighting before it is modified, or stops using it w/o cloning it if it is going
+/// to be cleared or replaced. Returns false if it couldn't be done, the chunk is then unchanged
+static bool _chunk_own_lighting(Chunk *c, const bool clone);
+/// shrinks the bounding box of a chunk using dense storage after a block removal
+void _chunk_dense_shrink_bounding_box(Chunk *chunk, const CHUNK_COORDS_INT3_T coords);
 
 void _chunk_hello_neighbor(Chunk *newcomer,
                            Neighbor newcomerLocation,
@@ -70,6 +177,35 @@ void _vertex_light_smoothing(VERTEX_LIGHT_STRUCT_T *base,
                              VERTEX_LIGHT_STRUCT_T vlight2,
                              VERTEX_LIGHT_STRUCT_T vlight3);
 
+/// adds a face to the mesh, or gathers it for greedy meshing if enabled and if it can be merged
+void _chunk_write_face(_ChunkWriteContext *ctx,
+                       const CHUNK_COORDS_INT_T x,
+                       const CHUNK_COORDS_INT_T y,
+                       const CHUNK_COORDS_INT_T z,
+                       const ATLAS_COLOR_INDEX_INT_T color,
+                       const bool transparent,
+                       const FACE_INDEX_INT_T face,
+                       const FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
+                       const VERTEX_LIGHT_STRUCT_T vlight1,
+                       const VERTEX_LIGHT_STRUCT_T vlight2,
+                       const VERTEX_LIGHT_STRUCT_T vlight3,
+                       const VERTEX_LIGHT_STRUCT_T vlight4);
+/// merges gathered faces into as few quads as possible, and adds them to the mesh
+void _chunk_write_greedy_faces(_ChunkWriteContext *ctx);
+void _chunk_mesh_add_face(ChunkMesh *mesh,
+                          const SHAPE_COORDS_INT3_T coords,
+                          const uint8_t width,
+                          const uint8_t height,
+                          const uint8_t depth,
+                          const ATLAS_COLOR_INDEX_INT_T color,
+                          const bool transparent,
+                          const FACE_INDEX_INT_T face,
+                          const FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
+                          const VERTEX_LIGHT_STRUCT_T vlight1,
+                          const VERTEX_LIGHT_STRUCT_T vlight2,
+                          const VERTEX_LIGHT_STRUCT_T vlight3,
+                          const VERTEX_LIGHT_STRUCT_T vlight4);
+
 bool _chunk_is_bounding_box_empty(const Chunk *chunk);
 void _chunk_update_bounding_box(Chunk *chunk,
                                 const CHUNK_COORDS_INT3_T coords,
@@ -88,11 +224,30 @@ void chunk_alloc_default_light(void) {
 }
 
 Chunk *chunk_new(const SHAPE_COORDS_INT3_T origin) {
+    return chunk_new_with_storage(origin, CHUNK_STORAGE_OCTREE);
+}
+
+Chunk *chunk_new_with_storage(const SHAPE_COORDS_INT3_T origin, const ChunkStorage storage) {
     Chunk *chunk = (Chunk *)malloc(sizeof(Chunk));
     if (chunk == NULL) {
         return NULL;
     }
-    chunk->octree = _chunk_new_octree();
+    chunk->sharedBlocks = _chunk_shared_new();
+    chunk->sharedLighting = _chunk_shared_new();
+    if (chunk->sharedBlocks == NULL || chunk->sharedLighting == NULL) {
+        free(chunk->sharedBlocks);
+        free(chunk->sharedLighting);
+        free(chunk);
+        return NULL;
+    }
+    if (storage == CHUNK_STORAGE_DENSE) {
+        chunk->octree = NULL;
+        chunk->dense = _chunk_new_dense_blocks();
+    } else {
+        chunk->octree = _chunk_new_octree();
+        chunk->dense = NULL;
+    }
+    chunk->storage = storage;
     chunk->lightingData = NULL;
     chunk->rtreeLeaf = NULL;
     chunk->dirty = false;
@@ -100,6 +255,8 @@ Chunk *chunk_new(const SHAPE_COORDS_INT3_T origin) {
     chunk->bbMin = (CHUNK_COORDS_INT3_T){0, 0, 0};
     chunk->bbMax = (CHUNK_COORDS_INT3_T){0, 0, 0};
     chunk->nbBlocks = 0;
+    chunk->nbFaces = 0;
+    chunk->nbQuads = 0;
 
     for (int i = 0; i < CHUNK_NEIGHBORS_COUNT; i++) {
         chunk->neighbors[i] = NULL;
@@ -111,26 +268,30 @@ Chunk *chunk_new(const SHAPE_COORDS_INT3_T origin) {
     return chunk;
 }
 
-Chunk *chunk_new_copy(const Chunk *c) {
+Chunk *chunk_new_copy(Chunk *c) {
     Chunk *copy = (Chunk *)malloc(sizeof(Chunk));
     if (copy == NULL) {
         return NULL;
     }
-    copy->octree = octree_new_copy(c->octree);
-    if (c->lightingData != NULL) {
-        const size_t lightingSize = (size_t)CHUNK_SIZE_SQR * (size_t)CHUNK_SIZE *
-                                    (size_t)sizeof(VERTEX_LIGHT_STRUCT_T);
-        copy->lightingData = malloc(lightingSize);
-        memcpy(copy->lightingData, c->lightingData, lightingSize);
-    } else {
-        copy->lightingData = NULL;
-    }
+
+    // share buffers in their current state, the source is only read, the octree of a dense chunk
+    // is only derived from its blocks
+    atomic_fetch_add(&c->sharedBlocks->refCount, 1);
+    atomic_fetch_add(&c->sharedLighting->refCount, 1);
+    copy->sharedBlocks = c->sharedBlocks;
+    copy->sharedLighting = c->sharedLighting;
+    copy->dense = c->dense;
+    copy->octree = c->dense != NULL ? NULL : c->octree;
+    copy->lightingData = c->lightingData;
+    copy->storage = c->storage;
     copy->rtreeLeaf = NULL;
     copy->dirty = false;
     copy->origin = c->origin;
     copy->bbMin = c->bbMin;
     copy->bbMax = c->bbMax;
     copy->nbBlocks = c->nbBlocks;
+    copy->nbFaces = 0;
+    copy->nbQuads = 0;
 
     for (int i = 0; i < CHUNK_NEIGHBORS_COUNT; i++) {
         copy->neighbors[i] = NULL;
@@ -147,8 +308,8 @@ void chunk_free(Chunk *chunk, bool updateNeighbors) {
         chunk_leave_neighborhood(chunk);
     }
 
-    octree_free(chunk->octree);
-    if (chunk->lightingData != NULL) {
+    _chunk_free_blocks(chunk, _chunk_shared_release(chunk->sharedBlocks));
+    if (_chunk_shared_release(chunk->sharedLighting)) {
         free(chunk->lightingData);
     }
 
@@ -185,7 +346,57 @@ int chunk_get_nb_blocks(const Chunk *chunk) {
     return chunk->nbBlocks;
 }
 
-Octree *chunk_get_octree(const Chunk *c) {
+uint16_t chunk_get_nb_faces(const Chunk *chunk) {
+    return chunk->nbFaces;
+}
+
+uint16_t chunk_get_nb_quads(const Chunk *chunk) {
+    return chunk->nbQuads;
+}
+
+ChunkStorage chunk_get_storage(const Chunk *c) {
+    return c->storage;
+}
+
+void chunk_set_storage(Chunk *c, const ChunkStorage storage) {
+    if (c->storage == storage || _chunk_own_blocks(c) == false) {
+        return;
+    }
+
+    if (storage == CHUNK_STORAGE_DENSE) {
+        c->dense = _chunk_new_dense_blocks();
+        const Block *b;
+        size_t rowIdx;
+        for (CHUNK_COORDS_INT_T z = c->bbMin.z; z < c->bbMax.z; ++z) {
+            for (CHUNK_COORDS_INT_T y = c->bbMin.y; y < c->bbMax.y; ++y) {
+                rowIdx = (size_t)z * CHUNK_SIZE + (size_t)y;
+                for (CHUNK_COORDS_INT_T x = c->bbMin.x; x < c->bbMax.x; ++x) {
+                    b = (Block *)octree_get_element_without_checking(c->octree,
+                                                                     (size_t)x,
+                                                                     (size_t)y,
+                                                                     (size_t)z);
+                    if (block_is_solid(b)) {
+                        c->dense->blocks[rowIdx * CHUNK_SIZE + (size_t)x] = *b;
+                        c->dense->rows[rowIdx] |= (uint16_t)(1 << x);
+                    }
+                }
+            }
+        }
+        // octree is kept until next edit
+    } else {
+        if (c->octree == NULL) {
+            _chunk_dense_build_octree(c);
+        }
+        free(c->dense);
+        c->dense = NULL;
+    }
+    c->storage = storage;
+}
+
+Octree *chunk_get_octree(Chunk *c) {
+    if (c->octree == NULL) {
+        _chunk_dense_build_octree(c);
+    }
     return c->octree;
 }
 
@@ -197,11 +408,47 @@ void *chunk_get_rtree_leaf(const Chunk *c) {
     return c->rtreeLeaf;
 }
 
-uint64_t chunk_get_hash(const Chunk *c, uint64_t crc) {
+uint64_t chunk_get_hash(Chunk *c, uint64_t crc) {
     const uint64_t originHash = crc32((uLong)crc,
                                       (const Bytef *)&c->origin,
                                       (uInt)sizeof(SHAPE_COORDS_INT3_T));
-    return octree_get_hash(c->octree, originHash);
+    return octree_get_hash(chunk_get_octree(c), originHash);
+}
+
+bool chunk_has_same_content(const Chunk *a, const Chunk *b) {
+    if (a->nbBlocks != b->nbBlocks ||
+        memcmp(&a->origin, &b->origin, sizeof(SHAPE_COORDS_INT3_T)) != 0 ||
+        memcmp(&a->bbMin, &b->bbMin, sizeof(CHUNK_COORDS_INT3_T)) != 0 ||
+        memcmp(&a->bbMax, &b->bbMax, sizeof(CHUNK_COORDS_INT3_T)) != 0) {
+        return false;
+    }
+
+    if ((a->lightingData == NULL) != (b->lightingData == NULL)) {
+        return false;
+    }
+    if (a->lightingData != b->lightingData &&
+        memcmp(a->lightingData,
+               b->lightingData,
+               CHUNK_SIZE_CUBE * sizeof(VERTEX_LIGHT_STRUCT_T)) != 0) {
+        return false;
+    }
+
+    const bool sameBuffer = a->dense != NULL ? a->dense == b->dense
+                                             : b->dense == NULL && a->octree == b->octree;
+    if (sameBuffer) {
+        return true;
+    }
+    for (CHUNK_COORDS_INT_T x = a->bbMin.x; x < a->bbMax.x; ++x) {
+        for (CHUNK_COORDS_INT_T y = a->bbMin.y; y < a->bbMax.y; ++y) {
+            for (CHUNK_COORDS_INT_T z = a->bbMin.z; z < a->bbMax.z; ++z) {
+                if (_chunk_get_block_unchecked(a, x, y, z)->colorIndex !=
+                    _chunk_get_block_unchecked(b, x, y, z)->colorIndex) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
 }
 
 void chunk_set_light(Chunk *c,
@@ -216,6 +463,8 @@ void chunk_set_light(Chunk *c,
 
     if (c->lightingData == NULL) {
         chunk_reset_lighting_data(c, initEmpty);
+    } else if (_chunk_own_lighting(c, true) == false) {
+        return;
     }
 
     c->lightingData[coords.x * CHUNK_SIZE_SQR + coords.y * CHUNK_SIZE + coords.z] = light;
@@ -245,6 +494,9 @@ VERTEX_LIGHT_STRUCT_T chunk_get_light_or_default(Chunk *c,
 }
 
 void chunk_clear_lighting_data(Chunk *c) {
+    if (_chunk_own_lighting(c, false) == false) {
+        return;
+    }
     if (c->lightingData != NULL) {
         free(c->lightingData);
         c->lightingData = NULL;
@@ -253,8 +505,15 @@ void chunk_clear_lighting_data(Chunk *c) {
 
 void chunk_reset_lighting_data(Chunk *c, const bool emptyOrDefault) {
     const size_t lightingSize = (size_t)CHUNK_SIZE_CUBE * (size_t)sizeof(VERTEX_LIGHT_STRUCT_T);
+    if (_chunk_own_lighting(c, false) == false) {
+        return;
+    }
     if (c->lightingData == NULL) {
         c->lightingData = malloc(lightingSize);
+        if (c->lightingData == NULL) {
+            cclog_error("🔥 chunk_reset_lighting_data: failed to allocate lighting");
+            return;
+        }
     }
     if (emptyOrDefault) {
         memset(c->lightingData, 0, lightingSize);
@@ -265,6 +524,10 @@ void chunk_reset_lighting_data(Chunk *c, const bool emptyOrDefault) {
 }
 
 void chunk_set_lighting_data(Chunk *c, VERTEX_LIGHT_STRUCT_T *data) {
+    if (_chunk_own_lighting(c, false) == false) {
+        free(data);
+        return;
+    }
     if (c->lightingData != NULL) {
         free(c->lightingData);
     }
@@ -285,12 +548,24 @@ bool chunk_add_block(Chunk *chunk,
         return false;
     }
 
-    Block *b = (Block *)
-        octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
+    Block *b = _chunk_get_block_unchecked(chunk, x, y, z);
     if (block_is_solid(b)) {
         return false;
     } else {
-        octree_set_element(chunk->octree, &block, (size_t)x, (size_t)y, (size_t)z);
+        if (_chunk_shared_is_last(chunk->sharedBlocks) == false) {
+            if (_chunk_own_blocks(chunk) == false) {
+                return false;
+            }
+            b = _chunk_get_block_unchecked(chunk, x, y, z);
+        }
+        if (chunk->dense != NULL) {
+            *b = block;
+            chunk->dense->rows[(size_t)z * CHUNK_SIZE + (size_t)y] |= (uint16_t)(1 << x);
+            octree_free(chunk->octree);
+            chunk->octree = NULL;
+        } else {
+            octree_set_element(chunk->octree, &block, (size_t)x, (size_t)y, (size_t)z);
+        }
         chunk->nbBlocks++;
         _chunk_update_bounding_box(chunk, (CHUNK_COORDS_INT3_T){x, y, z}, true);
         return true;
@@ -303,14 +578,25 @@ bool chunk_remove_block(Chunk *chunk,
                         const CHUNK_COORDS_INT_T z,
                         SHAPE_COLOR_INDEX_INT_T *prevColorIndex) {
 
-    Block *b = (Block *)
-        octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
+    Block *b = _chunk_get_block_unchecked(chunk, x, y, z);
     if (block_is_solid(b)) {
+        if (_chunk_shared_is_last(chunk->sharedBlocks) == false) {
+            if (_chunk_own_blocks(chunk) == false) {
+                return false;
+            }
+            b = _chunk_get_block_unchecked(chunk, x, y, z);
+        }
         if (prevColorIndex != NULL) {
             *prevColorIndex = block_get_color_index(b);
         }
         block_set_color_index(b, SHAPE_COLOR_INDEX_AIR_BLOCK);
-        octree_remove_element(chunk->octree, (size_t)x, (size_t)y, (size_t)z, NULL);
+        if (chunk->dense != NULL) {
+            chunk->dense->rows[(size_t)z * CHUNK_SIZE + (size_t)y] &= (uint16_t) ~(1 << x);
+            octree_free(chunk->octree);
+            chunk->octree = NULL;
+        } else {
+            octree_remove_element(chunk->octree, (size_t)x, (size_t)y, (size_t)z, NULL);
+        }
         chunk->nbBlocks--;
         _chunk_update_bounding_box(chunk, (CHUNK_COORDS_INT3_T){x, y, z}, false);
         return true;
@@ -326,13 +612,22 @@ bool chunk_paint_block(Chunk *chunk,
                        const SHAPE_COLOR_INDEX_INT_T colorIndex,
                        SHAPE_COLOR_INDEX_INT_T *prevColorIndex) {
 
-    Block *b = (Block *)
-        octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
+    Block *b = _chunk_get_block_unchecked(chunk, x, y, z);
     if (block_is_solid(b)) {
+        if (_chunk_shared_is_last(chunk->sharedBlocks) == false) {
+            if (_chunk_own_blocks(chunk) == false) {
+                return false;
+            }
+            b = _chunk_get_block_unchecked(chunk, x, y, z);
+        }
         if (prevColorIndex != NULL) {
             *prevColorIndex = block_get_color_index(b);
         }
         block_set_color_index(b, colorIndex);
+        if (chunk->dense != NULL) {
+            octree_free(chunk->octree);
+            chunk->octree = NULL;
+        }
         return true;
     } else {
         return false;
@@ -354,8 +649,7 @@ Block *chunk_get_block(const Chunk *chunk,
     if (z < 0 || z > CHUNK_SIZE_MINUS_ONE)
         return NULL;
 
-    return (
-        Block *)octree_get_element_without_checking(chunk->octree, (size_t)x, (size_t)y, (size_t)z);
+    return _chunk_get_block_unchecked(chunk, x, y, z);
 }
 
 Block *chunk_get_block_2(const Chunk *chunk, CHUNK_COORDS_INT3_T coords) {
@@ -492,10 +786,7 @@ Block *chunk_get_block_including_neighbors(Chunk *chunk,
     if (_chunk == NULL) {
         return NULL;
     } else {
-        return (Block *)octree_get_element_without_checking(_chunk->octree,
-                                                            (size_t)_coords.x,
-                                                            (size_t)_coords.y,
-                                                            (size_t)_coords.z);
+        return _chunk_get_block_unchecked(_chunk, _coords.x, _coords.y, _coords.z);
     }
 }
 
@@ -751,9 +1042,42 @@ void chunk_set_vbma(Chunk *chunk, void *vbma, bool transparent) {
     }
 }
 
+ChunkMesh *chunk_mesh_new(void) {
+    ChunkMesh *mesh = (ChunkMesh *)malloc(sizeof(ChunkMesh));
+    if (mesh == NULL) {
+        return NULL;
+    }
+    mesh->faces = NULL;
+    mesh->count = 0;
+    mesh->capacity = 0;
+    mesh->vLighting = false;
+    return mesh;
+}
+
+void chunk_mesh_free(ChunkMesh *mesh) {
+    if (mesh == NULL) {
+        return;
+    }
+    free(mesh->faces);
+    free(mesh);
+}
+
+size_t chunk_mesh_get_nb_faces(const ChunkMesh *mesh) {
+    return mesh->count;
+}
+
 void chunk_write_vertices(Shape *shape, Chunk *chunk) {
-    ColorPalette *palette = shape_get_palette(shape);
+    ChunkMesh *mesh = chunk_mesh_new();
+    if (mesh == NULL) {
+        cclog_error("🔥 chunk_write_vertices: failed to allocate mesh");
+        return;
+    }
+    chunk_compute_mesh(shape, chunk, mesh);
+    chunk_write_mesh(shape, chunk, mesh);
+    chunk_mesh_free(mesh);
+}
 
+void chunk_write_mesh(Shape *shape, Chunk *chunk, const ChunkMesh *mesh) {
     VertexBufferMemAreaWriter *opaqueWriter = vertex_buffer_mem_area_writer_new(shape,
                                                                                 chunk,
                                                                                 chunk->vbma_opaque,
@@ -768,8 +1092,38 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
     VertexBufferMemAreaWriter *transparentWriter = opaqueWriter;
 #endif
 
+    const _ChunkFace *f;
+    for (size_t i = 0; i < mesh->count; ++i) {
+        f = &mesh->faces[i];
+        vertex_buffer_mem_area_writer_write_quad(f->transparent ? transparentWriter : opaqueWriter,
+                                                 (float)f->coords.x,
+                                                 (float)f->coords.y,
+                                                 (float)f->coords.z,
+                                                 (float)f->width,
+                                                 (float)f->height,
+                                                 (float)f->depth,
+                                                 f->color,
+                                                 f->face,
+                                                 f->ao,
+                                                 mesh->vLighting,
+                                                 f->vlight[0],
+                                                 f->vlight[1],
+                                                 f->vlight[2],
+                                                 f->vlight[3]);
+    }
+
+    vertex_buffer_mem_area_writer_done(opaqueWriter);
+    vertex_buffer_mem_area_writer_free(opaqueWriter);
+#if ENABLE_TRANSPARENCY
+    vertex_buffer_mem_area_writer_done(transparentWriter);
+    vertex_buffer_mem_area_writer_free(transparentWriter);
+#endif
+}
+
+void chunk_compute_mesh(const Shape *shape, Chunk *chunk, ChunkMesh *mesh) {
+    const ColorPalette *palette = shape_get_palette(shape);
+
     Block *b;
-    SHAPE_COORDS_INT3_T coords_in_shape;
     SHAPE_COLOR_INDEX_INT_T shapeColorIdx;
     ATLAS_COLOR_INDEX_INT_T atlasColorIdx;
 
@@ -777,6 +1131,20 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
     const bool vLighting = shape_uses_baked_lighting(shape);
     VERTEX_LIGHT_STRUCT_T vlight1, vlight2, vlight3, vlight4;
 
+    mesh->count = 0;
+    mesh->vLighting = vLighting;
+
+    _ChunkWriteContext ctx;
+    ctx.chunk = chunk;
+    ctx.mesh = mesh;
+    ctx.greedyFaces = shape_uses_greedy_meshing(shape)
+                          ? (_GreedyFace *)calloc(FACE_SIZE_CTC * CHUNK_SIZE_CUBE,
+                                                  sizeof(_GreedyFace))
+                          : NULL;
+    ctx.vLighting = vLighting;
+    chunk->nbFaces = 0;
+    chunk->nbQuads = 0;
+
     FACE_AMBIENT_OCCLUSION_STRUCT_T ao;
 
     // neighbors block information
@@ -820,8 +1188,6 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
                     atlasColorIdx = color_palette_get_atlas_index(palette, shapeColorIdx);
                     selfTransparent = color_palette_is_transparent(palette, shapeColorIdx);
 
-                    coords_in_shape = chunk_get_block_coords_in_shape(chunk, x, y, z);
-
                     // get axis-aligned neighbouring blocks
                     neighbors[NX].block = chunk_get_block_including_neighbors(
                         chunk,
@@ -1184,19 +1550,18 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
                                                     neighbors[NX_NY].vlight);
                         }
 
-                        vertex_buffer_mem_area_writer_write(selfTransparent ? transparentWriter
-                                                                            : opaqueWriter,
-                                                            (float)coords_in_shape.x,
-                                                            (float)coords_in_shape.y,
-                                                            (float)coords_in_shape.z,
-                                                            atlasColorIdx,
-                                                            FACE_LEFT,
-                                                            ao,
-                                                            vLighting,
-                                                            vlight1,
-                                                            vlight2,
-                                                            vlight3,
-                                                            vlight4);
+                        _chunk_write_face(&ctx,
+                                          x,
+                                          y,
+                                          z,
+                                          atlasColorIdx,
+                                          selfTransparent,
+                                          FACE_LEFT,
+                                          ao,
+                                          vlight1,
+                                          vlight2,
+                                          vlight3,
+                                          vlight4);
                     }
 
                     if (renderRight) {
@@ -1401,19 +1766,18 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
                                                     neighbors[X_Z].vlight);
                         }
 
-                        vertex_buffer_mem_area_writer_write(selfTransparent ? transparentWriter
-                                                                            : opaqueWriter,
-                                                            (float)coords_in_shape.x,
-                                                            (float)coords_in_shape.y,
-                                                            (float)coords_in_shape.z,
-                                                            atlasColorIdx,
-                                                            FACE_RIGHT,
-                                                            ao,
-                                                            vLighting,
-                                                            vlight1,
-                                                            vlight2,
-                                                            vlight3,
-                                                            vlight4);
+                        _chunk_write_face(&ctx,
+                                          x,
+                                          y,
+                                          z,
+                                          atlasColorIdx,
+                                          selfTransparent,
+                                          FACE_RIGHT,
+                                          ao,
+                                          vlight1,
+                                          vlight2,
+                                          vlight3,
+                                          vlight4);
                     }
 
                     if (renderFront) {
@@ -1625,19 +1989,18 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
                                                     neighbors[X_NZ].vlight);
                         }
 
-                        vertex_buffer_mem_area_writer_write(selfTransparent ? transparentWriter
-                                                                            : opaqueWriter,
-                                                            (float)coords_in_shape.x,
-                                                            (float)coords_in_shape.y,
-                                                            (float)coords_in_shape.z,
-                                                            atlasColorIdx,
-                                                            FACE_BACK,
-                                                            ao,
-                                                            vLighting,
-                                                            vlight1,
-                                                            vlight2,
-                                                            vlight3,
-                                                            vlight4);
+                        _chunk_write_face(&ctx,
+                                          x,
+                                          y,
+                                          z,
+                                          atlasColorIdx,
+                                          selfTransparent,
+                                          FACE_BACK,
+                                          ao,
+                                          vlight1,
+                                          vlight2,
+                                          vlight3,
+                                          vlight4);
                     }
 
                     if (renderBack) {
@@ -1849,19 +2212,18 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
                                                     neighbors[X_Z].vlight);
                         }
 
-                        vertex_buffer_mem_area_writer_write(selfTransparent ? transparentWriter
-                                                                            : opaqueWriter,
-                                                            (float)coords_in_shape.x,
-                                                            (float)coords_in_shape.y,
-                                                            (float)coords_in_shape.z,
-                                                            atlasColorIdx,
-                                                            FACE_FRONT,
-                                                            ao,
-                                                            vLighting,
-                                                            vlight1,
-                                                            vlight2,
-                                                            vlight3,
-                                                            vlight4);
+                        _chunk_write_face(&ctx,
+                                          x,
+                                          y,
+                                          z,
+                                          atlasColorIdx,
+                                          selfTransparent,
+                                          FACE_FRONT,
+                                          ao,
+                                          vlight1,
+                                          vlight2,
+                                          vlight3,
+                                          vlight4);
                     }
 
                     if (renderTop) {
@@ -2082,19 +2444,18 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
                                                     neighbors[Y_NZ].vlight);
                         }
 
-                        vertex_buffer_mem_area_writer_write(selfTransparent ? transparentWriter
-                                                                            : opaqueWriter,
-                                                            (float)coords_in_shape.x,
-                                                            (float)coords_in_shape.y,
-                                                            (float)coords_in_shape.z,
-                                                            atlasColorIdx,
-                                                            FACE_TOP,
-                                                            ao,
-                                                            vLighting,
-                                                            vlight1,
-                                                            vlight2,
-                                                            vlight3,
-                                                            vlight4);
+                        _chunk_write_face(&ctx,
+                                          x,
+                                          y,
+                                          z,
+                                          atlasColorIdx,
+                                          selfTransparent,
+                                          FACE_TOP,
+                                          ao,
+                                          vlight1,
+                                          vlight2,
+                                          vlight3,
+                                          vlight4);
                     }
 
                     if (renderBottom) {
@@ -2315,35 +2676,274 @@ void chunk_write_vertices(Shape *shape, Chunk *chunk) {
                                                     neighbors[NY_NZ].vlight);
                         }
 
-                        vertex_buffer_mem_area_writer_write(selfTransparent ? transparentWriter
-                                                                            : opaqueWriter,
-                                                            (float)coords_in_shape.x,
-                                                            (float)coords_in_shape.y,
-                                                            (float)coords_in_shape.z,
-                                                            atlasColorIdx,
-                                                            FACE_DOWN,
-                                                            ao,
-                                                            vLighting,
-                                                            vlight1,
-                                                            vlight2,
-                                                            vlight3,
-                                                            vlight4);
+                        _chunk_write_face(&ctx,
+                                          x,
+                                          y,
+                                          z,
+                                          atlasColorIdx,
+                                          selfTransparent,
+                                          FACE_DOWN,
+                                          ao,
+                                          vlight1,
+                                          vlight2,
+                                          vlight3,
+                                          vlight4);
                     }
                 }
             }
         }
     }
 
-    vertex_buffer_mem_area_writer_done(opaqueWriter);
-    vertex_buffer_mem_area_writer_free(opaqueWriter);
-#if ENABLE_TRANSPARENCY
-    vertex_buffer_mem_area_writer_done(transparentWriter);
-    vertex_buffer_mem_area_writer_free(transparentWriter);
-#endif
+    if (ctx.greedyFaces != NULL) {
+        _chunk_write_greedy_faces(&ctx);
+        free(ctx.greedyFaces);
+    }
 }
 
 // MARK: private functions
 
+static bool _greedy_face_is_uniform(const bool vLighting,
+                                    const FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
+                                    const VERTEX_LIGHT_STRUCT_T vlight1,
+                                    const VERTEX_LIGHT_STRUCT_T vlight2,
+                                    const VERTEX_LIGHT_STRUCT_T vlight3,
+                                    const VERTEX_LIGHT_STRUCT_T vlight4) {
+    if (ao.ao1 != ao.ao2 || ao.ao1 != ao.ao3 || ao.ao1 != ao.ao4) {
+        return false;
+    }
+    if (vLighting == false) {
+        return true;
+    }
+    return memcmp(&vlight1, &vlight2, sizeof(VERTEX_LIGHT_STRUCT_T)) == 0 &&
+           memcmp(&vlight1, &vlight3, sizeof(VERTEX_LIGHT_STRUCT_T)) == 0 &&
+           memcmp(&vlight1, &vlight4, sizeof(VERTEX_LIGHT_STRUCT_T)) == 0;
+}
+
+static bool _greedy_face_can_merge(const _GreedyFace *face, const _GreedyFace *other) {
+    return other->visible && face->color == other->color &&
+           face->transparent == other->transparent && face->ao.ao1 == other->ao.ao1 &&
+           face->vlight.ambient == other->vlight.ambient && face->vlight.red == other->vlight.red &&
+           face->vlight.green == other->vlight.green && face->vlight.blue == other->vlight.blue;
+}
+
+/// Faces are stored in planes perpendicular to their normal: n is the coordinate along the
+/// normal, (u, v) the coordinates within the plane
+static size_t _greedy_face_index(const FACE_INDEX_INT_T face,
+                                 const CHUNK_COORDS_INT_T n,
+                                 const CHUNK_COORDS_INT_T u,
+                                 const CHUNK_COORDS_INT_T v) {
+    return (size_t)face * CHUNK_SIZE_CUBE + (size_t)n * CHUNK_SIZE_SQR + (size_t)v * CHUNK_SIZE +
+           (size_t)u;
+}
+
+static void _greedy_face_plane_coords(const FACE_INDEX_INT_T face,
+                                      const CHUNK_COORDS_INT_T x,
+                                      const CHUNK_COORDS_INT_T y,
+                                      const CHUNK_COORDS_INT_T z,
+                                      CHUNK_COORDS_INT_T *n,
+                                      CHUNK_COORDS_INT_T *u,
+                                      CHUNK_COORDS_INT_T *v) {
+    switch (face) {
+        case FACE_RIGHT_CTC:
+        case FACE_LEFT_CTC:
+            *n = x;
+            *u = y;
+            *v = z;
+            break;
+        case FACE_TOP_CTC:
+        case FACE_DOWN_CTC:
+            *n = y;
+            *u = x;
+            *v = z;
+            break;
+        default: // FACE_FRONT_CTC, FACE_BACK_CTC
+            *n = z;
+            *u = x;
+            *v = y;
+            break;
+    }
+}
+
+void _chunk_write_face(_ChunkWriteContext *ctx,
+                       const CHUNK_COORDS_INT_T x,
+                       const CHUNK_COORDS_INT_T y,
+                       const CHUNK_COORDS_INT_T z,
+                       const ATLAS_COLOR_INDEX_INT_T color,
+                       const bool transparent,
+                       const FACE_INDEX_INT_T face,
+                       const FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
+                       const VERTEX_LIGHT_STRUCT_T vlight1,
+                       const VERTEX_LIGHT_STRUCT_T vlight2,
+                       const VERTEX_LIGHT_STRUCT_T vlight3,
+                       const VERTEX_LIGHT_STRUCT_T vlight4) {
+    ctx->chunk->nbFaces++;
+
+    // only faces w/ the same AO & light on all 4 vertices are merged, other faces would be
+    // interpolated differently over a larger quad
+    if (ctx->greedyFaces != NULL &&
+        _greedy_face_is_uniform(ctx->vLighting, ao, vlight1, vlight2, vlight3, vlight4)) {
+        CHUNK_COORDS_INT_T n, u, v;
+        _greedy_face_plane_coords(face, x, y, z, &n, &u, &v);
+
+        _GreedyFace *gf = &ctx->greedyFaces[_greedy_face_index(face, n, u, v)];
+        gf->color = color;
+        gf->transparent = transparent;
+        gf->ao = ao;
+        if (ctx->vLighting) {
+            gf->vlight = vlight1;
+        } else {
+            ZERO_LIGHT(gf->vlight)
+        }
+        gf->visible = true;
+        return;
+    }
+
+    _chunk_mesh_add_face(ctx->mesh,
+                         chunk_get_block_coords_in_shape(ctx->chunk, x, y, z),
+                         1,
+                         1,
+                         1,
+                         color,
+                         transparent,
+                         face,
+                         ao,
+                         vlight1,
+                         vlight2,
+                         vlight3,
+                         vlight4);
+    ctx->chunk->nbQuads++;
+}
+
+void _chunk_mesh_add_face(ChunkMesh *mesh,
+                          const SHAPE_COORDS_INT3_T coords,
+                          const uint8_t width,
+                          const uint8_t height,
+                          const uint8_t depth,
+                          const ATLAS_COLOR_INDEX_INT_T color,
+                          const bool transparent,
+                          const FACE_INDEX_INT_T face,
+                          const FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
+                          const VERTEX_LIGHT_STRUCT_T vlight1,
+                          const VERTEX_LIGHT_STRUCT_T vlight2,
+                          const VERTEX_LIGHT_STRUCT_T vlight3,
+                          const VERTEX_LIGHT_STRUCT_T vlight4) {
+    if (mesh->count == mesh->capacity) {
+        const size_t capacity = mesh->capacity == 0 ? CHUNK_SIZE_SQR : mesh->capacity * 2;
+        _ChunkFace *faces = (_ChunkFace *)realloc(mesh->faces, capacity * sizeof(_ChunkFace));
+        if (faces == NULL) {
+            return;
+        }
+        mesh->faces = faces;
+        mesh->capacity = capacity;
+    }
+
+    _ChunkFace *f = &mesh->faces[mesh->count++];
+    f->coords = coords;
+    f->width = width;
+    f->height = height;
+    f->depth = depth;
+    f->color = color;
+    f->transparent = transparent;
+    f->face = face;
+    f->ao = ao;
+    f->vlight[0] = vlight1;
+    f->vlight[1] = vlight2;
+    f->vlight[2] = vlight3;
+    f->vlight[3] = vlight4;
+}
+
+void _chunk_write_greedy_faces(_ChunkWriteContext *ctx) {
+    _GreedyFace *faces = ctx->greedyFaces;
+    _GreedyFace *gf;
+    _GreedyFace merged;
+    CHUNK_COORDS_INT_T width, height, k;
+    CHUNK_COORDS_INT3_T coords;
+    uint8_t sizeX, sizeY, sizeZ;
+
+    for (FACE_INDEX_INT_T face = 0; face < FACE_COUNT; ++face) {
+        for (CHUNK_COORDS_INT_T n = 0; n < CHUNK_SIZE; ++n) {
+            for (CHUNK_COORDS_INT_T v = 0; v < CHUNK_SIZE; ++v) {
+                for (CHUNK_COORDS_INT_T u = 0; u < CHUNK_SIZE; ++u) {
+                    gf = &faces[_greedy_face_index(face, n, u, v)];
+                    if (gf->visible == false) {
+                        continue;
+                    }
+                    merged = *gf;
+
+                    // extend along u first, then along v as long as full rows can be merged
+                    width = 1;
+                    while (u + width < CHUNK_SIZE &&
+                           _greedy_face_can_merge(
+                               &merged,
+                               &faces[_greedy_face_index(face, n, u + width, v)])) {
+                        ++width;
+                    }
+                    height = 1;
+                    while (v + height < CHUNK_SIZE) {
+                        for (k = 0; k < width; ++k) {
+                            if (_greedy_face_can_merge(
+                                    &merged,
+                                    &faces[_greedy_face_index(face, n, u + k, v + height)]) ==
+                                false) {
+                                break;
+                            }
+                        }
+                        if (k < width) {
+                            break;
+                        }
+                        ++height;
+                    }
+
+                    for (CHUNK_COORDS_INT_T j = 0; j < height; ++j) {
+                        for (k = 0; k < width; ++k) {
+                            faces[_greedy_face_index(face, n, u + k, v + j)].visible = false;
+                        }
+                    }
+
+                    switch (face) {
+                        case FACE_RIGHT_CTC:
+                        case FACE_LEFT_CTC:
+                            coords = (CHUNK_COORDS_INT3_T){n, u, v};
+                            sizeX = 1;
+                            sizeY = (uint8_t)width;
+                            sizeZ = (uint8_t)height;
+                            break;
+                        case FACE_TOP_CTC:
+                        case FACE_DOWN_CTC:
+                            coords = (CHUNK_COORDS_INT3_T){u, n, v};
+                            sizeX = (uint8_t)width;
+                            sizeY = 1;
+                            sizeZ = (uint8_t)height;
+                            break;
+                        default: // FACE_FRONT_CTC, FACE_BACK_CTC
+                            coords = (CHUNK_COORDS_INT3_T){u, v, n};
+                            sizeX = (uint8_t)width;
+                            sizeY = (uint8_t)height;
+                            sizeZ = 1;
+                            break;
+                    }
+
+                    _chunk_mesh_add_face(
+                        ctx->mesh,
+                        chunk_get_block_coords_in_shape(ctx->chunk, coords.x, coords.y, coords.z),
+                        sizeX,
+                        sizeY,
+                        sizeZ,
+                        merged.color,
+                        merged.transparent,
+                        face,
+                        merged.ao,
+                        merged.vlight,
+                        merged.vlight,
+                        merged.vlight,
+                        merged.vlight);
+                    ctx->chunk->nbQuads++;
+                }
+            }
+        }
+    }
+}
+
 Octree *_chunk_new_octree(void) {
     unsigned long upPow2Size = upper_power_of_two(CHUNK_SIZE);
     Block *defaultBlock = block_new_air();
@@ -2393,6 +2993,192 @@ Octree *_chunk_new_octree(void) {
     return o;
 }
 
+_ChunkDenseBlocks *_chunk_new_dense_blocks(void) {
+    _ChunkDenseBlocks *dense = (_ChunkDenseBlocks *)malloc(sizeof(_ChunkDenseBlocks));
+    if (dense == NULL) {
+        return NULL;
+    }
+    memset(dense->blocks, SHAPE_COLOR_INDEX_AIR_BLOCK, sizeof(dense->blocks));
+    memset(dense->rows, 0, sizeof(dense->rows));
+    return dense;
+}
+
+void _chunk_dense_build_octree(Chunk *chunk) {
+    vx_assert(chunk->dense != NULL);
+
+    octree_free(chunk->octree);
+    chunk->octree = _chunk_new_octree();
+
+    const _ChunkDenseBlocks *dense = chunk->dense;
+    uint16_t row;
+    size_t rowIdx;
+    for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
+        for (CHUNK_COORDS_INT_T y = chunk->bbMin.y; y < chunk->bbMax.y; ++y) {
+            rowIdx = (size_t)z * CHUNK_SIZE + (size_t)y;
+            row = dense->rows[rowIdx];
+            for (CHUNK_COORDS_INT_T x = 0; row != 0; ++x, row >>= 1) {
+                if (row & 1) {
+                    octree_set_element(chunk->octree,
+                                       &dense->blocks[rowIdx * CHUNK_SIZE + (size_t)x],
+                                       (size_t)x,
+                                       (size_t)y,
+                                       (size_t)z);
+                }
+            }
+        }
+    }
+}
+
+static _ChunkShared *_chunk_shared_new(void) {
+    _ChunkShared *shared = (_ChunkShared *)malloc(sizeof(_ChunkShared));
+    if (shared != NULL) {
+        atomic_init(&shared->refCount, 1);
+    }
+    return shared;
+}
+
+static bool _chunk_shared_release(_ChunkShared *shared) {
+    const uint32_t refCount = atomic_fetch_sub(&shared->refCount, 1);
+    vx_assert(refCount > 0);
+    if (refCount == 1) {
+        free(shared);
+        return true;
+    }
+    return false;
+}
+
+static bool _chunk_shared_is_last(const _ChunkShared *shared) {
+    return atomic_load(&shared->refCount) == 1;
+}
+
+static void _chunk_free_blocks(Chunk *c, const bool storage) {
+    if (c->dense != NULL) {
+        octree_free(c->octree);
+        if (storage) {
+            free(c->dense);
+        }
+    } else if (storage) {
+        octree_free(c->octree);
+    }
+}
+
+static bool _chunk_own_blocks(Chunk *c) {
+    if (_chunk_shared_is_last(c->sharedBlocks)) {
+        return true;
+    }
+
+    // clones are made first, the chunk keeps using shared blocks if any of them fails
+    _ChunkShared *shared = _chunk_shared_new();
+    _ChunkDenseBlocks *dense = NULL;
+    Octree *octree = NULL;
+    if (shared != NULL && c->dense != NULL) {
+        dense = (_ChunkDenseBlocks *)malloc(sizeof(_ChunkDenseBlocks));
+        if (dense != NULL) {
+            memcpy(dense, c->dense, sizeof(_ChunkDenseBlocks));
+        }
+    } else if (shared != NULL) {
+        octree = octree_new_copy(c->octree);
+    }
+    if (shared == NULL || (dense == NULL && octree == NULL)) {
+        cclog_error("🔥 failed to clone shared chunk blocks");
+        free(shared);
+        return false;
+    }
+
+    // w/ dense storage, the octree derived from shared blocks is still valid & stays the chunk's
+    const bool last = _chunk_shared_release(c->sharedBlocks);
+    if (last) {
+        _chunk_free_blocks(c, true);
+    }
+    c->sharedBlocks = shared;
+    if (dense != NULL) {
+        if (last) {
+            c->octree = NULL;
+        }
+        c->dense = dense;
+    } else {
+        c->octree = octree;
+    }
+    return true;
+}
+
+static bool _chunk_own_lighting(Chunk *c, const bool clone) {
+    if (_chunk_shared_is_last(c->sharedLighting)) {
+        return true;
+    }
+
+    _ChunkShared *shared = _chunk_shared_new();
+    VERTEX_LIGHT_STRUCT_T *lightingData = NULL;
+    if (shared != NULL && clone && c->lightingData != NULL) {
+        const size_t lightingSize = (size_t)CHUNK_SIZE_CUBE * (size_t)sizeof(VERTEX_LIGHT_STRUCT_T);
+        lightingData = (VERTEX_LIGHT_STRUCT_T *)malloc(lightingSize);
+        if (lightingData != NULL) {
+            memcpy(lightingData, c->lightingData, lightingSize);
+        } else {
+            free(shared);
+            shared = NULL;
+        }
+    }
+    if (shared == NULL) {
+        cclog_error("🔥 failed to clone shared chunk lighting");
+        return false;
+    }
+
+    if (_chunk_shared_release(c->sharedLighting)) {
+        free(c->lightingData);
+    }
+    c->sharedLighting = shared;
+    c->lightingData = lightingData;
+    return true;
+}
+
+void _chunk_dense_shrink_bounding_box(Chunk *chunk, const CHUNK_COORDS_INT3_T coords) {
+    if (_chunk_is_bounding_box_empty(chunk)) {
+        return;
+    }
+
+    // box is unchanged if removed block wasn't on any of its sides
+    if (coords.x != chunk->bbMin.x && coords.x != chunk->bbMax.x - 1 &&
+        coords.y != chunk->bbMin.y && coords.y != chunk->bbMax.y - 1 &&
+        coords.z != chunk->bbMin.z && coords.z != chunk->bbMax.z - 1) {
+        return;
+    }
+
+    // gather the new box from occupied rows within current box
+    CHUNK_COORDS_INT3_T min = chunk->bbMax, max = chunk->bbMin;
+    uint16_t xMask = 0, row;
+    for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
+        for (CHUNK_COORDS_INT_T y = chunk->bbMin.y; y < chunk->bbMax.y; ++y) {
+            row = chunk->dense->rows[(size_t)z * CHUNK_SIZE + (size_t)y];
+            if (row != 0) {
+                xMask |= row;
+                min.y = minimum(min.y, y);
+                min.z = minimum(min.z, z);
+                max.y = maximum(max.y, y + 1);
+                max.z = maximum(max.z, z + 1);
+            }
+        }
+    }
+
+    if (xMask == 0) {
+        // chunk is empty, collapse box on its min corner like the octree storage does
+        chunk->bbMax = chunk->bbMin;
+        return;
+    }
+
+    min.x = 0;
+    while ((xMask & (1 << min.x)) == 0) {
+        ++min.x;
+    }
+    max.x = CHUNK_SIZE;
+    while ((xMask & (1 << (max.x - 1))) == 0) {
+        --max.x;
+    }
+
+    chunk->bbMin = min;
+    chunk->bbMax = max;
+}
+
 void _chunk_hello_neighbor(Chunk *newcomer,
                            Neighbor newcomerLocation,
                            Chunk *neighbor,
@@ -2517,6 +3303,8 @@ void _chunk_update_bounding_box(Chunk *chunk,
             chunk->bbMax.y = maximum(chunk->bbMax.y, coords.y + 1);
             chunk->bbMax.z = maximum(chunk->bbMax.z, coords.z + 1);
         }
+    } else if (chunk->dense != NULL) {
+        _chunk_dense_shrink_bounding_box(chunk, coords);
     } else if (_chunk_is_bounding_box_empty(chunk) == false) {
         // for each BB side the removed block was in, check if that side can be moved in
         if (coords.x == chunk->bbMax.x - 1) {
@@ -2525,10 +3313,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
             for (CHUNK_COORDS_INT_T x = chunk->bbMax.x - 1; isEmpty && x >= chunk->bbMin.x; --x) {
                 for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
                     for (CHUNK_COORDS_INT_T y = chunk->bbMin.y; y < chunk->bbMax.y; ++y) {
-                        b = (Block *)octree_get_element_without_checking(chunk->octree,
-                                                                         (size_t)x,
-                                                                         (size_t)y,
-                                                                         (size_t)z);
+                        b = _chunk_get_block_unchecked(chunk, x, y, z);
                         if (block_is_solid(b)) {
                             isEmpty = false;
                             break;
@@ -2548,10 +3333,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
             for (CHUNK_COORDS_INT_T x = chunk->bbMin.x; isEmpty && x < chunk->bbMax.x; ++x) {
                 for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
                     for (CHUNK_COORDS_INT_T y = chunk->bbMin.y; y < chunk->bbMax.y; ++y) {
-                        b = (Block *)octree_get_element_without_checking(chunk->octree,
-                                                                         (size_t)x,
-                                                                         (size_t)y,
-                                                                         (size_t)z);
+                        b = _chunk_get_block_unchecked(chunk, x, y, z);
                         if (block_is_solid(b)) {
                             isEmpty = false;
                             break;
@@ -2572,10 +3354,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
             for (CHUNK_COORDS_INT_T y = chunk->bbMax.y - 1; isEmpty && y >= chunk->bbMin.y; --y) {
                 for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
                     for (CHUNK_COORDS_INT_T x = chunk->bbMin.x; x < chunk->bbMax.x; ++x) {
-                        b = (Block *)octree_get_element_without_checking(chunk->octree,
-                                                                         (size_t)x,
-                                                                         (size_t)y,
-                                                                         (size_t)z);
+                        b = _chunk_get_block_unchecked(chunk, x, y, z);
                         if (block_is_solid(b)) {
                             isEmpty = false;
                             break;
@@ -2595,10 +3374,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
             for (CHUNK_COORDS_INT_T y = chunk->bbMin.y; isEmpty && y < chunk->bbMax.y; ++y) {
                 for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; z < chunk->bbMax.z; ++z) {
                     for (CHUNK_COORDS_INT_T x = chunk->bbMin.x; x < chunk->bbMax.x; ++x) {
-                        b = (Block *)octree_get_element_without_checking(chunk->octree,
-                                                                         (size_t)x,
-                                                                         (size_t)y,
-                                                                         (size_t)z);
+                        b = _chunk_get_block_unchecked(chunk, x, y, z);
                         if (block_is_solid(b)) {
                             isEmpty = false;
                             break;
@@ -2619,10 +3395,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
             for (CHUNK_COORDS_INT_T z = chunk->bbMax.z - 1; isEmpty && z >= chunk->bbMin.z; --z) {
                 for (CHUNK_COORDS_INT_T x = chunk->bbMin.x; x < chunk->bbMax.x; ++x) {
                     for (CHUNK_COORDS_INT_T y = chunk->bbMin.y; y < chunk->bbMax.y; ++y) {
-                        b = (Block *)octree_get_element_without_checking(chunk->octree,
-                                                                         (size_t)x,
-                                                                         (size_t)y,
-                                                                         (size_t)z);
+                        b = _chunk_get_block_unchecked(chunk, x, y, z);
                         if (block_is_solid(b)) {
                             isEmpty = false;
                             break;
@@ -2642,10 +3415,7 @@ void _chunk_update_bounding_box(Chunk *chunk,
             for (CHUNK_COORDS_INT_T z = chunk->bbMin.z; isEmpty && z < chunk->bbMax.z; ++z) {
                 for (CHUNK_COORDS_INT_T x = chunk->bbMin.x; x < chunk->bbMax.x; ++x) {
                     for (CHUNK_COORDS_INT_T y = chunk->bbMin.y; y < chunk->bbMax.y; ++y) {
-                        b = (Block *)octree_get_element_without_checking(chunk->octree,
-                                                                         (size_t)x,
-                                                                         (size_t)y,
-                                                                         (size_t)z);
+                        b = _chunk_get_block_unchecked(chunk, x, y, z);
                         if (block_is_solid(b)) {
                             isEmpty = false;
                             break;
@@ -58,17 +58,30 @@ typedef enum {
 void chunk_alloc_default_light(void);
 
 Chunk *chunk_new(const SHAPE_COORDS_INT3_T origin);
-Chunk *chunk_new_copy(const Chunk *c);
+Chunk *chunk_new_with_storage(const SHAPE_COORDS_INT3_T origin, const ChunkStorage storage);
+/// Copy shares the block & lighting buffers of the chunk, they are cloned on first write
+Chunk *chunk_new_copy(Chunk *c);
 void chunk_free(Chunk *chunk, bool updateNeighbors);
 void chunk_free_func(void *c);
 void chunk_set_dirty(Chunk *chunk, bool b);
 bool chunk_is_dirty(const Chunk *chunk);
 SHAPE_COORDS_INT3_T chunk_get_origin(const Chunk *chunk);
 int chunk_get_nb_blocks(const Chunk *chunk);
-Octree *chunk_get_octree(const Chunk *c);
+/// Number of block faces written during last vertices refresh
+uint16_t chunk_get_nb_faces(const Chunk *chunk);
+/// Number of quads written during last vertices refresh, lower than faces w/ greedy meshing
+uint16_t chunk_get_nb_quads(const Chunk *chunk);
+ChunkStorage chunk_get_storage(const Chunk *c);
+/// Converts chunk blocks to given storage
+void chunk_set_storage(Chunk *c, const ChunkStorage storage);
+/// With dense storage, the octree is built on demand and discarded on the next block change
+Octree *chunk_get_octree(Chunk *c);
 void chunk_set_rtree_leaf(Chunk *c, void *ptr);
 void *chunk_get_rtree_leaf(const Chunk *c);
-uint64_t chunk_get_hash(const Chunk *c, uint64_t crc);
+uint64_t chunk_get_hash(Chunk *c, uint64_t crc);
+/// Whether both chunks have the same origin, blocks & lighting, copies still sharing their
+/// buffers are compared without reading them
+bool chunk_has_same_content(const Chunk *a, const Chunk *b);
 
 void chunk_set_light(Chunk *c,
                      const CHUNK_COORDS_INT3_T coords,
@@ -140,6 +153,19 @@ void *chunk_get_vbma(const Chunk *chunk, bool transparent);
 void chunk_set_vbma(Chunk *chunk, void *vbma, bool transparent);
 void chunk_write_vertices(Shape *shape, Chunk *chunk);
 
+/// Faces computed for a chunk, meshing is split in 2 steps so that faces of several chunks can
+/// be computed in parallel before being written into the vertex buffers of the shape
+typedef struct _ChunkMesh ChunkMesh;
+
+ChunkMesh *chunk_mesh_new(void);
+void chunk_mesh_free(ChunkMesh *mesh);
+size_t chunk_mesh_get_nb_faces(const ChunkMesh *mesh);
+/// Only reads blocks & lighting of the chunk and its neighbors, it is safe to call it from
+/// several threads at once for different chunks, as long as the shape isn't modified meanwhile
+void chunk_compute_mesh(const Shape *shape, Chunk *chunk, ChunkMesh *mesh);
+/// Must be called from the thread owning the shape, in the same order as the serial refresh
+void chunk_write_mesh(Shape *shape, Chunk *chunk, const ChunkMesh *mesh);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
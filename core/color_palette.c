@@ -70,6 +70,7 @@ ColorPalette *color_palette_new(ColorAtlas *atlas) {
     p->colorToIdx = hash_uint32_int_new();
     p->count = 0;
     p->orderedCount = 0;
+    p->version = 0;
     p->lighting_dirty = false;
     p->wptr = NULL;
     p->refCount = 1;
@@ -92,6 +93,7 @@ ColorPalette *color_palette_new_from_data(ColorAtlas *atlas,
     p->colorToIdx = hash_uint32_int_new();
     p->count = count;
     p->orderedCount = count;
+    p->version = 0;
     p->lighting_dirty = false;
     p->wptr = NULL;
     p->refCount = 1;
@@ -166,6 +168,7 @@ void color_palette_set_atlas(ColorPalette *p, ColorAtlas *atlas) {
     for (SHAPE_COLOR_INDEX_INT_T i = 0; i < p->count; ++i) {
         p->entries[i].atlasIndex = color_atlas_check_and_add_color(atlas, p->entries[i].color);
     }
+    p->version++;
 }
 
 ColorAtlas *color_palette_get_atlas(const ColorPalette *p) {
@@ -372,6 +375,7 @@ void color_palette_set_color(ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry, RGB
         color_atlas_set_color(a, p->entries[entry].atlasIndex, color);
     }
     hash_uint32_int_set(p->colorToIdx, color_to_uint32(&color), entry);
+    p->version++;
 }
 
 RGBAColor color_palette_get_color(const ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry) {
@@ -381,6 +385,10 @@ RGBAColor color_palette_get_color(const ColorPalette *p, SHAPE_COLOR_INDEX_INT_T
     return p->entries[entry].color;
 }
 
+uint32_t color_palette_get_version(const ColorPalette *p) {
+    return p->version;
+}
+
 void color_palette_set_emissive(ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry, bool toggle) {
     if (entry >= p->count) {
         return;
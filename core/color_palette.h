@@ -58,6 +58,10 @@ typedef struct ColorPalette {
     // Number of colors in user-friendly order
     uint8_t orderedCount;
 
+    // Incremented whenever an entry color or the atlas changes, lets users of the atlas indices
+    // (eg. vertex buffers drawn for another palette) know they may be stale
+    uint32_t version;
+
     // Is true if any alpha or emission values changed since last clear
     bool lighting_dirty;
 
@@ -100,6 +104,7 @@ void color_palette_remove_all_unused_colors(ColorPalette *p, bool remap);
 uint32_t color_palette_get_color_use_count(const ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry);
 void color_palette_set_color(ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry, RGBAColor color);
 RGBAColor color_palette_get_color(const ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry);
+uint32_t color_palette_get_version(const ColorPalette *p);
 void color_palette_set_emissive(ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry, bool toggle);
 bool color_palette_is_emissive(const ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry);
 bool color_palette_is_transparent(const ColorPalette *p, SHAPE_COLOR_INDEX_INT_T entry);
@@ -125,6 +125,8 @@ extern unsigned long upper_power_of_two(unsigned long v);
     64.0f // 1/4 of a large-sized map, or "10 frames" of max velocity (PHYSICS_MAX_VELOCITY * .016)
 /// When updating a leaf, stick to current node if volume expansion is below threshold
 #define RTREE_LEAF_UPDATE_THRESHOLD 25.0f
+/// Rays cast in a batch share r-tree traversals by packets of that many rays (at most 255)
+#define RTREE_RAYS_PACKET_SIZE 64
 /// Maximum velocity magnitude in unit/sec for all objects
 #define PHYSICS_MAX_VELOCITY 400.0f
 #define PHYSICS_MAX_SQR_VELOCITY 160000.0f
@@ -294,6 +296,14 @@ static const FACE_INDEX_INT_T FACE_NONE = 7;
 #define CHUNK_SIZE_IS_PERFECT_SQRT true
 #define CHUNK_SIZE_SQRT 4
 
+/// Chunk blocks storage
+typedef uint8_t ChunkStorage;
+// blocks partitioned in an octree, compact for sparse chunks
+#define CHUNK_STORAGE_OCTREE 0
+// flat block array w/ an occupancy bitmask per row, faster lookups & edits for dense chunks,
+// the octree used for physics queries is derived on demand
+#define CHUNK_STORAGE_DENSE 1
+
 // SHAPE BUFFERS
 // Maximum allowed capacity for a single shape buffer
 #define SHAPE_BUFFER_MAX_COUNT 1048576
@@ -307,6 +317,17 @@ static const FACE_INDEX_INT_T FACE_NONE = 7;
 // Subsequent buffers on init/runtime can be downscaled or upscaled, see shape_add_buffer
 #define SHAPE_BUFFER_INIT_SCALE_RATE .75f
 #define SHAPE_BUFFER_RUNTIME_SCALE_RATE 4.0f
+// Write 8-bytes vertices w/ integer coordinates relative to chunk origin instead of 20-bytes float
+// vertices, renderer then has to offset each mem area by the origin of its chunk
+#define VERTEX_BUFFER_COMPACT_ATTRIBUTES false
+
+// SHAPE MESHING
+// Maximum number of worker threads meshing dirty chunks, in addition to the calling thread
+#define SHAPE_MESHING_MAX_WORKERS 7
+// Below this number of dirty chunks, they are meshed on the calling thread only
+#define SHAPE_MESHING_PARALLEL_MIN_CHUNKS 4
+// Baked lighting is propagated in parallel, in regions of NxN chunk columns, using the same workers
+#define SHAPE_LIGHTING_REGION_SIZE 4
 
 //// Disabling global lighting will use neutral value (15, 0, 0, 0) everywhere
 #define GLOBAL_LIGHTING_ENABLED true
@@ -22,16 +22,38 @@ typedef struct _LightRemovalNode LightRemovalNode;
 typedef struct _LightNodeQueue LightNodeQueue;
 typedef struct _LightRemovalNodeQueue LightRemovalNodeQueue;
 
+// Light queues are growable stacks of nodes stored by value, owned by the caller: pushing doesn't
+// allocate once capacity is reached & queues can be used concurrently from different threads.
+// Nodes are popped in reverse order of insertion.
+
+struct _LightNode {
+    Chunk *chunk;
+    SHAPE_COORDS_INT3_T coords; /* 6 bytes */
+    char pad[2];
+};
+
+struct _LightRemovalNode {
+    Chunk *chunk;
+    SHAPE_COORDS_INT3_T coords;  /* 6 bytes */
+    VERTEX_LIGHT_STRUCT_T light; /* 2 bytes */
+    // 4 first bits used to flag in which channel [sunlight:R:G:B] removal should propagate
+    uint8_t srgb; /* 1 byte */
+    // this makes it possible to enqueue an emissive block as removal node
+    SHAPE_COLOR_INDEX_INT_T blockID; /* 1 byte */
+    char pad[6];
+};
+
 SHAPE_COORDS_INT3_T light_node_get_coords(const LightNode *n);
 Chunk *light_node_get_chunk(const LightNode *n);
 
 LightNodeQueue *light_node_queue_new(void);
-void light_node_free(LightNode *n);
-void light_removal_node_free(LightRemovalNode *n);
 void light_node_queue_free(LightNodeQueue *q);
-LightNode *light_node_queue_pop(LightNodeQueue *q);
+/// Copies last pushed node into given node, returns false if queue is empty
+bool light_node_queue_pop(LightNodeQueue *q, LightNode *out);
 void light_node_queue_push(LightNodeQueue *q, Chunk *chunk, const SHAPE_COORDS_INT3_T coords);
-void light_node_queue_recycle(LightNode *n);
+size_t light_node_queue_get_count(const LightNodeQueue *q);
+/// Number of nodes that can be stored before the queue has to grow
+size_t light_node_queue_get_capacity(const LightNodeQueue *q);
 
 SHAPE_COORDS_INT3_T light_removal_node_get_coords(const LightRemovalNode *n);
 Chunk *light_removal_node_get_chunk(const LightRemovalNode *n);
@@ -41,14 +63,16 @@ SHAPE_COLOR_INDEX_INT_T light_removal_node_get_block_id(const LightRemovalNode *
 
 LightRemovalNodeQueue *light_removal_node_queue_new(void);
 void light_removal_node_queue_free(LightRemovalNodeQueue *q);
-LightRemovalNode *light_removal_node_queue_pop(LightRemovalNodeQueue *q);
+/// Copies last pushed node into given node, returns false if queue is empty
+bool light_removal_node_queue_pop(LightRemovalNodeQueue *q, LightRemovalNode *out);
 void light_removal_node_queue_push(LightRemovalNodeQueue *q,
                                    Chunk *chunk,
                                    const SHAPE_COORDS_INT3_T coords,
                                    VERTEX_LIGHT_STRUCT_T light,
                                    uint8_t srgb,
                                    SHAPE_COLOR_INDEX_INT_T blockID);
-void light_removal_node_queue_recycle(LightRemovalNode *n);
+size_t light_removal_node_queue_get_count(const LightRemovalNodeQueue *q);
+size_t light_removal_node_queue_get_capacity(const LightRemovalNodeQueue *q);
 
 #ifdef __cplusplus
 } // extern "C"
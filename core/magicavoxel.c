@@ -824,6 +824,25 @@ enum serialization_magicavoxel_error serialization_vox_to_shape(Stream *s,
     }
 
     ColorPalette *palette = shape_get_palette(*out);
+
+    // voxels are placed in a grid & added at once, coordinates are 8 bits in .vox files
+    // ⚠️ y -> z, z -> y
+    const uint16_t gridWidth = (uint16_t)minimum(sizeX, 256);
+    const uint16_t gridHeight = (uint16_t)minimum(sizeZ, 256);
+    const uint16_t gridDepth = (uint16_t)minimum(sizeY, 256);
+    const size_t gridSize = (size_t)gridWidth * gridHeight * gridDepth;
+    SHAPE_COLOR_INDEX_INT_T *grid = (SHAPE_COLOR_INDEX_INT_T *)malloc(gridSize);
+    if (grid == NULL) {
+        cclog_error("could not allocate blocks");
+        shape_release(*out);
+        free(colors);
+        return invalid_format;
+    }
+    memset(grid, SHAPE_COLOR_INDEX_AIR_BLOCK, gridSize);
+    uint16_t translated[UINT8_MAX + 1];
+    memset(translated, 0xFF, sizeof(translated));
+    size_t gridIdx;
+
     for (uint32_t i = 0; i < nbVoxels; i++) {
 
         // ⚠️ y -> z, z -> y
@@ -857,18 +876,36 @@ enum serialization_magicavoxel_error serialization_vox_to_shape(Stream *s,
         SHAPE_COLOR_INDEX_INT_T colorIdx = color_index - 1;
 
         // translate & shrink to a shape palette w/ only used colors
-        if (color_palette_check_and_add_color(palette, colors[colorIdx], &colorIdx, false) ==
-            false) {
-            colorIdx = 0;
+        if (translated[color_index] == UINT16_MAX) {
+            if (color_palette_check_and_add_color(palette, colors[colorIdx], &colorIdx, false) ==
+                false) {
+                colorIdx = 0;
+            }
+            translated[color_index] = colorIdx;
+        }
+        colorIdx = (SHAPE_COLOR_INDEX_INT_T)translated[color_index];
+
+        if (x >= gridWidth || y >= gridHeight || z >= gridDepth) {
+            // voxel outside of declared model size
+            shape_add_block(*out,
+                            colorIdx,
+                            (SHAPE_COORDS_INT_T)x,
+                            (SHAPE_COORDS_INT_T)y,
+                            (SHAPE_COORDS_INT_T)z,
+                            false);
+            continue;
         }
 
-        shape_add_block(*out,
-                        colorIdx,
-                        (SHAPE_COORDS_INT_T)x,
-                        (SHAPE_COORDS_INT_T)y,
-                        (SHAPE_COORDS_INT_T)z,
-                        false);
+        // first voxel at a given position is kept, as when adding blocks one by one
+        gridIdx = ((size_t)x * gridHeight + y) * gridDepth + z;
+        if (grid[gridIdx] == SHAPE_COLOR_INDEX_AIR_BLOCK) {
+            grid[gridIdx] = colorIdx;
+        }
+    }
+    if (err == no_error) {
+        shape_fill_blocks_from_grid(*out, grid, gridWidth, gridHeight, gridDepth);
     }
+    free(grid);
     color_palette_clear_lighting_dirty(palette);
 
     if (err != no_error) {
@@ -342,7 +342,9 @@ void *matrix4x4_op_invert(Matrix4x4 *m) {
 
     float det;
 
-    Matrix4x4 *m2 = matrix4x4_new_copy(m);
+    // work on a stack copy, this is called for every transform refresh
+    const Matrix4x4 copy = *m;
+    const Matrix4x4 *m2 = &copy;
 
     m->x1y1 = m2->x2y2 * m2->x3y3 * m2->x4y4 - m2->x2y2 * m2->x3y4 * m2->x4y3 -
               m2->x3y2 * m2->x2y3 * m2->x4y4 + m2->x3y2 * m2->x2y4 * m2->x4y3 +
@@ -413,12 +415,9 @@ void *matrix4x4_op_invert(Matrix4x4 *m) {
     if (det == 0.0f) {
         // restore m using copy (m2)
         matrix4x4_copy(m, m2);
-        free(m2);
         return m;
     }
 
-    free(m2);
-
     det = 1.0f / det;
 
     m->x1y1 = m->x1y1 * det;
@@ -871,36 +871,16 @@ uint64_t octree_get_hash(const Octree *octree, uint64_t crc) {
 
 // MARK: Octree iterator
 
-struct _OctreeIterator {
-    const Octree *octree;
-    OctreeNode *current_nodes[11]; // there's only one node by level maximum at any time when
-                                   // exploring the tree
-    int node_index_in_level[11];   // index of node in its own level (global index minus start of
-                                   // level)
-    int branch_index[10]; // index of first child for node at given level (8 children for each node)
-
-    uint8_t child_index_processed[11]; // child index being processed for each level
-    char pad[1];
-
-    int current_level;          // level being processed
-    int current_level_plus_one; // level being processed
-
-    uint16_t current_node_x;
-    uint16_t current_node_y;
-    uint16_t current_node_z;
-    uint16_t current_node_size;
-
-    bool done;
-    bool foundLeaf;
-    char pad2[6];
-};
-
 OctreeIterator *octree_iterator_new(const Octree *octree) {
     OctreeIterator *oi = (OctreeIterator *)malloc(sizeof(OctreeIterator));
     if (oi == NULL) {
         return NULL;
     }
+    octree_iterator_init(oi, octree);
+    return oi;
+}
 
+void octree_iterator_init(OctreeIterator *oi, const Octree *octree) {
     oi->octree = octree;
 
     oi->current_level = 0;
@@ -920,8 +900,6 @@ OctreeIterator *octree_iterator_new(const Octree *octree) {
 
     oi->done = false;
     oi->foundLeaf = false;
-
-    return oi;
 }
 
 void octree_iterator_free(OctreeIterator *oi) {
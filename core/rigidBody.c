@@ -20,6 +20,9 @@
 #define SIMULATIONFLAG_END_CALLBACK_ENABLED 64
 #define SIMULATIONFLAG_COLLIDER_CUSTOM_SET 128
 
+// initial number of island events, then doubles when full
+#define RIGIDBODY_ISLAND_EVENTS_INITIAL_CAPACITY 16
+
 #if DEBUG_RIGIDBODY
 static int debug_rigidbody_solver_iterations = 0;
 static int debug_rigidbody_replacements = 0;
@@ -29,32 +32,27 @@ static int debug_rigidbody_awakes = 0;
 #endif
 
 struct _RigidBody {
-    // collider axis-aligned box, may be arbitrary or similar to the axis-aligned bounding box
-    Box *collider;
+    // all properties are stored inline, hot simulation fields first, so that a rigidbody is one
+    // contiguous allocation instead of one per property
+
     // pointer to r-rtree leaf, its aabb represents the space last occupied in the scene
     RtreeNode *rtreeLeaf;
 
-    // Motion is an enforced force delta in world units, added every tick & not applied to velocity
-    float3 *motion;
+    // weak ref to the transform simulated w/ this rigidbody, woken up by any change
+    Transform *transform;
 
     // world velocity, in world units/sec is the current velocity along world axes
     // setting this directly ignores mass
-    float3 *velocity;
+    float3 velocity;
 
-    // world constant acceleration, in world units/sec^2 (ignores mass)
-    float3 *constantAcceleration;
-
-    // last known valid position
-    float3 *checkpoint;
+    // Motion is an enforced force delta in world units, added every tick & not applied to velocity
+    float3 motion;
 
-    // combined friction of 2 surfaces in contact represents how much force is absorbed,
-    // it is a rate between 0 (full stop on contact) and 1 (full slide, no friction), or
-    // below 0 (inverted movement) and above 1 (amplified movement)
-    float *friction;
+    // world constant acceleration, in world units/sec^2 (ignores mass)
+    float3 constantAcceleration;
 
-    // bounciness represents how much force is produced in response to a collision,
-    // it is a rate between 0 (no bounce) and 1 (100% of the force bounced) or above
-    float *bounciness;
+    // collider axis-aligned box, may be arbitrary or similar to the axis-aligned bounding box
+    Box collider;
 
     // mass of the object determines how much a given force can move it,
     // it cannot be zero, a neutral mass is a mass of 1
@@ -68,15 +66,36 @@ struct _RigidBody {
     uint8_t contact;
 
     // combines various simulation flags,
-    // [0-1] simulation modes (2 bits)
-    // [2] collider dirty
-    // [3] callback enabled
-    // [4] end callback enabled
-    // [5-7] <unused>
+    // [0-2] simulation modes (3 bits)
+    // [3] collider dirty
+    // [4] begin callback enabled
+    // [5] callback enabled
+    // [6] end callback enabled
+    // [7] collider custom set
     uint8_t simulationFlags;
     uint8_t awakeFlag;
 
-    char pad[5];
+    // whether checkpoint is set
+    bool hasCheckpoint;
+
+    // last known valid position
+    float3 checkpoint;
+
+    // combined friction of 2 surfaces in contact represents how much force is absorbed,
+    // it is a rate between 0 (full stop on contact) and 1 (full slide, no friction), or
+    // below 0 (inverted movement) and above 1 (amplified movement)
+    float friction[FACE_SIZE_CTC];
+
+    // bounciness represents how much force is produced in response to a collision,
+    // it is a rate between 0 (no bounce) and 1 (100% of the force bounced) or above
+    float bounciness[FACE_SIZE_CTC];
+
+    // contact island ID while stepped in parallel, 0 otherwise
+    uint32_t island;
+
+    // last step had no effect & nothing changed since, see rigidbody_is_idle
+    bool idle;
+    char pad[7];
 };
 
 static pointer_rigidbody_collision_func rigidbody_collision_callback = NULL;
@@ -106,6 +125,14 @@ void _rigidbody_reset_state(RigidBody *rb) {
     rb->contact = AxesMaskNone;
 }
 
+/// any change that may affect simulation, wakes up the rigidbody & its transform branch
+static void _rigidbody_wake(RigidBody *rb) {
+    rb->idle = false;
+    if (rb->transform != NULL) {
+        transform_set_idle_branch(rb->transform, false);
+    }
+}
+
 void _rigidbody_fire_reciprocal_callbacks(Scene *sc,
                                           RigidBody *selfRb,
                                           Transform *selfTr,
@@ -194,23 +221,87 @@ void _rigidbody_fire_reciprocal_callbacks(Scene *sc,
     }
 }
 
+/// records an effect outside of the island, to be applied once it is stepped
+static void _rigidbody_island_push_event(RigidbodyIsland *island,
+                                         const RigidbodyIslandEventType type,
+                                         RigidBody *selfRb,
+                                         Transform *selfTr,
+                                         RigidBody *otherRb,
+                                         Transform *otherTr,
+                                         const float3 *value) {
+    if (island->nbEvents == island->eventsCapacity) {
+        const size_t capacity = island->eventsCapacity > 0
+                                    ? island->eventsCapacity * 2
+                                    : RIGIDBODY_ISLAND_EVENTS_INITIAL_CAPACITY;
+        RigidbodyIslandEvent *events = (RigidbodyIslandEvent *)
+            realloc(island->events, capacity * sizeof(RigidbodyIslandEvent));
+        if (events == NULL) {
+            cclog_error("🔥 rigidbody: can't record island event");
+            return;
+        }
+        island->events = events;
+        island->eventsCapacity = capacity;
+    }
+
+    RigidbodyIslandEvent *e = &island->events[island->nbEvents++];
+    e->selfTr = selfTr;
+    e->otherTr = otherTr;
+    e->selfRb = selfRb;
+    e->otherRb = otherRb;
+    e->value = *value;
+    e->type = type;
+}
+
+/// fires callbacks right away, or records them if stepping an island
+static void _rigidbody_collision(Scene *sc,
+                                 RigidbodyIsland *island,
+                                 RigidBody *selfRb,
+                                 Transform *selfTr,
+                                 RigidBody *otherRb,
+                                 Transform *otherTr,
+                                 float3 wNormal,
+                                 void *callbackData) {
+    if (island == NULL) {
+        _rigidbody_fire_reciprocal_callbacks(sc,
+                                             selfRb,
+                                             selfTr,
+                                             otherRb,
+                                             otherTr,
+                                             wNormal,
+                                             callbackData);
+    } else if (rigidbody_collision_callback != NULL) {
+        _rigidbody_island_push_event(island,
+                                     RigidbodyIslandEvent_Collision,
+                                     selfRb,
+                                     selfTr,
+                                     otherRb,
+                                     otherTr,
+                                     &wNormal);
+    }
+}
+
 bool _rigidbody_dynamic_tick(Scene *scene,
                              RigidBody *rb,
                              Transform *t,
                              Box *worldCollider,
                              Rtree *r,
                              const TICK_DELTA_SEC_T dt,
-                             FifoList *sceneQuery,
+                             RtreeLeaves *sceneQuery,
+                             RigidbodyIsland *island,
                              void *callbackData) {
 
 #if DEBUG_RIGIDBODY_CALLS
-#define INC_REPLACEMENTS debug_rigidbody_replacements++;
-#define INC_COLLISIONS debug_rigidbody_collisions++;
-#define INC_SLEEPS debug_rigidbody_sleeps++;
+#define DEBUG_COUNTER(name, islandName) (island != NULL ? &island->islandName : &name)
+#define INC_REPLACEMENTS (*DEBUG_COUNTER(debug_rigidbody_replacements, debugReplacements))++;
+#define INC_COLLISIONS (*DEBUG_COUNTER(debug_rigidbody_collisions, debugCollisions))++;
+#define INC_SLEEPS (*DEBUG_COUNTER(debug_rigidbody_sleeps, debugSleeps))++;
+#define INC_AWAKES (*DEBUG_COUNTER(debug_rigidbody_awakes, debugAwakes))++;
+    const uint8_t awakeFlag = rb->awakeFlag;
 #else
 #define INC_REPLACEMENTS
 #define INC_COLLISIONS
 #define INC_SLEEPS
+#define INC_AWAKES
 #endif
 
     float3 f3;
@@ -222,10 +313,10 @@ bool _rigidbody_dynamic_tick(Scene *scene,
 
     const float3 constantAcceleration = *scene_get_constant_acceleration(scene);
 
-    f3 = (float3){(constantAcceleration.x + rb->constantAcceleration->x) * dt_f,
-                  (constantAcceleration.y + rb->constantAcceleration->y) * dt_f,
-                  (constantAcceleration.z + rb->constantAcceleration->z) * dt_f};
-    float3_op_add(rb->velocity, &f3);
+    f3 = (float3){(constantAcceleration.x + rb->constantAcceleration.x) * dt_f,
+                  (constantAcceleration.y + rb->constantAcceleration.y) * dt_f,
+                  (constantAcceleration.z + rb->constantAcceleration.z) * dt_f};
+    float3_op_add(&rb->velocity, &f3);
 
     // ------------------------
     // APPLY DRAG
@@ -237,27 +328,27 @@ bool _rigidbody_dynamic_tick(Scene *scene,
     float drag = PHYSICS_AIR_DRAG_DEFAULT;
     drag = 1.0f - minimum(drag * dt_f, 1.0f);
 
-    float3_op_scale(rb->velocity, drag);
+    float3_op_scale(&rb->velocity, drag);
 
     // ------------------------
     // MOTION CLAMP
     // ------------------------
     // Allow Motion to counter velocity if they are opposed, and dampen inertia faster
 
-    if (rb->velocity->x > 0 && rb->motion->x < 0) {
-        rb->velocity->x = maximum(rb->velocity->x + rb->motion->x, 0.0f);
-    } else if (rb->velocity->x < 0 && rb->motion->x > 0) {
-        rb->velocity->x = minimum(rb->velocity->x + rb->motion->x, 0.0f);
+    if (rb->velocity.x > 0 && rb->motion.x < 0) {
+        rb->velocity.x = maximum(rb->velocity.x + rb->motion.x, 0.0f);
+    } else if (rb->velocity.x < 0 && rb->motion.x > 0) {
+        rb->velocity.x = minimum(rb->velocity.x + rb->motion.x, 0.0f);
     }
-    if (rb->velocity->y > 0 && rb->motion->y < 0) {
-        rb->velocity->y = maximum(rb->velocity->y + rb->motion->y, 0.0f);
-    } else if (rb->velocity->y < 0 && rb->motion->y > 0) {
-        rb->velocity->y = minimum(rb->velocity->y + rb->motion->y, 0.0f);
+    if (rb->velocity.y > 0 && rb->motion.y < 0) {
+        rb->velocity.y = maximum(rb->velocity.y + rb->motion.y, 0.0f);
+    } else if (rb->velocity.y < 0 && rb->motion.y > 0) {
+        rb->velocity.y = minimum(rb->velocity.y + rb->motion.y, 0.0f);
     }
-    if (rb->velocity->z > 0 && rb->motion->z < 0) {
-        rb->velocity->z = maximum(rb->velocity->z + rb->motion->z, 0.0f);
-    } else if (rb->velocity->z < 0 && rb->motion->z > 0) {
-        rb->velocity->z = minimum(rb->velocity->z + rb->motion->z, 0.0f);
+    if (rb->velocity.z > 0 && rb->motion.z < 0) {
+        rb->velocity.z = maximum(rb->velocity.z + rb->motion.z, 0.0f);
+    } else if (rb->velocity.z < 0 && rb->motion.z > 0) {
+        rb->velocity.z = minimum(rb->velocity.z + rb->motion.z, 0.0f);
     }
 
     // ------------------------
@@ -266,16 +357,22 @@ bool _rigidbody_dynamic_tick(Scene *scene,
     // Motion moves the object w/o drag and w/o affecting velocity directly, although it may
     // contribute to provoking collision responses, like a bounce
 
-    float3_copy(&f3, rb->velocity);
-    float3_op_add(&f3, rb->motion);
+    float3_copy(&f3, &rb->velocity);
+    float3_op_add(&f3, &rb->motion);
     // f3 now represents object's velocity + motion
 
-    // dynamic rigidbodies may sleep
-    if (rigidbody_check_velocity_sleep(rb, &f3)) {
-        float3_set_zero(rb->velocity);
+    // dynamic rigidbodies may sleep, a sleeping rigidbody stays idle until woken up
+    rb->idle = rigidbody_check_velocity_sleep(rb, &f3);
+    if (rb->idle) {
+        float3_set_zero(&rb->velocity);
         INC_SLEEPS
         return false;
     }
+#if DEBUG_RIGIDBODY_CALLS
+    if (rb->awakeFlag < awakeFlag) {
+        INC_AWAKES
+    }
+#endif
 
     // ------------------------
     // CLAMP TO MAX VELOCITY
@@ -309,8 +406,10 @@ bool _rigidbody_dynamic_tick(Scene *scene,
     typedef struct {
         Transform *t;
         RigidBody *rb;
-        Matrix4x4 *model;
+        Matrix4x4 model; // set if hasModel, contact normal is then in model space
         float3 normal;
+        bool hasModel;
+        char pad[3];
     } ContactData;
     ContactData contact; // TODO: list of contacts to handle contact ties
 
@@ -331,7 +430,7 @@ bool _rigidbody_dynamic_tick(Scene *scene,
         minSwept = 1.0f;
         contact.t = NULL;
         contact.rb = NULL;
-        contact.model = NULL;
+        contact.hasModel = false;
 
         box_set_broadphase_box(worldCollider, &dv, &broadphase);
 
@@ -344,27 +443,43 @@ bool _rigidbody_dynamic_tick(Scene *scene,
         // static scene. It isn't going to be accurate in case of concurring trajectories. We can
         // add a full broadphase if we see it's necessary
 
-        // previous query should be processed entirely
-        vx_assert(fifo_list_pop(sceneQuery) == NULL);
-
-        // run collision query in r-tree
-        if (rtree_query_overlap_box(r,
-                                    &broadphase,
-                                    rb->groups,
-                                    rb->collidesWith,
-                                    NULL,
-                                    sceneQuery,
-                                    &float3_epsilon_collision) > 0) {
-            RtreeNode *hit = fifo_list_pop(sceneQuery);
+        // run collision query in r-tree, reusing the scratch array ; when stepping an island,
+        // other members are tested against their up-to-date collider instead of their leaf
+        rtree_leaves_reset(sceneQuery);
+        rtree_query_overlap_box_leaves(r,
+                                       &broadphase,
+                                       rb->groups,
+                                       rb->collidesWith,
+                                       NULL,
+                                       sceneQuery,
+                                       &float3_epsilon_collision);
+        const size_t nbLeaves = sceneQuery->count;
+        const size_t nbHits = nbLeaves + (island != NULL ? island->nbMembers : 0);
+        if (nbHits > 0) {
+            RtreeNode *hit;
             Transform *hitLeaf;
             RigidBody *hitRb;
-            while (hit != NULL) {
-                hitLeaf = (Transform *)rtree_node_get_leaf_ptr(hit);
-                vx_assert(rtree_node_is_leaf(hit));
+            const Box *hitBox;
+            Matrix4x4 model;
+            bool hasModel;
+            for (size_t i = 0; i < nbHits; ++i) {
+                if (i < nbLeaves) {
+                    hit = sceneQuery->items[i];
+                    hitLeaf = (Transform *)rtree_node_get_leaf_ptr(hit);
+                    hitBox = rtree_node_get_aabb(hit);
+                    vx_assert(rtree_node_is_leaf(hit));
+                } else {
+                    const RigidbodyIslandMember *member = &island->members[i - nbLeaves];
+                    hitLeaf = member->t;
+                    hitBox = &member->collider;
+                    if (box_collide_epsilon3(hitBox, &broadphase, &float3_epsilon_collision) ==
+                        false) {
+                        continue;
+                    }
+                }
 
                 // self isn't removed from r-tree before query
                 if (hitLeaf == t) {
-                    hit = fifo_list_pop(sceneQuery);
                     continue;
                 }
 
@@ -372,13 +487,16 @@ bool _rigidbody_dynamic_tick(Scene *scene,
                 vx_assert(hitRb != NULL);
 
                 if (rigidbody_collides_with_rigidbody(rb, hitRb) == false) {
-                    hit = fifo_list_pop(sceneQuery);
+                    continue;
+                }
+
+                // island members' leaves are out-of-date while it is stepped
+                if (i < nbLeaves && island != NULL && hitRb->island == island->id) {
                     continue;
                 }
 
                 const RigidbodyMode mode = rigidbody_get_simulation_mode(hitRb);
                 if (mode == RigidbodyMode_Disabled) {
-                    hit = fifo_list_pop(sceneQuery);
                     continue;
                 }
 
@@ -387,19 +505,18 @@ bool _rigidbody_dynamic_tick(Scene *scene,
 
                 if (isTrigger && selfCallbacks == false &&
                     rigidbody_has_callbacks(hitRb) == false) {
-                    hit = fifo_list_pop(sceneQuery);
                     continue;
                 }
 
                 rtreeSwept = box_swept(worldCollider,
                                        &dv,
-                                       rtree_node_get_aabb(hit),
+                                       hitBox,
                                        &float3_epsilon_collision,
                                        true,
                                        &rtreeNormal,
                                        NULL);
 
-                Matrix4x4 *model = NULL;
+                hasModel = false;
                 normal = float3_zero;
 
                 if (mode == RigidbodyMode_Dynamic) {
@@ -452,8 +569,8 @@ bool _rigidbody_dynamic_tick(Scene *scene,
                             swept = rtreeSwept;
                             normal = rtreeNormal;
                         } else {
-                            model = matrix4x4_new_identity();
-                            transform_utils_get_model_ltw(hitLeaf, model);
+                            transform_utils_get_model_ltw(hitLeaf, &model);
+                            hasModel = true;
                         }
                     } else {
                         swept = 1.0f;
@@ -465,33 +582,32 @@ bool _rigidbody_dynamic_tick(Scene *scene,
                         // consider triggers here too, in case dynamic rb passes through in one
                         // frame, or the callback is defined only on the dynamic rb
                         float3 wNormal;
-                        if (model != NULL) {
-                            matrix4x4_op_multiply_vec_vector(&wNormal, &normal, model);
+                        if (hasModel) {
+                            matrix4x4_op_multiply_vec_vector(&wNormal, &normal, &model);
                             float3_normalize(&wNormal);
-                            matrix4x4_free(model);
                         } else {
                             wNormal = normal;
                         }
 
-                        _rigidbody_fire_reciprocal_callbacks(scene,
-                                                             rb,
-                                                             t,
-                                                             hitRb,
-                                                             hitLeaf,
-                                                             wNormal,
-                                                             callbackData);
+                        _rigidbody_collision(scene,
+                                             island,
+                                             rb,
+                                             t,
+                                             hitRb,
+                                             hitLeaf,
+                                             wNormal,
+                                             callbackData);
                     } else {
                         contact.t = hitLeaf;
                         contact.rb = hitRb;
-                        contact.model = model;
+                        contact.hasModel = hasModel;
+                        if (hasModel) {
+                            contact.model = model;
+                        }
                         contact.normal = normal;
                         minSwept = swept;
                     }
-                } else if (model != NULL) {
-                    matrix4x4_free(model);
                 }
-
-                hit = fifo_list_pop(sceneQuery);
             }
         }
 
@@ -515,15 +631,14 @@ bool _rigidbody_dynamic_tick(Scene *scene,
             minSwept = 0.0f;
 
             // choose smaller replacement between checkpoint and trajectory
-            if (rb->checkpoint != NULL) {
-                const float3 checkpoint = {rb->checkpoint->x - pos.x,
-                                           rb->checkpoint->y - pos.y,
-                                           rb->checkpoint->z - pos.z};
+            if (rb->hasCheckpoint) {
+                const float3 checkpoint = {rb->checkpoint.x - pos.x,
+                                           rb->checkpoint.y - pos.y,
+                                           rb->checkpoint.z - pos.z};
                 const float sqrDist = float3_sqr_length(&checkpoint);
                 if (float_isZero(sqrDist, EPSILON_ZERO)) {
                     // checkpoint is now obsolete and may cause bad replacements, reset it
-                    float3_free(rb->checkpoint);
-                    rb->checkpoint = NULL;
+                    rb->hasCheckpoint = false;
                 } else if (sqrDist < float3_sqr_length(&f3)) {
                     f3 = checkpoint;
                 }
@@ -574,8 +689,8 @@ bool _rigidbody_dynamic_tick(Scene *scene,
 
             // contact world normal
             float3 wNormal;
-            if (contact.model != NULL) {
-                matrix4x4_op_multiply_vec_vector(&wNormal, &contact.normal, contact.model);
+            if (contact.hasModel) {
+                matrix4x4_op_multiply_vec_vector(&wNormal, &contact.normal, &contact.model);
                 float3_normalize(&wNormal);
             } else {
                 wNormal = contact.normal;
@@ -583,7 +698,7 @@ bool _rigidbody_dynamic_tick(Scene *scene,
 
             // split intruding & tangential displacements
             const float intruding_mag = float3_dot_product(&remainder, &wNormal);
-            const float vIntruding_mag = float3_dot_product(rb->velocity, &wNormal);
+            const float vIntruding_mag = float3_dot_product(&rb->velocity, &wNormal);
             const float3 intruding = (float3){wNormal.x * intruding_mag,
                                               wNormal.y * intruding_mag,
                                               wNormal.z * intruding_mag};
@@ -613,12 +728,12 @@ bool _rigidbody_dynamic_tick(Scene *scene,
             // displacement originated at least partly from own velocity, not only motion or scene
             // constant
             dv = tangential;
-            float3_op_substract(rb->velocity, &vIntruding);
+            float3_op_substract(&rb->velocity, &vIntruding);
 
             float3_op_scale(&dv, friction);
-            float3_op_scale(rb->velocity, friction);
+            float3_op_scale(&rb->velocity, friction);
 
-            if (float3_isZero(rb->velocity, EPSILON_ZERO) == false) {
+            if (float3_isZero(&rb->velocity, EPSILON_ZERO) == false) {
                 push3 = tangential;
                 // float3_op_scale(&push3, 1.0f - friction);
             } else {
@@ -636,7 +751,7 @@ bool _rigidbody_dynamic_tick(Scene *scene,
                                                -intruding.z * bounciness};
 
                 float3_op_add(&dv, &bounce);
-                float3_op_add(rb->velocity, &vBounce);
+                float3_op_add(&rb->velocity, &vBounce);
 
                 push3.x += intruding.x * (1.0f - bounciness);
                 push3.y += intruding.y * (1.0f - bounciness);
@@ -653,14 +768,25 @@ bool _rigidbody_dynamic_tick(Scene *scene,
                 push3.y *= push / dt_f;
                 push3.z *= push / dt_f;
 
-                rigidbody_apply_push(contact.rb, &push3);
+                // pushes outside of the island being stepped are applied once it is done
+                if (island != NULL && contact.rb->island != island->id) {
+                    _rigidbody_island_push_event(island,
+                                                 RigidbodyIslandEvent_Push,
+                                                 rb,
+                                                 t,
+                                                 contact.rb,
+                                                 contact.t,
+                                                 &push3);
+                } else {
+                    rigidbody_apply_push(contact.rb, &push3);
+                }
 
                 // self is flagged as awake, since contact will move from push
                 rigidbody_set_awake(rb);
 
                 // TODO: inherit velocity from contact rigidbody
                 /*const float inherit_push = rigidbody_get_mass_push_ratio(contact.rb, rb);
-                const float inherit_mag = float3_dot_product(contact.rb->velocity, &tangential);
+                const float inherit_mag = float3_dot_product(&contact.rb->velocity, &tangential);
                 const float3 inherit = (float3){
                     tangential.x * inherit_mag * (1.0f - friction),
                     tangential.y * inherit_mag * (1.0f - friction),
@@ -711,13 +837,14 @@ bool _rigidbody_dynamic_tick(Scene *scene,
             }
 
             // (5) fire reciprocal callbacks
-            _rigidbody_fire_reciprocal_callbacks(scene,
-                                                 rb,
-                                                 t,
-                                                 contact.rb,
-                                                 contact.t,
-                                                 wNormal,
-                                                 callbackData);
+            _rigidbody_collision(scene,
+                                 island,
+                                 rb,
+                                 t,
+                                 contact.rb,
+                                 contact.t,
+                                 wNormal,
+                                 callbackData);
 
             INC_COLLISIONS
         }
@@ -738,14 +865,10 @@ bool _rigidbody_dynamic_tick(Scene *scene,
             float3_set_zero(&dv);
         }
 
-        if (contact.model != NULL) {
-            matrix4x4_free(contact.model);
-        }
-
         solverCount++;
     }
 #if DEBUG_RIGIDBODY_CALLS
-    debug_rigidbody_solver_iterations += (int)solverCount;
+    *DEBUG_COUNTER(debug_rigidbody_solver_iterations, debugSolverIterations) += (int)solverCount;
 #endif
 
     if (solverCount > 0 &&
@@ -753,11 +876,8 @@ bool _rigidbody_dynamic_tick(Scene *scene,
         // apply final position to transform
         transform_set_position(t, pos.x, pos.y, pos.z);
 
-        if (rb->checkpoint == NULL) {
-            rb->checkpoint = float3_new_copy(&pos);
-        } else {
-            float3_copy(rb->checkpoint, &pos);
-        }
+        rb->checkpoint = pos;
+        rb->hasCheckpoint = true;
 
         return true;
     } else {
@@ -770,24 +890,22 @@ void _rigidbody_trigger_tick(Scene *scene,
                              Transform *t,
                              Box *worldCollider,
                              Rtree *r,
-                             FifoList *sceneQuery,
+                             RtreeLeaves *sceneQuery,
                              void *callbackData) {
 
     // ----------------------
     // SCENE OVERLAP
     // ----------------------
 
-    // previous query should be processed entirely
-    vx_assert(fifo_list_pop(sceneQuery) == NULL);
-
-    // run overlap query in r-tree
-    if (rtree_query_overlap_box(r,
-                                worldCollider,
-                                rb->groups,
-                                rb->collidesWith,
-                                NULL,
-                                sceneQuery,
-                                &float3_epsilon_collision) > 0) {
+    // run overlap query in r-tree, reusing the scene scratch array
+    rtree_leaves_reset(sceneQuery);
+    if (rtree_query_overlap_box_leaves(r,
+                                       worldCollider,
+                                       rb->groups,
+                                       rb->collidesWith,
+                                       NULL,
+                                       sceneQuery,
+                                       &float3_epsilon_collision) > 0) {
 
         const Shape *s = transform_utils_get_shape(t);
         const bool selfPerBlock = s != NULL && rigidbody_uses_per_block_collisions(rb);
@@ -799,18 +917,18 @@ void _rigidbody_trigger_tick(Scene *scene,
         Matrix4x4 selfInvModel;
         transform_utils_get_model_wtl(t, &selfInvModel);
 
-        RtreeNode *hit = fifo_list_pop(sceneQuery);
+        RtreeNode *hit;
         Transform *hitLeaf;
         RigidBody *hitRb;
         Box box;
         float3 modelEpsilon;
-        while (hit != NULL) {
+        for (size_t i = 0; i < sceneQuery->count; ++i) {
+            hit = sceneQuery->items[i];
             hitLeaf = (Transform *)rtree_node_get_leaf_ptr(hit);
             vx_assert(rtree_node_is_leaf(hit));
 
             // self isn't removed from r-tree before query
             if (hitLeaf == t) {
-                hit = fifo_list_pop(sceneQuery);
                 continue;
             }
 
@@ -818,7 +936,6 @@ void _rigidbody_trigger_tick(Scene *scene,
             vx_assert(hitRb != NULL);
 
             if (rigidbody_collides_with_rigidbody(rb, hitRb) == false) {
-                hit = fifo_list_pop(sceneQuery);
                 continue;
             }
 
@@ -905,8 +1022,6 @@ void _rigidbody_trigger_tick(Scene *scene,
                                                      wNormal,
                                                      callbackData);
             }
-
-            hit = fifo_list_pop(sceneQuery);
         }
     }
 }
@@ -917,27 +1032,22 @@ RigidBody *rigidbody_new(const uint8_t mode, const uint16_t groups, const uint16
         return NULL;
     }
 
-    rb->collider = box_new_copy(&box_one);
+    rb->collider = box_one;
     rb->rtreeLeaf = NULL;
-    rb->motion = float3_new_zero();
-    rb->velocity = float3_new_zero();
-    rb->constantAcceleration = float3_new_zero();
-    rb->checkpoint = NULL;
+    rb->motion = float3_zero;
+    rb->velocity = float3_zero;
+    rb->constantAcceleration = float3_zero;
+    rb->hasCheckpoint = false;
     rb->mass = PHYSICS_MASS_DEFAULT;
     rb->contact = AxesMaskNone;
     rb->groups = groups;
     rb->collidesWith = collidesWith;
     rb->simulationFlags = SIMULATIONFLAG_NONE;
     rb->awakeFlag = 0;
+    rb->island = 0;
+    rb->transform = NULL;
+    rb->idle = false;
 
-    rb->friction = (float *)malloc(sizeof(float) * FACE_COUNT);
-    if (rb->friction == NULL) {
-        return NULL;
-    }
-    rb->bounciness = (float *)malloc(sizeof(float) * FACE_COUNT);
-    if (rb->bounciness == NULL) {
-        return NULL;
-    }
     for (uint8_t i = 0; i < FACE_COUNT; ++i) {
         rb->friction[i] = PHYSICS_FRICTION_DEFAULT;
         rb->bounciness[i] = PHYSICS_BOUNCINESS_DEFAULT;
@@ -958,27 +1068,23 @@ RigidBody *rigidbody_new_copy(const RigidBody *other) {
         return NULL;
     }
 
-    rb->collider = box_new_copy(other->collider);
+    rb->collider = other->collider;
     rb->rtreeLeaf = NULL;
-    rb->motion = float3_new_zero();
-    rb->velocity = float3_new_zero();
-    rb->constantAcceleration = float3_new_copy(other->constantAcceleration);
-    rb->checkpoint = other->checkpoint != NULL ? float3_new_copy(other->checkpoint) : NULL;
+    rb->motion = float3_zero;
+    rb->velocity = float3_zero;
+    rb->constantAcceleration = other->constantAcceleration;
+    rb->hasCheckpoint = other->hasCheckpoint;
+    rb->checkpoint = other->checkpoint;
     rb->mass = other->mass;
     rb->contact = AxesMaskNone;
     rb->groups = other->groups;
     rb->collidesWith = other->collidesWith;
     rb->simulationFlags = SIMULATIONFLAG_NONE;
     rb->awakeFlag = 0;
+    rb->island = 0;
+    rb->transform = NULL;
+    rb->idle = false;
 
-    rb->friction = (float *)malloc(sizeof(float) * FACE_COUNT);
-    if (rb->friction == NULL) {
-        return NULL;
-    }
-    rb->bounciness = (float *)malloc(sizeof(float) * FACE_COUNT);
-    if (rb->bounciness == NULL) {
-        return NULL;
-    }
     for (uint8_t i = 0; i < FACE_COUNT; ++i) {
         rb->friction[i] = other->friction[i];
         rb->bounciness[i] = other->bounciness[i];
@@ -995,16 +1101,6 @@ void rigidbody_free(RigidBody *rb) {
         return;
     }
 
-    box_free(rb->collider);
-    float3_free(rb->motion);
-    float3_free(rb->velocity);
-    float3_free(rb->constantAcceleration);
-    if (rb->checkpoint != NULL) {
-        float3_free(rb->checkpoint);
-    }
-    free(rb->friction);
-    free(rb->bounciness);
-
     free(rb);
 }
 
@@ -1014,12 +1110,12 @@ void rigidbody_reset(RigidBody *rb) {
     }
 
     // note: rigidbody properties are persistent
-    float3_set_zero(rb->motion);
-    float3_set_zero(rb->velocity);
-    float3_free(rb->checkpoint);
-    rb->checkpoint = NULL;
+    float3_set_zero(&rb->motion);
+    float3_set_zero(&rb->velocity);
+    rb->hasCheckpoint = false;
 
     _rigidbody_reset_state(rb);
+    _rigidbody_wake(rb);
 }
 
 void rigidbody_non_kinematic_reset(RigidBody *rb) {
@@ -1028,6 +1124,7 @@ void rigidbody_non_kinematic_reset(RigidBody *rb) {
     }
 
     _rigidbody_reset_state(rb);
+    _rigidbody_wake(rb);
 }
 
 bool rigidbody_tick(Scene *scene,
@@ -1042,10 +1139,7 @@ bool rigidbody_tick(Scene *scene,
         return false;
     }
 
-    static FifoList *sceneQuery = NULL;
-    if (sceneQuery == NULL) {
-        sceneQuery = fifo_list_new();
-    }
+    RtreeLeaves *sceneQuery = scene_get_physics_query(scene);
 
     // dynamic rigidbodies are fully simulated, their callbacks are evaluated in this loop
     // vs. other dynamic rigidbodies only
@@ -1057,30 +1151,95 @@ bool rigidbody_tick(Scene *scene,
                                        r,
                                        dt,
                                        sceneQuery,
+                                       NULL,
                                        callbackData);
     }
     // check for overlaps to fire callbacks for trigger and static rigidbodies
     else if (rigidbody_is_active_trigger(rb)) {
         _rigidbody_trigger_tick(scene, rb, t, worldCollider, r, sceneQuery, callbackData);
     }
+    // other rigidbodies have nothing to simulate
+    else {
+        rb->idle = true;
+    }
 
     return false;
 }
 
+// MARK: - Islands -
+
+void rigidbody_island_tick(Scene *scene,
+                           RigidbodyIsland *island,
+                           Rtree *r,
+                           const TICK_DELTA_SEC_T dt,
+                           RtreeLeaves *query) {
+
+    island->nbEvents = 0;
+#if DEBUG_RIGIDBODY_CALLS
+    island->debugSolverIterations = 0;
+    island->debugReplacements = 0;
+    island->debugCollisions = 0;
+    island->debugSleeps = 0;
+    island->debugAwakes = 0;
+#endif
+
+    RigidbodyIslandMember *member;
+    for (size_t i = 0; i < island->nbMembers; ++i) {
+        member = &island->members[i];
+        member->moved = dt > 0.0 && _rigidbody_dynamic_tick(scene,
+                                                            member->rb,
+                                                            member->t,
+                                                            &member->collider,
+                                                            r,
+                                                            dt,
+                                                            query,
+                                                            island,
+                                                            NULL);
+    }
+}
+
+void rigidbody_island_flush(Scene *scene, RigidbodyIsland *island, void *callbackData) {
+    RigidbodyIslandEvent *e;
+    for (size_t i = 0; i < island->nbEvents; ++i) {
+        e = &island->events[i];
+        if (e->type == RigidbodyIslandEvent_Push) {
+            rigidbody_apply_push(e->otherRb, &e->value);
+        } else {
+            _rigidbody_fire_reciprocal_callbacks(scene,
+                                                 e->selfRb,
+                                                 e->selfTr,
+                                                 e->otherRb,
+                                                 e->otherTr,
+                                                 e->value,
+                                                 callbackData);
+        }
+    }
+    island->nbEvents = 0;
+
+#if DEBUG_RIGIDBODY_CALLS
+    debug_rigidbody_solver_iterations += island->debugSolverIterations;
+    debug_rigidbody_replacements += island->debugReplacements;
+    debug_rigidbody_collisions += island->debugCollisions;
+    debug_rigidbody_sleeps += island->debugSleeps;
+    debug_rigidbody_awakes += island->debugAwakes;
+#endif
+}
+
 // MARK: - Accessors -
 
 const Box *rigidbody_get_collider(const RigidBody *rb) {
-    return rb->collider;
+    return &rb->collider;
 }
 
 void rigidbody_set_collider(RigidBody *rb, const Box *value, const bool custom) {
-    box_copy(rb->collider, value);
+    box_copy(&rb->collider, value);
     if (_rigidbody_get_simulation_flag_value(rb, SIMULATIONFLAG_MODE) != RigidbodyMode_Disabled) {
         _rigidbody_set_simulation_flag(rb, SIMULATIONFLAG_COLLIDER_DIRTY);
     }
     if (custom) {
         _rigidbody_set_simulation_flag(rb, SIMULATIONFLAG_COLLIDER_CUSTOM_SET);
     }
+    _rigidbody_wake(rb);
 }
 
 RtreeNode *rigidbody_get_rtree_leaf(const RigidBody *rb) {
@@ -1092,27 +1251,30 @@ void rigidbody_set_rtree_leaf(RigidBody *rb, RtreeNode *leaf) {
 }
 
 const float3 *rigidbody_get_motion(const RigidBody *rb) {
-    return rb->motion;
+    return &rb->motion;
 }
 
 void rigidbody_set_motion(RigidBody *rb, const float3 *value) {
-    float3_copy(rb->motion, value);
+    float3_copy(&rb->motion, value);
+    _rigidbody_wake(rb);
 }
 
 const float3 *rigidbody_get_velocity(const RigidBody *rb) {
-    return rb->velocity;
+    return &rb->velocity;
 }
 
 void rigidbody_set_velocity(RigidBody *rb, const float3 *value) {
-    float3_copy(rb->velocity, value);
+    float3_copy(&rb->velocity, value);
+    _rigidbody_wake(rb);
 }
 
 const float3 *rigidbody_get_constant_acceleration(const RigidBody *rb) {
-    return rb->constantAcceleration;
+    return &rb->constantAcceleration;
 }
 
 void rigidbody_set_constant_acceleration(RigidBody *rb, const float3 *value) {
-    float3_copy(rb->constantAcceleration, value);
+    float3_copy(&rb->constantAcceleration, value);
+    _rigidbody_wake(rb);
 }
 
 float rigidbody_get_mass(const RigidBody *rb) {
@@ -1149,6 +1311,7 @@ uint16_t rigidbody_get_groups(const RigidBody *rb) {
 
 void rigidbody_set_groups(RigidBody *rb, uint16_t value) {
     rb->groups = value;
+    _rigidbody_wake(rb);
 }
 
 uint16_t rigidbody_get_collides_with(const RigidBody *rb) {
@@ -1157,6 +1320,7 @@ uint16_t rigidbody_get_collides_with(const RigidBody *rb) {
 
 void rigidbody_set_collides_with(RigidBody *rb, uint16_t value) {
     rb->collidesWith = value;
+    _rigidbody_wake(rb);
 }
 
 uint8_t rigidbody_get_simulation_mode(const RigidBody *rb) {
@@ -1173,6 +1337,7 @@ void rigidbody_set_simulation_mode(RigidBody *rb, const uint8_t value) {
             _rigidbody_set_simulation_flag(rb, SIMULATIONFLAG_COLLIDER_DIRTY);
         }
 #endif
+        _rigidbody_wake(rb);
     }
 }
 
@@ -1186,6 +1351,28 @@ void rigidbody_reset_collider_dirty(RigidBody *rb) {
 
 void rigidbody_set_awake(RigidBody *rb) {
     rb->awakeFlag = PHYSICS_AWAKE_FRAMES;
+
+    // only dynamic rigidbodies may sleep
+    if (rigidbody_is_dynamic(rb)) {
+        _rigidbody_wake(rb);
+    }
+}
+
+Transform *rigidbody_get_transform(const RigidBody *rb) {
+    return rb->transform;
+}
+
+void rigidbody_set_transform(RigidBody *rb, Transform *value) {
+    rb->transform = value;
+    _rigidbody_wake(rb);
+}
+
+uint32_t rigidbody_get_island(const RigidBody *rb) {
+    return rb->island;
+}
+
+void rigidbody_set_island(RigidBody *rb, const uint32_t value) {
+    rb->island = value;
 }
 
 // MARK: - State -
@@ -1223,7 +1410,7 @@ bool rigidbody_is_collider_valid(const RigidBody *rb) {
         return false;
     }
 
-    return box_is_valid(rb->collider, EPSILON_COLLISION);
+    return box_is_valid(&rb->collider, EPSILON_COLLISION);
 }
 
 bool rigidbody_is_enabled(const RigidBody *rb) {
@@ -1274,6 +1461,11 @@ bool rigidbody_is_collider_custom_set(const RigidBody *rb) {
     return rb != NULL && _rigidbody_get_simulation_flag(rb, SIMULATIONFLAG_COLLIDER_CUSTOM_SET);
 }
 
+bool rigidbody_is_idle(const RigidBody *rb) {
+    return rb == NULL || (rb->idle && rigidbody_get_collider_dirty(rb) == false &&
+                          rigidbody_is_active_trigger(rb) == false);
+}
+
 // MARK: - Utils -
 
 /// Returns whether or not the rigidbody can be considered in contact at the start of its movement
@@ -1312,9 +1504,6 @@ bool rigidbody_check_velocity_sleep(RigidBody *rb, const float3 *velocity) {
     if (rb->awakeFlag > 0) {
         rb->awakeFlag--;
         _rigidbody_reset_state(rb);
-#if DEBUG_RIGIDBODY_CALLS
-        debug_rigidbody_awakes++;
-#endif
         return false;
     }
     if (float_isZero(velocity->x, EPSILON_ZERO) == false) {
@@ -1347,6 +1536,7 @@ void rigidbody_toggle_groups(RigidBody *rb, uint16_t groups, bool toggle) {
     } else {
         rb->groups = rb->groups & ~groups;
     }
+    _rigidbody_wake(rb);
 }
 
 void rigidbody_toggle_collides_with(RigidBody *rb, uint16_t groups, bool toggle) {
@@ -1355,6 +1545,7 @@ void rigidbody_toggle_collides_with(RigidBody *rb, uint16_t groups, bool toggle)
     } else {
         rb->collidesWith = rb->collidesWith & ~groups;
     }
+    _rigidbody_wake(rb);
 }
 
 bool rigidbody_collision_mask_match(const uint16_t m1, const uint16_t m2) {
@@ -1404,24 +1595,26 @@ void rigidbody_apply_force_impulse(RigidBody *rb, const float3 *value) {
     // keep it simple: an IMPULSE is like applying immediately one second worth of acceleration from
     // that force
     const float3 v = {value->x / rb->mass, value->y / rb->mass, value->z / rb->mass};
-    float3_op_add(rb->velocity, &v);
+    float3_op_add(&rb->velocity, &v);
+    _rigidbody_wake(rb);
 }
 
 void rigidbody_apply_push(RigidBody *rb, const float3 *value) {
     // a PUSH ensures a given velocity at minimum and is not additive, to emulate the principle of
     // both objects possibly moving already in the same direction
-    if ((value->x > 0 && value->x > rb->velocity->x) ||
-        (value->x < 0 && value->x < rb->velocity->x)) {
-        rb->velocity->x = value->x;
+    if ((value->x > 0 && value->x > rb->velocity.x) ||
+        (value->x < 0 && value->x < rb->velocity.x)) {
+        rb->velocity.x = value->x;
     }
-    if ((value->y > 0 && value->y > rb->velocity->y) ||
-        (value->y < 0 && value->y < rb->velocity->y)) {
-        rb->velocity->y = value->y;
+    if ((value->y > 0 && value->y > rb->velocity.y) ||
+        (value->y < 0 && value->y < rb->velocity.y)) {
+        rb->velocity.y = value->y;
     }
-    if ((value->z > 0 && value->z > rb->velocity->z) ||
-        (value->z < 0 && value->z < rb->velocity->z)) {
-        rb->velocity->z = value->z;
+    if ((value->z > 0 && value->z > rb->velocity.z) ||
+        (value->z < 0 && value->z < rb->velocity.z)) {
+        rb->velocity.z = value->z;
     }
+    _rigidbody_wake(rb);
 }
 
 void rigidbody_broadphase_world_to_model(const Matrix4x4 *invModel,
@@ -1499,6 +1692,7 @@ void rigidbody_toggle_collision_callback(RigidBody *rb, CollisionCallbackType ty
             }
             break;
     }
+    _rigidbody_wake(rb);
 }
 
 // MARK: - Debug -
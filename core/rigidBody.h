@@ -91,6 +91,54 @@ bool rigidbody_tick(Scene *scene,
                     const TICK_DELTA_SEC_T dt,
                     void *callbackData);
 
+/// MARK: - Islands -
+/// A contact island groups the dynamic rigidbodies that may interact w/ each other during a
+/// physics step, distinct islands can then be stepped in parallel (see scene_set_physics_pool)
+
+typedef struct {
+    Transform *t;
+    RigidBody *rb;
+    Box collider; // world collider, kept up-to-date while the island is stepped
+    bool moved;
+    char pad[7];
+} RigidbodyIslandMember;
+
+typedef enum {
+    RigidbodyIslandEvent_Push,
+    RigidbodyIslandEvent_Collision
+} RigidbodyIslandEventType;
+
+typedef struct {
+    Transform *selfTr, *otherTr;
+    RigidBody *selfRb, *otherRb;
+    float3 value; // push velocity, or collision world normal
+    RigidbodyIslandEventType type;
+} RigidbodyIslandEvent;
+
+typedef struct {
+    RigidbodyIslandMember *members; // in hierarchy order
+    RigidbodyIslandEvent *events;   // effects outside of the island, in order of occurrence
+    size_t nbMembers, nbEvents, eventsCapacity;
+    uint32_t id; // non-zero, set on members w/ rigidbody_set_island while stepped
+#if DEBUG_RIGIDBODY_CALLS
+    // counted separately while stepped, added to the frame counters when flushed
+    int debugSolverIterations, debugReplacements, debugCollisions, debugSleeps, debugAwakes;
+#else
+    char pad[4];
+#endif
+} RigidbodyIsland;
+
+/// Steps island members in order, the r-tree is only read: hits against other members use their
+/// up-to-date collider, and pushes to other rigidbodies or collision callbacks are recorded as
+/// events. Does not touch anything outside of the island, it is safe to call from any thread
+void rigidbody_island_tick(Scene *scene,
+                           RigidbodyIsland *island,
+                           Rtree *r,
+                           const TICK_DELTA_SEC_T dt,
+                           RtreeLeaves *query);
+/// Applies recorded events in order, to be called from the thread stepping the scene
+void rigidbody_island_flush(Scene *scene, RigidbodyIsland *island, void *callbackData);
+
 /// MARK: - Accessors -
 const Box *rigidbody_get_collider(const RigidBody *rb);
 void rigidbody_set_collider(RigidBody *rb, const Box *value, const bool custom);
@@ -118,6 +166,11 @@ void rigidbody_set_simulation_mode(RigidBody *rb, const uint8_t value);
 bool rigidbody_get_collider_dirty(const RigidBody *rb);
 void rigidbody_reset_collider_dirty(RigidBody *rb);
 void rigidbody_set_awake(RigidBody *rb);
+Transform *rigidbody_get_transform(const RigidBody *rb);
+/// Any change to the rigidbody wakes up given transform branch, see transform_is_idle_branch
+void rigidbody_set_transform(RigidBody *rb, Transform *value);
+uint32_t rigidbody_get_island(const RigidBody *rb);
+void rigidbody_set_island(RigidBody *rb, const uint32_t value);
 
 /// MARK: - State -
 bool rigidbody_has_contact(const RigidBody *rb, uint8_t value);
@@ -134,6 +187,8 @@ bool rigidbody_is_dynamic(const RigidBody *rb);
 bool rigidbody_is_static(const RigidBody *rb);
 bool rigidbody_uses_per_block_collisions(const RigidBody *rb);
 bool rigidbody_is_collider_custom_set(const RigidBody *rb);
+/// Whether last step had no effect & nothing changed since, eg. sleeping or static rigidbody
+bool rigidbody_is_idle(const RigidBody *rb);
 
 /// MARK: - Utils -
 bool rigidbody_check_velocity_contact(const RigidBody *rb, const float3 *velocity);
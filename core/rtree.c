@@ -7,6 +7,7 @@
 #include "rtree.h"
 
 #include <float.h>
+#include <string.h>
 
 #include "cclog.h"
 #include "config.h"
@@ -21,82 +22,193 @@ static int debug_rtree_condense_calls = 0;
 static int debug_rtree_update_calls = 0;
 #endif
 
+// no node, for the root parent or a leaf not in the tree
+#define RTREE_NODE_NONE UINT32_MAX
+// nodes are allocated in pages, their address doesn't change when the pool grows
+#define RTREE_POOL_PAGE_SHIFT 5
+#define RTREE_POOL_PAGE_SIZE 32
+#define RTREE_POOL_PAGE_MASK 31
+// nodes waiting to be examined by a query, before it has to allocate
+#define RTREE_QUEUE_LOCAL_CAPACITY 64
+
 /// Ref: https://books.google.fr/books?id=1mu099DN9UwC&pg=PR5&redir_esc=y#v=onepage&q&f=false
 struct _Rtree {
+    // nodes pool, addressed by index
+    RtreeNode **pages;
+    // released nodes indices, reused first
+    uint32_t *freeNodes;
+    uint32_t nbNodes, nbPages, pagesCapacity;
+    uint32_t nbFreeNodes, freeNodesCapacity;
+    // leaves currently in the tree
+    uint32_t nbLeaves;
     // root node may change dynamically as the tree is updated
-    RtreeNode *root;
+    uint32_t root;
     // height of the R-tree, it is dynamic
     uint16_t h;
     // minimum number of entries per node, under which a node has to be deleted
     uint8_t m;
     // maximum number of entries per node, over which a node overflows and has to split
     uint8_t M;
-
-    char pad[4];
 };
 
 struct _RtreeNode {
-    // parent is null for the root node
-    RtreeNode *parent;
-    // children is empty for a leaf node
-    DoublyLinkedList *children;
-    // axis-aligned bounding box for this node
-    Box *aabb;
+    // axis-aligned bounding box for this node, valid for a leaf or a branch w/ children
+    Box aabb;
     // a leaf node carries a pointer to the corresponding object
     void *leaf;
+    Rtree *tree;
+    // index of this node in the pool
+    uint32_t index;
+    // parent is RTREE_NODE_NONE for the root node
+    uint32_t parent;
+    // children indices, a node may hold one more child while overflowing, until it is split
+    uint32_t children[RTREE_NODE_MAX_CAPACITY + 1];
     // collision masks may be used to filter out queries,
     uint16_t groups;       // standalone queries may filter w/ groups only (cast functions)
     uint16_t collidesWith; // reciprocal queries may use both masks (collision checks)
-    // children count
+    // children count, 0 for a leaf node
     uint8_t count;
-    // non-leaf node layers need to be refreshed
+    // non-leaf node layers need to be refreshed, ancestors of a dirty node are always dirty
     bool layersDirty;
 
     char pad[2];
 };
 
+typedef struct {
+    uint32_t *items;
+    uint32_t head, tail, capacity;
+    uint32_t local[RTREE_QUEUE_LOCAL_CAPACITY];
+} _RtreeQueue;
+
 // MARK: - Private functions prototypes -
 
 void _rtree_node_assign(RtreeNode *parent, RtreeNode *child, bool merge);
 void _rtree_node_free(RtreeNode *rn);
+void _rtree_insert(Rtree *r, RtreeNode *leaf);
 
 // MARK: - Private functions -
 
+static RtreeNode *_rtree_get_node(const Rtree *r, const uint32_t idx) {
+    return &r->pages[idx >> RTREE_POOL_PAGE_SHIFT][idx & RTREE_POOL_PAGE_MASK];
+}
+
+static RtreeNode *_rtree_node_get_parent(const RtreeNode *rn) {
+    return rn->parent != RTREE_NODE_NONE ? _rtree_get_node(rn->tree, rn->parent) : NULL;
+}
+
+static RtreeNode *_rtree_node_get_child(const RtreeNode *rn, const uint8_t i) {
+    return _rtree_get_node(rn->tree, rn->children[i]);
+}
+
+/// @returns a node from the pool, only its index & tree are set
+static RtreeNode *_rtree_node_alloc(Rtree *r) {
+    uint32_t idx;
+    if (r->nbFreeNodes > 0) {
+        idx = r->freeNodes[--r->nbFreeNodes];
+    } else {
+        if (r->nbNodes == r->nbPages * RTREE_POOL_PAGE_SIZE) {
+            if (r->nbPages == r->pagesCapacity) {
+                const uint32_t capacity = r->pagesCapacity > 0 ? r->pagesCapacity * 2 : 4;
+                RtreeNode **pages = (RtreeNode **)realloc(r->pages, capacity * sizeof(RtreeNode *));
+                if (pages == NULL) {
+                    return NULL;
+                }
+                r->pages = pages;
+                r->pagesCapacity = capacity;
+            }
+            RtreeNode *page = (RtreeNode *)malloc(RTREE_POOL_PAGE_SIZE * sizeof(RtreeNode));
+            if (page == NULL) {
+                return NULL;
+            }
+            r->pages[r->nbPages++] = page;
+        }
+        idx = r->nbNodes++;
+    }
+
+    RtreeNode *rn = _rtree_get_node(r, idx);
+    rn->tree = r;
+    rn->index = idx;
+    return rn;
+}
+
+static void _rtree_queue_init(_RtreeQueue *q) {
+    q->items = q->local;
+    q->head = 0;
+    q->tail = 0;
+    q->capacity = RTREE_QUEUE_LOCAL_CAPACITY;
+}
+
+static void _rtree_queue_push(_RtreeQueue *q, const uint32_t idx) {
+    if (q->tail == q->capacity) {
+        if (q->head > 0) {
+            memmove(q->items, q->items + q->head, (q->tail - q->head) * sizeof(uint32_t));
+            q->tail -= q->head;
+            q->head = 0;
+        } else {
+            const uint32_t capacity = q->capacity * 2;
+            uint32_t *items;
+            if (q->items == q->local) {
+                items = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+                if (items != NULL) {
+                    memcpy(items, q->local, q->tail * sizeof(uint32_t));
+                }
+            } else {
+                items = (uint32_t *)realloc(q->items, capacity * sizeof(uint32_t));
+            }
+            if (items == NULL) {
+                cclog_error("🔥 r-tree: can't grow query queue");
+                return;
+            }
+            q->items = items;
+            q->capacity = capacity;
+        }
+    }
+    q->items[q->tail++] = idx;
+}
+
+static RtreeNode *_rtree_queue_pop(Rtree *r, _RtreeQueue *q) {
+    return q->head < q->tail ? _rtree_get_node(r, q->items[q->head++]) : NULL;
+}
+
+static void _rtree_queue_free(_RtreeQueue *q) {
+    if (q->items != q->local) {
+        free(q->items);
+    }
+}
+
 RtreeNode *_rtree_node_new_root(Rtree *r) {
-    RtreeNode *rn = (RtreeNode *)malloc(sizeof(RtreeNode));
+    RtreeNode *rn = _rtree_node_alloc(r);
     if (rn == NULL) {
         return NULL;
     }
-    rn->parent = NULL;
-    rn->children = doubly_linked_list_new();
-    rn->aabb = NULL;
+    rn->parent = RTREE_NODE_NONE;
     rn->leaf = NULL;
     rn->count = 0;
     rn->groups = PHYSICS_GROUP_ALL_SYSTEM;
     rn->collidesWith = PHYSICS_GROUP_ALL_SYSTEM;
     rn->layersDirty = false;
 
-    if (r->root != NULL) {
-        rtree_recurse(r->root, _rtree_node_free);
+    if (r->root != RTREE_NODE_NONE) {
+        rtree_recurse(_rtree_get_node(r, r->root), _rtree_node_free);
     }
-    r->root = rn;
+    r->root = rn->index;
     r->h++;
 
     return rn;
 }
 
-RtreeNode *_rtree_node_new_leaf(RtreeNode *parent,
+RtreeNode *_rtree_node_new_leaf(Rtree *r,
+                                RtreeNode *parent,
                                 Box *aabb,
                                 uint16_t groups,
                                 uint16_t collidesWith,
                                 void *ptr) {
-    RtreeNode *rn = (RtreeNode *)malloc(sizeof(RtreeNode));
+    RtreeNode *rn = _rtree_node_alloc(r);
     if (rn == NULL) {
         return NULL;
     }
-    rn->parent = parent;
-    rn->children = doubly_linked_list_new();
-    rn->aabb = box_new_copy(aabb);
+    rn->parent = RTREE_NODE_NONE;
+    box_copy(&rn->aabb, aabb);
     rn->leaf = ptr;
     rn->count = 0;
     rn->groups = groups;
@@ -110,14 +222,12 @@ RtreeNode *_rtree_node_new_leaf(RtreeNode *parent,
     return rn;
 }
 
-RtreeNode *_rtree_node_new_branch(RtreeNode *parent, RtreeNode *child) {
-    RtreeNode *rn = (RtreeNode *)malloc(sizeof(RtreeNode));
+RtreeNode *_rtree_node_new_branch(Rtree *r, RtreeNode *parent, RtreeNode *child) {
+    RtreeNode *rn = _rtree_node_alloc(r);
     if (rn == NULL) {
         return NULL;
     }
-    rn->parent = parent;
-    rn->children = doubly_linked_list_new();
-    rn->aabb = NULL;
+    rn->parent = RTREE_NODE_NONE;
     rn->leaf = NULL;
     rn->count = 0;
     rn->groups = PHYSICS_GROUP_ALL_SYSTEM;
@@ -134,12 +244,20 @@ RtreeNode *_rtree_node_new_branch(RtreeNode *parent, RtreeNode *child) {
     return rn;
 }
 
+/// gives the node back to the pool
 void _rtree_node_free(RtreeNode *rn) {
-    doubly_linked_list_free(rn->children);
-    if (rn->aabb != NULL) {
-        box_free(rn->aabb);
+    Rtree *r = rn->tree;
+    if (r->nbFreeNodes == r->freeNodesCapacity) {
+        const uint32_t capacity = r->freeNodesCapacity > 0 ? r->freeNodesCapacity * 2
+                                                           : RTREE_POOL_PAGE_SIZE;
+        uint32_t *freeNodes = (uint32_t *)realloc(r->freeNodes, capacity * sizeof(uint32_t));
+        if (freeNodes == NULL) {
+            return;
+        }
+        r->freeNodes = freeNodes;
+        r->freeNodesCapacity = capacity;
     }
-    free(rn);
+    r->freeNodes[r->nbFreeNodes++] = rn->index;
 }
 
 /// @returns added volume to src box if it would merge w/ insert box
@@ -154,45 +272,50 @@ float _rtree_box_merge_dead_space(const Box *b1, const Box *b2, Box *result) {
     return box_get_volume(result) - box_get_volume(b1) - box_get_volume(b2);
 }
 
+/// flags the path from given node to the root, up to the first node already flagged
+static void _rtree_node_set_layers_dirty(RtreeNode *rn) {
+    while (rn != NULL && rn->layersDirty == false) {
+        rn->layersDirty = true;
+        rn = _rtree_node_get_parent(rn);
+    }
+}
+
 /// @param merge child & parent aabb
 void _rtree_node_assign(RtreeNode *parent, RtreeNode *child, bool merge) {
     // leaves should always stay at height level
     vx_assert(parent->leaf == NULL);
+    vx_assert(parent->count <= RTREE_NODE_MAX_CAPACITY);
 
-    doubly_linked_list_push_first(parent->children, child);
+    // new child goes first
+    memmove(parent->children + 1, parent->children, parent->count * sizeof(uint32_t));
+    parent->children[0] = child->index;
     parent->count++;
-    child->parent = parent;
+    child->parent = parent->index;
 
     if (merge) {
-        if (parent->aabb == NULL) {
-            // this should happen on a previously empty node
-            vx_assert(parent->count == 1);
-
-            parent->aabb = box_new_copy(child->aabb);
+        if (parent->count == 1) {
+            // previously empty node
+            box_copy(&parent->aabb, &child->aabb);
         } else {
-            box_op_merge(parent->aabb, child->aabb, parent->aabb);
+            box_op_merge(&parent->aabb, &child->aabb, &parent->aabb);
         }
-        parent->layersDirty = true;
+        _rtree_node_set_layers_dirty(parent);
     }
 }
 
 /// @returns whether or not child was found & removed, if so, ancestors aabb will need to be
 /// recomputed and the tree may need to be condensed
 bool _rtree_node_remove_child(RtreeNode *parent, RtreeNode *child) {
-    DoublyLinkedListNode *n;
-    RtreeNode *rn;
-
-    n = doubly_linked_list_first(parent->children);
-    while (n != NULL) {
-        rn = (RtreeNode *)doubly_linked_list_node_pointer(n);
-        if (rn == child) {
-            doubly_linked_list_delete_node(parent->children, n);
+    for (uint8_t i = 0; i < parent->count; ++i) {
+        if (parent->children[i] == child->index) {
             parent->count--;
-            child->parent = NULL;
+            memmove(parent->children + i,
+                    parent->children + i + 1,
+                    (size_t)(parent->count - i) * sizeof(uint32_t));
+            child->parent = RTREE_NODE_NONE;
 
             return true;
         }
-        n = doubly_linked_list_node_next(n);
     }
 
     return false;
@@ -202,45 +325,31 @@ void _rtree_node_reset_aabb(RtreeNode *rn) {
     // cannot reset the box of a leaf, it is a collider
     vx_assert(rn->leaf == NULL);
 
-    DoublyLinkedListNode *n = doubly_linked_list_first(rn->children);
-    if (n != NULL) {
-        // aabb is set to match its first child aabb
-        RtreeNode *child = (RtreeNode *)doubly_linked_list_node_pointer(n);
-        box_copy(rn->aabb, child->aabb);
-
-        // merge w/ other children aabb if any
-        n = doubly_linked_list_node_next(n);
-        while (n != NULL) {
-            child = (RtreeNode *)doubly_linked_list_node_pointer(n);
-            box_op_merge(rn->aabb, child->aabb, rn->aabb);
-            n = doubly_linked_list_node_next(n);
+    if (rn->count > 0) {
+        // aabb is set to match its first child aabb, merged w/ other children aabb if any
+        box_copy(&rn->aabb, &_rtree_node_get_child(rn, 0)->aabb);
+        for (uint8_t i = 1; i < rn->count; ++i) {
+            box_op_merge(&rn->aabb, &_rtree_node_get_child(rn, i)->aabb, &rn->aabb);
         }
     } else {
-        // only the tree root can remain w/o children
-        vx_assert(rn->parent == NULL);
-
-        box_free(rn->aabb);
-        rn->aabb = NULL;
+        // only the tree root can remain w/o children, its aabb is then unused
+        vx_assert(rn->parent == RTREE_NODE_NONE);
     }
 }
 
+/// recomputes masks of a dirty node from its children, refreshing dirty children first
 void _rtree_node_reset_collision_masks(RtreeNode *rn) {
-    if (rn->layersDirty) {
-        rn->groups = PHYSICS_GROUP_NONE;
-        rn->collidesWith = PHYSICS_GROUP_NONE;
-
-        DoublyLinkedListNode *n = doubly_linked_list_first(rn->children);
-        RtreeNode *child;
-        while (n != NULL) {
-            child = (RtreeNode *)doubly_linked_list_node_pointer(n);
-            rn->groups |= child->groups;
-            rn->collidesWith |= child->collidesWith;
-            n = doubly_linked_list_node_next(n);
-        }
+    rn->groups = PHYSICS_GROUP_NONE;
+    rn->collidesWith = PHYSICS_GROUP_NONE;
 
-        if (rn->parent != NULL) {
-            rn->parent->layersDirty = true;
+    RtreeNode *child;
+    for (uint8_t i = 0; i < rn->count; ++i) {
+        child = _rtree_node_get_child(rn, i);
+        if (child->layersDirty) {
+            _rtree_node_reset_collision_masks(child);
         }
+        rn->groups |= child->groups;
+        rn->collidesWith |= child->collidesWith;
     }
     rn->layersDirty = false;
 }
@@ -254,14 +363,14 @@ void _rtree_insert_choose_node(Box *aabb,
                                float *selectedRnVol) {
 
     // choose the node w/ minimum volume enlargement
-    const float vol = _rtree_box_expand_volume(rn->aabb, aabb, tmpBox);
+    const float vol = _rtree_box_expand_volume(&rn->aabb, aabb, tmpBox);
     if (vol < *selectedRnVol) {
         *selectedRn = rn;
         *selectedRnVol = vol;
     } else if (float_isEqual(vol, *selectedRnVol, EPSILON_COLLISION)) {
         // tie: choose the node w/ the smallest existing box
-        const float boxVol = box_get_volume(rn->aabb);
-        const float selectedBoxVol = box_get_volume((*selectedRn)->aabb);
+        const float boxVol = box_get_volume(&rn->aabb);
+        const float selectedBoxVol = box_get_volume(&(*selectedRn)->aabb);
         if (boxVol < selectedBoxVol) {
             *selectedRn = rn;
             *selectedRnVol = vol;
@@ -279,7 +388,6 @@ void _rtree_insert_choose_node(Box *aabb,
 /// its ancestors aabb)
 /// @returns parent node which now has an additional child
 RtreeNode *_rtree_split_node_quadratic(Rtree *r, RtreeNode *toSplit) {
-    DoublyLinkedListNode *n1, *n2;
     RtreeNode *rn1, *rn2;
     RtreeNode *seed1 = NULL, *seed2 = NULL;
     float maxVol = -FLT_MAX;
@@ -300,47 +408,42 @@ RtreeNode *_rtree_split_node_quadratic(Rtree *r, RtreeNode *toSplit) {
 
     // quadratic split: we use as seeds the two aabb that if merged create as much dead space as
     // possible
-    n1 = doubly_linked_list_first(toSplit->children);
-    while (n1 != NULL) {
-        rn1 = (RtreeNode *)doubly_linked_list_node_pointer(n1);
-        n2 = doubly_linked_list_node_next(n1);
-        while (n2 != NULL) {
-            rn2 = (RtreeNode *)doubly_linked_list_node_pointer(n2);
-
-            const float vol = _rtree_box_merge_dead_space(rn1->aabb, rn2->aabb, &tmpBox);
+    for (uint8_t i = 0; i < toSplit->count; ++i) {
+        rn1 = _rtree_node_get_child(toSplit, i);
+        for (uint8_t j = i + 1; j < toSplit->count; ++j) {
+            rn2 = _rtree_node_get_child(toSplit, j);
+
+            const float vol = _rtree_box_merge_dead_space(&rn1->aabb, &rn2->aabb, &tmpBox);
             if (vol > maxVol) {
                 seed1 = rn1;
                 seed2 = rn2;
                 maxVol = vol;
             }
-
-            n2 = doubly_linked_list_node_next(n2);
         }
-        n1 = doubly_linked_list_node_next(n1);
     }
     vx_assert(seed1 != NULL && seed2 != NULL);
 
     // selected node is the root: create a new root, increase tree height
-    if (toSplit->parent == NULL) {
-        r->root = NULL;
+    if (toSplit->parent == RTREE_NODE_NONE) {
+        r->root = RTREE_NODE_NONE;
         rn1 = _rtree_node_new_root(r);
         SET_HEIGHT_INCREASED
     }
     // selected node isn't the root: remove it from parent
     else {
-        rn1 = toSplit->parent;
-        _rtree_node_remove_child(toSplit->parent, toSplit);
+        rn1 = _rtree_node_get_parent(toSplit);
+        _rtree_node_remove_child(rn1, toSplit);
         _rtree_node_reset_aabb(rn1);
     }
 
     // create 2 branch nodes w/ each one a seed node
-    RtreeNode *rnSplit1 = _rtree_node_new_branch(rn1, seed1);
-    RtreeNode *rnSplit2 = _rtree_node_new_branch(rn1, seed2);
+    RtreeNode *rnSplit1 = _rtree_node_new_branch(r, rn1, seed1);
+    RtreeNode *rnSplit2 = _rtree_node_new_branch(r, rn1, seed2);
 
     // insert remaining nodes
     uint8_t toInsert = toSplit->count - 2;
-    while (doubly_linked_list_first(toSplit->children) != NULL) {
-        rn1 = (RtreeNode *)doubly_linked_list_pop_first(toSplit->children);
+    for (uint8_t i = 0; i < toSplit->count; ++i) {
+        rn1 = _rtree_node_get_child(toSplit, i);
         if (rn1 != seed1 && rn1 != seed2) {
             // prioritize minimum node size over any other criteria
             if (rnSplit1->count == r->m - toInsert) {
@@ -350,8 +453,8 @@ RtreeNode *_rtree_split_node_quadratic(Rtree *r, RtreeNode *toSplit) {
             } else {
                 // choose optimal insertion node
                 rn2 = rnSplit1;
-                float vol = _rtree_box_expand_volume(rnSplit1->aabb, rn1->aabb, &tmpBox);
-                _rtree_insert_choose_node(rn1->aabb, &tmpBox, rnSplit2, &rn2, &vol);
+                float vol = _rtree_box_expand_volume(&rnSplit1->aabb, &rn1->aabb, &tmpBox);
+                _rtree_insert_choose_node(&rn1->aabb, &tmpBox, rnSplit2, &rn2, &vol);
             }
 
             // assign to chosen node
@@ -360,6 +463,7 @@ RtreeNode *_rtree_split_node_quadratic(Rtree *r, RtreeNode *toSplit) {
             INC_REINSERT_COUNT
         }
     }
+    toSplit->count = 0;
 
     _rtree_node_free(toSplit);
 
@@ -381,47 +485,46 @@ RtreeNode *_rtree_split_node_quadratic(Rtree *r, RtreeNode *toSplit) {
     }
 #endif
 
-    return rnSplit1->parent;
+    return _rtree_node_get_parent(rnSplit1);
 }
 
 RtreeNode *_rtree_find_leaf(RtreeNode *start, Box *aabb, void *ptr, bool check) {
-    FifoList *toExamine = fifo_list_new();
-    DoublyLinkedListNode *n;
+    Rtree *r = start->tree;
+    _RtreeQueue toExamine;
     RtreeNode *rn, *child;
 
+    _rtree_queue_init(&toExamine);
+
     rn = start;
     while (rn != NULL) {
         if (rn->leaf != NULL) {
             if (rn->leaf == ptr) {
+                _rtree_queue_free(&toExamine);
                 return rn;
             }
-            rn = fifo_list_pop(toExamine);
+            rn = _rtree_queue_pop(r, &toExamine);
             continue;
         }
 
-        n = doubly_linked_list_first(rn->children);
-        while (n != NULL) {
-            child = (RtreeNode *)doubly_linked_list_node_pointer(n);
+        for (uint8_t i = 0; i < rn->count; ++i) {
+            child = _rtree_node_get_child(rn, i);
 
             // examine each potential node
-            if (check == false || box_collide_epsilon(child->aabb, aabb, EPSILON_COLLISION)) {
-                fifo_list_push(toExamine, child);
+            if (check == false || box_collide_epsilon(&child->aabb, aabb, EPSILON_COLLISION)) {
+                _rtree_queue_push(&toExamine, child->index);
             }
-
-            n = doubly_linked_list_node_next(n);
         }
 
-        rn = fifo_list_pop(toExamine);
+        rn = _rtree_queue_pop(r, &toExamine);
     }
 
-    fifo_list_free(toExamine, NULL);
+    _rtree_queue_free(&toExamine);
 
     return NULL;
 }
 
 void _rtree_condense(Rtree *r, RtreeNode *start) {
-    FifoList *toRemove = fifo_list_new();
-    DoublyLinkedListNode *n;
+    _RtreeQueue toRemove;
     RtreeNode *rn1, *rn2;
 #if DEBUG_RTREE_EXTRA_LOGS
     uint16_t removalCount = 0, reinsertCount = 0;
@@ -433,16 +536,18 @@ void _rtree_condense(Rtree *r, RtreeNode *start) {
 #define INC_REINSERT_COUNT
 #endif
 
+    _rtree_queue_init(&toRemove);
+
     rn1 = start;
 
     // condense the branch from start to root (excluded)
-    while (rn1->parent != NULL) {
-        rn2 = rn1->parent;
+    while (rn1->parent != RTREE_NODE_NONE) {
+        rn2 = _rtree_node_get_parent(rn1);
 
         // node is under capacity, select it for removal
         if (rn1->count < r->m) {
-            _rtree_node_remove_child(rn1->parent, rn1);
-            fifo_list_push(toRemove, rn1);
+            _rtree_node_remove_child(rn2, rn1);
+            _rtree_queue_push(&toRemove, rn1->index);
             INC_REMOVAL_COUNT
         }
         // or update aabb, made dirty by removal down the tree
@@ -454,31 +559,28 @@ void _rtree_condense(Rtree *r, RtreeNode *start) {
     }
 
     // update root box
-    _rtree_node_reset_aabb(r->root);
+    _rtree_node_reset_aabb(_rtree_get_node(r, r->root));
 
     // reinsert all the leaves amongst the children of nodes selected for removal
-    rn1 = fifo_list_pop(toRemove);
+    rn1 = _rtree_queue_pop(r, &toRemove);
     while (rn1 != NULL) {
-        n = doubly_linked_list_first(rn1->children);
-        while (n != NULL) {
-            rn2 = (RtreeNode *)doubly_linked_list_node_pointer(n);
+        for (uint8_t i = 0; i < rn1->count; ++i) {
+            rn2 = _rtree_node_get_child(rn1, i);
 
             if (rn2->leaf != NULL) {
-                rtree_insert(r, rn2);
+                _rtree_insert(r, rn2);
                 INC_REINSERT_COUNT
             } else {
-                fifo_list_push(toRemove, rn2);
+                _rtree_queue_push(&toRemove, rn2->index);
                 INC_REMOVAL_COUNT
             }
-
-            n = doubly_linked_list_node_next(n);
         }
 
         _rtree_node_free(rn1);
-        rn1 = fifo_list_pop(toRemove);
+        rn1 = _rtree_queue_pop(r, &toRemove);
     }
 
-    fifo_list_free(toRemove, NULL);
+    _rtree_queue_free(&toRemove);
 
 #if DEBUG_RTREE_CALLS
     debug_rtree_condense_calls++;
@@ -495,22 +597,40 @@ void _rtree_condense(Rtree *r, RtreeNode *start) {
 // MARK: - Public functions -
 
 Rtree *rtree_new(uint8_t m, uint8_t M) {
+    // children are stored inline, up to max capacity
+    vx_assert(M <= RTREE_NODE_MAX_CAPACITY);
+
     Rtree *r = (Rtree *)malloc(sizeof(Rtree));
     if (r == NULL) {
         return NULL;
     }
-    r->root = NULL;
+    r->pages = NULL;
+    r->freeNodes = NULL;
+    r->nbNodes = 0;
+    r->nbPages = 0;
+    r->pagesCapacity = 0;
+    r->nbFreeNodes = 0;
+    r->freeNodesCapacity = 0;
+    r->nbLeaves = 0;
+    r->root = RTREE_NODE_NONE;
     r->h = 0;
     r->m = m;
     r->M = M;
 
-    _rtree_node_new_root(r);
+    if (_rtree_node_new_root(r) == NULL) {
+        free(r);
+        return NULL;
+    }
 
     return r;
 }
 
 void rtree_free(Rtree *r) {
-    rtree_recurse(r->root, _rtree_node_free);
+    for (uint32_t i = 0; i < r->nbPages; ++i) {
+        free(r->pages[i]);
+    }
+    free(r->pages);
+    free(r->freeNodes);
     free(r);
 }
 
@@ -519,21 +639,136 @@ uint16_t rtree_get_height(const Rtree *r) {
 }
 
 RtreeNode *rtree_get_root(const Rtree *r) {
-    return r->root;
+    return _rtree_get_node(r, r->root);
+}
+
+size_t rtree_get_nb_leaves(const Rtree *r) {
+    return r->nbLeaves;
+}
+
+// MARK: Query results
+
+/// grows an array that may be using its local storage, returns new items pointer or NULL
+static void *_rtree_array_grow(void *items,
+                               const void *local,
+                               const size_t count,
+                               size_t *capacity,
+                               const size_t itemSize) {
+    const size_t newCapacity = *capacity > 0 ? *capacity * 2 : RTREE_QUEUE_LOCAL_CAPACITY;
+    void *newItems;
+    if (items == local) {
+        newItems = malloc(newCapacity * itemSize);
+        if (newItems != NULL && count > 0) {
+            memcpy(newItems, local, count * itemSize);
+        }
+    } else {
+        newItems = realloc(items, newCapacity * itemSize);
+    }
+    if (newItems == NULL) {
+        cclog_error("🔥 r-tree: can't grow query results");
+        return NULL;
+    }
+    *capacity = newCapacity;
+    return newItems;
+}
+
+void rtree_leaves_init(RtreeLeaves *l, RtreeNode **local, size_t capacity) {
+    l->items = local;
+    l->local = local;
+    l->count = 0;
+    l->capacity = local != NULL ? capacity : 0;
+}
+
+void rtree_leaves_reset(RtreeLeaves *l) {
+    l->count = 0;
+}
+
+bool rtree_leaves_push(RtreeLeaves *l, RtreeNode *leaf) {
+    if (l->count == l->capacity) {
+        RtreeNode **items = (RtreeNode **)_rtree_array_grow(l->items,
+                                                            l->local,
+                                                            l->count,
+                                                            &l->capacity,
+                                                            sizeof(RtreeNode *));
+        if (items == NULL) {
+            return false;
+        }
+        l->items = items;
+    }
+    l->items[l->count++] = leaf;
+    return true;
+}
+
+void rtree_leaves_free(RtreeLeaves *l) {
+    if (l->items != l->local) {
+        free(l->items);
+    }
+    l->items = NULL;
+    l->count = 0;
+    l->capacity = 0;
+}
+
+void rtree_cast_results_init(RtreeCastResults *cr, RtreeCastResult *local, size_t capacity) {
+    cr->items = local;
+    cr->local = local;
+    cr->count = 0;
+    cr->capacity = local != NULL ? capacity : 0;
+}
+
+bool rtree_cast_results_push(RtreeCastResults *cr, RtreeNode *leaf, float distance) {
+    if (cr->count == cr->capacity) {
+        RtreeCastResult *items = (RtreeCastResult *)_rtree_array_grow(cr->items,
+                                                                      cr->local,
+                                                                      cr->count,
+                                                                      &cr->capacity,
+                                                                      sizeof(RtreeCastResult));
+        if (items == NULL) {
+            return false;
+        }
+        cr->items = items;
+    }
+    RtreeCastResult *result = &cr->items[cr->count++];
+    result->rtreeLeaf = leaf;
+    result->distance = distance;
+    return true;
+}
+
+void rtree_cast_results_sort(RtreeCastResults *cr) {
+    // insertion sort, results are few and mostly ordered already
+    RtreeCastResult tmp;
+    size_t j;
+    for (size_t i = 1; i < cr->count; ++i) {
+        tmp = cr->items[i];
+        j = i;
+        while (j > 0 && cr->items[j - 1].distance > tmp.distance) {
+            cr->items[j] = cr->items[j - 1];
+            --j;
+        }
+        cr->items[j] = tmp;
+    }
+}
+
+void rtree_cast_results_free(RtreeCastResults *cr) {
+    if (cr->items != cr->local) {
+        free(cr->items);
+    }
+    cr->items = NULL;
+    cr->count = 0;
+    cr->capacity = 0;
 }
 
 // MARK: Nodes
 
 Box *rtree_node_get_aabb(const RtreeNode *rn) {
-    return rn->aabb;
+    return rn->leaf != NULL || rn->count > 0 ? (Box *)&rn->aabb : NULL;
 }
 
 uint8_t rtree_node_get_children_count(const RtreeNode *rn) {
     return rn->count;
 }
 
-DoublyLinkedListNode *rtree_node_get_children_iterator(const RtreeNode *rn) {
-    return doubly_linked_list_first(rn->children);
+RtreeNode *rtree_node_get_child(const RtreeNode *rn, const uint8_t i) {
+    return i < rn->count ? _rtree_node_get_child(rn, i) : NULL;
 }
 
 void *rtree_node_get_leaf_ptr(const RtreeNode *rn) {
@@ -541,7 +776,7 @@ void *rtree_node_get_leaf_ptr(const RtreeNode *rn) {
 }
 
 bool rtree_node_is_leaf(const RtreeNode *rn) {
-    return rn != NULL && rn->parent != NULL && rn->leaf != NULL && rn->aabb != NULL;
+    return rn != NULL && rn->parent != RTREE_NODE_NONE && rn->leaf != NULL;
 }
 
 uint16_t rtree_node_get_groups(const RtreeNode *rn) {
@@ -560,26 +795,22 @@ void rtree_node_set_collision_masks(RtreeNode *leaf,
 
     leaf->groups = groups;
     leaf->collidesWith = collidesWith;
-    leaf->parent->layersDirty = true;
+    _rtree_node_set_layers_dirty(_rtree_node_get_parent(leaf));
 }
 
 /// MARK: Operations
 
 // NOTE: rtree_recurse is always "deep first"
 void rtree_recurse(RtreeNode *rn, pointer_rtree_recurse_func f) {
-    DoublyLinkedListNode *n = doubly_linked_list_first(rn->children);
-    RtreeNode *child = NULL;
-    while (n != NULL) {
-        child = (RtreeNode *)doubly_linked_list_node_pointer(n);
-        rtree_recurse(child, f);
-        n = doubly_linked_list_node_next(n);
+    for (uint8_t i = 0; i < rn->count; ++i) {
+        rtree_recurse(_rtree_node_get_child(rn, i), f);
     }
     f(rn); // free parent
 }
 
-void rtree_insert(Rtree *r, RtreeNode *leaf) {
+/// inserts a leaf w/o counting it, for leaves already counted in the tree
+void _rtree_insert(Rtree *r, RtreeNode *leaf) {
     RtreeNode *rn, *selectedNode;
-    DoublyLinkedListNode *n;
     float selectedNodeVol;
     Box tmpBox;
     uint16_t level;
@@ -596,26 +827,26 @@ void rtree_insert(Rtree *r, RtreeNode *leaf) {
 #endif
 
     // we should only be inserting a leaf (no parent yet)
-    vx_assert(leaf->leaf != NULL && leaf->aabb != NULL);
+    vx_assert(leaf->leaf != NULL);
 
-    selectedNode = r->root;
+    selectedNode = _rtree_get_node(r, r->root);
     level = 1;
 
     // traverse the tree to select an appropriate leaf
     while (level < r->h) {
         // all leaves are at the same tree height level because the tree height changes only from
         // the root, therefore there cannot be a node w/o children at an intermediate level
-        vx_assert(selectedNode->parent == NULL || selectedNode->count > 0);
+        vx_assert(selectedNode->parent == RTREE_NODE_NONE || selectedNode->count > 0);
 
         selectedNodeVol = FLT_MAX;
 
-        n = doubly_linked_list_first(selectedNode->children);
-        while (n != NULL) {
-            rn = (RtreeNode *)doubly_linked_list_node_pointer(n);
-
-            _rtree_insert_choose_node(leaf->aabb, &tmpBox, rn, &selectedNode, &selectedNodeVol);
-
-            n = doubly_linked_list_node_next(n);
+        rn = selectedNode;
+        for (uint8_t i = 0; i < rn->count; ++i) {
+            _rtree_insert_choose_node(&leaf->aabb,
+                                      &tmpBox,
+                                      _rtree_node_get_child(rn, i),
+                                      &selectedNode,
+                                      &selectedNodeVol);
         }
 
         level++;
@@ -630,10 +861,10 @@ void rtree_insert(Rtree *r, RtreeNode *leaf) {
 
     // a) selected node is not full: simply propagate aabb update upwards
     if (selectedNode->count <= r->M) {
-        rn = selectedNode->parent;
+        rn = _rtree_node_get_parent(selectedNode);
         while (rn != NULL) {
-            box_op_merge(rn->aabb, leaf->aabb, rn->aabb);
-            rn = rn->parent;
+            box_op_merge(&rn->aabb, &leaf->aabb, &rn->aabb);
+            rn = _rtree_node_get_parent(rn);
             INC_BOX_MERGE_COUNT
         }
     }
@@ -651,7 +882,7 @@ void rtree_insert(Rtree *r, RtreeNode *leaf) {
             } else {
                 _rtree_node_reset_aabb(rn);
                 INC_BOX_RESET_COUNT
-                rn = rn->parent;
+                rn = _rtree_node_get_parent(rn);
             }
         }
     }
@@ -667,13 +898,28 @@ void rtree_insert(Rtree *r, RtreeNode *leaf) {
 #endif
 }
 
+void rtree_insert(Rtree *r, RtreeNode *leaf) {
+    _rtree_insert(r, leaf);
+    r->nbLeaves++;
+}
+
+RtreeNode *rtree_create_leaf(Rtree *r,
+                             Box *aabb,
+                             uint16_t groups,
+                             uint16_t collidesWith,
+                             void *ptr) {
+    return _rtree_node_new_leaf(r, NULL, aabb, groups, collidesWith, ptr);
+}
+
 RtreeNode *rtree_create_and_insert(Rtree *r,
                                    Box *aabb,
                                    uint16_t groups,
                                    uint16_t collidesWith,
                                    void *ptr) {
-    RtreeNode *newLeaf = _rtree_node_new_leaf(NULL, aabb, groups, collidesWith, ptr);
-    rtree_insert(r, newLeaf);
+    RtreeNode *newLeaf = _rtree_node_new_leaf(r, NULL, aabb, groups, collidesWith, ptr);
+    if (newLeaf != NULL) {
+        rtree_insert(r, newLeaf);
+    }
     return newLeaf;
 }
 
@@ -689,18 +935,20 @@ void rtree_remove(Rtree *r, RtreeNode *leaf, bool freeLeaf) {
     // we should only be removing a leaf already attached to the tree
     vx_assert(rtree_node_is_leaf(leaf));
 
-    RtreeNode *parent = leaf->parent;
+    RtreeNode *parent = _rtree_node_get_parent(leaf);
     if (_rtree_node_remove_child(parent, leaf)) {
+        r->nbLeaves--;
         if (freeLeaf) {
             _rtree_node_free(leaf);
         }
         _rtree_condense(r, parent);
 
         // reduce height if root has only one non-leaf child
-        if (r->root->count == 1 && r->h >= 2) {
-            r->root = (RtreeNode *)doubly_linked_list_pop_first(r->root->children);
-            _rtree_node_free(r->root->parent);
-            r->root->parent = NULL;
+        RtreeNode *root = _rtree_get_node(r, r->root);
+        if (root->count == 1 && r->h >= 2) {
+            r->root = root->children[0];
+            _rtree_node_free(root);
+            _rtree_get_node(r, r->root)->parent = RTREE_NODE_NONE;
             r->h--;
             SET_HEIGHT_DECREASED
         }
@@ -719,9 +967,9 @@ void rtree_remove(Rtree *r, RtreeNode *leaf, bool freeLeaf) {
 }
 
 void rtree_find_and_remove(Rtree *r, Box *aabb, void *ptr) {
-    RtreeNode *leaf = _rtree_find_leaf(r->root, aabb, ptr, false);
+    RtreeNode *leaf = _rtree_find_leaf(_rtree_get_node(r, r->root), aabb, ptr, false);
     if (leaf != NULL) {
-        vx_assert(leaf != r->root); // cannot happen (for code analyzer)
+        vx_assert(leaf->index != r->root); // cannot happen (for code analyzer)
         rtree_remove(r, leaf, true);
     }
 #if DEBUG_RTREE_EXTRA_LOGS
@@ -733,67 +981,244 @@ void rtree_find_and_remove(Rtree *r, Box *aabb, void *ptr) {
 
 void rtree_update(Rtree *r, RtreeNode *leaf, Box *aabb) {
     Box tmpBox;
-    DoublyLinkedListNode *n;
-    RtreeNode *child;
+    RtreeNode *parent = _rtree_node_get_parent(leaf);
 
     // simulate node volume w/ updated leaf aabb
     box_copy(&tmpBox, aabb);
-    n = doubly_linked_list_first(leaf->parent->children);
-    while (n != NULL) {
-        child = (RtreeNode *)doubly_linked_list_node_pointer(n);
-        if (child != leaf) {
-            box_op_merge(&tmpBox, child->aabb, &tmpBox);
+    for (uint8_t i = 0; i < parent->count; ++i) {
+        if (parent->children[i] != leaf->index) {
+            box_op_merge(&tmpBox, &_rtree_node_get_child(parent, i)->aabb, &tmpBox);
         }
-        n = doubly_linked_list_node_next(n);
     }
     const float vol = box_get_volume(&tmpBox);
 
     // if volume difference is within threshold, keep leaf in place
-    if (fabsf(vol - box_get_volume(leaf->parent->aabb)) < RTREE_LEAF_UPDATE_THRESHOLD) {
-        box_copy(leaf->aabb, aabb);
-        box_copy(leaf->parent->aabb, &tmpBox);
+    if (fabsf(vol - box_get_volume(&parent->aabb)) < RTREE_LEAF_UPDATE_THRESHOLD) {
+        box_copy(&leaf->aabb, aabb);
+        box_copy(&parent->aabb, &tmpBox);
 
         // propagate aabb update upwards
-        RtreeNode *rn = leaf->parent->parent;
+        RtreeNode *rn = _rtree_node_get_parent(parent);
         while (rn != NULL) {
             _rtree_node_reset_aabb(rn);
-            rn = rn->parent;
+            rn = _rtree_node_get_parent(rn);
         }
 #if DEBUG_RTREE_CALLS
         debug_rtree_update_calls++;
 #endif
     } else {
         rtree_remove(r, leaf, false);
-        box_copy(leaf->aabb, aabb);
+        box_copy(&leaf->aabb, aabb);
         rtree_insert(r, leaf);
     }
 }
 
 void rtree_refresh_collision_masks(Rtree *r) {
-    rtree_recurse(r->root, _rtree_node_reset_collision_masks);
+    // only dirty paths are refreshed, from changed leaves parents up to the root
+    RtreeNode *root = _rtree_get_node(r, r->root);
+    if (root->layersDirty) {
+        _rtree_node_reset_collision_masks(root);
+    }
 }
 
-// MARK: Queries
+// MARK: Bulk loading
 
-size_t rtree_query_overlap_func(Rtree *r,
-                                uint16_t groups,
-                                uint16_t collidesWith,
-                                pointer_rtree_query_overlap_func func,
-                                void *ptr,
-                                const DoublyLinkedList *excludeLeafPtrs,
-                                FifoList *results,
-                                const float3 *epsilon) {
+static int _rtree_str_compare(const float c1, const float c2) {
+    return c1 < c2 ? -1 : (c1 > c2 ? 1 : 0);
+}
+
+/// compares nodes centers along x, centers are doubled since only their order matters
+static int _rtree_str_compare_x(const void *a, const void *b) {
+    const RtreeNode *rn1 = *(RtreeNode *const *)a;
+    const RtreeNode *rn2 = *(RtreeNode *const *)b;
+    return _rtree_str_compare(rn1->aabb.min.x + rn1->aabb.max.x, rn2->aabb.min.x + rn2->aabb.max.x);
+}
 
-    FifoList *toExamine = fifo_list_new();
-    DoublyLinkedListNode *n;
+static int _rtree_str_compare_y(const void *a, const void *b) {
+    const RtreeNode *rn1 = *(RtreeNode *const *)a;
+    const RtreeNode *rn2 = *(RtreeNode *const *)b;
+    return _rtree_str_compare(rn1->aabb.min.y + rn1->aabb.max.y, rn2->aabb.min.y + rn2->aabb.max.y);
+}
+
+static int _rtree_str_compare_z(const void *a, const void *b) {
+    const RtreeNode *rn1 = *(RtreeNode *const *)a;
+    const RtreeNode *rn2 = *(RtreeNode *const *)b;
+    return _rtree_str_compare(rn1->aabb.min.z + rn1->aabb.max.z, rn2->aabb.min.z + rn2->aabb.max.z);
+}
+
+/// Sort-Tile-Recursive order: nodes are sorted along x & cut into S slabs, each slab is sorted
+/// along y & cut into S strips, each strip is sorted along z. With S the cube root of the number
+/// of parents needed, consecutive runs of M nodes are then tiles of space
+static void _rtree_str_sort(RtreeNode **nodes, const size_t n, const uint8_t M) {
+    const size_t nbParents = (n + M - 1) / M;
+    const size_t S = (size_t)ceil(cbrt((double)nbParents));
+    const size_t stripSize = S * M;
+    const size_t slabSize = S * stripSize;
+
+    qsort(nodes, n, sizeof(RtreeNode *), _rtree_str_compare_x);
+    for (size_t i = 0; i < n; i += slabSize) {
+        const size_t slabCount = minimum(slabSize, n - i);
+        qsort(nodes + i, slabCount, sizeof(RtreeNode *), _rtree_str_compare_y);
+        for (size_t j = 0; j < slabCount; j += stripSize) {
+            qsort(nodes + i + j,
+                  minimum(stripSize, slabCount - j),
+                  sizeof(RtreeNode *),
+                  _rtree_str_compare_z);
+        }
+    }
+}
+
+/// packs runs of M sorted nodes into new branches, written back at the beginning of the array,
+/// the last branch takes a few nodes from the one before if needed to reach minimum capacity
+/// @returns number of branches, or 0 if out of memory
+static size_t _rtree_str_pack(Rtree *r, RtreeNode **nodes, const size_t n) {
+    const size_t nbParents = (n + r->M - 1) / r->M;
+    const size_t lastCount = n - (nbParents - 1) * r->M;
+    const size_t shift = lastCount < r->m ? r->m - lastCount : 0;
+
+    // there are at least two branches, a node can give away nodes & stay above min capacity
+    vx_assert(nbParents >= 2 && r->M - shift >= r->m);
+
+    RtreeNode *parent;
+    size_t start = 0, count;
+    for (size_t i = 0; i < nbParents; ++i) {
+        if (i == nbParents - 1) {
+            count = lastCount + shift;
+        } else if (i == nbParents - 2) {
+            count = r->M - shift;
+        } else {
+            count = r->M;
+        }
+
+        parent = _rtree_node_new_branch(r, NULL, NULL);
+        if (parent == NULL) {
+            return 0;
+        }
+        for (size_t j = start; j < start + count; ++j) {
+            _rtree_node_assign(parent, nodes[j], true);
+        }
+        nodes[i] = parent;
+        start += count;
+    }
+    return nbParents;
+}
+
+/// moves leaves under given node to the array, and gives its branches back to the pool
+static void _rtree_node_collect_leaves(RtreeNode *rn, RtreeNode **leaves, size_t *count) {
+    RtreeNode *child;
+    for (uint8_t i = 0; i < rn->count; ++i) {
+        child = _rtree_node_get_child(rn, i);
+        if (child->leaf != NULL) {
+            child->parent = RTREE_NODE_NONE;
+            leaves[(*count)++] = child;
+        } else {
+            _rtree_node_collect_leaves(child, leaves, count);
+            _rtree_node_free(child);
+        }
+    }
+    rn->count = 0;
+}
+
+/// rebuilds the whole tree bottom-up from its leaves & given new leaves, branches are full except
+/// for the last ones of each level, their masks are computed on next refresh
+static bool _rtree_str_load(Rtree *r, RtreeNode **leaves, const size_t n) {
+    // packing nodes to full capacity must leave enough nodes for the last node of each level
+    vx_assert(r->m * 2 <= r->M);
+
+    const size_t total = r->nbLeaves + n;
+    if (total == 0) {
+        return true;
+    }
+
+    RtreeNode **nodes = (RtreeNode **)malloc(total * sizeof(RtreeNode *));
+    if (nodes == NULL) {
+        // tree is unchanged, new leaves can still be inserted one by one
+        cclog_error("🔥 r-tree: can't bulk-load, inserting leaves one by one");
+        for (size_t i = 0; i < n; ++i) {
+            rtree_insert(r, leaves[i]);
+        }
+        return false;
+    }
+    RtreeNode *root = _rtree_get_node(r, r->root);
+    size_t count = n;
+    if (n > 0) {
+        memcpy(nodes, leaves, n * sizeof(RtreeNode *));
+    }
+    _rtree_node_collect_leaves(root, nodes, &count);
+    vx_assert(count == total);
+
+    // pack each level into the next one up, until all nodes fit in the root
+    uint16_t h = 1;
+    while (count > r->M) {
+        _rtree_str_sort(nodes, count, r->M);
+        count = _rtree_str_pack(r, nodes, count);
+        if (count == 0) {
+            cclog_error("🔥 r-tree: can't allocate bulk-loaded nodes");
+            free(nodes);
+            return false;
+        }
+        ++h;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        _rtree_node_assign(root, nodes[i], true);
+    }
+    r->h = h;
+    r->nbLeaves = (uint32_t)total;
+
+    free(nodes);
+    return true;
+}
+
+bool rtree_bulk_load(Rtree *r, RtreeNode **leaves, size_t n) {
+    if (n == 0) {
+        return true;
+    }
+
+    // a batch as large as the tree rebuilds it entirely
+    if (n >= r->nbLeaves) {
+        return _rtree_str_load(r, leaves, n);
+    }
+
+    // otherwise, leaves are inserted one by one in STR order, for spatially coherent insertions
+    RtreeNode **sorted = (RtreeNode **)malloc(n * sizeof(RtreeNode *));
+    if (sorted != NULL) {
+        memcpy(sorted, leaves, n * sizeof(RtreeNode *));
+        _rtree_str_sort(sorted, n, r->M);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        rtree_insert(r, sorted != NULL ? sorted[i] : leaves[i]);
+    }
+    free(sorted);
+    return true;
+}
+
+bool rtree_rebuild(Rtree *r) {
+    return _rtree_str_load(r, NULL, 0);
+}
+
+// MARK: Queries
+
+/// fills either 'results' list or 'leaves' array if not NULL
+static size_t _rtree_query_overlap(Rtree *r,
+                                   uint16_t groups,
+                                   uint16_t collidesWith,
+                                   pointer_rtree_query_overlap_func func,
+                                   void *ptr,
+                                   const DoublyLinkedList *excludeLeafPtrs,
+                                   FifoList *results,
+                                   RtreeLeaves *leaves,
+                                   const float3 *epsilon) {
+
+    _RtreeQueue toExamine;
     RtreeNode *rn, *child;
     size_t hits = 0;
 
-    rn = r->root;
+    _rtree_queue_init(&toExamine);
+
+    rn = _rtree_get_node(r, r->root);
     while (rn != NULL) {
-        n = doubly_linked_list_first(rn->children);
-        while (n != NULL) {
-            child = (RtreeNode *)doubly_linked_list_node_pointer(n);
+        for (uint8_t i = 0; i < rn->count; ++i) {
+            child = _rtree_node_get_child(rn, i);
 
             if (rigidbody_collision_masks_reciprocal_match(child->groups,
                                                            child->collidesWith,
@@ -802,29 +1227,49 @@ size_t rtree_query_overlap_func(Rtree *r,
                 func(child, ptr, epsilon)) {
 
                 if (child->leaf == NULL) {
-                    fifo_list_push(toExamine, child);
+                    _rtree_queue_push(&toExamine, child->index);
                 } else if (excludeLeafPtrs == NULL ||
                            doubly_linked_list_contains(excludeLeafPtrs, child->leaf) == false) {
 
                     if (results != NULL) {
                         fifo_list_push(results, child);
+                    } else if (leaves != NULL) {
+                        rtree_leaves_push(leaves, child);
                     }
                     hits++;
                 }
             }
-
-            n = doubly_linked_list_node_next(n);
         }
-        rn = (RtreeNode *)fifo_list_pop(toExamine);
+        rn = _rtree_queue_pop(r, &toExamine);
     }
 
-    fifo_list_free(toExamine, NULL);
+    _rtree_queue_free(&toExamine);
 
     return hits;
 }
 
+size_t rtree_query_overlap_func(Rtree *r,
+                                uint16_t groups,
+                                uint16_t collidesWith,
+                                pointer_rtree_query_overlap_func func,
+                                void *ptr,
+                                const DoublyLinkedList *excludeLeafPtrs,
+                                FifoList *results,
+                                const float3 *epsilon) {
+
+    return _rtree_query_overlap(r,
+                                groups,
+                                collidesWith,
+                                func,
+                                ptr,
+                                excludeLeafPtrs,
+                                results,
+                                NULL,
+                                epsilon);
+}
+
 bool _rtree_query_overlap_box_func(RtreeNode *rn, void *ptr, const float3 *epsilon) {
-    return box_collide_epsilon3(rn->aabb, (Box *)ptr, epsilon);
+    return box_collide_epsilon3(&rn->aabb, (Box *)ptr, epsilon);
 }
 
 size_t rtree_query_overlap_box(Rtree *r,
@@ -845,6 +1290,25 @@ size_t rtree_query_overlap_box(Rtree *r,
                                     epsilon);
 }
 
+size_t rtree_query_overlap_box_leaves(Rtree *r,
+                                      const Box *aabb,
+                                      uint16_t groups,
+                                      uint16_t collidesWith,
+                                      const DoublyLinkedList *excludeLeafPtrs,
+                                      RtreeLeaves *results,
+                                      const float3 *epsilon) {
+
+    return _rtree_query_overlap(r,
+                                groups,
+                                collidesWith,
+                                _rtree_query_overlap_box_func,
+                                (void *)aabb,
+                                excludeLeafPtrs,
+                                NULL,
+                                results,
+                                epsilon);
+}
+
 size_t rtree_query_cast_all_func(Rtree *r,
                                  uint16_t groups,
                                  uint16_t collidesWith,
@@ -854,18 +1318,18 @@ size_t rtree_query_cast_all_func(Rtree *r,
                                  DoublyLinkedList *results) {
     vx_assert(results != NULL);
 
-    FifoList *toExamine = fifo_list_new();
-    DoublyLinkedListNode *n;
+    _RtreeQueue toExamine;
     RtreeNode *rn, *child;
     size_t hits = 0;
     float dist;
     RtreeCastResult *result;
 
-    rn = r->root;
+    _rtree_queue_init(&toExamine);
+
+    rn = _rtree_get_node(r, r->root);
     while (rn != NULL) {
-        n = doubly_linked_list_first(rn->children);
-        while (n != NULL) {
-            child = (RtreeNode *)doubly_linked_list_node_pointer(n);
+        for (uint8_t i = 0; i < rn->count; ++i) {
+            child = _rtree_node_get_child(rn, i);
 
             if (rigidbody_collision_masks_reciprocal_match(child->groups,
                                                            child->collidesWith,
@@ -874,7 +1338,7 @@ size_t rtree_query_cast_all_func(Rtree *r,
                 func(child, ptr, &dist)) {
 
                 if (child->leaf == NULL) {
-                    fifo_list_push(toExamine, child);
+                    _rtree_queue_push(&toExamine, child->index);
                 } else if (excludeLeafPtrs == NULL ||
                            doubly_linked_list_contains(excludeLeafPtrs, child->leaf) == false) {
 
@@ -887,19 +1351,17 @@ size_t rtree_query_cast_all_func(Rtree *r,
                     }
                 }
             }
-
-            n = doubly_linked_list_node_next(n);
         }
-        rn = (RtreeNode *)fifo_list_pop(toExamine);
+        rn = _rtree_queue_pop(r, &toExamine);
     }
 
-    fifo_list_free(toExamine, NULL);
+    _rtree_queue_free(&toExamine);
 
     return hits;
 }
 
 bool _rtree_query_cast_ray_all_func(RtreeNode *rn, void *ptr, float *distance) {
-    return ray_intersect_with_box((Ray *)ptr, &rn->aabb->min, &rn->aabb->max, distance);
+    return ray_intersect_with_box((Ray *)ptr, &rn->aabb.min, &rn->aabb.max, distance);
 }
 
 size_t rtree_query_cast_all_ray(Rtree *r,
@@ -918,6 +1380,104 @@ size_t rtree_query_cast_all_ray(Rtree *r,
                                      results);
 }
 
+typedef struct {
+    const Ray *const *rays;
+    float *maxDistances;
+    pointer_rtree_query_cast_rays_func func;
+    void *ptr;
+    const DoublyLinkedList *excludeLeafPtrs;
+    uint16_t groups, collidesWith;
+    uint8_t nbRays;
+
+    char pad[3];
+} _RtreeRaysQuery;
+
+/// 'active' lists the rays of the packet reaching given node, recursion depth is tree height
+static size_t _rtree_query_cast_rays_node(const RtreeNode *rn,
+                                          const uint8_t *active,
+                                          const uint8_t nbActive,
+                                          const _RtreeRaysQuery *q) {
+    uint8_t childActive[RTREE_RAYS_PACKET_SIZE];
+    uint8_t nbChildActive;
+    RtreeNode *child;
+    size_t hits = 0;
+    float dist;
+
+    for (uint8_t i = 0; i < rn->count; ++i) {
+        child = _rtree_node_get_child(rn, i);
+
+        if (rigidbody_collision_masks_reciprocal_match(child->groups,
+                                                       child->collidesWith,
+                                                       q->groups,
+                                                       q->collidesWith) == false) {
+            continue;
+        }
+        if (child->leaf != NULL && q->excludeLeafPtrs != NULL &&
+            doubly_linked_list_contains(q->excludeLeafPtrs, child->leaf)) {
+            continue;
+        }
+
+        nbChildActive = 0;
+        for (uint8_t j = 0; j < nbActive; ++j) {
+            const uint8_t rayIdx = active[j];
+            if (ray_intersect_with_box(q->rays[rayIdx],
+                                       &child->aabb.min,
+                                       &child->aabb.max,
+                                       &dist) == false ||
+                dist >= q->maxDistances[rayIdx]) {
+                continue;
+            }
+
+            if (child->leaf == NULL) {
+                childActive[nbChildActive++] = rayIdx;
+            } else {
+                q->func(child, rayIdx, dist, q->ptr);
+                hits++;
+            }
+        }
+
+        if (nbChildActive > 0) {
+            hits += _rtree_query_cast_rays_node(child, childActive, nbChildActive, q);
+        }
+    }
+
+    return hits;
+}
+
+size_t rtree_query_cast_rays(Rtree *r,
+                             const Ray *const *rays,
+                             uint8_t nbRays,
+                             uint16_t groups,
+                             uint16_t collidesWith,
+                             const DoublyLinkedList *excludeLeafPtrs,
+                             float *maxDistances,
+                             pointer_rtree_query_cast_rays_func func,
+                             void *ptr) {
+    vx_assert(nbRays <= RTREE_RAYS_PACKET_SIZE);
+
+    uint8_t active[RTREE_RAYS_PACKET_SIZE];
+    uint8_t nbActive = 0;
+    for (uint8_t i = 0; i < nbRays; ++i) {
+        if (rays[i] != NULL) {
+            active[nbActive++] = i;
+        }
+    }
+    if (nbActive == 0) {
+        return 0;
+    }
+
+    const _RtreeRaysQuery q = {rays,
+                               maxDistances,
+                               func,
+                               ptr,
+                               excludeLeafPtrs,
+                               groups,
+                               collidesWith,
+                               nbRays,
+                               {0, 0, 0}};
+    return _rtree_query_cast_rays_node(_rtree_get_node(r, r->root), active, nbActive, &q);
+}
+
 size_t rtree_query_cast_all_box_step_func(Rtree *r,
                                           const Box *stepOriginBox,
                                           float stepStartDistance,
@@ -930,40 +1490,36 @@ size_t rtree_query_cast_all_box_step_func(Rtree *r,
                                           DoublyLinkedList *results,
                                           const float3 *epsilon) {
 
+    RtreeNode *localLeaves[RTREE_QUEUE_LOCAL_CAPACITY];
+    RtreeLeaves query;
+    rtree_leaves_init(&query, localLeaves, RTREE_QUEUE_LOCAL_CAPACITY);
+
     float swept;
     RtreeNode *hit;
-    FifoList *query = fifo_list_new();
     RtreeCastResult *result;
     size_t hits = 0;
 
-    if (rtree_query_overlap_box(r,
-                                broadPhaseBox,
-                                groups,
-                                collidesWith,
-                                excludeLeafPtrs,
-                                query,
-                                epsilon) > 0) {
-        hit = fifo_list_pop(query);
-        while (hit != NULL) {
-            swept = box_swept(stepOriginBox, step3, hit->aabb, epsilon, false, NULL, NULL);
-
-            if ((excludeLeafPtrs == NULL ||
-                 doubly_linked_list_contains(excludeLeafPtrs, hit->leaf) == false)) {
-
-                result = malloc(sizeof(RtreeCastResult));
-                if (result != NULL) {
-                    result->rtreeLeaf = hit;
-                    result->distance = stepStartDistance + swept * float3_length(step3);
-                    doubly_linked_list_push_last(results, result);
-                    hits++;
-                }
-            }
-            hit = fifo_list_pop(query);
+    rtree_query_overlap_box_leaves(r,
+                                   broadPhaseBox,
+                                   groups,
+                                   collidesWith,
+                                   excludeLeafPtrs,
+                                   &query,
+                                   epsilon);
+    for (size_t i = 0; i < query.count; ++i) {
+        hit = query.items[i];
+        swept = box_swept(stepOriginBox, step3, &hit->aabb, epsilon, false, NULL, NULL);
+
+        result = malloc(sizeof(RtreeCastResult));
+        if (result != NULL) {
+            result->rtreeLeaf = hit;
+            result->distance = stepStartDistance + swept * float3_length(step3);
+            doubly_linked_list_push_last(results, result);
+            hits++;
         }
     }
 
-    vx_assert(fifo_list_get_size(query) == 0);
-    fifo_list_free(query, NULL);
+    rtree_leaves_free(&query);
 
     return hits;
 }
@@ -991,6 +1547,57 @@ size_t rtree_query_cast_all_box(Rtree *r,
                                         epsilon);
 }
 
+size_t rtree_query_cast_all_box_results(Rtree *r,
+                                        const Box *aabb,
+                                        const float3 *unit,
+                                        float maxDist,
+                                        uint16_t groups,
+                                        uint16_t collidesWith,
+                                        RtreeCastResults *results,
+                                        const float3 *epsilon) {
+
+    RtreeNode *localLeaves[RTREE_QUEUE_LOCAL_CAPACITY];
+    RtreeLeaves query;
+    rtree_leaves_init(&query, localLeaves, RTREE_QUEUE_LOCAL_CAPACITY);
+
+    Box broadPhaseBox, stepOriginBox = *aabb;
+    RtreeNode *hit;
+    float d = 0.0f, step = 0.0f, swept;
+    size_t hits = 0;
+
+    // same broadphase steps as rtree_utils_broadphase_steps
+    while (d < maxDist) {
+        d += step;
+        step = minimum(maxDist - d, RTREE_CAST_STEP_DISTANCE);
+
+        const float3 step3 = {unit->x * step, unit->y * step, unit->z * step};
+        box_set_broadphase_box(&stepOriginBox, &step3, &broadPhaseBox);
+
+        rtree_leaves_reset(&query);
+        rtree_query_overlap_box_leaves(r,
+                                       &broadPhaseBox,
+                                       groups,
+                                       collidesWith,
+                                       NULL,
+                                       &query,
+                                       epsilon);
+        for (size_t i = 0; i < query.count; ++i) {
+            hit = query.items[i];
+            swept = box_swept(&stepOriginBox, &step3, &hit->aabb, epsilon, false, NULL, NULL);
+            if (rtree_cast_results_push(results, hit, d + swept * float3_length(&step3))) {
+                hits++;
+            }
+        }
+
+        float3_op_add(&stepOriginBox.min, &step3);
+        float3_op_add(&stepOriginBox.max, &step3);
+    }
+
+    rtree_leaves_free(&query);
+
+    return hits;
+}
+
 // MARK: Utils
 
 size_t rtree_utils_broadphase_steps(Rtree *r,
@@ -1075,18 +1682,17 @@ void debug_rtree_reset_calls(void) {
 }
 
 bool debug_rtree_integrity_check(Rtree *r) {
-    DoublyLinkedList *toExamine = doubly_linked_list_new();
-    DoublyLinkedListNode *n;
+    _RtreeQueue toExamine;
     RtreeNode *rn, *child, *rbLeaf;
     Transform *t;
     Shape *s;
     RigidBody *rb;
     bool success = true;
 
-    doubly_linked_list_push_first(toExamine, r->root);
-    while (doubly_linked_list_first(toExamine) != NULL) {
-        rn = (RtreeNode *)doubly_linked_list_pop_first(toExamine);
+    _rtree_queue_init(&toExamine);
 
+    rn = _rtree_get_node(r, r->root);
+    while (rn != NULL) {
         if (rn->leaf != NULL) {
             if (rn->count > 0) {
                 cclog_debug("⚠️⚠️⚠️debug_rtree_integrity_check: misplaced leaf");
@@ -1102,8 +1708,8 @@ bool debug_rtree_integrity_check(Rtree *r) {
             if (rb != NULL) {
                 rbLeaf = rigidbody_get_rtree_leaf(rb);
                 if (rbLeaf != NULL) {
-                    if (float3_isEqual(&rn->aabb->min, &rbLeaf->aabb->min, EPSILON_ZERO) == false ||
-                        float3_isEqual(&rn->aabb->max, &rbLeaf->aabb->max, EPSILON_ZERO) == false) {
+                    if (float3_isEqual(&rn->aabb.min, &rbLeaf->aabb.min, EPSILON_ZERO) == false ||
+                        float3_isEqual(&rn->aabb.max, &rbLeaf->aabb.max, EPSILON_ZERO) == false) {
 
                         cclog_debug("⚠️⚠️⚠️debug_rtree_integrity_check: mismatched leaf");
                         success = false;
@@ -1113,7 +1719,7 @@ bool debug_rtree_integrity_check(Rtree *r) {
                     success = false;
                 }
             }
-        } else if (rn->parent != NULL) {
+        } else if (rn->parent != RTREE_NODE_NONE) {
             if (rn->count == 0) {
                 cclog_debug("⚠️⚠️⚠️debug_rtree_integrity_check: dangling branch");
                 success = false;
@@ -1126,30 +1732,27 @@ bool debug_rtree_integrity_check(Rtree *r) {
             }
         }
 
-        const size_t childrenCount = doubly_linked_list_node_count(rn->children);
-        if (rn->count != childrenCount) {
-            cclog_debug("⚠️⚠️⚠️debug_rtree_integrity_check: mismatched children count");
-            success = false;
-        }
-
-        n = doubly_linked_list_first(rn->children);
-        while (n != NULL) {
-            child = (RtreeNode *)doubly_linked_list_node_pointer(n);
+        for (uint8_t i = 0; i < rn->count; ++i) {
+            child = _rtree_node_get_child(rn, i);
 
-            if (box_contains_epsilon(rn->aabb, &child->aabb->min, EPSILON_ZERO) == false ||
-                box_contains_epsilon(rn->aabb, &child->aabb->max, EPSILON_ZERO) == false) {
+            if (child->parent != rn->index) {
+                cclog_debug("⚠️⚠️⚠️debug_rtree_integrity_check: mismatched parent");
+                success = false;
+            }
+            if (box_contains_epsilon(&rn->aabb, &child->aabb.min, EPSILON_ZERO) == false ||
+                box_contains_epsilon(&rn->aabb, &child->aabb.max, EPSILON_ZERO) == false) {
 
                 cclog_debug("⚠️⚠️⚠️debug_rtree_integrity_check: parent aabb does not contain "
                             "child aabb");
                 success = false;
             }
-            doubly_linked_list_push_first(toExamine, child);
-
-            n = doubly_linked_list_node_next(n);
+            _rtree_queue_push(&toExamine, child->index);
         }
+
+        rn = _rtree_queue_pop(r, &toExamine);
     }
 
-    doubly_linked_list_free(toExamine);
+    _rtree_queue_free(&toExamine);
 
     return success;
 }
@@ -1161,11 +1764,11 @@ void _debug_rtree_reset_all_aabb_recurse(RtreeNode *rn) {
 }
 
 void debug_rtree_reset_all_aabb(Rtree *r) {
-    rtree_recurse(r->root, _debug_rtree_reset_all_aabb_recurse);
+    rtree_recurse(_rtree_get_node(r, r->root), _debug_rtree_reset_all_aabb_recurse);
 }
 
 #endif
 
 bool rtree_node_has_parent(const RtreeNode *const rn) {
-    return rn->parent != NULL;
+    return rn->parent != RTREE_NODE_NONE;
 }
@@ -40,6 +40,11 @@ typedef struct _RtreeNode RtreeNode;
 typedef void (*pointer_rtree_recurse_func)(RtreeNode *rn);
 typedef bool (*pointer_rtree_query_overlap_func)(RtreeNode *rn, void *ptr, const float3 *epsilon);
 typedef bool (*pointer_rtree_query_cast_all_func)(RtreeNode *rn, void *ptr, float *distance);
+/// Called for each leaf reached by a ray of a packet, w/ the ray index in the packet
+typedef void (*pointer_rtree_query_cast_rays_func)(RtreeNode *leaf,
+                                                   uint8_t rayIdx,
+                                                   float distance,
+                                                   void *ptr);
 typedef size_t (*pointer_rtree_broadphase_step_func)(Rtree *r,
                                                      const Box *stepOriginBox,
                                                      float stepStartDistance,
@@ -59,16 +64,32 @@ typedef struct RtreeCastResult {
     char pad[4];
 } RtreeCastResult;
 
+/// Growable arrays filled by queries, they can start on caller-provided storage (e.g. on the
+/// stack) and only move to the heap if they overflow. Storage is kept when reset between queries
+typedef struct {
+    RtreeNode **items;
+    RtreeNode **local;
+    size_t count, capacity;
+} RtreeLeaves;
+
+typedef struct {
+    RtreeCastResult *items;
+    RtreeCastResult *local;
+    size_t count, capacity;
+} RtreeCastResults;
+
 Rtree *rtree_new(uint8_t m, uint8_t M);
 void rtree_free(Rtree *r);
 
 uint16_t rtree_get_height(const Rtree *r);
 RtreeNode *rtree_get_root(const Rtree *r);
+size_t rtree_get_nb_leaves(const Rtree *r);
 
 /// MARK: - Nodes -
 Box *rtree_node_get_aabb(const RtreeNode *rn);
 uint8_t rtree_node_get_children_count(const RtreeNode *rn);
-DoublyLinkedListNode *rtree_node_get_children_iterator(const RtreeNode *rn);
+/// @returns child at given position, or NULL if out of range
+RtreeNode *rtree_node_get_child(const RtreeNode *rn, const uint8_t i);
 void *rtree_node_get_leaf_ptr(const RtreeNode *rn);
 bool rtree_node_is_leaf(const RtreeNode *rn);
 uint16_t rtree_node_get_groups(const RtreeNode *rn);
@@ -77,10 +98,29 @@ void rtree_node_set_collision_masks(RtreeNode *leaf,
                                     const uint16_t groups,
                                     const uint16_t collidesWith);
 
+/// MARK: - Query results -
+/// 'local' storage of given capacity may be NULL
+void rtree_leaves_init(RtreeLeaves *l, RtreeNode **local, size_t capacity);
+void rtree_leaves_reset(RtreeLeaves *l);
+bool rtree_leaves_push(RtreeLeaves *l, RtreeNode *leaf);
+/// Frees heap storage if any, the array must be initialized again to be reused
+void rtree_leaves_free(RtreeLeaves *l);
+void rtree_cast_results_init(RtreeCastResults *cr, RtreeCastResult *local, size_t capacity);
+bool rtree_cast_results_push(RtreeCastResults *cr, RtreeNode *leaf, float distance);
+/// Stable sort by ascending distance
+void rtree_cast_results_sort(RtreeCastResults *cr);
+void rtree_cast_results_free(RtreeCastResults *cr);
+
 /// MARK: - Operations -
 // NOTE: rtree_recurse is always "deep first"
 void rtree_recurse(RtreeNode *rn, pointer_rtree_recurse_func f);
 void rtree_insert(Rtree *r, RtreeNode *leaf);
+/// Creates a leaf outside of the tree, to be inserted later w/ rtree_insert or rtree_bulk_load
+RtreeNode *rtree_create_leaf(Rtree *r,
+                             Box *aabb,
+                             uint16_t groups,
+                             uint16_t collidesWith,
+                             void *ptr);
 RtreeNode *rtree_create_and_insert(Rtree *r,
                                    Box *aabb,
                                    uint16_t groups,
@@ -89,6 +129,13 @@ RtreeNode *rtree_create_and_insert(Rtree *r,
 void rtree_remove(Rtree *r, RtreeNode *leaf, bool freeLeaf);
 void rtree_find_and_remove(Rtree *r, Box *aabb, void *ptr);
 void rtree_update(Rtree *r, RtreeNode *leaf, Box *aabb);
+/// Inserts leaves created w/ rtree_create_leaf, in Sort-Tile-Recursive order. A batch at least as
+/// large as the tree rebuilds it bottom-up w/ full nodes, a smaller batch is inserted one by one
+/// @returns false if out of memory, leaves may then have been inserted one by one
+bool rtree_bulk_load(Rtree *r, RtreeNode **leaves, size_t n);
+/// Rebuilds the tree bottom-up from its current leaves, w/ Sort-Tile-Recursive packing
+bool rtree_rebuild(Rtree *r);
+/// Applies leaves collision masks changes to their ancestors, only dirty paths are visited
 void rtree_refresh_collision_masks(Rtree *r);
 
 /// MARK: - Queries -
@@ -120,6 +167,14 @@ size_t rtree_query_overlap_box(Rtree *r,
                                const DoublyLinkedList *excludeLeafPtrs,
                                FifoList *results,
                                const float3 *epsilon);
+/// Same as rtree_query_overlap_box, appending hits to a leaves array
+size_t rtree_query_overlap_box_leaves(Rtree *r,
+                                      const Box *aabb,
+                                      uint16_t groups,
+                                      uint16_t collidesWith,
+                                      const DoublyLinkedList *excludeLeafPtrs,
+                                      RtreeLeaves *results,
+                                      const float3 *epsilon);
 size_t rtree_query_cast_all_func(Rtree *r,
                                  uint16_t groups,
                                  uint16_t collidesWith,
@@ -133,6 +188,19 @@ size_t rtree_query_cast_all_ray(Rtree *r,
                                 uint16_t collidesWith,
                                 const DoublyLinkedList *excludeLeafPtrs,
                                 DoublyLinkedList *results);
+/// Casts a packet of up to RTREE_RAYS_PACKET_SIZE rays in a single traversal, each node is only
+/// examined for the rays reaching it before their 'maxDistances' value. Leaves are not sorted, the
+/// callback may lower a ray max distance to skip farther nodes for that ray. NULL rays are skipped
+/// @return number of calls to the callback
+size_t rtree_query_cast_rays(Rtree *r,
+                             const Ray *const *rays,
+                             uint8_t nbRays,
+                             uint16_t groups,
+                             uint16_t collidesWith,
+                             const DoublyLinkedList *excludeLeafPtrs,
+                             float *maxDistances,
+                             pointer_rtree_query_cast_rays_func func,
+                             void *ptr);
 size_t rtree_query_cast_all_box_step_func(Rtree *r,
                                           const Box *stepOriginBox,
                                           float stepStartDistance,
@@ -153,6 +221,16 @@ size_t rtree_query_cast_all_box(Rtree *r,
                                 const DoublyLinkedList *excludeLeafPtrs,
                                 DoublyLinkedList *results,
                                 const float3 *epsilon);
+/// Same as rtree_query_cast_all_box, appending hits to a cast results array, w/o allocation as
+/// long as the results fit in their current storage
+size_t rtree_query_cast_all_box_results(Rtree *r,
+                                        const Box *aabb,
+                                        const float3 *unit,
+                                        float maxDist,
+                                        uint16_t groups,
+                                        uint16_t collidesWith,
+                                        RtreeCastResults *results,
+                                        const float3 *epsilon);
 
 /// MARK: - Utils -
 size_t rtree_utils_broadphase_steps(Rtree *r,
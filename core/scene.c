@@ -8,13 +8,44 @@
 
 #include <float.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "weakptr.h"
 
+// initial number of collision couples, then doubles when full (index: when 3/4 full)
+#define SCENE_COLLISIONS_INITIAL_CAPACITY 64
+// ray casts broadphase hits kept on the stack for each packet, before using the heap
+#define SCENE_CAST_RAYS_LOCAL_CANDIDATES 256
+// initial capacity of the scratch arrays used by each physics step, then doubles when full
+#define SCENE_PHYSICS_SCRATCH_INITIAL_CAPACITY 64
+// a new awake box may be merged into one of the last registered boxes only, registrations are
+// spatially coherent (same rigidbody, siblings) & a full search is quadratic w/ many bodies
+#define SCENE_AWAKE_BOXES_MERGE_WINDOW 8
+// r-tree hits kept on the stack for each island stepped on a worker, before using the heap
+#define SCENE_ISLAND_LOCAL_HITS 64
+// r-tree is rebuilt at end-of-frame when at least this many non-dynamic leaves were inserted, and
+// they make up at least half of the tree (e.g. world spawn), incremental insertions leave looser
+// nodes. Dynamic leaves are not counted, their spawn positions don't last
+#define SCENE_RTREE_REBUILD_MIN_LEAVES 64
+
 #if DEBUG_SCENE
 static int debug_scene_awake_queries = 0;
 #endif
 
+typedef struct {
+    Weakptr *t1, *t2;
+    float3 wNormal;
+    uint32_t key; // ordered pair of transform IDs
+    bool flag;
+    char pad[3];
+} _CollisionCouple;
+
+typedef struct {
+    Box bounds;      // space the rigidbody may cover during the step
+    uint32_t parent; // union-find, the root is the island's first member
+    uint32_t island; // index in the islands array
+} _IslandNode;
+
 struct _Scene {
     Transform *root;
     Transform *map;    // weak ref to Map transform (Shape retained by parent)
@@ -28,27 +59,109 @@ struct _Scene {
     // relevant for physics & sync, internal transforms do not need to be accounted for here
     FifoList *removed;
 
-    // rigidbody couples registered & waiting for a call to end-of-collision callback
-    DoublyLinkedList *collisions;
+    // rigidbody couples registered & waiting for a call to end-of-collision callback,
+    // stored contiguously & indexed by an open-addressing hash of their transform IDs
+    _CollisionCouple *collisions;
+    uint32_t *collisionsIndex; // couple index + 1, 0 for an empty slot
+    uint32_t nbCollisions, collisionsCapacity, collisionsIndexCapacity;
 
     // awake volumes can be registered for end-of-frame awake phase
-    DoublyLinkedList *awakeBoxes;
+    Box *awakeBoxes;
+    uint32_t nbAwakeBoxes, awakeBoxesCapacity;
+
+    // physics step scratch storage, reset every frame & only grown when needed: hierarchy
+    // traversal queue, and r-tree query results
+    Transform **toExamine;
+    size_t toExamineCapacity;
+    RtreeLeaves physicsQuery;
+
+    // transforms visited & idle branches skipped by last refresh, see transform_is_idle_branch
+    size_t nbVisited, nbIdleBranches;
+
+    // non-dynamic leaves inserted in the r-tree since last end-of-frame
+    size_t nbNewLeaves;
+
+    // parallel physics step, see scene_set_physics_pool: dynamic rigidbodies deferred during
+    // hierarchy traversal, in traversal order, then grouped by contact islands
+    ThreadPool *physicsPool;
+    RigidbodyIslandMember *deferred, *islandMembers;
+    _IslandNode *islandNodes;
+    uint32_t *islandOrder;
+    size_t nbDeferred, deferredCapacity;
+    // triggers & static rigidbodies w/ callbacks, ticked after islands so that they check overlaps
+    // against dynamic rigidbodies at their new positions
+    RigidbodyIslandMember *triggers;
+    size_t nbTriggers, triggersCapacity;
+    RigidbodyIsland *islands;
+    size_t nbIslands, islandsCapacity;
 
     // constant acceleration for the whole Scene (gravity usually)
     float3 constantAcceleration;
+
+    // all idle branches are woken up at the beginning of next refresh
+    bool wakeIdleBranches;
+    char pad[3];
 };
 
-typedef struct {
-    Weakptr *t1, *t2;
-    float3 wNormal;
-    bool flag;
-} _CollisionCouple;
+static uint32_t _scene_collision_couple_key(Transform *t1, Transform *t2) {
+    const uint16_t id1 = transform_get_id(t1);
+    const uint16_t id2 = transform_get_id(t2);
+    return id1 < id2 ? (uint32_t)id1 << 16 | id2 : (uint32_t)id2 << 16 | id1;
+}
 
-void _scene_collision_couple_free_func(void *ptr) {
-    _CollisionCouple *cc = (_CollisionCouple *)ptr;
-    weakptr_release(cc->t1);
-    weakptr_release(cc->t2);
-    free(cc);
+static uint32_t _scene_collision_couple_hash(uint32_t key) {
+    key = (key ^ (key >> 16)) * 0x45d9f3b;
+    return key ^ (key >> 16);
+}
+
+/// returns the index slot of the couple w/ given key, or of the empty slot where it would go
+static uint32_t *_scene_collisions_index_find(const Scene *sc, const uint32_t key) {
+    const uint32_t mask = sc->collisionsIndexCapacity - 1;
+    uint32_t i = _scene_collision_couple_hash(key) & mask;
+    while (sc->collisionsIndex[i] != 0 && sc->collisions[sc->collisionsIndex[i] - 1].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &sc->collisionsIndex[i];
+}
+
+/// clears & fills the index from the couples array, w/ given number of slots (power of 2)
+static bool _scene_collisions_index_rebuild(Scene *sc, const uint32_t capacity) {
+    if (capacity != sc->collisionsIndexCapacity) {
+        uint32_t *index = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+        if (index == NULL) {
+            return false;
+        }
+        free(sc->collisionsIndex);
+        sc->collisionsIndex = index;
+        sc->collisionsIndexCapacity = capacity;
+    }
+    memset(sc->collisionsIndex, 0, capacity * sizeof(uint32_t));
+    for (uint32_t i = 0; i < sc->nbCollisions; ++i) {
+        *_scene_collisions_index_find(sc, sc->collisions[i].key) = i + 1;
+    }
+    return true;
+}
+
+/// makes room for one more couple, in the array & in the index
+static bool _scene_collisions_reserve(Scene *sc) {
+    if (sc->nbCollisions == sc->collisionsCapacity) {
+        const uint32_t capacity = sc->collisionsCapacity > 0 ? sc->collisionsCapacity * 2
+                                                             : SCENE_COLLISIONS_INITIAL_CAPACITY;
+        _CollisionCouple *collisions = (_CollisionCouple *)
+            realloc(sc->collisions, capacity * sizeof(_CollisionCouple));
+        if (collisions == NULL) {
+            return false;
+        }
+        sc->collisions = collisions;
+        sc->collisionsCapacity = capacity;
+    }
+    if ((sc->nbCollisions + 1) * 4 > sc->collisionsIndexCapacity * 3) {
+        const uint32_t capacity = sc->collisionsIndexCapacity > 0
+                                      ? sc->collisionsIndexCapacity * 2
+                                      : SCENE_COLLISIONS_INITIAL_CAPACITY;
+        return _scene_collisions_index_rebuild(sc, capacity);
+    }
+    return true;
 }
 
 void _scene_update_rtree(Scene *sc, RigidBody *rb, Transform *t, Box *collider) {
@@ -65,6 +178,9 @@ void _scene_update_rtree(Scene *sc, RigidBody *rb, Transform *t, Box *collider)
                                                              rigidbody_get_collides_with(rb),
                                                              t));
             scene_register_awake_rigidbody_contacts(sc, rb);
+            if (rigidbody_is_dynamic(rb) == false) {
+                sc->nbNewLeaves++;
+            }
         }
         // update leaf due to collider or transformations change
         else if (rigidbody_get_collider_dirty(rb) || transform_is_physics_dirty(t)) {
@@ -106,6 +222,16 @@ bool _scene_shapes_iterator_func(Transform *t, void *ptr) {
     return false;
 }
 
+bool _scene_wake_func(Transform *t, void *ptr) {
+    transform_set_idle_branch(t, false);
+    return false;
+}
+
+bool _scene_count_func(Transform *t, void *ptr) {
+    (*(size_t *)ptr)++;
+    return false;
+}
+
 bool _scene_standalone_refresh_func(Transform *t, void *ptr) {
     if (transform_get_type(t) == ShapeTransform) {
         shape_apply_current_transaction(transform_utils_get_shape(t), true);
@@ -123,6 +249,385 @@ void _scene_register_removed_transform(Scene *sc, Transform *t) {
     fifo_list_push(sc->removed, t);
 }
 
+/// makes room for given number of transforms in the hierarchy traversal queue
+static bool _scene_to_examine_reserve(Scene *sc, const size_t count) {
+    if (count > sc->toExamineCapacity) {
+        size_t capacity = sc->toExamineCapacity > 0 ? sc->toExamineCapacity
+                                                    : SCENE_PHYSICS_SCRATCH_INITIAL_CAPACITY;
+        while (capacity < count) {
+            capacity *= 2;
+        }
+        Transform **toExamine = (Transform **)realloc(sc->toExamine,
+                                                      capacity * sizeof(Transform *));
+        if (toExamine == NULL) {
+            cclog_error("🔥 scene: can't grow hierarchy traversal queue");
+            return false;
+        }
+        sc->toExamine = toExamine;
+        sc->toExamineCapacity = capacity;
+    }
+    return true;
+}
+
+/// makes room for given number of islands, new ones have no events storage yet
+static bool _scene_islands_reserve(Scene *sc, const size_t count) {
+    if (count > sc->islandsCapacity) {
+        size_t capacity = sc->islandsCapacity > 0 ? sc->islandsCapacity
+                                                  : SCENE_PHYSICS_SCRATCH_INITIAL_CAPACITY;
+        while (capacity < count) {
+            capacity *= 2;
+        }
+        RigidbodyIsland *islands = (RigidbodyIsland *)realloc(sc->islands,
+                                                              capacity * sizeof(RigidbodyIsland));
+        if (islands == NULL) {
+            return false;
+        }
+        for (size_t i = sc->islandsCapacity; i < capacity; ++i) {
+            islands[i].events = NULL;
+            islands[i].nbEvents = 0;
+            islands[i].eventsCapacity = 0;
+        }
+        sc->islands = islands;
+        sc->islandsCapacity = capacity;
+    }
+    return true;
+}
+
+/// makes room for one more rigidbody deferred to the parallel physics step, & its own island
+static bool _scene_deferred_reserve(Scene *sc) {
+    if (sc->nbDeferred == sc->deferredCapacity) {
+        const size_t capacity = sc->deferredCapacity > 0 ? sc->deferredCapacity * 2
+                                                         : SCENE_PHYSICS_SCRATCH_INITIAL_CAPACITY;
+        RigidbodyIslandMember *deferred = (RigidbodyIslandMember *)
+            realloc(sc->deferred, capacity * sizeof(RigidbodyIslandMember));
+        if (deferred == NULL) {
+            return false;
+        }
+        sc->deferred = deferred;
+        RigidbodyIslandMember *members = (RigidbodyIslandMember *)
+            realloc(sc->islandMembers, capacity * sizeof(RigidbodyIslandMember));
+        if (members == NULL) {
+            return false;
+        }
+        sc->islandMembers = members;
+        _IslandNode *nodes = (_IslandNode *)realloc(sc->islandNodes,
+                                                    capacity * sizeof(_IslandNode));
+        if (nodes == NULL) {
+            return false;
+        }
+        sc->islandNodes = nodes;
+        uint32_t *order = (uint32_t *)realloc(sc->islandOrder, capacity * sizeof(uint32_t));
+        if (order == NULL) {
+            return false;
+        }
+        sc->islandOrder = order;
+        sc->deferredCapacity = capacity;
+    }
+    return _scene_islands_reserve(sc, sc->nbDeferred + 1);
+}
+
+/// a rigidbody may be stepped out of the hierarchy traversal only if no descendant is in the r-tree
+static bool _scene_has_enabled_rigidbody_descendants(Transform *t) {
+    DoublyLinkedListNode *n = transform_get_children_iterator(t);
+    Transform *child;
+    RigidBody *rb;
+    while (n != NULL) {
+        child = (Transform *)doubly_linked_list_node_pointer(n);
+        rb = transform_get_rigidbody(child);
+        if ((rb != NULL && rigidbody_is_enabled(rb)) ||
+            _scene_has_enabled_rigidbody_descendants(child)) {
+            return true;
+        }
+        n = doubly_linked_list_node_next(n);
+    }
+    return false;
+}
+
+/// defers a dynamic rigidbody to the parallel physics step, if its descendants can be refreshed
+/// after it is moved w/o affecting physics
+static bool _scene_defer_rigidbody(Scene *sc, RigidBody *rb, Transform *t, const Box *collider) {
+    if (sc->physicsPool == NULL || rigidbody_is_dynamic(rb) == false ||
+        rigidbody_get_rtree_leaf(rb) == NULL || _scene_has_enabled_rigidbody_descendants(t) ||
+        _scene_deferred_reserve(sc) == false) {
+        return false;
+    }
+
+    RigidbodyIslandMember *member = &sc->deferred[sc->nbDeferred++];
+    member->t = t;
+    member->rb = rb;
+    member->collider = *collider;
+    member->moved = false;
+    return true;
+}
+
+/// defers an overlap-checking rigidbody after the parallel physics step, its collider is not
+/// affected by deferred rigidbodies which have no enabled rigidbody descendants
+static bool _scene_defer_trigger(Scene *sc, RigidBody *rb, Transform *t, const Box *collider) {
+    if (sc->physicsPool == NULL || rigidbody_is_active_trigger(rb) == false) {
+        return false;
+    }
+    if (sc->nbTriggers == sc->triggersCapacity) {
+        const size_t capacity = sc->triggersCapacity > 0 ? sc->triggersCapacity * 2
+                                                         : SCENE_PHYSICS_SCRATCH_INITIAL_CAPACITY;
+        RigidbodyIslandMember *triggers = (RigidbodyIslandMember *)
+            realloc(sc->triggers, capacity * sizeof(RigidbodyIslandMember));
+        if (triggers == NULL) {
+            return false;
+        }
+        sc->triggers = triggers;
+        sc->triggersCapacity = capacity;
+    }
+
+    RigidbodyIslandMember *member = &sc->triggers[sc->nbTriggers++];
+    member->t = t;
+    member->rb = rb;
+    member->collider = *collider;
+    member->moved = false;
+    return true;
+}
+
+static uint32_t _scene_island_find(_IslandNode *nodes, uint32_t i) {
+    while (nodes[i].parent != i) {
+        nodes[i].parent = nodes[nodes[i].parent].parent;
+        i = nodes[i].parent;
+    }
+    return i;
+}
+
+/// in-place heap sort of bounds indices by their min x
+static void _scene_islands_sort(const _IslandNode *nodes, uint32_t *order, const uint32_t count) {
+    uint32_t start = count / 2, end = count, root, child, tmp;
+    while (end > 1) {
+        if (start > 0) {
+            --start;
+        } else {
+            --end;
+            tmp = order[end];
+            order[end] = order[0];
+            order[0] = tmp;
+        }
+        root = start;
+        while ((child = 2 * root + 1) < end) {
+            if (child + 1 < end &&
+                nodes[order[child + 1]].bounds.min.x > nodes[order[child]].bounds.min.x) {
+                ++child;
+            }
+            if (nodes[order[child]].bounds.min.x <= nodes[order[root]].bounds.min.x) {
+                break;
+            }
+            tmp = order[root];
+            order[root] = order[child];
+            order[child] = tmp;
+            root = child;
+        }
+    }
+}
+
+/// groups deferred rigidbodies whose step bounds overlap, directly or through other rigidbodies,
+/// islands & their members are in traversal order
+static void _scene_build_islands(Scene *sc, const TICK_DELTA_SEC_T dt) {
+    const float dt_f = (float)dt;
+    const float3 *gravity = &sc->constantAcceleration;
+    _IslandNode *nodes = sc->islandNodes;
+    RigidbodyIslandMember *member;
+
+    // bounds of each rigidbody: its collider, expanded by the furthest it can move this frame
+    for (uint32_t i = 0; i < sc->nbDeferred; ++i) {
+        member = &sc->deferred[i];
+        const float3 *velocity = rigidbody_get_velocity(member->rb);
+        const float3 *acceleration = rigidbody_get_constant_acceleration(member->rb);
+        const float3 v = {velocity->x + (gravity->x + acceleration->x) * dt_f,
+                          velocity->y + (gravity->y + acceleration->y) * dt_f,
+                          velocity->z + (gravity->z + acceleration->z) * dt_f};
+        const float speed = float3_length(&v) + float3_length(rigidbody_get_motion(member->rb));
+        const float margin = minimum(speed, PHYSICS_MAX_VELOCITY) * dt_f + EPSILON_COLLISION;
+
+        nodes[i].bounds = member->collider;
+        float3_op_substract_scalar(&nodes[i].bounds.min, margin);
+        float3_op_add_scalar(&nodes[i].bounds.max, margin);
+        nodes[i].parent = i;
+    }
+
+    // union of overlapping bounds, swept along x
+    uint32_t *order = sc->islandOrder;
+    for (uint32_t i = 0; i < sc->nbDeferred; ++i) {
+        order[i] = i;
+    }
+    _scene_islands_sort(nodes, order, (uint32_t)sc->nbDeferred);
+
+    uint32_t i, j, ri, rj;
+    for (uint32_t k = 0; k < sc->nbDeferred; ++k) {
+        i = order[k];
+        for (uint32_t l = k + 1; l < sc->nbDeferred; ++l) {
+            j = order[l];
+            if (nodes[j].bounds.min.x >= nodes[i].bounds.max.x) {
+                break;
+            }
+            if (box_collide_epsilon(&nodes[i].bounds, &nodes[j].bounds, 0.0f) &&
+                rigidbody_collides_with_rigidbody(sc->deferred[i].rb, sc->deferred[j].rb)) {
+                ri = _scene_island_find(nodes, i);
+                rj = _scene_island_find(nodes, j);
+                if (ri < rj) {
+                    nodes[rj].parent = ri;
+                } else if (rj < ri) {
+                    nodes[ri].parent = rj;
+                }
+            }
+        }
+    }
+
+    // islands in order of their first member, then members stored contiguously in order
+    sc->nbIslands = 0;
+    for (i = 0; i < sc->nbDeferred; ++i) {
+        ri = _scene_island_find(nodes, i);
+        if (ri == i) {
+            nodes[i].island = (uint32_t)sc->nbIslands;
+            sc->islands[sc->nbIslands].nbMembers = 0;
+            sc->islands[sc->nbIslands].id = (uint32_t)sc->nbIslands + 1;
+            sc->nbIslands++;
+        }
+        nodes[i].island = nodes[ri].island;
+        sc->islands[nodes[i].island].nbMembers++;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < sc->nbIslands; ++i) {
+        sc->islands[i].members = &sc->islandMembers[offset];
+        sc->islands[i].nbEvents = 0;
+        offset += sc->islands[i].nbMembers;
+        sc->islands[i].nbMembers = 0;
+    }
+    RigidbodyIsland *island;
+    for (i = 0; i < sc->nbDeferred; ++i) {
+        island = &sc->islands[nodes[i].island];
+        island->members[island->nbMembers++] = sc->deferred[i];
+        rigidbody_set_island(sc->deferred[i].rb, island->id);
+    }
+}
+
+typedef struct {
+    Scene *sc;
+    TICK_DELTA_SEC_T dt;
+} _IslandsStep;
+
+static void _scene_island_job(void *ctx, size_t idx) {
+    _IslandsStep *step = (_IslandsStep *)ctx;
+    RtreeNode *local[SCENE_ISLAND_LOCAL_HITS];
+    RtreeLeaves query;
+    rtree_leaves_init(&query, local, SCENE_ISLAND_LOCAL_HITS);
+
+    rigidbody_island_tick(step->sc, &step->sc->islands[idx], step->sc->rtree, step->dt, &query);
+
+    rtree_leaves_free(&query);
+}
+
+/// refreshes the descendants of a transform moved after they were traversed
+static void _scene_refresh_children(Transform *t) {
+    DoublyLinkedListNode *n = transform_get_children_iterator(t);
+    Transform *child;
+    while (n != NULL) {
+        child = (Transform *)doubly_linked_list_node_pointer(n);
+        transform_refresh(child, true, false);
+        _scene_refresh_children(child);
+        n = doubly_linked_list_node_next(n);
+    }
+    transform_reset_children_dirty(t);
+}
+
+/// per-block queries build missing chunk octrees on demand, this builds them on the calling thread
+/// for all shapes deferred rigidbodies may reach this frame, so that islands jobs don't write to
+/// shapes they share
+static void _scene_build_islands_octrees(Scene *sc) {
+    RtreeNode *local[SCENE_ISLAND_LOCAL_HITS];
+    RtreeLeaves query;
+    rtree_leaves_init(&query, local, SCENE_ISLAND_LOCAL_HITS);
+
+    const Box *bounds;
+    Transform *hitLeaf;
+    RigidBody *hitRb;
+    for (uint32_t i = 0; i < sc->nbDeferred; ++i) {
+        bounds = &sc->islandNodes[i].bounds;
+        rtree_leaves_reset(&query);
+        if (rtree_query_overlap_box_leaves(sc->rtree,
+                                           bounds,
+                                           PHYSICS_GROUP_ALL_SYSTEM,
+                                           PHYSICS_GROUP_ALL_SYSTEM,
+                                           NULL,
+                                           &query,
+                                           &float3_epsilon_collision) > 0) {
+            for (size_t j = 0; j < query.count; ++j) {
+                hitLeaf = (Transform *)rtree_node_get_leaf_ptr(query.items[j]);
+                hitRb = transform_get_rigidbody(hitLeaf);
+                if (hitRb != NULL && rigidbody_uses_per_block_collisions(hitRb)) {
+                    shape_build_octrees_in_box(transform_utils_get_shape(hitLeaf), bounds);
+                }
+            }
+        }
+    }
+
+    rtree_leaves_free(&query);
+}
+
+/// steps deferred rigidbodies by contact islands on the physics pool, then applies the results in
+/// islands order: transforms & r-tree, then recorded pushes & collision callbacks
+static void _scene_step_islands(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
+    _scene_build_islands(sc, dt);
+    if (sc->physicsPool != NULL && thread_pool_get_nb_workers(sc->physicsPool) > 0 &&
+        sc->nbIslands > 1) {
+        _scene_build_islands_octrees(sc);
+    }
+
+    _IslandsStep step = {sc, dt};
+    thread_pool_parallel_for(sc->physicsPool, sc->nbIslands, _scene_island_job, &step);
+
+    RigidbodyIsland *island;
+    RigidbodyIslandMember *member;
+    Box collider;
+    for (size_t i = 0; i < sc->nbIslands; ++i) {
+        island = &sc->islands[i];
+        for (size_t j = 0; j < island->nbMembers; ++j) {
+            member = &island->members[j];
+            rigidbody_set_island(member->rb, 0);
+
+            if (member->moved) {
+                transform_refresh(member->t, false, false);
+                transform_get_or_compute_world_aligned_collider(member->t, &collider, false);
+                _scene_update_rtree(sc, member->rb, member->t, &collider);
+                _scene_refresh_children(member->t);
+            }
+        }
+        rigidbody_island_flush(sc, island, callbackData);
+    }
+    sc->nbDeferred = 0;
+}
+
+/// whether refreshing this transform would have no effect, until woken up by a change
+static bool _scene_is_idle(Transform *t) {
+    if (transform_is_hierarchy_dirty(t)) {
+        return false;
+    }
+    if (transform_get_type(t) == ShapeTransform &&
+        shape_has_pending_transaction(transform_utils_get_shape(t))) {
+        return false;
+    }
+    RigidBody *rb = transform_get_rigidbody(t);
+    return rb == NULL || (transform_is_physics_dirty(t) == false && rigidbody_is_idle(rb));
+}
+
+/// flags an idle branch after it was visited, each of its children branches must be idle already
+static void _scene_flag_idle_branch(Transform *t) {
+    if (_scene_is_idle(t) == false) {
+        return;
+    }
+    DoublyLinkedListNode *n = transform_get_children_iterator(t);
+    while (n != NULL) {
+        if (transform_is_idle_branch((Transform *)doubly_linked_list_node_pointer(n)) == false) {
+            return;
+        }
+        n = doubly_linked_list_node_next(n);
+    }
+    transform_set_idle_branch(t, true);
+}
+
 // MARK: -
 
 Scene *scene_new(Weakptr *g) {
@@ -135,9 +640,35 @@ Scene *scene_new(Weakptr *g) {
         sc->wptr = NULL;
         sc->game = g;
         sc->removed = fifo_list_new();
-        sc->collisions = doubly_linked_list_new();
-        sc->awakeBoxes = doubly_linked_list_new();
+        sc->collisions = NULL;
+        sc->collisionsIndex = NULL;
+        sc->nbCollisions = 0;
+        sc->collisionsCapacity = 0;
+        sc->collisionsIndexCapacity = 0;
+        sc->awakeBoxes = NULL;
+        sc->nbAwakeBoxes = 0;
+        sc->awakeBoxesCapacity = 0;
+        sc->toExamine = NULL;
+        sc->toExamineCapacity = 0;
+        rtree_leaves_init(&sc->physicsQuery, NULL, 0);
+        sc->nbVisited = 0;
+        sc->nbIdleBranches = 0;
+        sc->nbNewLeaves = 0;
+        sc->physicsPool = NULL;
+        sc->deferred = NULL;
+        sc->islandMembers = NULL;
+        sc->islandNodes = NULL;
+        sc->islandOrder = NULL;
+        sc->nbDeferred = 0;
+        sc->deferredCapacity = 0;
+        sc->triggers = NULL;
+        sc->nbTriggers = 0;
+        sc->triggersCapacity = 0;
+        sc->islands = NULL;
+        sc->nbIslands = 0;
+        sc->islandsCapacity = 0;
         float3_set(&sc->constantAcceleration, 0.0f, 0.0f, 0.0f);
+        sc->wakeIdleBranches = false;
 
         transform_set_parent(sc->system, sc->root, false);
     }
@@ -160,10 +691,24 @@ void scene_free(Scene *sc) {
     rtree_free(sc->rtree);
     weakptr_invalidate(sc->wptr);
     fifo_list_free(sc->removed, NULL);
-    doubly_linked_list_flush(sc->collisions, _scene_collision_couple_free_func);
-    doubly_linked_list_free(sc->collisions);
-    doubly_linked_list_flush(sc->awakeBoxes, box_free_std);
-    doubly_linked_list_free(sc->awakeBoxes);
+    for (uint32_t i = 0; i < sc->nbCollisions; ++i) {
+        weakptr_release(sc->collisions[i].t1);
+        weakptr_release(sc->collisions[i].t2);
+    }
+    free(sc->collisions);
+    free(sc->collisionsIndex);
+    free(sc->awakeBoxes);
+    free(sc->toExamine);
+    rtree_leaves_free(&sc->physicsQuery);
+    free(sc->deferred);
+    free(sc->islandMembers);
+    free(sc->islandNodes);
+    free(sc->islandOrder);
+    free(sc->triggers);
+    for (size_t i = 0; i < sc->islandsCapacity; ++i) {
+        free(sc->islands[i].events);
+    }
+    free(sc->islands);
 
     free(sc);
 }
@@ -206,7 +751,14 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
     cclog_debug("🏞 physics step");
 #endif
 
-    FifoList *toExamine = fifo_list_new();
+    if (sc->wakeIdleBranches) {
+        transform_recurse(sc->root, _scene_wake_func, NULL, false);
+        sc->wakeIdleBranches = false;
+    }
+
+    // breadth-first traversal, in a queue reused every frame, idle branches are skipped
+    size_t toExamineHead = 0, toExamineTail = 0;
+    sc->nbIdleBranches = 0;
     Transform *t = sc->root, *child = NULL;
     DoublyLinkedListNode *n;
     while (t != NULL) {
@@ -230,15 +782,24 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
             _scene_update_rtree(sc, rb, t, &collider);
             _scene_refresh_rtree_collision_masks(rb);
 
-            // Step physics (top-first), collider is kept up-to-date
-            const bool moved = rigidbody_tick(sc, rb, t, &collider, sc->rtree, dt, callbackData);
-
-            if (moved) {
-                // Refresh transform (top-first) after physics changes
-                transform_refresh(t, false, false);
-
-                // Update r-tree (top-first) after physics changes
-                if (rb != NULL) {
+            // Step physics (top-first), collider is kept up-to-date ; w/ a physics pool, dynamic
+            // rigidbodies are deferred to be stepped in parallel after traversal, and triggers to
+            // be ticked after them
+            if (_scene_defer_rigidbody(sc, rb, t, &collider) == false &&
+                _scene_defer_trigger(sc, rb, t, &collider) == false) {
+                const bool moved = rigidbody_tick(sc,
+                                                  rb,
+                                                  t,
+                                                  &collider,
+                                                  sc->rtree,
+                                                  dt,
+                                                  callbackData);
+
+                if (moved) {
+                    // Refresh transform (top-first) after physics changes
+                    transform_refresh(t, false, false);
+
+                    // Update r-tree (top-first) after physics changes
                     transform_get_or_compute_world_aligned_collider(t, &collider, false);
                     _scene_update_rtree(sc, rb, t, &collider);
                 }
@@ -254,14 +815,38 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
                 transform_set_children_dirty(child);
             }
 
-            fifo_list_push(toExamine, child);
+            if (transform_is_idle_branch(child)) {
+                sc->nbIdleBranches++;
+            } else if (_scene_to_examine_reserve(sc, toExamineTail + 1)) {
+                sc->toExamine[toExamineTail++] = child;
+            }
             n = doubly_linked_list_node_next(n);
         }
         transform_reset_children_dirty(t);
 
-        t = (Transform *)fifo_list_pop(toExamine);
+        t = toExamineHead < toExamineTail ? sc->toExamine[toExamineHead++] : NULL;
+    }
+
+    if (sc->nbDeferred > 0) {
+        _scene_step_islands(sc, dt, callbackData);
     }
-    fifo_list_free(toExamine, NULL);
+    for (size_t i = 0; i < sc->nbTriggers; ++i) {
+        rigidbody_tick(sc,
+                       sc->triggers[i].rb,
+                       sc->triggers[i].t,
+                       &sc->triggers[i].collider,
+                       sc->rtree,
+                       dt,
+                       callbackData);
+    }
+    sc->nbTriggers = 0;
+
+    // flag idle branches bottom-up, in reverse traversal order
+    sc->nbVisited = toExamineTail + 1;
+    while (toExamineTail > 0) {
+        _scene_flag_idle_branch(sc->toExamine[--toExamineTail]);
+    }
+    _scene_flag_idle_branch(sc->root);
 
 #if DEBUG_RTREE_CHECK
     vx_assert(debug_rtree_integrity_check(sc->rtree));
@@ -273,6 +858,9 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
     while (t != NULL) {
         // if still outside of hierarchy at end-of-frame, proceed with removal
         if (transform_is_removed_from_scene(t)) {
+            // idle state is not kept outside of the scene, a branch added again is refreshed
+            transform_set_idle_branch(t, false);
+
             // enqueue children for r-tree leaf removal
             n = transform_get_children_iterator(t);
             while (n != NULL) {
@@ -296,12 +884,12 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
         t = (Transform *)fifo_list_pop(sc->removed);
     }
 
-    // process collision couples for end-of-contact callback
-    n = doubly_linked_list_first(sc->collisions);
+    // process collision couples for end-of-contact callback, compacting remaining ones
     _CollisionCouple *cc;
     Transform *t2;
-    while (n != NULL) {
-        cc = (_CollisionCouple *)doubly_linked_list_node_pointer(n);
+    uint32_t nbCollisions = 0;
+    for (uint32_t i = 0; i < sc->nbCollisions; ++i) {
+        cc = &sc->collisions[i];
         t = weakptr_get(cc->t1);
         t2 = weakptr_get(cc->t2);
 
@@ -310,37 +898,35 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
                 rigidbody_fire_reciprocal_collision_end_callback(t, t2, callbackData);
             }
 
-            _scene_collision_couple_free_func(cc);
-
-            DoublyLinkedListNode *next = doubly_linked_list_node_next(n);
-            doubly_linked_list_delete_node(sc->collisions, n);
-            n = next;
+            weakptr_release(cc->t1);
+            weakptr_release(cc->t2);
         } else {
             cc->flag = false;
-            n = doubly_linked_list_node_next(n);
+            sc->collisions[nbCollisions++] = *cc;
         }
     }
+    if (nbCollisions != sc->nbCollisions) {
+        sc->nbCollisions = nbCollisions;
+        _scene_collisions_index_rebuild(sc, sc->collisionsIndexCapacity);
+    }
 
     // awake phase
-    FifoList *awakeQuery = fifo_list_new();
-    Box *awakeBox;
-    n = doubly_linked_list_first(sc->awakeBoxes);
-    while (n != NULL) {
+    RtreeLeaves *awakeQuery = &sc->physicsQuery;
+    RtreeNode *hit;
+    Transform *hitLeaf;
+    RigidBody *hitRb;
+    for (uint32_t i = 0; i < sc->nbAwakeBoxes; ++i) {
         // TODO: save groups in the list
-        awakeBox = (Box *)doubly_linked_list_node_pointer(n);
-
-        vx_assert(fifo_list_pop(awakeQuery) == NULL);
-        if (rtree_query_overlap_box(sc->rtree,
-                                    awakeBox,
-                                    PHYSICS_GROUP_ALL_SYSTEM,
-                                    PHYSICS_GROUP_ALL_SYSTEM,
-                                    NULL,
-                                    awakeQuery,
-                                    &float3_epsilon_collision) > 0) {
-            RtreeNode *hit = fifo_list_pop(awakeQuery);
-            Transform *hitLeaf = NULL;
-            RigidBody *hitRb = NULL;
-            while (hit != NULL) {
+        rtree_leaves_reset(awakeQuery);
+        if (rtree_query_overlap_box_leaves(sc->rtree,
+                                           &sc->awakeBoxes[i],
+                                           PHYSICS_GROUP_ALL_SYSTEM,
+                                           PHYSICS_GROUP_ALL_SYSTEM,
+                                           NULL,
+                                           awakeQuery,
+                                           &float3_epsilon_collision) > 0) {
+            for (size_t j = 0; j < awakeQuery->count; ++j) {
+                hit = awakeQuery->items[j];
                 hitLeaf = (Transform *)rtree_node_get_leaf_ptr(hit);
                 vx_assert(rtree_node_is_leaf(hit));
 
@@ -348,20 +934,21 @@ void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData) {
                 vx_assert(hitRb != NULL);
 
                 rigidbody_set_awake(hitRb);
-
-                hit = fifo_list_pop(awakeQuery);
             }
 #if DEBUG_SCENE_CALLS
             debug_scene_awake_queries++;
 #endif
         }
+    }
+    sc->nbAwakeBoxes = 0;
 
-        DoublyLinkedListNode *next = doubly_linked_list_node_next(n);
-        doubly_linked_list_delete_node(sc->awakeBoxes, n);
-        n = next;
-        box_free(awakeBox);
+    // a batch of objects spawned in the same frame is packed w/ a bulk-load of the whole tree,
+    // leaves stay in place & only branches are rebuilt, masks are then refreshed below
+    if (sc->nbNewLeaves >= SCENE_RTREE_REBUILD_MIN_LEAVES &&
+        sc->nbNewLeaves * 2 >= rtree_get_nb_leaves(sc->rtree)) {
+        rtree_rebuild(sc->rtree);
     }
-    fifo_list_free(awakeQuery, NULL);
+    sc->nbNewLeaves = 0;
 
     // physics layers mask changes take effect in the rtree once each frame
     rtree_refresh_collision_masks(sc->rtree);
@@ -420,15 +1007,6 @@ void scene_register_managed_transform(Scene *sc, Transform *t) {
     transform_set_managed_ptr(t, sc->game);
 }
 
-bool _scene_register_collision_couple_func(void *ptr, void *data) {
-    const _CollisionCouple *cc1 = (_CollisionCouple *)ptr;
-    const _CollisionCouple *cc2 = (_CollisionCouple *)data;
-    return (weakptr_get(cc1->t1) == weakptr_get(cc2->t1) &&
-            weakptr_get(cc1->t2) == weakptr_get(cc2->t2)) ||
-           (weakptr_get(cc1->t1) == weakptr_get(cc2->t2) &&
-            weakptr_get(cc1->t2) == weakptr_get(cc2->t1));
-}
-
 CollisionCoupleStatus scene_register_collision_couple(Scene *sc,
                                                       Transform *t1,
                                                       Transform *t2,
@@ -438,31 +1016,37 @@ CollisionCoupleStatus scene_register_collision_couple(Scene *sc,
     }
     vx_assert(wNormal != NULL);
 
-    _CollisionCouple *newCC = (_CollisionCouple *)malloc(sizeof(_CollisionCouple));
-    if (newCC == NULL) {
+    if (_scene_collisions_reserve(sc) == false) {
         return CollisionCoupleStatus_Discard;
     }
-    newCC->t1 = transform_get_and_retain_weakptr(t1);
-    newCC->t2 = transform_get_and_retain_weakptr(t2);
-    newCC->wNormal = *wNormal;
-    newCC->flag = true;
-
-    _CollisionCouple *existingCC;
-    if (doubly_linked_list_contains_func(sc->collisions,
-                                         _scene_register_collision_couple_func,
-                                         newCC,
-                                         (void **)&existingCC)) {
-        _scene_collision_couple_free_func(newCC);
-        *wNormal = existingCC->wNormal;
-        if (existingCC->flag) {
-            return CollisionCoupleStatus_Discard;
-        } else {
-            existingCC->flag = true;
-            return CollisionCoupleStatus_Tick;
+
+    const uint32_t key = _scene_collision_couple_key(t1, t2);
+    uint32_t *slot = _scene_collisions_index_find(sc, key);
+    _CollisionCouple *cc;
+    if (*slot != 0) {
+        cc = &sc->collisions[*slot - 1];
+
+        // transform IDs are recycled, couple is still valid only if both transforms are alive
+        if (weakptr_get(cc->t1) != NULL && weakptr_get(cc->t2) != NULL) {
+            *wNormal = cc->wNormal;
+            if (cc->flag) {
+                return CollisionCoupleStatus_Discard;
+            } else {
+                cc->flag = true;
+                return CollisionCoupleStatus_Tick;
+            }
         }
+        weakptr_release(cc->t1);
+        weakptr_release(cc->t2);
+    } else {
+        *slot = ++sc->nbCollisions;
+        cc = &sc->collisions[*slot - 1];
+        cc->key = key;
     }
-
-    doubly_linked_list_push_last(sc->collisions, newCC);
+    cc->t1 = transform_get_and_retain_weakptr(t1);
+    cc->t2 = transform_get_and_retain_weakptr(t2);
+    cc->wNormal = *wNormal;
+    cc->flag = true;
 
     return CollisionCoupleStatus_Begin;
 }
@@ -472,6 +1056,8 @@ CollisionCoupleStatus scene_register_collision_couple(Scene *sc,
 void scene_set_constant_acceleration(Scene *sc, const float *x, const float *y, const float *z) {
     vx_assert(sc != NULL);
 
+    const float3 previous = sc->constantAcceleration;
+
     if (x != NULL) {
         sc->constantAcceleration.x = *x;
     }
@@ -481,6 +1067,11 @@ void scene_set_constant_acceleration(Scene *sc, const float *x, const float *y,
     if (z != NULL) {
         sc->constantAcceleration.x = *z;
     }
+
+    // sleeping rigidbodies have to be stepped w/ the new value
+    if (float3_isEqual(&previous, &sc->constantAcceleration, EPSILON_ZERO) == false) {
+        sc->wakeIdleBranches = true;
+    }
 }
 
 const float3 *scene_get_constant_acceleration(const Scene *sc) {
@@ -488,31 +1079,67 @@ const float3 *scene_get_constant_acceleration(const Scene *sc) {
     return &sc->constantAcceleration;
 }
 
-void scene_register_awake_box(Scene *sc, Box *b) {
+void scene_set_physics_pool(Scene *sc, ThreadPool *pool) {
+    sc->physicsPool = pool;
+}
+
+ThreadPool *scene_get_physics_pool(const Scene *sc) {
+    return sc->physicsPool;
+}
+
+size_t scene_get_nb_visited_transforms(const Scene *sc) {
+    return sc->nbVisited;
+}
+
+size_t scene_get_nb_idle_branches(const Scene *sc) {
+    return sc->nbIdleBranches;
+}
+
+size_t scene_get_nb_transforms(const Scene *sc) {
+    size_t count = 1;
+    transform_recurse(sc->root, _scene_count_func, &count, false);
+    return count;
+}
+
+RtreeLeaves *scene_get_physics_query(Scene *sc) {
+    vx_assert(sc != NULL);
+    return &sc->physicsQuery;
+}
+
+void scene_register_awake_box(Scene *sc, const Box *b) {
     float3 size;
     box_get_size_float(b, &size);
     if (float3_isZero(&size, EPSILON_COLLISION) == false) {
-        DoublyLinkedListNode *n = doubly_linked_list_first(sc->awakeBoxes);
-        Box *awakeBox;
-        while (n != NULL) {
-            awakeBox = doubly_linked_list_node_pointer(n);
-            if (box_collide_epsilon(awakeBox, b, EPSILON_ZERO)) {
-                box_op_merge(awakeBox, b, awakeBox);
-                box_free(b);
+        const uint32_t first = sc->nbAwakeBoxes > SCENE_AWAKE_BOXES_MERGE_WINDOW
+                                   ? sc->nbAwakeBoxes - SCENE_AWAKE_BOXES_MERGE_WINDOW
+                                   : 0;
+        for (uint32_t i = sc->nbAwakeBoxes; i > first; --i) {
+            if (box_collide_epsilon(&sc->awakeBoxes[i - 1], b, EPSILON_ZERO)) {
+                box_op_merge(&sc->awakeBoxes[i - 1], b, &sc->awakeBoxes[i - 1]);
                 return;
             }
-            n = doubly_linked_list_node_next(n);
         }
-        doubly_linked_list_push_last(sc->awakeBoxes, b);
+        if (sc->nbAwakeBoxes == sc->awakeBoxesCapacity) {
+            const uint32_t capacity = sc->awakeBoxesCapacity > 0
+                                          ? sc->awakeBoxesCapacity * 2
+                                          : SCENE_PHYSICS_SCRATCH_INITIAL_CAPACITY;
+            Box *awakeBoxes = (Box *)realloc(sc->awakeBoxes, capacity * sizeof(Box));
+            if (awakeBoxes == NULL) {
+                return;
+            }
+            sc->awakeBoxes = awakeBoxes;
+            sc->awakeBoxesCapacity = capacity;
+        }
+        sc->awakeBoxes[sc->nbAwakeBoxes++] = *b;
     }
 }
 
 void scene_register_awake_rigidbody_contacts(Scene *sc, RigidBody *rb) {
     if (rigidbody_get_rtree_leaf(rb) != NULL) {
-        Box *awakeBox = box_new_copy(rtree_node_get_aabb(rigidbody_get_rtree_leaf(rb)));
-        float3_op_add_scalar(&awakeBox->max, PHYSICS_AWAKE_DISTANCE);
-        float3_op_substract_scalar(&awakeBox->min, PHYSICS_AWAKE_DISTANCE);
-        scene_register_awake_box(sc, awakeBox);
+        Box awakeBox = *rtree_node_get_aabb(rigidbody_get_rtree_leaf(rb));
+        float3_op_add_scalar(&awakeBox.max, PHYSICS_AWAKE_DISTANCE);
+        float3_op_substract_scalar(&awakeBox.min, PHYSICS_AWAKE_DISTANCE);
+        scene_register_awake_box(sc, &awakeBox);
     }
 }
 
@@ -533,14 +1160,14 @@ void scene_register_awake_block_box(Scene *sc,
     float3 scale2;
     matrix4x4_get_scaleXYZ(&model, &scale2);
     float3_op_scale(&scale2, 0.5f);
-    Box *worldBox = box_new_2((float)worldPoint.x - scale2.x - PHYSICS_AWAKE_DISTANCE,
-                              (float)worldPoint.y - scale2.y - PHYSICS_AWAKE_DISTANCE,
-                              (float)worldPoint.z - scale2.z - PHYSICS_AWAKE_DISTANCE,
-                              (float)worldPoint.x + scale2.x + PHYSICS_AWAKE_DISTANCE,
-                              (float)worldPoint.y + scale2.y + PHYSICS_AWAKE_DISTANCE,
-                              (float)worldPoint.z + scale2.z + PHYSICS_AWAKE_DISTANCE);
-
-    scene_register_awake_box(sc, worldBox);
+    const Box worldBox = {{(float)worldPoint.x - scale2.x - PHYSICS_AWAKE_DISTANCE,
+                           (float)worldPoint.y - scale2.y - PHYSICS_AWAKE_DISTANCE,
+                           (float)worldPoint.z - scale2.z - PHYSICS_AWAKE_DISTANCE},
+                          {(float)worldPoint.x + scale2.x + PHYSICS_AWAKE_DISTANCE,
+                           (float)worldPoint.y + scale2.y + PHYSICS_AWAKE_DISTANCE,
+                           (float)worldPoint.z + scale2.z + PHYSICS_AWAKE_DISTANCE}};
+
+    scene_register_awake_box(sc, &worldBox);
 }
 
 CastResult scene_cast_result_default(void) {
@@ -554,6 +1181,65 @@ CastResult scene_cast_result_default(void) {
     return hit;
 }
 
+/// Confirms a ray cast broadphase hit w/ the leaf transform collider or blocks, 'hit' is replaced
+/// if this hit is closer
+static void _scene_cast_ray_leaf(Scene *sc,
+                                 Transform *hitTr,
+                                 const float rtreeDistance,
+                                 const Ray *worldRay,
+                                 CastResult *hit) {
+    RigidBody *hitRb = transform_get_rigidbody(hitTr);
+    const RigidbodyMode mode = rigidbody_get_simulation_mode(hitRb);
+
+    if (mode == RigidbodyMode_Dynamic) {
+        hit->hitTr = hitTr;
+        hit->distance = rtreeDistance;
+        hit->type = Hit_CollisionBox;
+    } else if (transform_get_type(hitTr) == ShapeTransform &&
+               rigidbody_uses_per_block_collisions(hitRb)) {
+
+        CastResult blockHit;
+        Block *b = scene_cast_ray_shape_only(sc,
+                                             hitTr,
+                                             transform_utils_get_shape(hitTr),
+                                             worldRay,
+                                             &blockHit);
+        if (b != NULL && blockHit.distance < hit->distance) {
+            *hit = blockHit;
+        }
+    } else {
+        Matrix4x4 invModel;
+        transform_utils_get_model_wtl(hitTr, &invModel);
+
+        // solve non-dynamic rigidbodies in their model space (rotated collider)
+        const Box *collider = rigidbody_get_collider(hitRb);
+        float3 origin, dir, invdir;
+        matrix4x4_op_multiply_vec_point(&origin, worldRay->origin, &invModel);
+        matrix4x4_op_multiply_vec_vector(&dir, worldRay->dir, &invModel);
+        float3_normalize(&dir);
+        float3_set(&invdir, 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+        const Ray modelRay = {&origin, &dir, &invdir};
+
+        float distance;
+        if (ray_intersect_with_box(&modelRay, &collider->min, &collider->max, &distance)) {
+            const float3 modelVector = {dir.x * distance, dir.y * distance, dir.z * distance};
+
+            Matrix4x4 model;
+            transform_utils_get_model_ltw(hitTr, &model);
+
+            float3 worldVector;
+            matrix4x4_op_multiply_vec_vector(&worldVector, &modelVector, &model);
+
+            distance = float3_length(&worldVector);
+            if (distance < hit->distance) {
+                hit->hitTr = hitTr;
+                hit->distance = distance;
+                hit->type = Hit_CollisionBox;
+            }
+        }
+    }
+}
+
 HitType scene_cast_ray(Scene *sc,
                        const Ray *worldRay,
                        uint16_t groups,
@@ -584,78 +1270,195 @@ HitType scene_cast_ray(Scene *sc,
         // process query results in order, to return first hit block or collision box
         DoublyLinkedListNode *n = doubly_linked_list_first(sceneQuery);
         RtreeCastResult *rtreeHit;
-        Transform *hitTr;
-        RigidBody *hitRb;
         while (n != NULL) {
             rtreeHit = (RtreeCastResult *)doubly_linked_list_node_pointer(n);
-            hitTr = (Transform *)rtree_node_get_leaf_ptr(rtreeHit->rtreeLeaf);
-            hitRb = transform_get_rigidbody(hitTr);
 
             // re-examine closer hits after updating hit.distance vs. per-block or rotated collider
             if (rtreeHit->distance >= hit.distance) {
                 break;
             }
 
-            const RigidbodyMode mode = rigidbody_get_simulation_mode(hitRb);
+            _scene_cast_ray_leaf(sc,
+                                 (Transform *)rtree_node_get_leaf_ptr(rtreeHit->rtreeLeaf),
+                                 rtreeHit->distance,
+                                 worldRay,
+                                 &hit);
 
-            if (mode == RigidbodyMode_Dynamic) {
-                hit.hitTr = hitTr;
-                hit.distance = rtreeHit->distance;
-                hit.type = Hit_CollisionBox;
-            } else if (transform_get_type(hitTr) == ShapeTransform &&
-                       rigidbody_uses_per_block_collisions(transform_get_rigidbody(hitTr))) {
+            n = doubly_linked_list_node_next(n);
+        }
+    }
+    doubly_linked_list_flush(sceneQuery, free);
+    doubly_linked_list_free(sceneQuery);
 
-                CastResult blockHit;
-                Block *b = scene_cast_ray_shape_only(sc,
-                                                     hitTr,
-                                                     transform_utils_get_shape(hitTr),
-                                                     worldRay,
-                                                     &blockHit);
-                if (b != NULL && blockHit.distance < hit.distance) {
-                    hit = blockHit;
-                }
-            } else {
-                Matrix4x4 invModel;
-                transform_utils_get_model_wtl(hitTr, &invModel);
+    if (result != NULL) {
+        *result = hit;
+    }
 
-                // solve non-dynamic rigidbodies in their model space (rotated collider)
-                const Box *collider = rigidbody_get_collider(hitRb);
-                Ray *modelRay = ray_transform(worldRay, &invModel);
+    return hit.type;
+}
 
-                float distance;
-                if (ray_intersect_with_box(modelRay, &collider->min, &collider->max, &distance)) {
-                    const float3 modelVector = {modelRay->dir->x * distance,
-                                                modelRay->dir->y * distance,
-                                                modelRay->dir->z * distance};
+typedef struct {
+    Scene *sc;
+    const Ray *const *worldRays;
+    const DoublyLinkedList *filterOutTransforms;
+    CastResult *results;
+    size_t count;
+    uint16_t groups;
 
-                    Matrix4x4 model;
-                    transform_utils_get_model_ltw(hitTr, &model);
+    char pad[6];
+} _SceneCastRaysBatch;
 
-                    float3 worldVector;
-                    matrix4x4_op_multiply_vec_vector(&worldVector, &modelVector, &model);
+/// broadphase hit of a ray in a packet
+typedef struct {
+    RtreeNode *leaf;
+    float distance;
+    uint8_t rayIdx;
 
-                    distance = float3_length(&worldVector);
-                    if (distance < hit.distance) {
-                        hit.hitTr = hitTr;
-                        hit.distance = distance;
-                        hit.type = Hit_CollisionBox;
-                    }
-                }
+    char pad[3];
+} _SceneCastRaysCandidate;
 
-                ray_free(modelRay);
-            }
+typedef struct {
+    _SceneCastRaysCandidate local[SCENE_CAST_RAYS_LOCAL_CANDIDATES];
+    float maxDistances[RTREE_RAYS_PACKET_SIZE];
+    _SceneCastRaysCandidate *candidates;
+    size_t nbCandidates, capacity;
+} _SceneCastRaysPacket;
+
+static void _scene_cast_rays_leaf_func(RtreeNode *leaf,
+                                       uint8_t rayIdx,
+                                       float distance,
+                                       void *ptr) {
+    _SceneCastRaysPacket *packet = (_SceneCastRaysPacket *)ptr;
+
+    if (packet->nbCandidates == packet->capacity) {
+        const size_t capacity = packet->capacity * 2;
+        _SceneCastRaysCandidate *candidates = (_SceneCastRaysCandidate *)malloc(
+            capacity * sizeof(_SceneCastRaysCandidate));
+        if (candidates == NULL) {
+            return;
+        }
+        memcpy(candidates,
+               packet->candidates,
+               packet->nbCandidates * sizeof(_SceneCastRaysCandidate));
+        if (packet->candidates != packet->local) {
+            free(packet->candidates);
+        }
+        packet->candidates = candidates;
+        packet->capacity = capacity;
+    }
 
-            n = doubly_linked_list_node_next(n);
+    _SceneCastRaysCandidate *c = &packet->candidates[packet->nbCandidates++];
+    c->leaf = leaf;
+    c->distance = distance;
+    c->rayIdx = rayIdx;
+
+    // a dynamic rigidbody is hit at its broadphase distance, farther nodes can be skipped for
+    // that ray ; other hits are only known after sorting, see _scene_cast_ray_leaf
+    RigidBody *rb = transform_get_rigidbody((Transform *)rtree_node_get_leaf_ptr(leaf));
+    if (distance < packet->maxDistances[rayIdx] &&
+        rigidbody_get_simulation_mode(rb) == RigidbodyMode_Dynamic) {
+        packet->maxDistances[rayIdx] = distance;
+    }
+}
+
+static int _scene_cast_rays_candidate_cmp(const void *a, const void *b) {
+    const _SceneCastRaysCandidate *c1 = (const _SceneCastRaysCandidate *)a;
+    const _SceneCastRaysCandidate *c2 = (const _SceneCastRaysCandidate *)b;
+    if (c1->rayIdx != c2->rayIdx) {
+        return c1->rayIdx < c2->rayIdx ? -1 : 1;
+    }
+    if (c1->distance != c2->distance) {
+        return c1->distance < c2->distance ? -1 : 1;
+    }
+    return 0;
+}
+
+static void _scene_cast_rays_packet_job(void *ctx, const size_t idx) {
+    const _SceneCastRaysBatch *batch = (const _SceneCastRaysBatch *)ctx;
+    const size_t offset = idx * RTREE_RAYS_PACKET_SIZE;
+    const size_t nbRays = minimum(batch->count - offset, (size_t)RTREE_RAYS_PACKET_SIZE);
+
+    _SceneCastRaysPacket packet;
+    packet.candidates = packet.local;
+    packet.nbCandidates = 0;
+    packet.capacity = SCENE_CAST_RAYS_LOCAL_CANDIDATES;
+    for (size_t i = 0; i < nbRays; ++i) {
+        packet.maxDistances[i] = FLT_MAX;
+    }
+
+    // broadphase for the whole packet in one traversal
+    rtree_query_cast_rays(batch->sc->rtree,
+                          batch->worldRays + offset,
+                          (uint8_t)nbRays,
+                          PHYSICS_GROUP_NONE,
+                          batch->groups,
+                          batch->filterOutTransforms,
+                          packet.maxDistances,
+                          _scene_cast_rays_leaf_func,
+                          &packet);
+
+    // then process each ray hits in order, same as scene_cast_ray
+    qsort(packet.candidates,
+          packet.nbCandidates,
+          sizeof(_SceneCastRaysCandidate),
+          _scene_cast_rays_candidate_cmp);
+
+    const _SceneCastRaysCandidate *c;
+    for (size_t i = 0; i < packet.nbCandidates; ++i) {
+        c = &packet.candidates[i];
+        CastResult *hit = &batch->results[offset + c->rayIdx];
+
+        if (c->distance < hit->distance) {
+            _scene_cast_ray_leaf(batch->sc,
+                                 (Transform *)rtree_node_get_leaf_ptr(c->leaf),
+                                 c->distance,
+                                 batch->worldRays[offset + c->rayIdx],
+                                 hit);
         }
     }
-    doubly_linked_list_flush(sceneQuery, free);
-    doubly_linked_list_free(sceneQuery);
 
-    if (result != NULL) {
-        *result = hit;
+    if (packet.candidates != packet.local) {
+        free(packet.candidates);
     }
+}
 
-    return hit.type;
+size_t scene_cast_rays_batch(Scene *sc,
+                             const Ray *const *worldRays,
+                             const size_t count,
+                             uint16_t groups,
+                             const DoublyLinkedList *filterOutTransforms,
+                             ThreadPool *pool,
+                             CastResult *results) {
+
+    if (worldRays == NULL || results == NULL) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = scene_cast_result_default();
+    }
+
+    if (groups == PHYSICS_GROUP_NONE) {
+        return 0;
+    }
+
+    const _SceneCastRaysBatch batch = {sc,
+                                       worldRays,
+                                       filterOutTransforms,
+                                       results,
+                                       count,
+                                       groups,
+                                       {0, 0, 0, 0, 0, 0}};
+    const size_t nbPackets = (count + RTREE_RAYS_PACKET_SIZE - 1) / RTREE_RAYS_PACKET_SIZE;
+    thread_pool_parallel_for(pool, nbPackets, _scene_cast_rays_packet_job, (void *)&batch);
+
+    size_t hits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (results[i].type != Hit_None) {
+            hits++;
+        }
+    }
+    return hits;
 }
 
 size_t scene_cast_all_ray(Scene *sc,
@@ -14,6 +14,7 @@ extern "C" {
 #include "rigidBody.h"
 #include "rtree.h"
 #include "shape.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 #if DEBUG
@@ -49,6 +50,13 @@ Rtree *scene_get_rtree(Scene *sc);
 /// Perform transform refreshes, update the r-tree, step the physics engine,
 /// handle transform removal and collision callbacks
 void scene_refresh(Scene *sc, const TICK_DELTA_SEC_T dt, void *callbackData);
+/// Refresh statistics: a branch w/ nothing to refresh or simulate, eg. static shapes or sleeping
+/// rigidbodies, is flagged idle & skipped until woken up by any change in that branch. Returns the
+/// number of transforms visited & of idle branches skipped by last refresh, and the total number of
+/// transforms in the scene hierarchy (full traversal)
+size_t scene_get_nb_visited_transforms(const Scene *sc);
+size_t scene_get_nb_idle_branches(const Scene *sc);
+size_t scene_get_nb_transforms(const Scene *sc);
 
 /// A standalone refresh can be called to solely refresh transforms in special cases where waiting
 /// for end-of-frame isn't an option, overall it should be avoided
@@ -85,9 +93,23 @@ CollisionCoupleStatus scene_register_collision_couple(Scene *sc,
 
 void scene_set_constant_acceleration(Scene *sc, const float *x, const float *y, const float *z);
 const float3 *scene_get_constant_acceleration(const Scene *sc);
-
-/// Register a volume that will be processed during the awake phase
-void scene_register_awake_box(Scene *sc, Box *b);
+/// Steps dynamic rigidbodies by contact islands on given pool workers, or all in hierarchy order on
+/// the calling thread if NULL (default). The scene does not own the pool.
+/// Islands are built from the r-tree each frame, grouping rigidbodies whose trajectories may
+/// overlap, and each island steps its members in hierarchy order. Results are deterministic
+/// regardless of the number of workers: collision callbacks & pushes to rigidbodies outside of an
+/// island are applied after it is stepped, in islands order. Rigidbodies w/ physics descendants are
+/// always stepped during hierarchy traversal. Triggers & static rigidbodies w/ callbacks are ticked
+/// after islands, they see dynamic rigidbodies at their new positions ; in the serial step, they
+/// see those after them in hierarchy order at last frame's positions
+void scene_set_physics_pool(Scene *sc, ThreadPool *pool);
+ThreadPool *scene_get_physics_pool(const Scene *sc);
+/// Scratch array reused by the physics step for its r-tree queries, its storage is kept between
+/// frames, to be reset before each query
+RtreeLeaves *scene_get_physics_query(Scene *sc);
+
+/// Register a volume that will be processed during the awake phase, it is copied
+void scene_register_awake_box(Scene *sc, const Box *b);
 void scene_register_awake_rigidbody_contacts(Scene *sc, RigidBody *rb);
 void scene_register_awake_block_box(Scene *sc,
                                     const Transform *t,
@@ -131,6 +153,21 @@ size_t scene_cast_all_ray(Scene *sc,
                           uint16_t groups,
                           const DoublyLinkedList *filterOutTransforms,
                           DoublyLinkedList *results);
+/// Casts many rays w/ the same filters, results are the same as scene_cast_ray for each ray.
+/// Rays are cast by packets sharing a single r-tree traversal, packets are split across the given
+/// pool workers or cast on the calling thread if NULL. Scene must not be modified meanwhile.
+/// The pool is used exclusively for the whole call: other callers on the same pool, e.g. a scene
+/// refresh stepping physics on it, wait for it to return. It must not be called from one of the
+/// pool's own jobs
+/// @param results filled w/ 'count' results, in rays order
+/// @return number of rays that hit
+size_t scene_cast_rays_batch(Scene *sc,
+                             const Ray *const *worldRays,
+                             const size_t count,
+                             uint16_t groups,
+                             const DoublyLinkedList *filterOutTransforms,
+                             ThreadPool *pool,
+                             CastResult *results);
 Block *scene_cast_ray_shape_only(Scene *sc,
                                  const Transform *t,
                                  const Shape *sh,
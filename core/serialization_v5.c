@@ -397,34 +397,49 @@ uint32_t chunk_read_shape_process_blocks(Stream *s,
         return 0;
     }
 
-    uint32_t c;
-    SHAPE_COLOR_INDEX_INT_T colorIndex;
-    uint16_t block_z_pos;
-    uint16_t block_y_pos;
-    uint16_t block_x_pos;
-
-    for (uint32_t i = 0; i < cubeCount; i++) {
-        if (stream_read_uint8(s, &colorIndex) == false) {
-            cclog_error("failed to read cube");
-            return 0;
-        }
-        if (colorIndex == SHAPE_COLOR_INDEX_AIR_BLOCK) { // no cube
-            continue;
+    SHAPE_COLOR_INDEX_INT_T *blocks = (SHAPE_COLOR_INDEX_INT_T *)malloc(chunkSize);
+    SHAPE_COLOR_INDEX_INT_T *grid = (SHAPE_COLOR_INDEX_INT_T *)malloc(chunkSize);
+    if (blocks == NULL || grid == NULL) {
+        cclog_error("failed to allocate blocks");
+        free(blocks);
+        free(grid);
+        return 0;
+    }
+    if (stream_read(s, blocks, sizeof(SHAPE_COLOR_INDEX_INT_T), cubeCount) == false) {
+        cclog_error("failed to read cubes");
+        free(blocks);
+        free(grid);
+        return 0;
+    }
+
+    // blocks are stored z-major w/ x varying fastest, transpose to the grid layout expected by
+    // shape_fill_blocks_from_grid; default colors are translated in file order, once per index
+    ColorPalette *palette = shape_get_palette(shape);
+    uint16_t translated[UINT8_MAX + 1];
+    memset(translated, 0xFF, sizeof(translated));
+    SHAPE_COLOR_INDEX_INT_T colorIndex, entry;
+    uint32_t i = 0;
+
+    for (uint16_t z = 0; z < d; z++) {
+        for (uint16_t y = 0; y < h; y++) {
+            for (uint16_t x = 0; x < w; x++) {
+                colorIndex = blocks[i++];
+                if (useDefaultPalette && colorIndex != SHAPE_COLOR_INDEX_AIR_BLOCK) {
+                    if (translated[colorIndex] == UINT16_MAX) {
+                        entry = colorIndex;
+                        color_palette_check_and_add_default_color_2021(palette, colorIndex, &entry);
+                        translated[colorIndex] = entry;
+                    }
+                    colorIndex = (SHAPE_COLOR_INDEX_INT_T)translated[colorIndex];
+                }
+                grid[((uint32_t)x * h + y) * d + z] = colorIndex;
+            }
         }
-        c = i;
-        block_z_pos = (uint16_t)(c / (w * h));
-        c -= (uint32_t)(block_z_pos * (w * h));
-        block_y_pos = (uint16_t)(c / w);
-        c -= (uint32_t)(block_y_pos * w);
-        block_x_pos = (uint16_t)c;
-
-        shape_add_block(shape,
-                        colorIndex,
-                        (SHAPE_COORDS_INT_T)block_x_pos,
-                        (SHAPE_COORDS_INT_T)block_y_pos,
-                        (SHAPE_COORDS_INT_T)block_z_pos,
-                        useDefaultPalette);
     }
+    free(blocks);
+
+    shape_fill_blocks_from_grid(shape, grid, w, h, d);
+    free(grid);
     color_palette_clear_lighting_dirty(shape_get_palette(shape));
 
     return chunkSize + 4;
@@ -48,7 +48,8 @@ typedef enum P3sCompressionMethod {
 #define P3S_CHUNK_ID_SHAPE_PALETTE 22        // palette
 #define P3S_CHUNK_ID_OBJECT_COLLISION_BOX 23 // collision box
 #define P3S_CHUNK_ID_OBJECT_IS_HIDDEN 24     // isHidden
-#define P3S_CHUNK_ID_MAX 25                  // /!\ update this when adding chunks
+#define P3S_CHUNK_ID_SHAPE_BLOCKS_RLE 25     // run-length encoded blocks, replaces SHAPE_BLOCKS
+#define P3S_CHUNK_ID_MAX 26                  // /!\ update this when adding chunks
 
 // size of the chunk header, without chunk ID (it's already read at this point)
 #define CHUNK_V6_HEADER_NO_ID_SIZE (sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t))
@@ -57,6 +58,14 @@ typedef enum P3sCompressionMethod {
 // takes the 4 low bits of a and casts into uint8_t
 #define TO_UINT4(a) (uint8_t)((a) & 0x0F)
 
+// encoding version of SHAPE_BLOCKS_RLE sub-chunk, written as its first byte
+#define P3S_SHAPE_BLOCKS_RLE_VERSION 1
+// a run of N blocks is encoded as N (varint) + palette index (uint8)
+#define P3S_SHAPE_BLOCKS_RLE_MAX_RUN_SIZE (5 + sizeof(uint8_t))
+
+// opt-in until all supported clients read SHAPE_BLOCKS_RLE
+static bool _shapeBlocksRLEEnabled = false;
+
 // MARK: - Private functions prototypes -
 // MARK: Write as buffer -
 
@@ -75,6 +84,15 @@ bool chunk_v6_shape_create_and_write_compressed_buffer(const Shape *shape,
                                                        uint32_t *compressedSize,
                                                        void **compressedData);
 
+/// Encodes blocks within [start, end[ as runs of the same palette index, in the same x, y, z order
+/// as SHAPE_BLOCKS, function allocates data that must be freed by caller
+bool _chunk_v6_shape_blocks_create_rle_buffer(const Shape *shape,
+                                              const SHAPE_COORDS_INT3_T start,
+                                              const SHAPE_COORDS_INT3_T end,
+                                              const SHAPE_COLOR_INDEX_INT_T *paletteMapping,
+                                              uint32_t *size,
+                                              void **data);
+
 void _chunk_v6_palette_create_and_write_uncompressed_buffer(
     const ColorPalette *palette,
     uint32_t *uncompressedSize,
@@ -148,6 +166,15 @@ uint32_t chunk_v6_read_shape_process_blocks(void *cursor,
                                             uint8_t paletteID,
                                             ColorPalette *shrinkPalette);
 
+// same as chunk_v6_read_shape_process_blocks, for SHAPE_BLOCKS_RLE sub-chunk
+uint32_t chunk_v6_read_shape_process_blocks_rle(void *cursor,
+                                                Shape *shape,
+                                                uint16_t w,
+                                                uint16_t h,
+                                                uint16_t d,
+                                                uint8_t paletteID,
+                                                ColorPalette *shrinkPalette);
+
 // chunk_v6_read_shape allocates a new Shape if shape != NULL
 uint32_t chunk_v6_read_shape(Stream *s,
                              Shape **shape,
@@ -394,6 +421,14 @@ bool serialization_v6_save_shape_as_buffer(const Shape *const shape,
 }
 
 /// get preview data from save file path (caller must free *imageData)
+void serialization_v6_set_shape_blocks_rle_enabled(const bool enabled) {
+    _shapeBlocksRLEEnabled = enabled;
+}
+
+bool serialization_v6_is_shape_blocks_rle_enabled(void) {
+    return _shapeBlocksRLEEnabled;
+}
+
 bool serialization_v6_get_preview_data(Stream *s, void **imageData, uint32_t *size) {
 
     uint8_t i;
@@ -765,6 +800,45 @@ uint32_t chunk_v6_read_palette_id(Stream *s, uint8_t *paletteID) {
     return CHUNK_V6_HEADER_NO_ID_SIZE + chunkSize;
 }
 
+static SHAPE_COLOR_INDEX_INT_T _chunk_v6_read_shape_translate_color(
+    ColorPalette *palette,
+    SHAPE_COLOR_INDEX_INT_T colorIndex,
+    uint8_t paletteID,
+    ColorPalette *shrinkPalette) {
+    bool success = true;
+    // translate & shrink to a shape palette w/ only used colors if,
+    // 1) octree was serialized w/ a palette ID using any of the default palettes
+    if (paletteID == PALETTE_ID_IOS_ITEM_EDITOR_LEGACY) {
+        success = color_palette_check_and_add_default_color_pico8p(palette,
+                                                                   colorIndex,
+                                                                   &colorIndex);
+    } else if (paletteID == PALETTE_ID_2021) {
+        success = color_palette_check_and_add_default_color_2021(palette, colorIndex, &colorIndex);
+    }
+    // 2) octree was serialized w/ a palette that exceeds max size
+    else if (shrinkPalette != NULL) {
+        RGBAColor color = color_palette_get_color(shrinkPalette, colorIndex);
+        success = color_palette_check_and_add_color(palette, color, &colorIndex, false);
+    }
+    return success ? colorIndex : 0;
+}
+
+/// Same as _chunk_v6_read_shape_translate_color, each file color index is only translated once
+static SHAPE_COLOR_INDEX_INT_T _chunk_v6_read_shape_translate_color_cached(
+    uint16_t *translated,
+    ColorPalette *palette,
+    SHAPE_COLOR_INDEX_INT_T colorIndex,
+    uint8_t paletteID,
+    ColorPalette *shrinkPalette) {
+    if (translated[colorIndex] == UINT16_MAX) {
+        translated[colorIndex] = _chunk_v6_read_shape_translate_color(palette,
+                                                                      colorIndex,
+                                                                      paletteID,
+                                                                      shrinkPalette);
+    }
+    return (SHAPE_COLOR_INDEX_INT_T)translated[colorIndex];
+}
+
 uint32_t chunk_v6_read_shape_process_blocks(void *cursor,
                                             Shape *shape,
                                             uint16_t w,
@@ -775,43 +849,105 @@ uint32_t chunk_v6_read_shape_process_blocks(void *cursor,
     uint32_t size = 0;
     memcpy(&size, cursor, sizeof(uint32_t));
     cursor = (void *)((uint32_t *)cursor + 1);
-    SHAPE_COLOR_INDEX_INT_T colorIndex;
+
+    const size_t blockCount = (size_t)w * (size_t)h * (size_t)d;
+    if (size < blockCount * sizeof(SHAPE_COLOR_INDEX_INT_T)) {
+        cclog_error("shape blocks: truncated grid");
+        return size + sizeof(uint32_t);
+    }
+
+    // blocks are stored in the same order as expected by shape_fill_blocks_from_grid, colors are
+    // translated in place since chunk data is owned & released by the caller
+    SHAPE_COLOR_INDEX_INT_T *grid = (SHAPE_COLOR_INDEX_INT_T *)cursor;
     ColorPalette *palette = shape_get_palette(shape);
-    for (SHAPE_COORDS_INT_T x = 0; x < w; x++) { // shape blocks
-        for (SHAPE_COORDS_INT_T y = 0; y < h; y++) {
-            for (SHAPE_COORDS_INT_T z = 0; z < d; z++) {
-                colorIndex = *((SHAPE_COLOR_INDEX_INT_T *)cursor);
-                cursor = (void *)((SHAPE_COLOR_INDEX_INT_T *)cursor + 1);
-
-                if (colorIndex == SHAPE_COLOR_INDEX_AIR_BLOCK) { // no cube
-                    continue;
-                }
+    uint16_t translated[UINT8_MAX + 1];
+    memset(translated, 0xFF, sizeof(translated));
+
+    for (size_t i = 0; i < blockCount; ++i) {
+        if (grid[i] != SHAPE_COLOR_INDEX_AIR_BLOCK) {
+            grid[i] = _chunk_v6_read_shape_translate_color_cached(translated,
+                                                                  palette,
+                                                                  grid[i],
+                                                                  paletteID,
+                                                                  shrinkPalette);
+        }
+    }
+    shape_fill_blocks_from_grid(shape, grid, w, h, d);
+    color_palette_clear_lighting_dirty(palette);
 
-                bool success = true;
-                // translate & shrink to a shape palette w/ only used colors if,
-                // 1) octree was serialized w/ a palette ID using any of the default palettes
-                if (paletteID == PALETTE_ID_IOS_ITEM_EDITOR_LEGACY) {
-                    success = color_palette_check_and_add_default_color_pico8p(palette,
-                                                                               colorIndex,
-                                                                               &colorIndex);
-                } else if (paletteID == PALETTE_ID_2021) {
-                    success = color_palette_check_and_add_default_color_2021(palette,
-                                                                             colorIndex,
-                                                                             &colorIndex);
-                }
-                // 2) octree was serialized w/ a palette that exceeds max size
-                else if (shrinkPalette != NULL) {
-                    RGBAColor color = color_palette_get_color(shrinkPalette, colorIndex);
-                    success = color_palette_check_and_add_color(palette, color, &colorIndex, false);
-                }
-                if (success == false) {
-                    colorIndex = 0;
-                }
+    return size + sizeof(uint32_t);
+}
+
+uint32_t chunk_v6_read_shape_process_blocks_rle(void *cursor,
+                                                Shape *shape,
+                                                uint16_t w,
+                                                uint16_t h,
+                                                uint16_t d,
+                                                uint8_t paletteID,
+                                                ColorPalette *shrinkPalette) {
+    uint32_t size = 0;
+    memcpy(&size, cursor, sizeof(uint32_t));
+    cursor = (void *)((uint32_t *)cursor + 1);
 
-                shape_add_block(shape, colorIndex, x, y, z, false);
+    const uint8_t *bytes = (const uint8_t *)cursor;
+    const uint8_t *bytesEnd = bytes + size;
+
+    if (size == 0 || *bytes != P3S_SHAPE_BLOCKS_RLE_VERSION) {
+        cclog_error("shape blocks: unsupported encoding version");
+        return size + sizeof(uint32_t);
+    }
+    ++bytes;
+
+    const uint32_t blockCount = (uint32_t)w * (uint32_t)h * (uint32_t)d;
+    SHAPE_COLOR_INDEX_INT_T *grid = (SHAPE_COLOR_INDEX_INT_T *)malloc(
+        blockCount * sizeof(SHAPE_COLOR_INDEX_INT_T));
+    if (grid == NULL) {
+        cclog_error("shape blocks: can't allocate grid");
+        return size + sizeof(uint32_t);
+    }
+    memset(grid, SHAPE_COLOR_INDEX_AIR_BLOCK, blockCount * sizeof(SHAPE_COLOR_INDEX_INT_T));
+
+    ColorPalette *palette = shape_get_palette(shape);
+    uint16_t translated[UINT8_MAX + 1];
+    memset(translated, 0xFF, sizeof(translated));
+    SHAPE_COLOR_INDEX_INT_T colorIndex;
+    uint32_t idx = 0, run, shift;
+
+    while (bytes < bytesEnd && idx < blockCount) {
+        // run length (varint)
+        run = 0;
+        shift = 0;
+        while (bytes < bytesEnd && shift < 32) {
+            run |= (uint32_t)(*bytes & 0x7F) << shift;
+            shift += 7;
+            if ((*bytes++ & 0x80) == 0) {
+                break;
             }
         }
+        if (bytes >= bytesEnd) {
+            cclog_error("shape blocks: truncated run");
+            break;
+        }
+        colorIndex = *bytes++;
+
+        if (run > blockCount - idx) {
+            cclog_error("shape blocks: run exceeds shape size");
+            run = blockCount - idx;
+        }
+
+        // grid is initialized w/ air, only solid runs are written
+        if (colorIndex != SHAPE_COLOR_INDEX_AIR_BLOCK && run > 0) {
+            colorIndex = _chunk_v6_read_shape_translate_color_cached(translated,
+                                                                     palette,
+                                                                     colorIndex,
+                                                                     paletteID,
+                                                                     shrinkPalette);
+            memset(grid + idx, colorIndex, run * sizeof(SHAPE_COLOR_INDEX_INT_T));
+        }
+        idx += run;
     }
+    shape_fill_blocks_from_grid(shape, grid, w, h, d);
+    free(grid);
     color_palette_clear_lighting_dirty(palette);
 
     return size + sizeof(uint32_t);
@@ -854,6 +990,7 @@ uint32_t chunk_v6_read_shape(Stream *s,
     /// get shape data
     void *cursor = chunkData;
     void *shapeBlocksCursor = NULL;
+    bool shapeBlocksRLE = false;
 
     uint32_t totalSizeRead = 0;
     uint32_t sizeRead = 0;
@@ -994,10 +1131,12 @@ uint32_t chunk_v6_read_shape(Stream *s,
                 *shape = shape_make_2(shapeSettings->isMutable);
                 break;
             }
-            case P3S_CHUNK_ID_SHAPE_BLOCKS: {
+            case P3S_CHUNK_ID_SHAPE_BLOCKS:
+            case P3S_CHUNK_ID_SHAPE_BLOCKS_RLE: {
                 // Palette and size are required to read blocks, storing blocks position to process
                 // them later
                 shapeBlocksCursor = cursor;
+                shapeBlocksRLE = chunkID == P3S_CHUNK_ID_SHAPE_BLOCKS_RLE;
 
                 // shape blocks chunk size
                 memcpy(&sizeRead, cursor, sizeof(uint32_t));
@@ -1166,7 +1305,15 @@ uint32_t chunk_v6_read_shape(Stream *s,
     }
 
     // process blocks now
-    if (shapeBlocksCursor != NULL) {
+    if (shapeBlocksCursor != NULL && shapeBlocksRLE) {
+        chunk_v6_read_shape_process_blocks_rle(shapeBlocksCursor,
+                                               *shape,
+                                               width,
+                                               height,
+                                               depth,
+                                               paletteID,
+                                               shrinkPalette ? filePalette : NULL);
+    } else if (shapeBlocksCursor != NULL) {
         chunk_v6_read_shape_process_blocks(shapeBlocksCursor,
                                            *shape,
                                            width,
@@ -1448,6 +1595,21 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
                                                                &paletteMapping);
     }
 
+    // blocks are run-length encoded if enabled, unless it doesn't save space over the dense grid
+    uint32_t shapeBlocksRLESize = 0;
+    void *shapeBlocksRLEData = NULL;
+    if (_shapeBlocksRLEEnabled &&
+        _chunk_v6_shape_blocks_create_rle_buffer(shape,
+                                                 start,
+                                                 end,
+                                                 paletteMapping,
+                                                 &shapeBlocksRLESize,
+                                                 &shapeBlocksRLEData) &&
+        shapeBlocksRLESize >= blockCount) {
+        free(shapeBlocksRLEData);
+        shapeBlocksRLEData = NULL;
+    }
+
     const char *name = transform_get_name(shape_get_root_transform(shape));
     uint8_t nameLen = 0;
     if (name != NULL) {
@@ -1465,7 +1627,8 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
     uint32_t objectCollisionBoxSize = sizeof(float3) * 2;
     uint32_t objectIsHiddenSelfSize = sizeof(uint8_t);
     uint32_t shapeLocalTransformSize = sizeof(LocalTransform);
-    uint32_t shapeBlocksSize = blockCount * sizeof(uint8_t);
+    uint32_t shapeBlocksSize = shapeBlocksRLEData != NULL ? shapeBlocksRLESize
+                                                          : blockCount * sizeof(uint8_t);
     uint32_t shapeLightingSize = blockCount * sizeof(VERTEX_LIGHT_STRUCT_T);
     uint32_t nameLenSize = sizeof(uint8_t);
 
@@ -1531,6 +1694,7 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
     *uncompressedData = malloc(*uncompressedSize);
     if (*uncompressedData == NULL) {
         free(shapePaletteData);
+        free(shapeBlocksRLEData);
         return false;
     }
 
@@ -1657,25 +1821,35 @@ bool chunk_v6_shape_create_and_write_uncompressed_buffer(const Shape *shape,
     }
 
     // shape blocks sub-chunk
-    *((uint8_t *)cursor) = P3S_CHUNK_ID_SHAPE_BLOCKS; // shape blocks chunk ID
-    cursor = (void *)((uint8_t *)cursor + 1);
-    *((uint32_t *)cursor) = shapeBlocksSize; // shape blocks chunk size
-    cursor = (void *)((uint32_t *)cursor + 1);
-    for (int x = start.x; x < end.x; ++x) { // shape blocks
-        for (int y = start.y; y < end.y; ++y) {
-            for (int z = start.z; z < end.z; ++z) {
-                block = shape_get_block(shape,
-                                        (SHAPE_COORDS_INT_T)x,
-                                        (SHAPE_COORDS_INT_T)y,
-                                        (SHAPE_COORDS_INT_T)z);
-                if (block_is_solid(block)) {
-                    *((uint8_t *)cursor) = paletteMapping != NULL
-                                               ? paletteMapping[block_get_color_index(block)]
-                                               : block_get_color_index(block);
-                } else {
-                    *((uint8_t *)cursor) = SHAPE_COLOR_INDEX_AIR_BLOCK;
+    if (shapeBlocksRLEData != NULL) {
+        *((uint8_t *)cursor) = P3S_CHUNK_ID_SHAPE_BLOCKS_RLE; // shape blocks chunk ID
+        cursor = (void *)((uint8_t *)cursor + 1);
+        *((uint32_t *)cursor) = shapeBlocksSize; // shape blocks chunk size
+        cursor = (void *)((uint32_t *)cursor + 1);
+        memcpy(cursor, shapeBlocksRLEData, shapeBlocksSize);
+        cursor = (void *)((uint8_t *)cursor + shapeBlocksSize);
+        free(shapeBlocksRLEData);
+    } else {
+        *((uint8_t *)cursor) = P3S_CHUNK_ID_SHAPE_BLOCKS; // shape blocks chunk ID
+        cursor = (void *)((uint8_t *)cursor + 1);
+        *((uint32_t *)cursor) = shapeBlocksSize; // shape blocks chunk size
+        cursor = (void *)((uint32_t *)cursor + 1);
+        for (int x = start.x; x < end.x; ++x) { // shape blocks
+            for (int y = start.y; y < end.y; ++y) {
+                for (int z = start.z; z < end.z; ++z) {
+                    block = shape_get_block(shape,
+                                            (SHAPE_COORDS_INT_T)x,
+                                            (SHAPE_COORDS_INT_T)y,
+                                            (SHAPE_COORDS_INT_T)z);
+                    if (block_is_solid(block)) {
+                        *((uint8_t *)cursor) = paletteMapping != NULL
+                                                   ? paletteMapping[block_get_color_index(block)]
+                                                   : block_get_color_index(block);
+                    } else {
+                        *((uint8_t *)cursor) = SHAPE_COLOR_INDEX_AIR_BLOCK;
+                    }
+                    cursor = (void *)((uint8_t *)cursor + 1);
                 }
-                cursor = (void *)((uint8_t *)cursor + 1);
             }
         }
     }
@@ -1858,6 +2032,93 @@ bool chunk_v6_shape_create_and_write_compressed_buffer(const Shape *shape,
     return true;
 }
 
+/// Appends a run to the buffer, growing it if needed
+static bool _chunk_v6_shape_blocks_write_run(uint8_t **bytes,
+                                             size_t *count,
+                                             size_t *capacity,
+                                             uint32_t run,
+                                             const SHAPE_COLOR_INDEX_INT_T colorIndex) {
+    if (*count + P3S_SHAPE_BLOCKS_RLE_MAX_RUN_SIZE > *capacity) {
+        uint8_t *grown = (uint8_t *)realloc(*bytes, *capacity * 2);
+        if (grown == NULL) {
+            return false;
+        }
+        *bytes = grown;
+        *capacity *= 2;
+    }
+    while (run >= 0x80) {
+        (*bytes)[(*count)++] = (uint8_t)((run & 0x7F) | 0x80);
+        run >>= 7;
+    }
+    (*bytes)[(*count)++] = (uint8_t)run;
+    (*bytes)[(*count)++] = colorIndex;
+    return true;
+}
+
+bool _chunk_v6_shape_blocks_create_rle_buffer(const Shape *shape,
+                                              const SHAPE_COORDS_INT3_T start,
+                                              const SHAPE_COORDS_INT3_T end,
+                                              const SHAPE_COLOR_INDEX_INT_T *paletteMapping,
+                                              uint32_t *size,
+                                              void **data) {
+    size_t capacity = 256;
+    uint8_t *bytes = (uint8_t *)malloc(capacity);
+    if (bytes == NULL) {
+        return false;
+    }
+    bytes[0] = P3S_SHAPE_BLOCKS_RLE_VERSION;
+    size_t count = 1;
+
+    const Block *block;
+    SHAPE_COLOR_INDEX_INT_T colorIndex, runColorIndex = SHAPE_COLOR_INDEX_AIR_BLOCK;
+    uint32_t run = 0;
+    bool success = true;
+
+    for (int x = start.x; x < end.x && success; ++x) {
+        for (int y = start.y; y < end.y && success; ++y) {
+            for (int z = start.z; z < end.z && success; ++z) {
+                block = shape_get_block(shape,
+                                        (SHAPE_COORDS_INT_T)x,
+                                        (SHAPE_COORDS_INT_T)y,
+                                        (SHAPE_COORDS_INT_T)z);
+                if (block_is_solid(block)) {
+                    colorIndex = paletteMapping != NULL
+                                     ? paletteMapping[block_get_color_index(block)]
+                                     : block_get_color_index(block);
+                } else {
+                    colorIndex = SHAPE_COLOR_INDEX_AIR_BLOCK;
+                }
+
+                if (run > 0 && colorIndex != runColorIndex) {
+                    success = _chunk_v6_shape_blocks_write_run(&bytes,
+                                                               &count,
+                                                               &capacity,
+                                                               run,
+                                                               runColorIndex);
+                    run = 0;
+                }
+                runColorIndex = colorIndex;
+                ++run;
+            }
+        }
+    }
+    if (success && run > 0) {
+        success = _chunk_v6_shape_blocks_write_run(&bytes,
+                                                   &count,
+                                                   &capacity,
+                                                   run,
+                                                   runColorIndex);
+    }
+    if (success == false) {
+        free(bytes);
+        return false;
+    }
+
+    *size = (uint32_t)count;
+    *data = bytes;
+    return true;
+}
+
 void _chunk_v6_palette_create_and_write_uncompressed_buffer(
     const ColorPalette *palette,
     uint32_t *uncompressedSize,
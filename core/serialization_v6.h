@@ -50,6 +50,11 @@ bool serialization_v6_save_shape_as_buffer(const Shape *const shape,
                                            void **const outBuffer,
                                            uint32_t *const outBufferSize);
 
+/// Shapes blocks are written as a SHAPE_BLOCKS_RLE sub-chunk when enabled & smaller than the
+/// dense grid. Readers older than this sub-chunk skip it & load an empty shape, disabled by default
+void serialization_v6_set_shape_blocks_rle_enabled(const bool enabled);
+bool serialization_v6_is_shape_blocks_rle_enabled(void);
+
 /// get preview data from save file path (caller must free *imageData)
 bool serialization_v6_get_preview_data(Stream *s, void **imageData, uint32_t *size);
 
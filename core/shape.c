@@ -17,8 +17,10 @@
 #include "history.h"
 #include "rigidBody.h"
 #include "scene.h"
+#include "thread_pool.h"
 #include "transaction.h"
 #include "utils.h"
+#include "zlib.h"
 
 #ifdef DEBUG
 #define SHAPE_LIGHTING_DEBUG false
@@ -36,12 +38,25 @@
 #define SHAPE_RENDERING_FLAG_BAKED_LIGHTING 8
 // no automatic refresh, no model changes until unlocked
 #define SHAPE_RENDERING_FLAG_BAKE_LOCKED 16
+// whether or not to merge coplanar faces w/ identical color, AO & lighting into larger quads
+#define SHAPE_RENDERING_FLAG_GREEDY_MESHING 32
+// whether or not the shape may draw the vertex buffers of a shape w/ identical content
+#define SHAPE_RENDERING_FLAG_MESH_SHARING 64
+// rendering flags affecting what is written in the vertex buffers
+#define SHAPE_RENDERING_FLAGS_MESH                                                                 \
+    (SHAPE_RENDERING_FLAG_INNER_TRANSPARENT_FACES | SHAPE_RENDERING_FLAG_BAKED_LIGHTING |          \
+     SHAPE_RENDERING_FLAG_GREEDY_MESHING)
 
 #define SHAPE_LUA_FLAG_NONE 0
 #define SHAPE_LUA_FLAG_MUTABLE 1
 #define SHAPE_LUA_FLAG_HISTORY 2
 #define SHAPE_LUA_FLAG_HISTORY_KEEP_PENDING 4
 
+// chunks hit by a box cast or overlap kept on the stack, before using the heap
+#define SHAPE_BOX_CAST_LOCAL_HITS 32
+// initial number of slots in the shared meshes index, then doubles when 3/4 full
+#define SHAPE_SHARED_MESHES_INITIAL_CAPACITY 64
+
 struct _Shape {
     Weakptr *wptr;
 
@@ -63,6 +78,15 @@ struct _Shape {
     // buffers storing vertex data used for rendering, latest buffer is inserted after first
     VertexBuffer *firstVB_opaque, *firstVB_transparent;
 
+    // mesh sharing, see shape_toggle_mesh_sharing: shape whose vertex buffers are drawn instead of
+    // this shape's own, or shapes drawing this shape's vertex buffers & its key in shared meshes
+    Shape *meshOwner;
+    DoublyLinkedList *meshInstances;
+    uint64_t meshHash;
+    // versions of the instance's palette & of its owner's when it started drawing the owner's
+    // vertex buffers, which encode the owner's palette atlas indices
+    uint32_t meshPaletteVersion, meshOwnerPaletteVersion;
+
     // Chunks are indexed by coordinates, and partitioned in a r-tree for physics queries
     Index3D *chunks;
     FifoList *dirtyChunks;
@@ -97,20 +121,80 @@ struct _Shape {
     uint8_t renderingFlags; // 1 byte
     uint8_t luaFlags;       // 1 byte
 
-    char pad[1];
+    // storage used for new chunks
+    ChunkStorage chunkStorage; // 1 byte
+
+    // whether the shape is in shared meshes, its instances can draw its vertex buffers
+    bool meshRegistered; // 1 byte
+    // whether the shape was an instance of an owner that stopped sharing its mesh, it has to mesh
+    // its own on next refresh
+    bool meshReleased; // 1 byte
 };
 
+// worker threads shared by all shapes to mesh chunks & bake lighting, created on first use.
+// These globals are guarded by thread_pool_shared_lock
+static ThreadPool *_workersPool = NULL;
+static bool _workersPoolReady = false;
+// number of callers currently using the pool, it can't be freed until this is back to 0
+static uint32_t _workersPoolUsers = 0;
+// number of workers to create, or -1 to use available cores
+static int _nbWorkers = -1;
+
+// shapes owning vertex buffers that shapes w/ identical content may draw, indexed by open
+// addressing on their mesh hash. Several owners may have the same hash if their content differs.
+// Shapes may be meshed on several threads: the index, and the owner/instances links between
+// shapes, are guarded by thread_pool_shared_lock
+static Shape **_sharedMeshes = NULL;
+static size_t _sharedMeshesCapacity = 0;
+static size_t _sharedMeshesCount = 0;
+
+/// region of chunk columns owning its blocks lighting, when baking lighting in parallel
+typedef struct _LightRegion _LightRegion;
+
 // MARK: - private functions prototypes -
 
 static void _shape_toggle_rendering_flag(Shape *s, const uint8_t flag, const bool toggle);
+/// returns NULL if work should be done on the calling thread only, otherwise the pool must be
+/// given back w/ _shape_release_workers_pool once done
+static ThreadPool *_shape_acquire_workers_pool(void);
+static void _shape_release_workers_pool(ThreadPool *pool);
 static bool _shape_get_rendering_flag(const Shape *s, const uint8_t flag);
 static void _shape_toggle_lua_flag(Shape *s, const uint8_t flag, const bool toggle);
 static bool _shape_get_lua_flag(const Shape *s, const uint8_t flag);
 
 void _shape_chunk_enqueue_refresh(Shape *shape, Chunk *c);
+/// content hash of everything written in the shape's vertex buffers
+static uint64_t _shape_get_mesh_hash(Shape *s);
+/// whether both shapes would write the same vertex buffers, hash collisions are ruled out by
+/// comparing their content
+static bool _shape_mesh_equals(const Shape *a, const Shape *b);
+/// whether an instance's palette or its owner's changed colors since it started drawing the
+/// owner's vertex buffers
+static bool _shape_mesh_palettes_changed(const Shape *s);
+/// returns the slot of given shape in shared meshes, or of the empty slot ending its probe sequence
+static size_t _shape_mesh_index_find(const Shape *s, const uint64_t hash);
+/// returns true if the shape now draws the vertex buffers of a shared mesh w/ the same content
+static bool _shape_mesh_share(Shape *s, const uint64_t hash);
+static void _shape_mesh_register(Shape *s, const uint64_t hash);
+/// must be called w/ thread_pool_shared_lock held
+static void _shape_mesh_unregister(Shape *s);
+static void _shape_mesh_enqueue_all_chunks(Shape *s);
+/// stops sharing shape's mesh before it is modified or freed. An owner keeps its vertex buffers,
+/// its instances are released and mesh their own on their next refresh
+/// @param remesh whether or not all chunks of an instance should be refreshed, for it to get its
+/// own mesh
+static void _shape_mesh_detach(Shape *s, const bool remesh);
+/// computes chunks faces in parallel if possible, then writes them in given order
+static void _shape_mesh_chunks(Shape *shape, Chunk **chunks, const size_t count);
 void _shape_chunk_check_neighbors_dirty(Shape *shape,
                                         const Chunk *chunk,
                                         CHUNK_COORDS_INT3_T block_pos);
+/// returns the chunk at given chunk coordinates, inserting a new one if needed, its r-tree leaf
+/// is either inserted or appended to 'newLeaves' if not NULL, to be bulk-loaded by the caller
+static Chunk *_shape_get_or_add_chunk(Shape *shape,
+                                      const SHAPE_COORDS_INT3_T chunk_coords,
+                                      RtreeLeaves *newLeaves,
+                                      bool *chunkAdded);
 static bool _shape_add_block_in_chunks(Shape *shape,
                                        const Block block,
                                        const SHAPE_COORDS_INT_T x,
@@ -143,8 +227,10 @@ void _light_removal_process_neighbor(Shape *s,
                                      const Block *neighbor,
                                      LightNodeQueue *lightQueue,
                                      LightRemovalNodeQueue *lightRemovalQueue);
-/// insert light values and if necessary (lightQueue != NULL) add it to the light propagation queue
-void _light_set_and_enqueue_source(Shape *shape,
+/// insert light values and if necessary (lightQueue != NULL) add it to the light propagation queue,
+/// if region != NULL and doesn't own the block, it is deferred to its owner
+void _light_set_and_enqueue_source(_LightRegion *region,
+                                   Shape *shape,
                                    Chunk *c,
                                    CHUNK_COORDS_INT3_T coords_in_chunk,
                                    SHAPE_COORDS_INT3_T coords_in_shape,
@@ -156,8 +242,10 @@ void _light_enqueue_ambient_and_block_sources(Shape *s,
                                               SHAPE_COORDS_INT3_T min,
                                               SHAPE_COORDS_INT3_T max,
                                               bool enqueueAir);
-/// propagate light values at a given block
-void _light_block_propagate(Shape *s,
+/// propagate light values at a given block, if region != NULL and doesn't own the block, it is
+/// deferred to its owner
+void _light_block_propagate(_LightRegion *region,
+                            Shape *s,
                             Chunk *c,
                             SHAPE_COORDS_INT3_T *bbMin,
                             SHAPE_COORDS_INT3_T *bbMax,
@@ -180,6 +268,20 @@ void _light_propagate(Shape *s,
                       SHAPE_COORDS_INT_T srcY,
                       SHAPE_COORDS_INT_T srcZ,
                       bool initWithEmptyLight);
+/// propagation loop, processes all nodes in lightQueue & expands changed values bounding box
+void _light_propagate_nodes(Shape *s,
+                            SHAPE_COORDS_INT3_T *bbMin,
+                            SHAPE_COORDS_INT3_T *bbMax,
+                            LightNodeQueue *lightQueue,
+                            _LightRegion *region,
+                            bool initWithEmptyLight);
+/// same result as _light_propagate w/ source above the volume, lighting is propagated in regions
+/// of chunk columns in parallel. Returns false if shape is too small to be split into regions
+static bool _light_propagate_parallel(Shape *s,
+                                      ThreadPool *pool,
+                                      SHAPE_COORDS_INT3_T *bbMin,
+                                      SHAPE_COORDS_INT3_T *bbMax,
+                                      LightNodeQueue *lightQueue);
 /// light removal also enqueues back any light source that needs recomputing
 void _light_removal(Shape *s,
                     SHAPE_COORDS_INT3_T *bbMin,
@@ -243,6 +345,14 @@ Shape *shape_make(void) {
     s->vbAllocationFlag_opaque = 0;
     s->vbAllocationFlag_transparent = 0;
 
+    s->meshOwner = NULL;
+    s->meshInstances = NULL;
+    s->meshRegistered = false;
+    s->meshReleased = false;
+    s->meshHash = 0;
+    s->meshPaletteVersion = 0;
+    s->meshOwnerPaletteVersion = 0;
+
     s->history = NULL;
     s->fullname = NULL;
     s->pendingTransaction = NULL;
@@ -257,6 +367,7 @@ Shape *shape_make(void) {
     s->layers = 1; // CAMERA_LAYERS_DEFAULT
 
     s->luaFlags = SHAPE_LUA_FLAG_NONE;
+    s->chunkStorage = CHUNK_STORAGE_OCTREE;
 
     return s;
 }
@@ -310,19 +421,30 @@ Shape *shape_make_copy(Shape *const origin) {
 
     s->bbMin = origin->bbMin;
     s->bbMax = origin->bbMax;
+    s->nbBlocks = origin->nbBlocks;
+    s->nbChunks = origin->nbChunks;
 
     s->drawMode = origin->drawMode;
     s->renderingFlags = origin->renderingFlags;
     s->layers = origin->layers;
 
     s->luaFlags = origin->luaFlags;
+    s->chunkStorage = origin->chunkStorage;
 
-    // copy chunks data
+    // copy chunks, their blocks & lighting are shared until first write, r-tree leaves are
+    // bulk-loaded once all chunks are copied
+    RtreeLeaves chunksLeaves;
+    rtree_leaves_init(&chunksLeaves, NULL, 0);
     Index3DIterator *chunks_it = index3d_iterator_new(origin->chunks);
     Chunk *chunk, *chunkCopy;
+    bool chunksCopied = true;
     while (index3d_iterator_pointer(chunks_it) != NULL) {
         chunk = index3d_iterator_pointer(chunks_it);
         chunkCopy = chunk_new_copy(chunk);
+        if (chunkCopy == NULL) {
+            chunksCopied = false;
+            break;
+        }
 
         const SHAPE_COORDS_INT3_T chunkOrigin = chunk_get_origin(chunk);
         const SHAPE_COORDS_INT3_T chunkCoords = chunk_utils_get_coords(chunkOrigin);
@@ -336,8 +458,11 @@ Shape *shape_make_copy(Shape *const origin) {
                         {(float)(chunkOrigin.x + CHUNK_SIZE),
                          (float)(chunkOrigin.y + CHUNK_SIZE),
                          (float)(chunkOrigin.z + CHUNK_SIZE)}};
-        chunk_set_rtree_leaf(chunkCopy,
-                             rtree_create_and_insert(s->rtree, &chunkBox, 1, 1, chunkCopy));
+        RtreeNode *leaf = rtree_create_leaf(s->rtree, &chunkBox, 1, 1, chunkCopy);
+        if (rtree_leaves_push(&chunksLeaves, leaf) == false) {
+            rtree_insert(s->rtree, leaf);
+        }
+        chunk_set_rtree_leaf(chunkCopy, leaf);
 
         // enqueue new shape buffers
         _shape_chunk_enqueue_refresh(s, chunkCopy);
@@ -345,6 +470,13 @@ Shape *shape_make_copy(Shape *const origin) {
         index3d_iterator_next(chunks_it);
     }
     index3d_iterator_free(chunks_it);
+    rtree_bulk_load(s->rtree, chunksLeaves.items, chunksLeaves.count);
+    rtree_leaves_free(&chunksLeaves);
+    if (chunksCopied == false) {
+        cclog_error("🔥 shape_make_copy: failed to copy chunks");
+        shape_free(s);
+        return NULL;
+    }
 
     if (origin->fullname != NULL) {
         s->fullname = string_new_copy(origin->fullname);
@@ -380,6 +512,8 @@ Shape *shape_make_copy(Shape *const origin) {
 
 void shape_flush(Shape *shape) {
     if (shape != NULL) {
+        _shape_mesh_detach(shape, false);
+
         // remove own blocks count from (potentially shared) palette
         const uint8_t count = color_palette_get_count(shape->palette);
         for (uint8_t i = 0; i < count; ++i) {
@@ -446,6 +580,8 @@ void shape_free(Shape *const shape) {
 
     weakptr_invalidate(shape->wptr);
 
+    _shape_mesh_detach(shape, false);
+
     if (shape->palette != NULL) {
         // remove own blocks count from (potentially shared) palette
         const uint8_t count = color_palette_get_count(shape->palette);
@@ -554,6 +690,7 @@ bool shape_add_block_as_transaction(Shape *const shape,
         if (shape->history != NULL) {
             history_discardTransactionsMoreRecentThanCursor(shape->history);
         }
+        transform_set_idle_branch(shape->transform, false);
     }
 
     if (transaction_addBlock(shape->pendingTransaction, x, y, z, colorIndex)) {
@@ -586,6 +723,7 @@ bool shape_remove_block_as_transaction(Shape *const shape,
         if (shape->history != NULL) {
             history_discardTransactionsMoreRecentThanCursor(shape->history);
         }
+        transform_set_idle_branch(shape->transform, false);
     }
 
     transaction_removeBlock(shape->pendingTransaction, x, y, z);
@@ -623,6 +761,7 @@ bool shape_paint_block_as_transaction(Shape *const shape,
         if (shape->history != NULL) {
             history_discardTransactionsMoreRecentThanCursor(shape->history);
         }
+        transform_set_idle_branch(shape->transform, false);
     }
 
     transaction_replaceBlock(shape->pendingTransaction, x, y, z, newColorIndex);
@@ -630,6 +769,10 @@ bool shape_paint_block_as_transaction(Shape *const shape,
     return true; // block is considered replaced
 }
 
+bool shape_has_pending_transaction(const Shape *shape) {
+    return shape->pendingTransaction != NULL;
+}
+
 void shape_apply_current_transaction(Shape *const shape, bool keepPending) {
     vx_assert(shape != NULL);
     if (shape->pendingTransaction == NULL ||
@@ -716,6 +859,134 @@ bool shape_add_block(Shape *shape,
     return blockAdded;
 }
 
+size_t shape_fill_blocks_from_grid(Shape *shape,
+                                   const SHAPE_COLOR_INDEX_INT_T *grid,
+                                   const uint16_t width,
+                                   const uint16_t height,
+                                   const uint16_t depth) {
+    if (shape == NULL || grid == NULL) {
+        return 0;
+    }
+    if (width > SHAPE_COORDS_MAX || height > SHAPE_COORDS_MAX || depth > SHAPE_COORDS_MAX) {
+        cclog_error("shape_fill_blocks_from_grid: grid is too large");
+        return 0;
+    }
+
+    size_t added = 0;
+    SHAPE_COLOR_INDEX_INT_T colorIndex;
+
+    // baked lighting is updated for each added block, this can't be batched
+    if (_shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_BAKED_LIGHTING)) {
+        const SHAPE_COLOR_INDEX_INT_T *cursor = grid;
+        for (SHAPE_COORDS_INT_T x = 0; x < width; ++x) {
+            for (SHAPE_COORDS_INT_T y = 0; y < height; ++y) {
+                for (SHAPE_COORDS_INT_T z = 0; z < depth; ++z) {
+                    colorIndex = *cursor++;
+                    if (colorIndex != SHAPE_COLOR_INDEX_AIR_BLOCK &&
+                        shape_add_block(shape, colorIndex, x, y, z, false)) {
+                        ++added;
+                    }
+                }
+            }
+        }
+        return added;
+    }
+
+    uint32_t counts[SHAPE_COLOR_INDEX_MAX_COUNT];
+    memset(counts, 0, sizeof(counts));
+    SHAPE_COORDS_INT3_T min = {SHAPE_COORDS_MAX, SHAPE_COORDS_MAX, SHAPE_COORDS_MAX};
+    SHAPE_COORDS_INT3_T max = {0, 0, 0};
+
+    Chunk *chunk;
+    bool chunkAdded;
+    size_t rowStart;
+    SHAPE_COORDS_INT_T cx, cy, cz, x, y, z, xMax, yMax, zMax;
+
+    // new chunks leaves are bulk-loaded in the r-tree once filled
+    RtreeLeaves newLeaves;
+    rtree_leaves_init(&newLeaves, NULL, 0);
+
+    // fill one chunk at a time, chunk is only looked up once
+    for (cx = 0; cx < width; cx += CHUNK_SIZE) {
+        xMax = (SHAPE_COORDS_INT_T)minimum(cx + CHUNK_SIZE, width);
+        for (cy = 0; cy < height; cy += CHUNK_SIZE) {
+            yMax = (SHAPE_COORDS_INT_T)minimum(cy + CHUNK_SIZE, height);
+            for (cz = 0; cz < depth; cz += CHUNK_SIZE) {
+                zMax = (SHAPE_COORDS_INT_T)minimum(cz + CHUNK_SIZE, depth);
+                chunk = NULL;
+
+                for (x = cx; x < xMax; ++x) {
+                    for (y = cy; y < yMax; ++y) {
+                        rowStart = ((size_t)x * height + (size_t)y) * depth;
+                        for (z = cz; z < zMax; ++z) {
+                            colorIndex = grid[rowStart + (size_t)z];
+                            if (colorIndex >= SHAPE_COLOR_INDEX_MAX_COUNT) { // air
+                                continue;
+                            }
+                            if (chunk == NULL) {
+                                chunk = _shape_get_or_add_chunk(
+                                    shape,
+                                    (SHAPE_COORDS_INT3_T){cx / CHUNK_SIZE,
+                                                          cy / CHUNK_SIZE,
+                                                          cz / CHUNK_SIZE},
+                                    &newLeaves,
+                                    &chunkAdded);
+                                if (chunkAdded) {
+                                    shape->nbChunks++;
+                                }
+                            }
+                            if (chunk_add_block(chunk,
+                                                (Block){colorIndex},
+                                                (CHUNK_COORDS_INT_T)(x - cx),
+                                                (CHUNK_COORDS_INT_T)(y - cy),
+                                                (CHUNK_COORDS_INT_T)(z - cz))) {
+                                ++counts[colorIndex];
+                                ++added;
+                                min.x = minimum(min.x, x);
+                                min.y = minimum(min.y, y);
+                                min.z = minimum(min.z, z);
+                                max.x = maximum(max.x, x);
+                                max.y = maximum(max.y, y);
+                                max.z = maximum(max.z, z);
+                            }
+                        }
+                    }
+                }
+
+                if (chunk != NULL) {
+                    _shape_chunk_enqueue_refresh(shape, chunk);
+                    _shape_chunk_enqueue_refresh(shape, chunk_get_neighbor(chunk, X));
+                    _shape_chunk_enqueue_refresh(shape, chunk_get_neighbor(chunk, NX));
+                    _shape_chunk_enqueue_refresh(shape, chunk_get_neighbor(chunk, Y));
+                    _shape_chunk_enqueue_refresh(shape, chunk_get_neighbor(chunk, NY));
+                    _shape_chunk_enqueue_refresh(shape, chunk_get_neighbor(chunk, Z));
+                    _shape_chunk_enqueue_refresh(shape, chunk_get_neighbor(chunk, NZ));
+                }
+            }
+        }
+    }
+
+    rtree_bulk_load(shape->rtree, newLeaves.items, newLeaves.count);
+    rtree_leaves_free(&newLeaves);
+
+    if (added == 0) {
+        return 0;
+    }
+
+    shape->nbBlocks += added;
+    shape_expand_box(shape, min);
+    shape_expand_box(shape, max);
+
+    for (int i = 0; i < SHAPE_COLOR_INDEX_MAX_COUNT; ++i) {
+        if (counts[i] > 0) {
+            color_palette_increment_color(shape->palette, (SHAPE_COLOR_INDEX_INT_T)i, counts[i]);
+            shape->blocksCount[i] += counts[i];
+        }
+    }
+
+    return added;
+}
+
 bool shape_remove_block(Shape *shape,
                         const SHAPE_COORDS_INT_T x,
                         const SHAPE_COORDS_INT_T y,
@@ -818,6 +1089,8 @@ ColorPalette *shape_get_palette(const Shape *shape) {
 
 /// @param retain can be set to false if given palette already accounts for shape's ownership
 void shape_set_palette(Shape *shape, ColorPalette *palette, const bool retain) {
+    _shape_mesh_detach(shape, true);
+
     if (shape->palette != NULL) {
         // transfer blocks count to new palette
         const uint8_t count = color_palette_get_count(shape->palette);
@@ -877,7 +1150,7 @@ void shape_remap_colors(Shape *s, const SHAPE_COLOR_INDEX_INT_T *remap) {
                                     continue;
                                 }
 
-                                block_set_color_index(b, newColor);
+                                chunk_paint_block(chunk, cx, cy, cz, newColor, NULL);
 
                                 color_palette_decrement_color(s->palette, prevColor, 1);
                                 color_palette_increment_color(s->palette, newColor, 1);
@@ -1695,16 +1968,55 @@ void shape_refresh_vertices(Shape *shape) {
         return;
     }
 
-    Chunk *c = shape->dirtyChunks != NULL ? fifo_list_pop(shape->dirtyChunks) : NULL;
-    if (c == NULL) {
+    // vertex buffers are refreshed by the owner of the shared mesh, as long as they show the
+    // instance's colors
+    if (_shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_MESH_SHARING)) {
+        thread_pool_shared_lock();
+        const bool drawsOwnerMesh = shape->meshOwner != NULL &&
+                                    _shape_mesh_palettes_changed(shape) == false;
+        const bool detach = drawsOwnerMesh == false &&
+                            (shape->meshOwner != NULL || shape->meshReleased);
+        thread_pool_shared_unlock();
+
+        if (drawsOwnerMesh) {
+            return;
+        } else if (detach) {
+            _shape_mesh_detach(shape, true);
+        }
+    }
+
+    if (shape->dirtyChunks == NULL || fifo_list_get_size(shape->dirtyChunks) == 0) {
         return;
     }
+
+    // a shape meshed for the first time may draw an identical shared mesh instead
+    const bool shareMesh = _shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_MESH_SHARING) &&
+                           shape->meshRegistered == false && shape->firstVB_opaque == NULL &&
+                           shape->firstVB_transparent == NULL;
+    const size_t nbChunksBefore = shape->nbChunks;
+    uint64_t meshHash = 0;
+    if (shareMesh) {
+        meshHash = _shape_get_mesh_hash(shape);
+        if (_shape_mesh_share(shape, meshHash)) {
+            return;
+        }
+    }
+
+    Chunk *c = fifo_list_pop(shape->dirtyChunks);
+
+    // chunks left to be meshed, in refresh order
+    Chunk **chunks = (Chunk **)malloc(fifo_list_get_size(shape->dirtyChunks) * sizeof(Chunk *) +
+                                      sizeof(Chunk *));
+    size_t nbChunks = 0;
+
     while (c != NULL) {
         // Note: chunk should never be NULL
         // Note: no need to check chunk_is_dirty, it has to be true
 
         // if the chunk has been emptied, we can remove it from shape index and destroy it
         // Note: this will create gaps in all the vb used for this chunk ie. make them fragmented
+        // Note: emptied chunks are all removed before meshing, so that neighbors read by meshing
+        // don't depend on refresh order
         if (chunk_get_nb_blocks(c) == 0) {
             const SHAPE_COORDS_INT3_T chunkOrigin = chunk_get_origin(c);
             SHAPE_COORDS_INT3_T chunk_coords = chunk_utils_get_coords(chunkOrigin);
@@ -1715,22 +2027,21 @@ void shape_refresh_vertices(Shape *shape) {
                            NULL);
             rtree_remove(shape->rtree, chunk_get_rtree_leaf(c), true);
             chunk_free(c, true);
-            c = NULL;
 
             shape->nbChunks--;
         }
         // else chunk has data that needs updating
         else {
-            chunk_write_vertices(shape, c);
-        }
-
-        if (c != NULL) {
+            chunks[nbChunks++] = c;
             chunk_set_dirty(c, false);
         }
 
         c = fifo_list_pop(shape->dirtyChunks);
     }
 
+    _shape_mesh_chunks(shape, chunks, nbChunks);
+    free(chunks);
+
     // check all vertex buffers used by this shape, to see if they have to be defragmented
     _shape_check_all_vb_fragmented(shape, shape->firstVB_opaque);
     _shape_check_all_vb_fragmented(shape, shape->firstVB_transparent);
@@ -1761,22 +2072,38 @@ void shape_refresh_vertices(Shape *shape) {
     _shape_fill_draw_slices(shape->firstVB_transparent);
 
     _set_vb_allocation_flag_one_frame(shape);
+
+    if (shareMesh && shape->nbBlocks > 0) {
+        // emptied chunks have been removed
+        if (shape->nbChunks != nbChunksBefore) {
+            meshHash = _shape_get_mesh_hash(shape);
+        }
+        _shape_mesh_register(shape, meshHash);
+    }
 }
 
 void shape_refresh_all_vertices(Shape *s) {
+    _shape_mesh_detach(s, false);
+
     // refresh all chunks
+    Chunk **chunks = (Chunk **)malloc(s->nbChunks * sizeof(Chunk *) + sizeof(Chunk *));
+    size_t nbChunks = 0;
+
     Index3DIterator *it = index3d_iterator_new(s->chunks);
     Chunk *chunk;
     while (index3d_iterator_pointer(it) != NULL) {
         chunk = index3d_iterator_pointer(it);
 
-        chunk_write_vertices(s, chunk);
+        chunks[nbChunks++] = chunk;
         chunk_set_dirty(chunk, false);
 
         index3d_iterator_next(it);
     }
     index3d_iterator_free(it);
 
+    _shape_mesh_chunks(s, chunks, nbChunks);
+    free(chunks);
+
     // refresh draw slices after full refresh
     _shape_fill_draw_slices(s->firstVB_opaque);
     _shape_fill_draw_slices(s->firstVB_transparent);
@@ -1789,9 +2116,103 @@ void shape_refresh_all_vertices(Shape *s) {
 }
 
 VertexBuffer *shape_get_first_vertex_buffer(const Shape *shape, bool transparent) {
+    if (_shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_MESH_SHARING)) {
+        thread_pool_shared_lock();
+        if (shape->meshOwner != NULL) {
+            shape = shape->meshOwner;
+        }
+        VertexBuffer *vb = transparent ? shape->firstVB_transparent : shape->firstVB_opaque;
+        thread_pool_shared_unlock();
+        return vb;
+    }
     return transparent ? shape->firstVB_transparent : shape->firstVB_opaque;
 }
 
+// MARK: - Mesh sharing -
+
+void shape_toggle_mesh_sharing(Shape *s, const bool toggle) {
+    if (s == NULL || _shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_MESH_SHARING) == toggle) {
+        return;
+    }
+    _shape_toggle_rendering_flag(s, SHAPE_RENDERING_FLAG_MESH_SHARING, toggle);
+
+    if (toggle == false) {
+        _shape_mesh_detach(s, true);
+    }
+}
+
+bool shape_uses_mesh_sharing(const Shape *s) {
+    if (s == NULL) {
+        return false;
+    }
+    return _shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_MESH_SHARING);
+}
+
+bool shape_is_mesh_instance(const Shape *s) {
+    if (s == NULL) {
+        return false;
+    }
+    thread_pool_shared_lock();
+    const bool instance = s->meshOwner != NULL;
+    thread_pool_shared_unlock();
+    return instance;
+}
+
+Shape *shape_get_mesh_owner(Shape *s) {
+    if (s == NULL) {
+        return NULL;
+    }
+    thread_pool_shared_lock();
+    Shape *owner = s->meshOwner != NULL ? s->meshOwner : s;
+    thread_pool_shared_unlock();
+    return owner;
+}
+
+size_t shape_get_mesh_instances_count(const Shape *s) {
+    if (s == NULL) {
+        return 0;
+    }
+    thread_pool_shared_lock();
+    if (s->meshOwner != NULL) {
+        s = s->meshOwner;
+    }
+    const size_t count = 1 + (s->meshInstances != NULL
+                                  ? doubly_linked_list_node_count(s->meshInstances)
+                                  : 0);
+    thread_pool_shared_unlock();
+    return count;
+}
+
+size_t shape_get_mesh_instances_models(Shape *s, Matrix4x4 *models, const size_t max) {
+    if (s == NULL || models == NULL) {
+        return 0;
+    }
+
+    thread_pool_shared_lock();
+    if (s->meshOwner != NULL) {
+        thread_pool_shared_unlock();
+        return 0;
+    }
+
+    size_t count = 0;
+    if (max > 0 && shape_is_hidden(s) == false) {
+        transform_utils_get_model_ltw(s->transform, &models[count++]);
+    }
+
+    DoublyLinkedListNode *n = s->meshInstances != NULL ? doubly_linked_list_first(s->meshInstances)
+                                                       : NULL;
+    Shape *instance;
+    while (n != NULL && count < max) {
+        instance = (Shape *)doubly_linked_list_node_pointer(n);
+        if (shape_is_hidden(instance) == false) {
+            transform_utils_get_model_ltw(instance->transform, &models[count++]);
+        }
+        n = doubly_linked_list_node_next(n);
+    }
+    thread_pool_shared_unlock();
+    return count;
+}
+
 // MARK: - Physics -
 
 Rtree *shape_get_rtree(const Shape *shape) {
@@ -1912,33 +2333,34 @@ float shape_box_cast(const Shape *s,
                          modelVector->y / maxDist,
                          modelVector->z / maxDist};
 
-    // select overlapped chunks
-    DoublyLinkedList *chunksQuery = doubly_linked_list_new();
-    if (rtree_query_cast_all_box(s->rtree,
-                                 modelBox,
-                                 &unit,
-                                 maxDist,
-                                 0,
-                                 1,
-                                 NULL,
-                                 chunksQuery,
-                                 modelEpsilon) > 0) {
+    // select overlapped chunks, this is called for every contact by the physics solver and
+    // shouldn't allocate in the common case
+    RtreeCastResult localHits[SHAPE_BOX_CAST_LOCAL_HITS];
+    RtreeCastResults chunksQuery;
+    rtree_cast_results_init(&chunksQuery, localHits, SHAPE_BOX_CAST_LOCAL_HITS);
+    if (rtree_query_cast_all_box_results(s->rtree,
+                                         modelBox,
+                                         &unit,
+                                         maxDist,
+                                         0,
+                                         1,
+                                         &chunksQuery,
+                                         modelEpsilon) > 0) {
         // sort query results by distance
-        doubly_linked_list_sort_ascending(chunksQuery, rtree_utils_result_sort_func);
+        rtree_cast_results_sort(&chunksQuery);
 
         Box broadPhaseBox, tmpBox;
         box_set_broadphase_box(modelBox, modelVector, &broadPhaseBox);
 
         // examine query results in order, return first hit block
-        DoublyLinkedListNode *n = doubly_linked_list_first(chunksQuery);
         RtreeCastResult *rtreeHit;
-        OctreeIterator *oi;
+        OctreeIterator it, *oi = &it;
         Chunk *c;
         bool didHit = false, leaf;
         float3 tmpNormal, tmpReplacement;
         float swept = 1.0f, lastRtreeDist = FLT_MAX;
-        while (n != NULL) {
-            rtreeHit = (RtreeCastResult *)doubly_linked_list_node_pointer(n);
+        for (size_t i = 0; i < chunksQuery.count; ++i) {
+            rtreeHit = &chunksQuery.items[i];
             c = (Chunk *)rtree_node_get_leaf_ptr(rtreeHit->rtreeLeaf);
 
             // make sure to examine all hits w/ similar distances before stopping
@@ -1954,7 +2376,7 @@ float shape_box_cast(const Shape *s,
             float blockedX = false, blockedY = false, blockedZ = false;
 #endif
 
-            oi = octree_iterator_new(chunk_get_octree(c));
+            octree_iterator_init(oi, chunk_get_octree(c));
             while (octree_iterator_is_done(oi) == false) {
                 octree_iterator_get_node_box(oi, &tmpBox);
 
@@ -2046,7 +2468,6 @@ float shape_box_cast(const Shape *s,
 
                 octree_iterator_next(oi, collides == false && leaf == false, &leaf);
             }
-            octree_iterator_free(oi);
 
             if (didHit && blockCoords != NULL) {
                 // chunk block coordinates in model space
@@ -2054,12 +2475,9 @@ float shape_box_cast(const Shape *s,
                 blockCoords->y += chunkOrigin.y;
                 blockCoords->z += chunkOrigin.z;
             }
-
-            n = doubly_linked_list_node_next(n);
         }
     }
-    doubly_linked_list_flush(chunksQuery, free);
-    doubly_linked_list_free(chunksQuery);
+    rtree_cast_results_free(&chunksQuery);
 
     return minSwept;
 }
@@ -2072,130 +2490,139 @@ bool shape_ray_cast(const Transform *t,
                     Block **block,
                     SHAPE_COORDS_INT3_T *coords) {
 
-    if (s == NULL || worldRay == NULL) {
+    if (s == NULL || worldRay == NULL || s->nbBlocks == 0) {
         return false;
     }
 
-    // we want a ray in model space to intersect with block coordinates
+    // we want a ray in model space to intersect with block coordinates, kept on the stack
     Matrix4x4 invModel;
     transform_utils_get_model_wtl(t, &invModel);
-    Ray *modelRay = ray_transform(worldRay, &invModel);
+    float3 origin, dir, invdir;
+    matrix4x4_op_multiply_vec_point(&origin, worldRay->origin, &invModel);
+    matrix4x4_op_multiply_vec_vector(&dir, worldRay->dir, &invModel);
+    float3_normalize(&dir);
+    float3_set(&invdir, 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+    const Ray modelRay = {&origin, &dir, &invdir};
+
+    // clip ray to shape model box
+    const float3 bbMin = {s->bbMin.x, s->bbMin.y, s->bbMin.z};
+    const float3 bbMax = {s->bbMax.x, s->bbMax.y, s->bbMax.z};
+    float tEnter;
+    if (ray_intersect_with_box(&modelRay, &bbMin, &bbMax, &tEnter) == false) {
+        return false;
+    }
+    if (tEnter < 0.0f) {
+        tEnter = 0.0f;
+    }
+
+    // voxel traversal (Amanatides & Woo), starting from the block where the ray enters the box
+    float3 p;
+    ray_impact_point(&modelRay, tEnter, &p);
+    int32_t v[3] = {(int32_t)floorf(p.x), (int32_t)floorf(p.y), (int32_t)floorf(p.z)};
+    const int32_t vMin[3] = {s->bbMin.x, s->bbMin.y, s->bbMin.z};
+    const int32_t vMax[3] = {s->bbMax.x - 1, s->bbMax.y - 1, s->bbMax.z - 1};
+    const float o[3] = {origin.x, origin.y, origin.z};
+    const float d[3] = {dir.x, dir.y, dir.z};
+    const float inv[3] = {invdir.x, invdir.y, invdir.z};
+    int32_t step[3];
+    float tMax[3], tDelta[3];
+    for (int i = 0; i < 3; ++i) {
+        if (v[i] < vMin[i]) {
+            v[i] = vMin[i];
+        } else if (v[i] > vMax[i]) {
+            v[i] = vMax[i];
+        }
 
-    // select traversed chunks
-    DoublyLinkedList *chunksQuery = doubly_linked_list_new();
-    if (rtree_query_cast_all_ray(s->rtree, modelRay, 0, 1, NULL, chunksQuery) > 0) {
-        // sort query results by distance
-        doubly_linked_list_sort_ascending(chunksQuery, rtree_utils_result_sort_func);
+        if (d[i] > 0.0f) {
+            step[i] = 1;
+            tMax[i] = ((float)(v[i] + 1) - o[i]) * inv[i];
+            tDelta[i] = inv[i];
+        } else if (d[i] < 0.0f) {
+            step[i] = -1;
+            tMax[i] = ((float)v[i] - o[i]) * inv[i];
+            tDelta[i] = -inv[i];
+        } else {
+            step[i] = 0;
+            tMax[i] = FLT_MAX;
+            tDelta[i] = FLT_MAX;
+        }
+    }
 
-        // examine query results in order, return first hit block
-        DoublyLinkedListNode *n = doubly_linked_list_first(chunksQuery);
-        RtreeCastResult *rtreeHit;
-        OctreeIterator *oi;
-        Chunk *c;
-        bool didHit = false, leaf;
-        Block *hitBlock = NULL;
-        float minDistance = FLT_MAX, lastRtreeDist = FLT_MAX;
-        uint16_t x = 0, y = 0, z = 0;
-        Box tmpBox;
-        float d;
-        while (n != NULL) {
-            rtreeHit = (RtreeCastResult *)doubly_linked_list_node_pointer(n);
-            c = (Chunk *)rtree_node_get_leaf_ptr(rtreeHit->rtreeLeaf);
+    // chunk is only looked up again when the traversal crosses a chunk boundary
+    SHAPE_COORDS_INT3_T chunkCoords = chunk_utils_get_coords((SHAPE_COORDS_INT3_T){
+        (SHAPE_COORDS_INT_T)v[0], (SHAPE_COORDS_INT_T)v[1], (SHAPE_COORDS_INT_T)v[2]});
+    Chunk *c = (Chunk *)index3d_get(s->chunks, chunkCoords.x, chunkCoords.y, chunkCoords.z);
+
+    Block *hitBlock = NULL;
+    while (true) {
+        const SHAPE_COORDS_INT3_T vCoords = {(SHAPE_COORDS_INT_T)v[0],
+                                             (SHAPE_COORDS_INT_T)v[1],
+                                             (SHAPE_COORDS_INT_T)v[2]};
+        const SHAPE_COORDS_INT3_T cCoords = chunk_utils_get_coords(vCoords);
+        if (cCoords.x != chunkCoords.x || cCoords.y != chunkCoords.y ||
+            cCoords.z != chunkCoords.z) {
+            chunkCoords = cCoords;
+            c = (Chunk *)index3d_get(s->chunks, chunkCoords.x, chunkCoords.y, chunkCoords.z);
+        }
 
-            // make sure to examine all hits w/ similar distances before stopping
-            if (didHit &&
-                float_isEqual(rtreeHit->distance, lastRtreeDist, EPSILON_COLLISION) == false) {
+        if (c != NULL) {
+            Block *b = chunk_get_block_2(c, chunk_utils_get_coords_in_chunk(vCoords));
+            if (block_is_solid(b)) {
+                hitBlock = b;
                 break;
             }
-            lastRtreeDist = rtreeHit->distance;
-
-            const SHAPE_COORDS_INT3_T chunkOrigin = chunk_get_origin(c);
-            leaf = false;
-
-            oi = octree_iterator_new(chunk_get_octree(c));
-            while (octree_iterator_is_done(oi) == false) {
-                octree_iterator_get_node_box(oi, &tmpBox);
-
-                // chunk octree box in model space
-                tmpBox.min.x += chunkOrigin.x;
-                tmpBox.min.y += chunkOrigin.y;
-                tmpBox.min.z += chunkOrigin.z;
-                tmpBox.max.x += chunkOrigin.x;
-                tmpBox.max.y += chunkOrigin.y;
-                tmpBox.max.z += chunkOrigin.z;
-
-                const bool collides = ray_intersect_with_box(modelRay,
-                                                             &tmpBox.min,
-                                                             &tmpBox.max,
-                                                             &d) &&
-                                      d < minDistance;
-                if (leaf && collides) {
-                    didHit = true;
-                    minDistance = d;
-                    hitBlock = (Block *)octree_iterator_get_element(oi);
-                    octree_iterator_get_current_position(oi, &x, &y, &z);
-                }
-
-                octree_iterator_next(oi, collides == false && leaf == false, &leaf);
-            }
-            octree_iterator_free(oi);
-
-            if (didHit) {
-                // chunk block coordinates in model space
-                x += chunkOrigin.x;
-                y += chunkOrigin.y;
-                z += chunkOrigin.z;
-            }
-
-            n = doubly_linked_list_node_next(n);
         }
 
-        if (hitBlock == NULL) {
-            ray_free(modelRay);
-            doubly_linked_list_flush(chunksQuery, free);
-            doubly_linked_list_free(chunksQuery);
-            return false;
+        // step along the axis w/ the closest block boundary
+        const int i = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        v[i] += step[i];
+        if (v[i] < vMin[i] || v[i] > vMax[i]) {
+            break;
         }
+        tMax[i] += tDelta[i];
+    }
 
-        if (worldDistance != NULL || localImpact != NULL) {
-            float3 _localImpact;
-            ray_impact_point(modelRay, minDistance, &_localImpact);
-            if (localImpact != NULL) {
-                *localImpact = _localImpact;
-            }
+    if (hitBlock == NULL) {
+        return false;
+    }
 
-            if (worldDistance != NULL) {
-                Matrix4x4 model;
-                transform_utils_get_model_ltw(t, &model);
+    if (block != NULL) {
+        *block = hitBlock;
+    }
 
-                float3 worldImpact;
-                matrix4x4_op_multiply_vec_point(&worldImpact, &_localImpact, &model);
-                float3_op_substract(&worldImpact, worldRay->origin);
-                *worldDistance = float3_length(&worldImpact);
-            }
-        }
+    if (coords != NULL) {
+        coords->x = (SHAPE_COORDS_INT_T)v[0];
+        coords->y = (SHAPE_COORDS_INT_T)v[1];
+        coords->z = (SHAPE_COORDS_INT_T)v[2];
+    }
 
-        if (block != NULL) {
-            *block = hitBlock;
+    if (worldDistance != NULL || localImpact != NULL) {
+        // distance to the block box, negative if the ray starts inside it
+        const float3 ldf = {(float)v[0], (float)v[1], (float)v[2]};
+        const float3 rtb = {ldf.x + 1.0f, ldf.y + 1.0f, ldf.z + 1.0f};
+        float minDistance;
+        if (ray_intersect_with_box(&modelRay, &ldf, &rtb, &minDistance) == false) {
+            minDistance = tEnter;
         }
 
-        if (coords != NULL) {
-            coords->x = (SHAPE_COORDS_INT_T)x;
-            coords->y = (SHAPE_COORDS_INT_T)y;
-            coords->z = (SHAPE_COORDS_INT_T)z;
+        float3 _localImpact;
+        ray_impact_point(&modelRay, minDistance, &_localImpact);
+        if (localImpact != NULL) {
+            *localImpact = _localImpact;
         }
 
-        ray_free(modelRay);
-        doubly_linked_list_flush(chunksQuery, free);
-        doubly_linked_list_free(chunksQuery);
-        return true;
-    }
+        if (worldDistance != NULL) {
+            Matrix4x4 model;
+            transform_utils_get_model_ltw(t, &model);
 
-    ray_free(modelRay);
-    doubly_linked_list_flush(chunksQuery, free);
-    doubly_linked_list_free(chunksQuery);
+            float3 worldImpact;
+            matrix4x4_op_multiply_vec_point(&worldImpact, &_localImpact, &model);
+            float3_op_substract(&worldImpact, worldRay->origin);
+            *worldDistance = float3_length(&worldImpact);
+        }
+    }
 
-    return false;
+    return true;
 }
 
 bool shape_point_overlap(const Shape *s, const float3 *world) {
@@ -2215,12 +2642,7 @@ bool shape_point_overlap(const Shape *s, const float3 *world) {
     shape_get_chunk_and_coordinates(s, coords_in_shape, &c, NULL, &coords_in_chunk);
 
     if (c != NULL) {
-        Block *b = (Block *)octree_get_element_without_checking(chunk_get_octree(c),
-                                                                (size_t)coords_in_chunk.x,
-                                                                (size_t)coords_in_chunk.y,
-                                                                (size_t)coords_in_chunk.z);
-
-        return block_is_solid(b);
+        return block_is_solid(chunk_get_block_2(c, coords_in_chunk));
     }
 
     return false;
@@ -2232,23 +2654,30 @@ bool shape_box_overlap(const Shape *s, const Box *modelBox, const float3 *modelE
     }
 
     // select overlapped chunks
-    FifoList *chunksQuery = fifo_list_new();
+    RtreeNode *localHits[SHAPE_BOX_CAST_LOCAL_HITS];
+    RtreeLeaves chunksQuery;
+    rtree_leaves_init(&chunksQuery, localHits, SHAPE_BOX_CAST_LOCAL_HITS);
     bool didHit = false;
-    if (rtree_query_overlap_box(s->rtree, modelBox, 0, 1, NULL, chunksQuery, modelEpsilon) > 0) {
+    if (rtree_query_overlap_box_leaves(s->rtree,
+                                       modelBox,
+                                       0,
+                                       1,
+                                       NULL,
+                                       &chunksQuery,
+                                       modelEpsilon) > 0) {
 
         // examine query results, stop at first overlap
-        RtreeNode *hit = fifo_list_pop(chunksQuery);
-        OctreeIterator *oi;
+        OctreeIterator it, *oi = &it;
         bool leaf;
         Chunk *c;
         Box tmpBox;
-        while (hit != NULL && didHit == false) {
-            c = (Chunk *)rtree_node_get_leaf_ptr(hit);
+        for (size_t i = 0; i < chunksQuery.count && didHit == false; ++i) {
+            c = (Chunk *)rtree_node_get_leaf_ptr(chunksQuery.items[i]);
 
             const SHAPE_COORDS_INT3_T chunkOrigin = chunk_get_origin(c);
             leaf = false;
 
-            oi = octree_iterator_new(chunk_get_octree(c));
+            octree_iterator_init(oi, chunk_get_octree(c));
             while (octree_iterator_is_done(oi) == false) {
                 octree_iterator_get_node_box(oi, &tmpBox);
 
@@ -2271,16 +2700,49 @@ bool shape_box_overlap(const Shape *s, const Box *modelBox, const float3 *modelE
 
                 octree_iterator_next(oi, collides == false && leaf == false, &leaf);
             }
-            octree_iterator_free(oi);
-
-            hit = fifo_list_pop(chunksQuery);
         }
     }
-    fifo_list_free(chunksQuery, NULL);
+    rtree_leaves_free(&chunksQuery);
 
     return didHit;
 }
 
+void shape_build_octrees_in_box(Shape *s, const Box *worldBox) {
+    if (s == NULL || worldBox == NULL) {
+        return;
+    }
+
+    Matrix4x4 invModel;
+    transform_utils_get_model_wtl(s->transform, &invModel);
+    Box modelBox;
+    box_model1_to_model2_aabox(worldBox,
+                               &modelBox,
+                               &matrix4x4_identity,
+                               &invModel,
+                               &float3_zero,
+                               NoSquarify);
+
+    // a block of margin covers queries epsilons & rounding
+    float3_op_substract_scalar(&modelBox.min, 1.0f);
+    float3_op_add_scalar(&modelBox.max, 1.0f);
+
+    RtreeNode *localHits[SHAPE_BOX_CAST_LOCAL_HITS];
+    RtreeLeaves chunksQuery;
+    rtree_leaves_init(&chunksQuery, localHits, SHAPE_BOX_CAST_LOCAL_HITS);
+    if (rtree_query_overlap_box_leaves(s->rtree,
+                                       &modelBox,
+                                       0,
+                                       1,
+                                       NULL,
+                                       &chunksQuery,
+                                       &float3_epsilon_zero) > 0) {
+        for (size_t i = 0; i < chunksQuery.count; ++i) {
+            chunk_get_octree((Chunk *)rtree_node_get_leaf_ptr(chunksQuery.items[i]));
+        }
+    }
+    rtree_leaves_free(&chunksQuery);
+}
+
 // MARK: - Graphics -
 
 bool shape_is_hidden(Shape *s) {
@@ -2340,6 +2802,85 @@ bool shape_is_unlit(const Shape *s) {
     return _shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_UNLIT);
 }
 
+void shape_set_greedy_meshing(Shape *s, const bool toggle) {
+    if (s == NULL || _shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_GREEDY_MESHING) == toggle) {
+        return;
+    }
+    _shape_toggle_rendering_flag(s, SHAPE_RENDERING_FLAG_GREEDY_MESHING, toggle);
+
+    Index3DIterator *it = index3d_iterator_new(s->chunks);
+    while (index3d_iterator_pointer(it) != NULL) {
+        _shape_chunk_enqueue_refresh(s, index3d_iterator_pointer(it));
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+}
+
+bool shape_uses_greedy_meshing(const Shape *s) {
+    if (s == NULL) {
+        return false;
+    }
+    return _shape_get_rendering_flag(s, SHAPE_RENDERING_FLAG_GREEDY_MESHING);
+}
+
+bool shape_set_meshing_workers(const int nbWorkers) {
+    thread_pool_shared_lock();
+    if (_workersPoolUsers > 0) {
+        thread_pool_shared_unlock();
+        cclog_error("shape_set_meshing_workers: workers are in use");
+        return false;
+    }
+    thread_pool_free(_workersPool);
+    _workersPool = NULL;
+    _workersPoolReady = false;
+    _nbWorkers = nbWorkers;
+    thread_pool_shared_unlock();
+    return true;
+}
+
+void shape_set_chunk_storage(Shape *s, const ChunkStorage storage) {
+    if (s == NULL || s->chunkStorage == storage) {
+        return;
+    }
+    s->chunkStorage = storage;
+
+    Index3DIterator *it = index3d_iterator_new(s->chunks);
+    while (index3d_iterator_pointer(it) != NULL) {
+        chunk_set_storage(index3d_iterator_pointer(it), storage);
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+}
+
+ChunkStorage shape_get_chunk_storage(const Shape *s) {
+    return s->chunkStorage;
+}
+
+void shape_get_meshing_stats(const Shape *s, size_t *nbFaces, size_t *nbQuads) {
+    size_t faces = 0, quads = 0;
+
+    if (s->meshOwner != NULL) {
+        s = s->meshOwner;
+    }
+
+    Index3DIterator *it = index3d_iterator_new(s->chunks);
+    Chunk *c;
+    while (index3d_iterator_pointer(it) != NULL) {
+        c = index3d_iterator_pointer(it);
+        faces += chunk_get_nb_faces(c);
+        quads += chunk_get_nb_quads(c);
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+
+    if (nbFaces != NULL) {
+        *nbFaces = faces;
+    }
+    if (nbQuads != NULL) {
+        *nbQuads = quads;
+    }
+}
+
 void shape_set_layers(Shape *s, const uint16_t value) {
     s->layers = value;
 }
@@ -2388,6 +2929,12 @@ void shape_remove_point(Shape *s, const char *key) {
 // MARK: - Baked lighting -
 
 void shape_compute_baked_lighting(Shape *s) {
+    ThreadPool *pool = _shape_acquire_workers_pool();
+    shape_compute_baked_lighting_on_pool(s, pool);
+    _shape_release_workers_pool(pool);
+}
+
+void shape_compute_baked_lighting_on_pool(Shape *s, ThreadPool *pool) {
     _shape_toggle_rendering_flag(s, SHAPE_RENDERING_FLAG_BAKED_LIGHTING, true);
 
     LightNodeQueue *q = light_node_queue_new();
@@ -2395,7 +2942,11 @@ void shape_compute_baked_lighting(Shape *s) {
 
     _light_removal_all(s, &min, &max);
     _light_enqueue_ambient_and_block_sources(s, q, min, max, false);
-    _light_propagate(s, &min, &max, q, min.x - 1, max.y, min.z - 1, true);
+
+    if (pool == NULL || thread_pool_get_nb_workers(pool) == 0 ||
+        _light_propagate_parallel(s, pool, &min, &max, q) == false) {
+        _light_propagate(s, &min, &max, q, min.x - 1, max.y, min.z - 1, true);
+    }
 
     light_node_queue_free(q);
 
@@ -2995,11 +3546,95 @@ static bool _shape_get_lua_flag(const Shape *s, const uint8_t flag) {
     return (s->luaFlags & flag) != 0;
 }
 
-void _shape_chunk_enqueue_refresh(Shape *shape, Chunk *c) {
-    if (c == NULL)
-        return;
-    if (chunk_is_dirty(c) == false) {
-        if (shape->dirtyChunks == NULL) {
+typedef struct {
+    const Shape *shape;
+    Chunk **chunks;
+    ChunkMesh **meshes;
+} _ShapeMeshingJobs;
+
+static void _shape_compute_chunk_mesh_job(void *ctx, const size_t idx) {
+    _ShapeMeshingJobs *jobs = (_ShapeMeshingJobs *)ctx;
+    chunk_compute_mesh(jobs->shape, jobs->chunks[idx], jobs->meshes[idx]);
+}
+
+static ThreadPool *_shape_acquire_workers_pool(void) {
+    thread_pool_shared_lock();
+    if (_workersPoolReady == false) {
+        const int nbWorkers = _nbWorkers >= 0 ? _nbWorkers
+                                              : minimum(thread_pool_get_nb_cores() - 1,
+                                                        SHAPE_MESHING_MAX_WORKERS);
+        _workersPool = nbWorkers > 0 ? thread_pool_new((uint8_t)nbWorkers) : NULL;
+        _workersPoolReady = true;
+    }
+    ThreadPool *pool = _workersPool;
+    if (pool != NULL) {
+        _workersPoolUsers++;
+    }
+    thread_pool_shared_unlock();
+    return pool;
+}
+
+static void _shape_release_workers_pool(ThreadPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    thread_pool_shared_lock();
+    _workersPoolUsers--;
+    thread_pool_shared_unlock();
+}
+
+static void _shape_mesh_chunks(Shape *shape, Chunk **chunks, const size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // all faces are kept until written, if they can't be allocated chunks are meshed one by one
+    ChunkMesh **meshes = (ChunkMesh **)malloc(count * sizeof(ChunkMesh *));
+    size_t nbMeshes = 0;
+    if (meshes != NULL) {
+        while (nbMeshes < count) {
+            meshes[nbMeshes] = chunk_mesh_new();
+            if (meshes[nbMeshes] == NULL) {
+                break;
+            }
+            nbMeshes++;
+        }
+    }
+    if (nbMeshes < count) {
+        for (size_t i = 0; i < nbMeshes; ++i) {
+            chunk_mesh_free(meshes[i]);
+        }
+        free(meshes);
+        for (size_t i = 0; i < count; ++i) {
+            chunk_write_vertices(shape, chunks[i]);
+        }
+        return;
+    }
+
+    ThreadPool *pool = count >= SHAPE_MESHING_PARALLEL_MIN_CHUNKS ? _shape_acquire_workers_pool()
+                                                                  : NULL;
+
+    // faces computation only reads chunks, they can be processed in any order
+    _ShapeMeshingJobs jobs = {shape, chunks, meshes};
+    thread_pool_parallel_for(pool, count, _shape_compute_chunk_mesh_job, &jobs);
+    _shape_release_workers_pool(pool);
+
+    // vertex buffers are shared by all chunks, write in refresh order for deterministic results
+    for (size_t i = 0; i < count; ++i) {
+        chunk_write_mesh(shape, chunks[i], meshes[i]);
+        chunk_mesh_free(meshes[i]);
+    }
+    free(meshes);
+}
+
+void _shape_chunk_enqueue_refresh(Shape *shape, Chunk *c) {
+    if (c == NULL)
+        return;
+    if (_shape_get_rendering_flag(shape, SHAPE_RENDERING_FLAG_MESH_SHARING)) {
+        _shape_mesh_detach(shape, true);
+    }
+    if (chunk_is_dirty(c) == false) {
+        if (shape->dirtyChunks == NULL) {
             shape->dirtyChunks = fifo_list_new();
         }
         fifo_list_push(shape->dirtyChunks, c);
@@ -3033,18 +3668,10 @@ void _shape_chunk_check_neighbors_dirty(Shape *shape,
     }
 }
 
-bool _shape_add_block_in_chunks(Shape *shape,
-                                const Block block,
-                                const SHAPE_COORDS_INT_T x,
-                                const SHAPE_COORDS_INT_T y,
-                                const SHAPE_COORDS_INT_T z,
-                                CHUNK_COORDS_INT3_T *block_coords,
-                                bool *chunkAdded,
-                                Chunk **added_or_existing_chunk,
-                                Block **added_or_existing_block) {
-
-    // see if there's a chunk ready for that block
-    const SHAPE_COORDS_INT3_T chunk_coords = chunk_utils_get_coords((SHAPE_COORDS_INT3_T){x, y, z});
+static Chunk *_shape_get_or_add_chunk(Shape *shape,
+                                      const SHAPE_COORDS_INT3_T chunk_coords,
+                                      RtreeLeaves *newLeaves,
+                                      bool *chunkAdded) {
     Chunk *chunk = (Chunk *)
         index3d_get(shape->chunks, chunk_coords.x, chunk_coords.y, chunk_coords.z);
 
@@ -3053,7 +3680,7 @@ bool _shape_add_block_in_chunks(Shape *shape,
         SHAPE_COORDS_INT3_T chunkOrigin = {(SHAPE_COORDS_INT_T)chunk_coords.x * CHUNK_SIZE,
                                            (SHAPE_COORDS_INT_T)chunk_coords.y * CHUNK_SIZE,
                                            (SHAPE_COORDS_INT_T)chunk_coords.z * CHUNK_SIZE};
-        chunk = chunk_new(chunkOrigin);
+        chunk = chunk_new_with_storage(chunkOrigin, shape->chunkStorage);
 
         index3d_insert(shape->chunks, chunk, chunk_coords.x, chunk_coords.y, chunk_coords.z, NULL);
         chunk_move_in_neighborhood(shape->chunks, chunk, chunk_coords);
@@ -3062,12 +3689,32 @@ bool _shape_add_block_in_chunks(Shape *shape,
                         {(float)(chunkOrigin.x + CHUNK_SIZE),
                          (float)(chunkOrigin.y + CHUNK_SIZE),
                          (float)(chunkOrigin.z + CHUNK_SIZE)}};
-        chunk_set_rtree_leaf(chunk, rtree_create_and_insert(shape->rtree, &chunkBox, 1, 1, chunk));
+        RtreeNode *leaf = rtree_create_leaf(shape->rtree, &chunkBox, 1, 1, chunk);
+        if (newLeaves == NULL || rtree_leaves_push(newLeaves, leaf) == false) {
+            rtree_insert(shape->rtree, leaf);
+        }
+        chunk_set_rtree_leaf(chunk, leaf);
 
         *chunkAdded = true;
     } else {
         *chunkAdded = false;
     }
+    return chunk;
+}
+
+bool _shape_add_block_in_chunks(Shape *shape,
+                                const Block block,
+                                const SHAPE_COORDS_INT_T x,
+                                const SHAPE_COORDS_INT_T y,
+                                const SHAPE_COORDS_INT_T z,
+                                CHUNK_COORDS_INT3_T *block_coords,
+                                bool *chunkAdded,
+                                Chunk **added_or_existing_chunk,
+                                Block **added_or_existing_block) {
+
+    // see if there's a chunk ready for that block
+    const SHAPE_COORDS_INT3_T chunk_coords = chunk_utils_get_coords((SHAPE_COORDS_INT3_T){x, y, z});
+    Chunk *chunk = _shape_get_or_add_chunk(shape, chunk_coords, NULL, chunkAdded);
 
     if (added_or_existing_chunk != NULL) {
         *added_or_existing_chunk = chunk;
@@ -3246,13 +3893,359 @@ void _light_removal_process_neighbor(Shape *s,
     }
 }
 
-void _light_set_and_enqueue_source(Shape *shape,
+// MARK: Parallel baked lighting
+
+// Light propagation only ever increases light values, its result doesn't depend on the order in
+// which nodes are processed. Each region propagates light in its own blocks, light reaching a block
+// owned by another region is sent to it as a border node & replayed there in the next wave.
+// Air blocks lit directly from above are given full sunlight first, most sunlight crossing borders
+// then has nothing to update & doesn't need to be sent
+
+/// light propagation reaching a block owned by another region
+typedef struct {
+    Chunk *chunk;
+    SHAPE_COORDS_INT3_T coords_in_shape;
+    CHUNK_COORDS_INT3_T coords_in_chunk;
+    VERTEX_LIGHT_STRUCT_T light;
+    uint8_t stepS;
+    // emissive self-lighting source, see _light_set_and_enqueue_source
+    bool source;
+    // owner of the block
+    uint32_t region;
+} _LightBorderNode;
+
+typedef struct {
+    _LightBorderNode *nodes;
+    size_t count;
+    size_t capacity;
+} _LightBorderNodes;
+
+typedef struct {
+    Shape *shape;
+    _LightRegion *regions;
+    // lowest y of air blocks lit directly from above, for each (x,z) column of the volume
+    SHAPE_COORDS_INT_T *skyHeight;
+    // volume aligned on chunks, regions are laid out on a (x,z) grid from its first chunk column
+    SHAPE_COORDS_INT3_T min, max;
+    SHAPE_COORDS_INT_T chunkX, chunkZ;
+    uint32_t width, depth;
+} _LightBake;
+
+struct _LightRegion {
+    const _LightBake *bake;
+    LightNodeQueue *queue;
+    // border nodes sent to other regions during current wave
+    _LightBorderNodes outbox;
+    // border nodes received from other regions, processed at the start of next wave
+    _LightBorderNodes inbox;
+    // changed values bounding box
+    SHAPE_COORDS_INT3_T min, max;
+    uint32_t index;
+};
+
+static uint32_t _light_bake_get_region(const _LightBake *bake, const SHAPE_COORDS_INT3_T coords) {
+    const SHAPE_COORDS_INT3_T chunkCoords = chunk_utils_get_coords(coords);
+
+    // blocks around the volume belong to the closest region
+    const int x = (chunkCoords.x - bake->chunkX) / SHAPE_LIGHTING_REGION_SIZE;
+    const int z = (chunkCoords.z - bake->chunkZ) / SHAPE_LIGHTING_REGION_SIZE;
+    const uint32_t rx = (uint32_t)minimum(maximum(x, 0), (int)bake->width - 1);
+    const uint32_t rz = (uint32_t)minimum(maximum(z, 0), (int)bake->depth - 1);
+
+    return rx * bake->depth + rz;
+}
+
+static size_t _light_bake_get_column(const _LightBake *bake, const SHAPE_COORDS_INT3_T coords) {
+    return (size_t)(coords.x - bake->min.x) * (size_t)(bake->max.z - bake->min.z) +
+           (size_t)(coords.z - bake->min.z);
+}
+
+static void _light_border_nodes_push(_LightBorderNodes *list, const _LightBorderNode *node) {
+    if (list->count == list->capacity) {
+        const size_t capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        _LightBorderNode *nodes = (_LightBorderNode *)realloc(list->nodes,
+                                                              capacity * sizeof(_LightBorderNode));
+        if (nodes == NULL) {
+            cclog_error("🔥 can't create light border node");
+            return;
+        }
+        list->nodes = nodes;
+        list->capacity = capacity;
+    }
+    list->nodes[list->count++] = *node;
+}
+
+/// returns true if block isn't owned by given region & was sent to its owner
+static bool _light_region_defer(_LightRegion *region,
+                                Chunk *c,
+                                const CHUNK_COORDS_INT3_T coords_in_chunk,
+                                const SHAPE_COORDS_INT3_T coords_in_shape,
+                                const VERTEX_LIGHT_STRUCT_T light,
+                                const uint8_t stepS,
+                                const bool source) {
+    const uint32_t owner = _light_bake_get_region(region->bake, coords_in_shape);
+    if (owner == region->index) {
+        return false;
+    }
+    // sunlight only, to an air block that already has full sunlight
+    if (source == false && light.red == 0 && light.green == 0 && light.blue == 0 &&
+        coords_in_shape.y >= region->bake->skyHeight[_light_bake_get_column(region->bake,
+                                                                             coords_in_shape)]) {
+        return true;
+    }
+    const _LightBorderNode node =
+        {c, coords_in_shape, coords_in_chunk, light, stepS, source, owner};
+    _light_border_nodes_push(&region->outbox, &node);
+    return true;
+}
+
+/// (x,z) columns of the given region, clamped to the volume
+static void _light_bake_get_region_columns(const _LightBake *bake,
+                                           const size_t idx,
+                                           SHAPE_COORDS_INT3_T *from,
+                                           SHAPE_COORDS_INT3_T *to) {
+    const SHAPE_COORDS_INT_T regionBlocks = CHUNK_SIZE * SHAPE_LIGHTING_REGION_SIZE;
+    from->x = (SHAPE_COORDS_INT_T)(bake->min.x + (SHAPE_COORDS_INT_T)(idx / bake->depth) *
+                                                     regionBlocks);
+    from->z = (SHAPE_COORDS_INT_T)(bake->min.z + (SHAPE_COORDS_INT_T)(idx % bake->depth) *
+                                                     regionBlocks);
+    to->x = (SHAPE_COORDS_INT_T)minimum(from->x + regionBlocks, bake->max.x);
+    to->z = (SHAPE_COORDS_INT_T)minimum(from->z + regionBlocks, bake->max.z);
+}
+
+/// sets full sunlight in air blocks lit directly from above & records each column's sky height
+static void _light_region_sunlight_job(void *ctx, const size_t idx) {
+    _LightBake *bake = (_LightBake *)ctx;
+    _LightRegion *r = &bake->regions[idx];
+    Shape *s = bake->shape;
+
+    SHAPE_COORDS_INT3_T from, to;
+    _light_bake_get_region_columns(bake, idx, &from, &to);
+    const SHAPE_COORDS_INT_T chunkFromY = chunk_utils_get_coords(bake->min).y;
+    const SHAPE_COORDS_INT_T chunkToY = chunk_utils_get_coords(bake->max).y - 1;
+
+    Chunk *chunk;
+    VERTEX_LIGHT_STRUCT_T light;
+    SHAPE_COORDS_INT3_T chunkCoords, coords;
+    CHUNK_COORDS_INT3_T cc;
+    SHAPE_COORDS_INT_T sky, cy;
+    for (coords.x = from.x; coords.x < to.x; ++coords.x) {
+        for (coords.z = from.z; coords.z < to.z; ++coords.z) {
+            coords.y = 0;
+            chunkCoords = chunk_utils_get_coords(coords);
+            cc = chunk_utils_get_coords_in_chunk(coords);
+            sky = bake->min.y;
+
+            for (cy = chunkToY; cy >= chunkFromY && sky == bake->min.y; --cy) {
+                chunk = (Chunk *)index3d_get(s->chunks, chunkCoords.x, cy, chunkCoords.z);
+                if (chunk == NULL) {
+                    continue;
+                }
+                for (cc.y = CHUNK_SIZE - 1; cc.y >= 0; --cc.y) {
+                    coords.y = (SHAPE_COORDS_INT_T)(cy * CHUNK_SIZE + cc.y);
+                    if (chunk_get_block_2(chunk, cc)->colorIndex != SHAPE_COLOR_INDEX_AIR_BLOCK) {
+                        sky = coords.y + 1;
+                        break;
+                    }
+                    light = chunk_get_light_without_checking(chunk, cc);
+                    light.ambient = 15;
+                    chunk_set_light(chunk, cc, light, true);
+                    _lighting_set_dirty(&r->min, &r->max, coords);
+                }
+            }
+            bake->skyHeight[_light_bake_get_column(bake, coords)] = sky;
+        }
+    }
+}
+
+/// enqueues sunlit blocks that may still light their surroundings: the lowest of each column, and
+/// those next to a column with a lower sky height
+static void _light_region_sunlight_edges_job(void *ctx, const size_t idx) {
+    _LightBake *bake = (_LightBake *)ctx;
+    _LightRegion *r = &bake->regions[idx];
+    Shape *s = bake->shape;
+
+    static const SHAPE_COORDS_INT_T offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+    SHAPE_COORDS_INT3_T from, to, neighbor, chunkCoords;
+    _light_bake_get_region_columns(bake, idx, &from, &to);
+
+    Chunk *chunk;
+    SHAPE_COORDS_INT3_T coords;
+    SHAPE_COORDS_INT_T sky, top;
+    for (coords.x = from.x; coords.x < to.x; ++coords.x) {
+        for (coords.z = from.z; coords.z < to.z; ++coords.z) {
+            sky = bake->skyHeight[_light_bake_get_column(bake, coords)];
+            top = sky + 1;
+            for (int i = 0; i < 4; ++i) {
+                neighbor = (SHAPE_COORDS_INT3_T){coords.x + offsets[i][0],
+                                                 0,
+                                                 coords.z + offsets[i][1]};
+                if (neighbor.x >= bake->min.x && neighbor.x < bake->max.x &&
+                    neighbor.z >= bake->min.z && neighbor.z < bake->max.z) {
+                    top = maximum(top, bake->skyHeight[_light_bake_get_column(bake, neighbor)]);
+                }
+            }
+            top = minimum(top, bake->max.y);
+
+            for (coords.y = sky; coords.y < top; ++coords.y) {
+                chunkCoords = chunk_utils_get_coords(coords);
+                chunk = (Chunk *)index3d_get(s->chunks,
+                                             chunkCoords.x,
+                                             chunkCoords.y,
+                                             chunkCoords.z);
+                if (chunk != NULL) {
+                    light_node_queue_push(r->queue, chunk, coords);
+                }
+            }
+        }
+    }
+}
+
+static void _light_region_job(void *ctx, const size_t idx) {
+    _LightBake *bake = (_LightBake *)ctx;
+    _LightRegion *r = &bake->regions[idx];
+    Shape *s = bake->shape;
+
+    // replay propagation from other regions into this one
+    const _LightBorderNode *n;
+    const Block *b;
+    for (size_t i = 0; i < r->inbox.count; ++i) {
+        n = &r->inbox.nodes[i];
+        if (n->source) {
+            _light_set_and_enqueue_source(r,
+                                          s,
+                                          n->chunk,
+                                          n->coords_in_chunk,
+                                          n->coords_in_shape,
+                                          n->light,
+                                          r->queue,
+                                          true);
+        } else {
+            b = chunk_get_block_2(n->chunk, n->coords_in_chunk);
+            _light_block_propagate(r,
+                                   s,
+                                   n->chunk,
+                                   &r->min,
+                                   &r->max,
+                                   n->light,
+                                   n->coords_in_chunk,
+                                   n->coords_in_shape,
+                                   b,
+                                   b->colorIndex == SHAPE_COLOR_INDEX_AIR_BLOCK,
+                                   color_palette_is_transparent(s->palette, b->colorIndex),
+                                   r->queue,
+                                   n->stepS,
+                                   EMISSION_PROPAGATION_STEP,
+                                   true);
+        }
+    }
+    r->inbox.count = 0;
+
+    _light_propagate_nodes(s, &r->min, &r->max, r->queue, r, true);
+}
+
+static bool _light_propagate_parallel(Shape *s,
+                                      ThreadPool *pool,
+                                      SHAPE_COORDS_INT3_T *bbMin,
+                                      SHAPE_COORDS_INT3_T *bbMax,
+                                      LightNodeQueue *lightQueue) {
+    // bounding box is aligned on chunks, see _light_removal_all
+    const SHAPE_COORDS_INT3_T chunkMin = chunk_utils_get_coords(*bbMin);
+    const uint32_t regionBlocks = CHUNK_SIZE * SHAPE_LIGHTING_REGION_SIZE;
+    const uint32_t width = ((uint32_t)(bbMax->x - bbMin->x) + regionBlocks - 1) / regionBlocks;
+    const uint32_t depth = ((uint32_t)(bbMax->z - bbMin->z) + regionBlocks - 1) / regionBlocks;
+    const uint32_t count = width * depth;
+    if (count < 2) {
+        return false;
+    }
+
+    _LightBake bake = {s, NULL, NULL, *bbMin, *bbMax, chunkMin.x, chunkMin.z, width, depth};
+    bake.regions = (_LightRegion *)calloc(count, sizeof(_LightRegion));
+    bake.skyHeight = (SHAPE_COORDS_INT_T *)malloc((size_t)(bbMax->x - bbMin->x) *
+                                                  (size_t)(bbMax->z - bbMin->z) *
+                                                  sizeof(SHAPE_COORDS_INT_T));
+    if (bake.regions == NULL || bake.skyHeight == NULL) {
+        free(bake.regions);
+        free(bake.skyHeight);
+        return false;
+    }
+
+    // changed values bounding box, source is above the volume as with _light_propagate
+    SHAPE_COORDS_INT3_T min = *bbMin;
+    SHAPE_COORDS_INT3_T max = *bbMax;
+    _lighting_set_dirty(&min, &max, (SHAPE_COORDS_INT3_T){bbMin->x - 1, bbMax->y, bbMin->z - 1});
+
+    for (uint32_t i = 0; i < count; ++i) {
+        bake.regions[i].bake = &bake;
+        bake.regions[i].queue = light_node_queue_new();
+        bake.regions[i].min = min;
+        bake.regions[i].max = max;
+        bake.regions[i].index = i;
+    }
+
+    // give each region its sources, then sunlight from above in its chunk columns
+    LightNode n;
+    while (light_node_queue_pop(lightQueue, &n)) {
+        light_node_queue_push(bake.regions[_light_bake_get_region(&bake, n.coords)].queue,
+                              n.chunk,
+                              n.coords);
+    }
+    thread_pool_parallel_for(pool, count, _light_region_sunlight_job, &bake);
+    thread_pool_parallel_for(pool, count, _light_region_sunlight_edges_job, &bake);
+
+    // propagate until no more light crosses regions borders
+    size_t exchanged;
+    _LightRegion *r;
+    do {
+        thread_pool_parallel_for(pool, count, _light_region_job, &bake);
+
+        exchanged = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            r = &bake.regions[i];
+            for (size_t j = 0; j < r->outbox.count; ++j) {
+                _light_border_nodes_push(&bake.regions[r->outbox.nodes[j].region].inbox,
+                                         &r->outbox.nodes[j]);
+            }
+            exchanged += r->outbox.count;
+            r->outbox.count = 0;
+        }
+    } while (exchanged > 0);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        r = &bake.regions[i];
+        min.x = minimum(min.x, r->min.x);
+        min.y = minimum(min.y, r->min.y);
+        min.z = minimum(min.z, r->min.z);
+        max.x = maximum(max.x, r->max.x);
+        max.y = maximum(max.y, r->max.y);
+        max.z = maximum(max.z, r->max.z);
+
+        light_node_queue_free(r->queue);
+        free(r->outbox.nodes);
+        free(r->inbox.nodes);
+    }
+    free(bake.regions);
+    free(bake.skyHeight);
+
+    _lighting_postprocess_dirty(s, &min, &max);
+
+    return true;
+}
+
+void _light_set_and_enqueue_source(_LightRegion *region,
+                                   Shape *shape,
                                    Chunk *c,
                                    CHUNK_COORDS_INT3_T coords_in_chunk,
                                    SHAPE_COORDS_INT3_T coords_in_shape,
                                    VERTEX_LIGHT_STRUCT_T source,
                                    LightNodeQueue *lightQueue,
                                    bool initEmpty) {
+    if (region != NULL &&
+        _light_region_defer(region, c, coords_in_chunk, coords_in_shape, source, 0, true)) {
+        return;
+    }
+
     VERTEX_LIGHT_STRUCT_T current = chunk_get_light_without_checking(c, coords_in_chunk);
     const bool s = current.ambient < source.ambient;
     const bool r = current.red < source.red;
@@ -3345,7 +4338,8 @@ void _light_enqueue_ambient_and_block_sources(Shape *s,
     }
 }
 
-void _light_block_propagate(Shape *s,
+void _light_block_propagate(_LightRegion *region,
+                            Shape *s,
                             Chunk *c,
                             SHAPE_COORDS_INT3_T *bbMin,
                             SHAPE_COORDS_INT3_T *bbMax,
@@ -3360,6 +4354,11 @@ void _light_block_propagate(Shape *s,
                             uint8_t stepRGB,
                             bool initEmpty) {
 
+    if (region != NULL &&
+        _light_region_defer(region, c, coords_in_chunk, coords_in_shape, current, stepS, false)) {
+        return;
+    }
+
     // if neighbor non-opaque, propagate sunlight and emission values individually & enqueue if
     // needed
     if (air || transparent) {
@@ -3433,18 +4432,33 @@ void _light_propagate(Shape *s,
                       SHAPE_COORDS_INT_T srcZ,
                       bool initWithEmptyLight) {
 
+    // changed values bounding box
+    SHAPE_COORDS_INT3_T min = *bbMin;
+    SHAPE_COORDS_INT3_T max = *bbMax;
+
+    // set source block dirty
+    _lighting_set_dirty(&min, &max, (SHAPE_COORDS_INT3_T){srcX, srcY, srcZ});
+
+    _light_propagate_nodes(s, &min, &max, lightQueue, NULL, initWithEmptyLight);
+
+    _lighting_postprocess_dirty(s, &min, &max);
+}
+
+void _light_propagate_nodes(Shape *s,
+                            SHAPE_COORDS_INT3_T *bbMin,
+                            SHAPE_COORDS_INT3_T *bbMax,
+                            LightNodeQueue *lightQueue,
+                            _LightRegion *region,
+                            bool initWithEmptyLight) {
+
 #if SHAPE_LIGHTING_DEBUG
     cclog_debug("☀️ light propagation started...");
     int iCount = 0;
 #endif
 
-    // changed values bounding box
     SHAPE_COORDS_INT3_T min = *bbMin;
     SHAPE_COORDS_INT3_T max = *bbMax;
 
-    // set source block dirty
-    _lighting_set_dirty(&min, &max, (SHAPE_COORDS_INT3_T){srcX, srcY, srcZ});
-
     Chunk *chunk, *insertChunk;
     CHUNK_COORDS_INT3_T coords_in_chunk, cc;
     SHAPE_COORDS_INT3_T coords_in_shape, cs;
@@ -3452,10 +4466,10 @@ void _light_propagate(Shape *s,
     const Block *neighbor = NULL;
     VERTEX_LIGHT_STRUCT_T currentLight;
     bool isCurrentAir, isCurrentOpen, isCurrentTransparent, isNeighborAir, isNeighborTransparent;
-    LightNode *n = light_node_queue_pop(lightQueue);
-    while (n != NULL) {
-        coords_in_shape = light_node_get_coords(n);
-        chunk = light_node_get_chunk(n);
+    LightNode n;
+    while (light_node_queue_pop(lightQueue, &n)) {
+        coords_in_shape = n.coords;
+        chunk = n.chunk;
 
         coords_in_chunk = chunk_utils_get_coords_in_chunk(coords_in_shape);
 
@@ -3500,7 +4514,8 @@ void _light_propagate(Shape *s,
 
             if (isCurrentAir || isCurrentTransparent) {
                 // sunlight propagates infinitely vertically (step = 0)
-                _light_block_propagate(s,
+                _light_block_propagate(region,
+                                       s,
                                        insertChunk,
                                        &min,
                                        &max,
@@ -3550,7 +4565,8 @@ void _light_propagate(Shape *s,
             }
 
             if (isCurrentAir || isCurrentTransparent) {
-                _light_block_propagate(s,
+                _light_block_propagate(region,
+                                       s,
                                        insertChunk,
                                        &min,
                                        &max,
@@ -3592,7 +4608,8 @@ void _light_propagate(Shape *s,
             }
 
             if (isCurrentAir || isCurrentTransparent) {
-                _light_block_propagate(s,
+                _light_block_propagate(region,
+                                       s,
                                        insertChunk,
                                        &min,
                                        &max,
@@ -3634,7 +4651,8 @@ void _light_propagate(Shape *s,
             }
 
             if (isCurrentAir || isCurrentTransparent) {
-                _light_block_propagate(s,
+                _light_block_propagate(region,
+                                       s,
                                        insertChunk,
                                        &min,
                                        &max,
@@ -3676,7 +4694,8 @@ void _light_propagate(Shape *s,
             }
 
             if (isCurrentAir || isCurrentTransparent) {
-                _light_block_propagate(s,
+                _light_block_propagate(region,
+                                       s,
                                        insertChunk,
                                        &min,
                                        &max,
@@ -3718,7 +4737,8 @@ void _light_propagate(Shape *s,
             }
 
             if (isCurrentAir || isCurrentTransparent) {
-                _light_block_propagate(s,
+                _light_block_propagate(region,
+                                       s,
                                        insertChunk,
                                        &min,
                                        &max,
@@ -3743,8 +4763,6 @@ void _light_propagate(Shape *s,
                                                                      current->colorIndex);
 
             if (currentLight.red == 0 && currentLight.green == 0 && currentLight.blue == 0) {
-                light_node_queue_recycle(n);
-                n = light_node_queue_pop(lightQueue);
                 continue;
             }
             // here: emissive block in need of (re)propagation
@@ -3769,6 +4787,7 @@ void _light_propagate(Shape *s,
                                                                        &cc);
                         if (neighbor != NULL && block_is_opaque(neighbor, s->palette) == false) {
                             _light_set_and_enqueue_source(
+                                region,
                                 s,
                                 insertChunk,
                                 cc,
@@ -3787,12 +4806,10 @@ void _light_propagate(Shape *s,
 #if SHAPE_LIGHTING_DEBUG
         iCount++;
 #endif
-
-        light_node_queue_recycle(n);
-        n = light_node_queue_pop(lightQueue);
     }
 
-    _lighting_postprocess_dirty(s, &min, &max);
+    *bbMin = min;
+    *bbMax = max;
 
 #if SHAPE_LIGHTING_DEBUG
     cclog_debug("☀️ light propagation done with %d iterations", iCount);
@@ -3817,13 +4834,13 @@ void _light_removal(Shape *s,
     Chunk *chunk, *insertChunk;
     SHAPE_COORDS_INT3_T coords_in_shape;
     CHUNK_COORDS_INT3_T coords_in_chunk, cc;
-    LightRemovalNode *rn = light_removal_node_queue_pop(lightRemovalQueue);
-    while (rn != NULL) {
-        coords_in_shape = light_removal_node_get_coords(rn);
-        light = light_removal_node_get_light(rn);
-        srgb = light_removal_node_get_srgb(rn);
-        blockID = light_removal_node_get_block_id(rn);
-        chunk = light_removal_node_get_chunk(rn);
+    LightRemovalNode rn;
+    while (light_removal_node_queue_pop(lightRemovalQueue, &rn)) {
+        coords_in_shape = rn.coords;
+        light = rn.light;
+        srgb = rn.srgb;
+        blockID = rn.blockID;
+        chunk = rn.chunk;
 
         // check that the current block is inside the shape bounds
         if (shape_is_within_bounding_box(s, coords_in_shape)) {
@@ -4037,9 +5054,6 @@ void _light_removal(Shape *s,
 #if SHAPE_LIGHTING_DEBUG
         iCount++;
 #endif
-
-        light_removal_node_queue_recycle(rn);
-        rn = light_removal_node_queue_pop(lightRemovalQueue);
     }
 
 #if SHAPE_LIGHTING_DEBUG
@@ -4091,6 +5105,8 @@ void _shape_check_all_vb_fragmented(Shape *s, VertexBuffer *first) {
 }
 
 void _shape_flush_all_vb(Shape *s) {
+    _shape_mesh_detach(s, false);
+
     // unbind all chunks from current vertex buffers and set them dirty
     Index3DIterator *it = index3d_iterator_new(s->chunks);
     Chunk *c;
@@ -4132,6 +5148,260 @@ VertexBuffer *_shape_get_latest_buffer(const Shape *s, const bool transparent) {
     }
 }
 
+static uint64_t _shape_get_mesh_hash(Shape *s) {
+    // vertices encode palette atlas indices & transparency, instances draw the atlas colors of
+    // their owner's palette: palettes must have the same colors
+    const uint8_t flags = s->renderingFlags & SHAPE_RENDERING_FLAGS_MESH;
+    uLong crc = crc32(0, (const Bytef *)&flags, sizeof(uint8_t));
+    const uint8_t count = s->palette != NULL ? color_palette_get_count(s->palette) : 0;
+    for (SHAPE_COLOR_INDEX_INT_T i = 0; i < count; ++i) {
+        const RGBAColor color = color_palette_get_color(s->palette, i);
+        crc = crc32(crc, (const Bytef *)&color, sizeof(RGBAColor));
+    }
+
+    // chunks hashes are summed up, for a result independent of chunks iteration order
+    uint64_t chunksHash = 0;
+    Index3DIterator *it = index3d_iterator_new(s->chunks);
+    Chunk *c;
+    VERTEX_LIGHT_STRUCT_T *lighting;
+    uint64_t hash;
+    while (index3d_iterator_pointer(it) != NULL) {
+        c = index3d_iterator_pointer(it);
+        hash = chunk_get_hash(c, 0);
+
+        lighting = chunk_get_lighting_data(c);
+        if (lighting != NULL) {
+            hash = crc32((uLong)hash,
+                         (const Bytef *)lighting,
+                         (uInt)(CHUNK_SIZE_CUBE * sizeof(VERTEX_LIGHT_STRUCT_T)));
+        }
+        chunksHash += hash;
+
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+
+    return ((uint64_t)crc << 32) ^ chunksHash;
+}
+
+static bool _shape_mesh_equals(const Shape *a, const Shape *b) {
+    if (a->nbBlocks != b->nbBlocks || a->nbChunks != b->nbChunks ||
+        (a->renderingFlags & SHAPE_RENDERING_FLAGS_MESH) !=
+            (b->renderingFlags & SHAPE_RENDERING_FLAGS_MESH) ||
+        memcmp(&a->bbMin, &b->bbMin, sizeof(SHAPE_COORDS_INT3_T)) != 0 ||
+        memcmp(&a->bbMax, &b->bbMax, sizeof(SHAPE_COORDS_INT3_T)) != 0) {
+        return false;
+    }
+
+    // palettes must have the same colors, see _shape_get_mesh_hash
+    const uint8_t count = a->palette != NULL ? color_palette_get_count(a->palette) : 0;
+    if (count != (b->palette != NULL ? color_palette_get_count(b->palette) : 0)) {
+        return false;
+    }
+    RGBAColor colorA, colorB;
+    for (SHAPE_COLOR_INDEX_INT_T i = 0; i < count; ++i) {
+        colorA = color_palette_get_color(a->palette, i);
+        colorB = color_palette_get_color(b->palette, i);
+        if (colors_are_equal(&colorA, &colorB) == false) {
+            return false;
+        }
+    }
+
+    bool equals = true;
+    Index3DIterator *it = index3d_iterator_new(a->chunks);
+    const Chunk *c, *other;
+    SHAPE_COORDS_INT3_T coords;
+    while (equals && index3d_iterator_pointer(it) != NULL) {
+        c = index3d_iterator_pointer(it);
+        coords = chunk_utils_get_coords(chunk_get_origin(c));
+        other = (const Chunk *)index3d_get(b->chunks, coords.x, coords.y, coords.z);
+        equals = other != NULL && chunk_has_same_content(c, other);
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+
+    return equals;
+}
+
+static bool _shape_mesh_palettes_changed(const Shape *s) {
+    const Shape *owner = s->meshOwner;
+    if (s->palette == owner->palette) {
+        return false;
+    }
+    if (s->palette == NULL || owner->palette == NULL) {
+        return true;
+    }
+    return color_palette_get_version(s->palette) != s->meshPaletteVersion ||
+           color_palette_get_version(owner->palette) != s->meshOwnerPaletteVersion;
+}
+
+static size_t _shape_mesh_index_slot(const uint64_t hash) {
+    return (size_t)(hash ^ (hash >> 32)) & (_sharedMeshesCapacity - 1);
+}
+
+static size_t _shape_mesh_index_find(const Shape *s, const uint64_t hash) {
+    const size_t mask = _sharedMeshesCapacity - 1;
+    size_t i = _shape_mesh_index_slot(hash);
+    while (_sharedMeshes[i] != NULL && _sharedMeshes[i] != s) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static bool _shape_mesh_share(Shape *s, const uint64_t hash) {
+    if (s->nbBlocks == 0) {
+        return false;
+    }
+
+    thread_pool_shared_lock();
+    if (_sharedMeshes == NULL) {
+        thread_pool_shared_unlock();
+        return false;
+    }
+
+    const size_t mask = _sharedMeshesCapacity - 1;
+    size_t i = _shape_mesh_index_slot(hash);
+    Shape *owner = NULL;
+    while (_sharedMeshes[i] != NULL) {
+        if (_sharedMeshes[i]->meshHash == hash && _shape_mesh_equals(_sharedMeshes[i], s)) {
+            owner = _sharedMeshes[i];
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    if (owner == NULL) {
+        thread_pool_shared_unlock();
+        return false;
+    }
+
+    // chunks are not meshed as long as the shape draws the shared mesh
+    Chunk *c = fifo_list_pop(s->dirtyChunks);
+    while (c != NULL) {
+        chunk_set_dirty(c, false);
+        c = fifo_list_pop(s->dirtyChunks);
+    }
+
+    if (owner->meshInstances == NULL) {
+        owner->meshInstances = doubly_linked_list_new();
+    }
+    doubly_linked_list_push_last(owner->meshInstances, s);
+    s->meshOwner = owner;
+    s->meshPaletteVersion = s->palette != NULL ? color_palette_get_version(s->palette) : 0;
+    s->meshOwnerPaletteVersion = owner->palette != NULL ? color_palette_get_version(owner->palette)
+                                                        : 0;
+    thread_pool_shared_unlock();
+
+    return true;
+}
+
+static void _shape_mesh_register(Shape *s, const uint64_t hash) {
+    thread_pool_shared_lock();
+    if ((_sharedMeshesCount + 1) * 4 > _sharedMeshesCapacity * 3) {
+        const size_t capacity = _sharedMeshesCapacity > 0 ? _sharedMeshesCapacity * 2
+                                                          : SHAPE_SHARED_MESHES_INITIAL_CAPACITY;
+        Shape **slots = (Shape **)calloc(capacity, sizeof(Shape *));
+        if (slots == NULL) {
+            thread_pool_shared_unlock();
+            return;
+        }
+        Shape **previous = _sharedMeshes;
+        const size_t previousCapacity = _sharedMeshesCapacity;
+        _sharedMeshes = slots;
+        _sharedMeshesCapacity = capacity;
+        for (size_t i = 0; i < previousCapacity; ++i) {
+            if (previous[i] != NULL) {
+                _sharedMeshes[_shape_mesh_index_find(previous[i], previous[i]->meshHash)] =
+                    previous[i];
+            }
+        }
+        free(previous);
+    }
+    s->meshHash = hash;
+    s->meshRegistered = true;
+    _sharedMeshes[_shape_mesh_index_find(s, hash)] = s;
+    _sharedMeshesCount++;
+    thread_pool_shared_unlock();
+}
+
+static void _shape_mesh_unregister(Shape *s) {
+    const size_t mask = _sharedMeshesCapacity - 1;
+    size_t i = _shape_mesh_index_find(s, s->meshHash);
+    vx_assert(_sharedMeshes[i] == s);
+    s->meshRegistered = false;
+
+    // backward shift deletion: moves up following entries that can't be found past an empty slot
+    size_t j = i, home;
+    while (true) {
+        j = (j + 1) & mask;
+        if (_sharedMeshes[j] == NULL) {
+            break;
+        }
+        home = _shape_mesh_index_slot(_sharedMeshes[j]->meshHash);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            _sharedMeshes[i] = _sharedMeshes[j];
+            i = j;
+        }
+    }
+    _sharedMeshes[i] = NULL;
+
+    if (--_sharedMeshesCount == 0) {
+        free(_sharedMeshes);
+        _sharedMeshes = NULL;
+        _sharedMeshesCapacity = 0;
+    }
+}
+
+static void _shape_mesh_enqueue_all_chunks(Shape *s) {
+    Index3DIterator *it = index3d_iterator_new(s->chunks);
+    while (index3d_iterator_pointer(it) != NULL) {
+        _shape_chunk_enqueue_refresh(s, index3d_iterator_pointer(it));
+        index3d_iterator_next(it);
+    }
+    index3d_iterator_free(it);
+}
+
+static void _shape_mesh_detach(Shape *s, const bool remesh) {
+    thread_pool_shared_lock();
+
+    // an instance only has to leave its owner, or may have been released by it already
+    bool meshSelf = s->meshReleased;
+    s->meshReleased = false;
+    if (s->meshOwner != NULL) {
+        Shape *owner = s->meshOwner;
+        s->meshOwner = NULL;
+        meshSelf = true;
+
+        doubly_linked_list_delete_node(owner->meshInstances,
+                                       doubly_linked_list_find(owner->meshInstances, s));
+        if (doubly_linked_list_is_empty(owner->meshInstances)) {
+            doubly_linked_list_free(owner->meshInstances);
+            owner->meshInstances = NULL;
+        }
+    } else if (s->meshRegistered) {
+        _shape_mesh_unregister(s);
+
+        // the shape keeps its vertex buffers and updates them as usual. They encode its palette
+        // atlas indices, so instances can't take them over: each meshes its own on its next
+        // refresh, the first one registers a shared mesh for the others
+        if (s->meshInstances != NULL) {
+            Shape *instance = (Shape *)doubly_linked_list_pop_first(s->meshInstances);
+            while (instance != NULL) {
+                instance->meshOwner = NULL;
+                instance->meshReleased = true;
+                instance = (Shape *)doubly_linked_list_pop_first(s->meshInstances);
+            }
+            doubly_linked_list_free(s->meshInstances);
+            s->meshInstances = NULL;
+        }
+    }
+
+    thread_pool_shared_unlock();
+
+    if (meshSelf && remesh) {
+        _shape_mesh_enqueue_all_chunks(s);
+    }
+}
+
 bool _shape_apply_transaction(Shape *const sh, Transaction *tr) {
     vx_assert(sh != NULL);
     vx_assert(tr != NULL);
@@ -26,6 +26,7 @@ extern "C" {
 #include "octree.h"
 #include "quaternion.h"
 #include "ray.h"
+#include "thread_pool.h"
 #include "vertextbuffer.h"
 
 typedef struct _RigidBody RigidBody;
@@ -67,6 +68,8 @@ typedef uint8_t ShapeDrawMode;
 
 Shape *shape_make(void);
 Shape *shape_make_2(const bool isMutable);
+/// Chunks of the copy share their blocks & lighting w/ the origin until first write, returns NULL
+/// if they couldn't be copied
 Shape *shape_make_copy(Shape *const origin);
 
 /// Returns false if retain fails
@@ -130,6 +133,7 @@ bool shape_paint_block_as_transaction(Shape *const shape,
                                       const SHAPE_COORDS_INT_T y,
                                       const SHAPE_COORDS_INT_T z);
 
+bool shape_has_pending_transaction(const Shape *shape);
 ///
 void shape_apply_current_transaction(Shape *const shape, bool keepPending);
 
@@ -141,6 +145,16 @@ bool shape_add_block(Shape *shape,
                      const SHAPE_COORDS_INT_T z,
                      bool useDefaultColor);
 
+/// Adds blocks from a grid of palette indices laid out as grid[(x * height + y) * depth + z], at
+/// shape coordinates [0, size[, air blocks are skipped and existing blocks are kept. Much faster
+/// than calling shape_add_block for each block when loading a model: chunks are filled directly and
+/// bounding box, palette usage & dirty chunks are updated once. Returns number of blocks added
+size_t shape_fill_blocks_from_grid(Shape *shape,
+                                   const SHAPE_COLOR_INDEX_INT_T *grid,
+                                   const uint16_t width,
+                                   const uint16_t height,
+                                   const uint16_t depth);
+
 bool shape_remove_block(Shape *shape,
                         const SHAPE_COORDS_INT_T x,
                         const SHAPE_COORDS_INT_T y,
@@ -261,8 +275,41 @@ void shape_log_vertex_buffers(const Shape *shape, bool dirtyOnly, bool transpare
 VertexBuffer *shape_add_buffer(Shape *shape, bool transparency);
 void shape_refresh_vertices(Shape *shape);
 void shape_refresh_all_vertices(Shape *s);
+/// Chunks faces are computed on worker threads shared by all shapes, when enough chunks need a
+/// refresh. By default, one worker is used per additional core (up to SHAPE_MESHING_MAX_WORKERS),
+/// 0 meshes everything on the calling thread, -1 restores the default.
+/// The same workers bake lighting, in regions of SHAPE_LIGHTING_REGION_SIZE chunk columns.
+/// Returns false, leaving workers untouched, if they are in use by another thread
+bool shape_set_meshing_workers(const int nbWorkers);
 VertexBuffer *shape_get_first_vertex_buffer(const Shape *shape, bool transparent);
 
+// MARK: - Mesh sharing -
+
+/// When enabled, a shape meshed for the first time draws the vertex buffers of another enabled
+/// shape w/ identical content (blocks, palette colors & baked lighting) instead of writing its own.
+/// Only vertex buffers are shared, each shape keeps its own palette. A shape meshes its own vertex
+/// buffers again as soon as it is modified, or its palette or the other shape's changes colors
+/// (checked by shape_refresh_vertices). When the other shape is modified or freed, shapes drawing
+/// its vertex buffers are meshed again, the first one refreshed sharing its own w/ the others.
+/// Shapes may be refreshed on different threads: the shared meshes index & the links between
+/// shapes are guarded by thread_pool_shared_lock. Shape content isn't, a shape w/ mesh sharing
+/// must not be modified while another thread refreshes a shape w/ mesh sharing or draws one of its
+/// instances
+void shape_toggle_mesh_sharing(Shape *s, const bool toggle);
+bool shape_uses_mesh_sharing(const Shape *s);
+/// An instance has no vertex buffers of its own, shape_get_first_vertex_buffer returns its owner's.
+/// Renderers may skip instances and draw them all w/ their owner, see
+/// shape_get_mesh_instances_models
+bool shape_is_mesh_instance(const Shape *s);
+/// Returns the shape whose vertex buffers are drawn for given shape, itself if not an instance
+Shape *shape_get_mesh_owner(Shape *s);
+/// Number of shapes drawing the same vertex buffers as given shape, including itself
+size_t shape_get_mesh_instances_count(const Shape *s);
+/// Fills the model matrices of a mesh owner & of its instances, hidden shapes excluded, to draw
+/// its vertex buffers once for all of them
+/// @return number of matrices written, at most max
+size_t shape_get_mesh_instances_models(Shape *s, Matrix4x4 *models, const size_t max);
+
 // MARK: - Physics -
 
 Rtree *shape_get_rtree(const Shape *shape);
@@ -308,6 +355,9 @@ bool shape_point_overlap(const Shape *s, const float3 *world);
 /// Overlaps a box in shape's model space against its blocks
 /// @return true if there is an overlap
 bool shape_box_overlap(const Shape *s, const Box *modelBox, const float3 *modelEpsilon, Box *out);
+/// Builds missing octrees of chunks overlapping a world box. Box queries in that area then only
+/// read the shape, and can run on other threads while it isn't modified
+void shape_build_octrees_in_box(Shape *s, const Box *worldBox);
 
 // MARK: - Graphics -
 
@@ -325,6 +375,19 @@ bool shape_has_shadow(const Shape *s);
 void shape_set_unlit(Shape *s, const bool value);
 bool shape_is_unlit(const Shape *s);
 
+/// Greedy meshing merges adjacent coplanar faces sharing the same color, ambient occlusion and
+/// baked lighting into larger quads, for an identical result w/ fewer vertices
+void shape_set_greedy_meshing(Shape *s, const bool toggle);
+bool shape_uses_greedy_meshing(const Shape *s);
+/// Number of visible block faces & of quads written for them during last vertices refresh,
+/// 1 - nbQuads / nbFaces gives the reduction ratio obtained w/ greedy meshing
+void shape_get_meshing_stats(const Shape *s, size_t *nbFaces, size_t *nbQuads);
+
+/// Chunks use an octree by default, dense storage trades memory for faster block lookups &
+/// edits, which suits maps & large filled models. Existing chunks are converted
+void shape_set_chunk_storage(Shape *s, const ChunkStorage storage);
+ChunkStorage shape_get_chunk_storage(const Shape *s);
+
 void shape_set_layers(Shape *s, const uint16_t value);
 uint16_t shape_get_layers(const Shape *s);
 
@@ -347,8 +410,12 @@ void shape_remove_point(Shape *s, const char *key);
 /// Shape lighting may be initialized from baked lighting, or by calling this function directly.
 /// Calling this function will enable the use of baked lighting for the shape i.e. adding or
 /// removing blocks will now update baked lighting. If already enabled, it overwrites existing
-/// baked lighting
+/// baked lighting. Large shapes are baked in parallel on the workers shared w/ meshing
 void shape_compute_baked_lighting(Shape *s);
+/// Same as shape_compute_baked_lighting, on given pool (NULL bakes on the calling thread only).
+/// Parallel baking keeps a light queue & border nodes per region of SHAPE_LIGHTING_REGION_SIZE
+/// chunk columns, peak memory is about 4x the serial bake (17 MB vs. 4.5 MB for 256x46x256 blocks)
+void shape_compute_baked_lighting_on_pool(Shape *s, ThreadPool *pool);
 
 void shape_toggle_baked_lighting(Shape *s, const bool toggle);
 bool shape_uses_baked_lighting(const Shape *s);
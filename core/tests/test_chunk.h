@@ -6,9 +6,12 @@
 
 #pragma once
 
+#include <time.h>
+
 #include "block.h"
 #include "chunk.h"
 #include "int3.h"
+#include "thread_pool.h"
 
 ///// Some function are left untested :
 // --- chunk_get_neighbor()
@@ -144,3 +147,271 @@ void test_chunk_needs_display(void) {
 
     chunk_free(chunk, false);
 }
+
+// Apply the same sequence of adds, removes & paints on a chunk of each storage, and check that
+// blocks, bounding box & hash are identical. Also check all of these function :
+// --- chunk_new_with_storage()
+// --- chunk_get_storage()
+// --- chunk_set_storage()
+// --- chunk_get_hash()
+/////
+void test_chunk_dense_storage(void) {
+    Chunk *octreeChunk = chunk_new_with_storage((SHAPE_COORDS_INT3_T){0, 0, 0},
+                                                CHUNK_STORAGE_OCTREE);
+    Chunk *denseChunk = chunk_new_with_storage((SHAPE_COORDS_INT3_T){0, 0, 0},
+                                               CHUNK_STORAGE_DENSE);
+    TEST_CHECK(chunk_get_storage(octreeChunk) == CHUNK_STORAGE_OCTREE);
+    TEST_CHECK(chunk_get_storage(denseChunk) == CHUNK_STORAGE_DENSE);
+
+    uint32_t seed = 42;
+    CHUNK_COORDS_INT_T x, y, z;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        x = (CHUNK_COORDS_INT_T)((seed >> 8) % CHUNK_SIZE);
+        y = (CHUNK_COORDS_INT_T)((seed >> 12) % CHUNK_SIZE);
+        z = (CHUNK_COORDS_INT_T)((seed >> 16) % CHUNK_SIZE);
+        const SHAPE_COLOR_INDEX_INT_T color = (SHAPE_COLOR_INDEX_INT_T)((seed >> 20) % 200);
+
+        switch ((seed >> 28) % 4) {
+            case 0:
+            case 1: {
+                const Block b = {color};
+                TEST_CHECK(chunk_add_block(octreeChunk, b, x, y, z) ==
+                           chunk_add_block(denseChunk, b, x, y, z));
+                break;
+            }
+            case 2:
+                TEST_CHECK(chunk_remove_block(octreeChunk, x, y, z, NULL) ==
+                           chunk_remove_block(denseChunk, x, y, z, NULL));
+                break;
+            default:
+                TEST_CHECK(chunk_paint_block(octreeChunk, x, y, z, color, NULL) ==
+                           chunk_paint_block(denseChunk, x, y, z, color, NULL));
+                break;
+        }
+    }
+
+    TEST_CHECK(chunk_get_nb_blocks(octreeChunk) == chunk_get_nb_blocks(denseChunk));
+    float3 min1, max1, min2, max2;
+    chunk_get_bounding_box(octreeChunk, &min1, &max1);
+    chunk_get_bounding_box(denseChunk, &min2, &max2);
+    TEST_CHECK(float3_isEqual(&min1, &min2, EPSILON_ZERO));
+    TEST_CHECK(float3_isEqual(&max1, &max2, EPSILON_ZERO));
+    TEST_CHECK(chunk_get_hash(octreeChunk, 0) == chunk_get_hash(denseChunk, 0));
+
+    // converting storage keeps blocks
+    chunk_set_storage(denseChunk, CHUNK_STORAGE_OCTREE);
+    chunk_set_storage(octreeChunk, CHUNK_STORAGE_DENSE);
+    for (x = 0; x < CHUNK_SIZE; ++x) {
+        for (y = 0; y < CHUNK_SIZE; ++y) {
+            for (z = 0; z < CHUNK_SIZE; ++z) {
+                TEST_CHECK(chunk_get_block(octreeChunk, x, y, z)->colorIndex ==
+                           chunk_get_block(denseChunk, x, y, z)->colorIndex);
+            }
+        }
+    }
+    TEST_CHECK(chunk_get_hash(octreeChunk, 0) == chunk_get_hash(denseChunk, 0));
+
+    chunk_free(octreeChunk, false);
+    chunk_free(denseChunk, false);
+}
+
+static double _test_chunk_storage_benchmark_run(const ChunkStorage storage, size_t *solidCount) {
+    const clock_t start = clock();
+
+    Chunk *chunk = chunk_new_with_storage((SHAPE_COORDS_INT3_T){0, 0, 0}, storage);
+    const Block b = {1};
+    Chunk *neighbor;
+    CHUNK_COORDS_INT3_T neighborCoords;
+
+    *solidCount = 0;
+    for (int pass = 0; pass < 20; ++pass) {
+        // block edits, filling the chunk below a wavy surface
+        for (CHUNK_COORDS_INT_T x = 0; x < CHUNK_SIZE; ++x) {
+            for (CHUNK_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+                for (CHUNK_COORDS_INT_T y = 0; y < 8 + (x + z + pass) % 8; ++y) {
+                    chunk_add_block(chunk, b, x, y, z);
+                }
+            }
+        }
+        // lookups, as done when meshing
+        for (CHUNK_COORDS_INT_T x = 0; x < CHUNK_SIZE; ++x) {
+            for (CHUNK_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+                for (CHUNK_COORDS_INT_T y = 0; y < CHUNK_SIZE; ++y) {
+                    for (CHUNK_COORDS_INT_T d = -1; d <= 1; d += 2) {
+                        *solidCount += block_is_solid(
+                            chunk_get_block_including_neighbors(chunk,
+                                                                x + d,
+                                                                y,
+                                                                z,
+                                                                &neighbor,
+                                                                &neighborCoords));
+                        *solidCount += block_is_solid(
+                            chunk_get_block_including_neighbors(chunk,
+                                                                x,
+                                                                y + d,
+                                                                z,
+                                                                &neighbor,
+                                                                &neighborCoords));
+                        *solidCount += block_is_solid(
+                            chunk_get_block_including_neighbors(chunk,
+                                                                x,
+                                                                y,
+                                                                z + d,
+                                                                &neighbor,
+                                                                &neighborCoords));
+                    }
+                }
+            }
+        }
+        // carve the surface back
+        for (CHUNK_COORDS_INT_T x = 0; x < CHUNK_SIZE; ++x) {
+            for (CHUNK_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+                for (CHUNK_COORDS_INT_T y = CHUNK_SIZE_MINUS_ONE; y >= 8; --y) {
+                    chunk_remove_block(chunk, x, y, z, NULL);
+                }
+            }
+        }
+    }
+    chunk_free(chunk, false);
+
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+// Compare block edits & lookups w/ both storages on a dense chunk, timings are reported as a
+// test case (visible w/ --verbose=3)
+void test_chunk_storage_benchmark(void) {
+    size_t octreeCount, denseCount;
+    const double octreeMs = _test_chunk_storage_benchmark_run(CHUNK_STORAGE_OCTREE, &octreeCount);
+    const double denseMs = _test_chunk_storage_benchmark_run(CHUNK_STORAGE_DENSE, &denseCount);
+
+    TEST_CASE_("octree: %.2fms, dense: %.2fms", octreeMs, denseMs);
+    TEST_CHECK(octreeCount == denseCount);
+    TEST_CHECK(octreeCount > 0);
+}
+
+static void _test_chunk_fill_for_copy(Chunk *chunk) {
+    const Block b = {1};
+    for (CHUNK_COORDS_INT_T x = 0; x < CHUNK_SIZE; ++x) {
+        for (CHUNK_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+            for (CHUNK_COORDS_INT_T y = 0; y < 1 + (x + z) % 6; ++y) {
+                chunk_add_block(chunk, b, x, y, z);
+            }
+        }
+    }
+    chunk_reset_lighting_data(chunk, true);
+    chunk_set_light(chunk,
+                    (CHUNK_COORDS_INT3_T){2, 8, 2},
+                    (VERTEX_LIGHT_STRUCT_T){9, 0, 0, 0},
+                    true);
+}
+
+// Copies share blocks & lighting w/ their source, check that writing to any of them doesn't change
+// the others, whichever is freed first
+void test_chunk_copy_on_write(void) {
+    const ChunkStorage storages[2] = {CHUNK_STORAGE_OCTREE, CHUNK_STORAGE_DENSE};
+    const CHUNK_COORDS_INT3_T lightCoords = {2, 8, 2};
+    const Block b = {2};
+
+    for (int i = 0; i < 2; ++i) {
+        Chunk *src = chunk_new_with_storage((SHAPE_COORDS_INT3_T){0, 0, 0}, storages[i]);
+        _test_chunk_fill_for_copy(src);
+        const int nbBlocks = chunk_get_nb_blocks(src);
+
+        Chunk *copy1 = chunk_new_copy(src);
+        Chunk *copy2 = chunk_new_copy(copy1);
+        TEST_CHECK(chunk_get_lighting_data(copy1) == chunk_get_lighting_data(src));
+        TEST_CHECK(chunk_get_block(copy2, 0, 0, 0) == chunk_get_block(src, 0, 0, 0));
+
+        // blocks
+        TEST_CHECK(chunk_add_block(copy1, b, 0, 10, 0));
+        TEST_CHECK(chunk_remove_block(copy1, 0, 0, 0, NULL));
+        TEST_CHECK(chunk_paint_block(copy1, 1, 0, 0, 3, NULL));
+        TEST_CHECK(chunk_get_nb_blocks(copy1) == nbBlocks);
+        TEST_CHECK(chunk_get_nb_blocks(src) == nbBlocks);
+        TEST_CHECK(block_is_solid(chunk_get_block(src, 0, 10, 0)) == false);
+        TEST_CHECK(chunk_get_block(src, 0, 0, 0)->colorIndex == 1);
+        TEST_CHECK(chunk_get_block(src, 1, 0, 0)->colorIndex == 1);
+        TEST_CHECK(chunk_get_block(copy2, 1, 0, 0)->colorIndex == 1);
+        TEST_CHECK(chunk_get_block(copy1, 0, 10, 0)->colorIndex == 2);
+        TEST_CHECK(chunk_get_block(copy1, 1, 0, 0)->colorIndex == 3);
+
+        // lighting
+        TEST_CHECK(chunk_get_lighting_data(copy1) == chunk_get_lighting_data(src));
+        chunk_set_light(copy1, lightCoords, (VERTEX_LIGHT_STRUCT_T){1, 0, 0, 0}, true);
+        TEST_CHECK(chunk_get_light_without_checking(src, lightCoords).ambient == 9);
+        TEST_CHECK(chunk_get_light_without_checking(copy1, lightCoords).ambient == 1);
+
+        // source freed first, remaining copy keeps the shared buffers
+        chunk_free(src, false);
+        TEST_CHECK(chunk_get_light_without_checking(copy2, lightCoords).ambient == 9);
+        TEST_CHECK(chunk_get_nb_blocks(copy2) == nbBlocks);
+        chunk_clear_lighting_data(copy2);
+        TEST_CHECK(chunk_get_lighting_data(copy2) == NULL);
+        TEST_CHECK(chunk_remove_block(copy2, 0, 0, 0, NULL));
+        TEST_CHECK(block_is_solid(chunk_get_block(copy1, 0, 10, 0)));
+
+        Chunk *copy3 = chunk_new_copy(copy2);
+        chunk_set_storage(copy3, storages[1 - i]);
+        TEST_CHECK(chunk_get_block(copy3, 1, 0, 0)->colorIndex == 1);
+        TEST_CHECK(chunk_get_block(copy2, 1, 0, 0)->colorIndex == 1);
+
+        chunk_free(copy2, false);
+        chunk_free(copy1, false);
+        chunk_free(copy3, false);
+    }
+}
+
+#define TEST_CHUNK_NB_CONCURRENT_COPIES 64
+
+typedef struct {
+    Chunk *src;
+    Chunk **copies;
+} _TestChunkConcurrentCopies;
+
+static void _test_chunk_copy_job(void *ctx, const size_t idx) {
+    _TestChunkConcurrentCopies *jobs = (_TestChunkConcurrentCopies *)ctx;
+    jobs->copies[idx] = chunk_new_copy(jobs->src);
+}
+
+static void _test_chunk_free_job(void *ctx, const size_t idx) {
+    _TestChunkConcurrentCopies *jobs = (_TestChunkConcurrentCopies *)ctx;
+    chunk_free(jobs->copies[idx], false);
+}
+
+// Copies of the same chunk can be made & freed from several threads at once, the source is
+// only read
+void test_chunk_copy_concurrent(void) {
+    ThreadPool *pool = thread_pool_new(3);
+    Chunk *copies[TEST_CHUNK_NB_CONCURRENT_COPIES];
+    const CHUNK_COORDS_INT3_T lightCoords = {2, 8, 2};
+
+    Chunk *src = chunk_new_with_storage((SHAPE_COORDS_INT3_T){0, 0, 0}, CHUNK_STORAGE_DENSE);
+    _test_chunk_fill_for_copy(src);
+    _TestChunkConcurrentCopies jobs = {src, copies};
+
+    for (int i = 0; i < 10; ++i) {
+        thread_pool_parallel_for(pool, TEST_CHUNK_NB_CONCURRENT_COPIES, _test_chunk_copy_job, &jobs);
+        for (int j = 0; j < TEST_CHUNK_NB_CONCURRENT_COPIES; ++j) {
+            TEST_CHECK(copies[j] != NULL &&
+                       chunk_get_lighting_data(copies[j]) == chunk_get_lighting_data(src));
+        }
+
+        // last copy is edited after all the others are freed, it must still clone its buffers
+        thread_pool_parallel_for(pool,
+                                 TEST_CHUNK_NB_CONCURRENT_COPIES - 1,
+                                 _test_chunk_free_job,
+                                 &jobs);
+        Chunk *last = copies[TEST_CHUNK_NB_CONCURRENT_COPIES - 1];
+        TEST_CHECK(chunk_remove_block(last, 0, 0, 0, NULL));
+        chunk_set_light(last, lightCoords, (VERTEX_LIGHT_STRUCT_T){1, 0, 0, 0}, true);
+        TEST_CHECK(block_is_solid(chunk_get_block(src, 0, 0, 0)));
+        TEST_CHECK(chunk_get_light_without_checking(src, lightCoords).ambient == 9);
+        chunk_free(last, false);
+    }
+
+    // source owns its buffers again
+    TEST_CHECK(chunk_remove_block(src, 0, 0, 0, NULL));
+    chunk_free(src, false);
+    thread_pool_free(pool);
+}
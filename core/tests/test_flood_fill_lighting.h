@@ -10,18 +10,16 @@
 #include "int3.h"
 
 // Function that are not tested :
-// light_node_queue_recycle
 // light_node_queue_free
 // light_removal_node_queue_free
-// light_removal_node_queue_recycle
 // light_removal_node_get_light
 
 // Create a new queue and check if the created queue is empty.
 void test_light_node_queue_new(void) {
     LightNodeQueue *const q = light_node_queue_new();
 
-    LightNode *const check = light_node_queue_pop(q);
-    TEST_CHECK(check == NULL);
+    LightNode check;
+    TEST_CHECK(light_node_queue_pop(q, &check) == false);
 
     light_node_queue_free(q);
 }
@@ -32,26 +30,22 @@ void test_light_node_get_coords(void) {
     const SHAPE_COORDS_INT3_T coords1 = {-10, 0, 10};
     const SHAPE_COORDS_INT3_T coords2 = {185, 516, -1684};
     SHAPE_COORDS_INT3_T coordsCheck = {0, 0, 0};
-    LightNode *check = NULL;
+    LightNode check;
 
     LightNodeQueue *const q = light_node_queue_new();
 
     light_node_queue_push(q, NULL, coords1);
-    check = light_node_queue_pop(q);
-    coordsCheck = light_node_get_coords(check);
+    TEST_CHECK(light_node_queue_pop(q, &check));
+    coordsCheck = light_node_get_coords(&check);
 
-    light_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coords1.x);
     TEST_CHECK(coordsCheck.y == coords1.y);
     TEST_CHECK(coordsCheck.z == coords1.z);
 
     light_node_queue_push(q, NULL, coords2);
-    check = light_node_queue_pop(q);
-    coordsCheck = light_node_get_coords(check);
+    TEST_CHECK(light_node_queue_pop(q, &check));
+    coordsCheck = light_node_get_coords(&check);
 
-    light_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coords2.x);
     TEST_CHECK(coordsCheck.y == coords2.y);
     TEST_CHECK(coordsCheck.z == coords2.z);
@@ -67,11 +61,10 @@ void test_light_node_queue_push(void) {
     LightNodeQueue *q = light_node_queue_new();
     light_node_queue_push(q, NULL, coords);
 
-    LightNode *check = light_node_queue_pop(q);
-    coordsCheck = light_node_get_coords(check);
+    LightNode check;
+    TEST_CHECK(light_node_queue_pop(q, &check));
+    coordsCheck = light_node_get_coords(&check);
 
-    light_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coords.x);
     TEST_CHECK(coordsCheck.y == coords.y);
     TEST_CHECK(coordsCheck.z == coords.z);
@@ -87,42 +80,69 @@ void test_light_node_queue_pop(void) {
     const SHAPE_COORDS_INT3_T coordsB = {-3565, 17368, 20724};
     const SHAPE_COORDS_INT3_T coordsC = {984, -27863, 1563};
     SHAPE_COORDS_INT3_T coordsCheck = {0, 0, 0};
-    LightNode *check = NULL;
+    LightNode check;
 
     LightNodeQueue *q = light_node_queue_new();
     light_node_queue_push(q, NULL, coordsA); // [coordsA]
     light_node_queue_push(q, NULL, coordsB); // [coordsB, coordsA]
     light_node_queue_push(q, NULL, coordsC); // [coordsC, coordsB, coordsA]
 
-    check = light_node_queue_pop(q); // [coordsB, coordsA]
-    coordsCheck = light_node_get_coords(check);
+    TEST_CHECK(light_node_queue_pop(q, &check)); // [coordsB, coordsA]
+    coordsCheck = light_node_get_coords(&check);
 
-    light_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coordsC.x);
     TEST_CHECK(coordsCheck.y == coordsC.y);
     TEST_CHECK(coordsCheck.z == coordsC.z);
 
-    check = light_node_queue_pop(q); // [coordsA]
-    coordsCheck = light_node_get_coords(check);
+    TEST_CHECK(light_node_queue_pop(q, &check)); // [coordsA]
+    coordsCheck = light_node_get_coords(&check);
 
-    light_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coordsB.x);
     TEST_CHECK(coordsCheck.y == coordsB.y);
     TEST_CHECK(coordsCheck.z == coordsB.z);
 
-    check = light_node_queue_pop(q); // []
-    coordsCheck = light_node_get_coords(check);
+    TEST_CHECK(light_node_queue_pop(q, &check)); // []
+    coordsCheck = light_node_get_coords(&check);
 
-    light_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coordsA.x);
     TEST_CHECK(coordsCheck.y == coordsA.y);
     TEST_CHECK(coordsCheck.z == coordsA.z);
 
-    check = light_node_queue_pop(q);
-    TEST_CHECK(check == NULL);
+    TEST_CHECK(light_node_queue_pop(q, &check) == false);
+
+    light_node_queue_free(q);
+}
+
+// Push enough nodes for the queue to grow several times, then pop them all in reverse order.
+// Capacity is kept once the queue is empty, pushing again doesn't need to grow.
+void test_light_node_queue_grow(void) {
+    const int count = 5000;
+    LightNode check;
+
+    LightNodeQueue *q = light_node_queue_new();
+    TEST_CHECK(light_node_queue_get_capacity(q) == 0);
+
+    for (int i = 0; i < count; ++i) {
+        light_node_queue_push(q, NULL, (SHAPE_COORDS_INT3_T){(SHAPE_COORDS_INT_T)i, 0, 0});
+    }
+    TEST_CHECK(light_node_queue_get_count(q) == (size_t)count);
+    const size_t capacity = light_node_queue_get_capacity(q);
+    TEST_CHECK(capacity >= (size_t)count);
+
+    bool ordered = true;
+    for (int i = count - 1; i >= 0; --i) {
+        if (light_node_queue_pop(q, &check) == false || check.coords.x != i) {
+            ordered = false;
+            break;
+        }
+    }
+    TEST_CHECK(ordered);
+    TEST_CHECK(light_node_queue_pop(q, &check) == false);
+
+    for (int i = 0; i < count; ++i) {
+        light_node_queue_push(q, NULL, (SHAPE_COORDS_INT3_T){0, 0, 0});
+    }
+    TEST_CHECK(light_node_queue_get_capacity(q) == capacity);
 
     light_node_queue_free(q);
 }
@@ -133,8 +153,8 @@ void test_light_node_queue_pop(void) {
 void test_light_removal_node_queue_new(void) {
     LightRemovalNodeQueue *q = light_removal_node_queue_new();
 
-    LightRemovalNode *check = light_removal_node_queue_pop(q);
-    TEST_CHECK(check == NULL);
+    LightRemovalNode check;
+    TEST_CHECK(light_removal_node_queue_pop(q, &check) == false);
 
     light_removal_node_queue_free(q);
 }
@@ -142,7 +162,7 @@ void test_light_removal_node_queue_new(void) {
 // Create a new removal queue and insert a node in it. We now check if the queue isn't empty anymore
 void test_light_removal_node_queue_push(void) {
     const SHAPE_COORDS_INT3_T coords = {-10, 0, 10};
-    LightRemovalNode *check = NULL;
+    LightRemovalNode check;
 
     LightRemovalNodeQueue *q = light_removal_node_queue_new();
     VERTEX_LIGHT_STRUCT_T light;
@@ -151,11 +171,8 @@ void test_light_removal_node_queue_push(void) {
     SHAPE_COLOR_INDEX_INT_T blockID = 100;
     light_removal_node_queue_push(q, NULL, coords, light, srgb, blockID);
 
-    check = light_removal_node_queue_pop(q);
-    TEST_CHECK(check != NULL);
+    TEST_CHECK(light_removal_node_queue_pop(q, &check));
 
-    light_removal_node_free(check);
-    check = NULL;
 
     light_removal_node_queue_free(q);
 }
@@ -164,7 +181,7 @@ void test_light_removal_node_queue_push(void) {
 // is now empty and if the values of the popped value are correct.
 void test_light_removal_node_queue_pop(void) {
     const SHAPE_COORDS_INT3_T coords = {-10, 0, 10};
-    LightRemovalNode *check = NULL;
+    LightRemovalNode check;
     SHAPE_COORDS_INT3_T coordsCheck = {0, 0, 0};
 
     LightRemovalNodeQueue *q = light_removal_node_queue_new();
@@ -174,12 +191,9 @@ void test_light_removal_node_queue_pop(void) {
     SHAPE_COLOR_INDEX_INT_T blockID = 100;
     light_removal_node_queue_push(q, NULL, coords, light, srgb, blockID);
 
-    check = light_removal_node_queue_pop(q);
-    TEST_CHECK(check != NULL);
-    coordsCheck = light_removal_node_get_coords(check);
+    TEST_CHECK(light_removal_node_queue_pop(q, &check));
+    coordsCheck = light_removal_node_get_coords(&check);
 
-    light_removal_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coords.x);
     TEST_CHECK(coordsCheck.y == coords.y);
     TEST_CHECK(coordsCheck.z == coords.z);
@@ -192,7 +206,7 @@ void test_light_removal_node_queue_pop(void) {
 void test_light_removal_node_get_coords(void) {
     const SHAPE_COORDS_INT3_T coordsA = {-10, 0, 10};
     const SHAPE_COORDS_INT3_T coordsB = {29684, -45, -14556};
-    LightRemovalNode *check = NULL;
+    LightRemovalNode check;
     SHAPE_COORDS_INT3_T coordsCheck = {0, 0, 0};
 
     LightRemovalNodeQueue *q = light_removal_node_queue_new();
@@ -212,21 +226,17 @@ void test_light_removal_node_get_coords(void) {
     light_removal_node_queue_push(q, NULL, coordsB, lightB, srgbB, blockIDB);
 
     // Check for Node B
-    check = light_removal_node_queue_pop(q);
-    coordsCheck = light_removal_node_get_coords(check);
+    TEST_CHECK(light_removal_node_queue_pop(q, &check));
+    coordsCheck = light_removal_node_get_coords(&check);
 
-    light_removal_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coordsB.x);
     TEST_CHECK(coordsCheck.y == coordsB.y);
     TEST_CHECK(coordsCheck.z == coordsB.z);
 
     // Check for Node A
-    check = light_removal_node_queue_pop(q);
-    coordsCheck = light_removal_node_get_coords(check);
+    TEST_CHECK(light_removal_node_queue_pop(q, &check));
+    coordsCheck = light_removal_node_get_coords(&check);
 
-    light_removal_node_free(check);
-    check = NULL;
     TEST_CHECK(coordsCheck.x == coordsA.x);
     TEST_CHECK(coordsCheck.y == coordsA.y);
     TEST_CHECK(coordsCheck.z == coordsA.z);
@@ -239,7 +249,7 @@ void test_light_removal_node_get_coords(void) {
 void test_light_removal_node_get_srgb(void) {
     const SHAPE_COORDS_INT3_T coordsA = {-10, 0, 10};
     const SHAPE_COORDS_INT3_T coordsB = {29684, -45, -14556};
-    LightRemovalNode *check = NULL;
+    LightRemovalNode check;
     uint8_t checkSrgb = 0;
 
     LightRemovalNodeQueue *q = light_removal_node_queue_new();
@@ -259,19 +269,15 @@ void test_light_removal_node_get_srgb(void) {
     light_removal_node_queue_push(q, NULL, coordsB, lightB, srgbB, blockIDB);
 
     // Check for Node B
-    check = light_removal_node_queue_pop(q);
-    checkSrgb = light_removal_node_get_srgb(check);
+    TEST_CHECK(light_removal_node_queue_pop(q, &check));
+    checkSrgb = light_removal_node_get_srgb(&check);
 
-    light_removal_node_free(check);
-    check = NULL;
     TEST_CHECK(checkSrgb == srgbB);
 
     // Check for Node A
-    check = light_removal_node_queue_pop(q);
-    checkSrgb = light_removal_node_get_srgb(check);
+    TEST_CHECK(light_removal_node_queue_pop(q, &check));
+    checkSrgb = light_removal_node_get_srgb(&check);
 
-    light_removal_node_free(check);
-    check = NULL;
     TEST_CHECK(checkSrgb == srgbA);
 
     light_removal_node_queue_free(q);
@@ -282,7 +288,7 @@ void test_light_removal_node_get_srgb(void) {
 void test_light_removal_node_get_block_id(void) {
     const SHAPE_COORDS_INT3_T coordsA = {-10, 0, 10};
     const SHAPE_COORDS_INT3_T coordsB = {29684, -45, -14556};
-    LightRemovalNode *check = NULL;
+    LightRemovalNode check;
     SHAPE_COLOR_INDEX_INT_T checkBlockID = 0;
 
     LightRemovalNodeQueue *q = light_removal_node_queue_new();
@@ -302,19 +308,15 @@ void test_light_removal_node_get_block_id(void) {
     light_removal_node_queue_push(q, NULL, coordsB, lightB, srgbB, blockIDB);
 
     // Check for Node B
-    check = light_removal_node_queue_pop(q);
-    checkBlockID = light_removal_node_get_block_id(check);
+    TEST_CHECK(light_removal_node_queue_pop(q, &check));
+    checkBlockID = light_removal_node_get_block_id(&check);
 
-    light_removal_node_free(check);
-    check = NULL;
     TEST_CHECK(checkBlockID == blockIDB);
 
     // Check for Node A
-    check = light_removal_node_queue_pop(q);
-    checkBlockID = light_removal_node_get_block_id(check);
+    TEST_CHECK(light_removal_node_queue_pop(q, &check));
+    checkBlockID = light_removal_node_get_block_id(&check);
 
-    light_removal_node_free(check);
-    check = NULL;
     TEST_CHECK(checkBlockID == blockIDA);
 
     light_removal_node_queue_free(q);
@@ -12,6 +12,11 @@
 #pragma clang diagnostic pop // ignored "-Wsign-conversion"
 #pragma clang diagnostic pop // ignored "-Wconversion"
 
+// benchmarks are opt-in, see README
+#ifndef CUBZH_TESTS_BENCHMARKS
+#define CUBZH_TESTS_BENCHMARKS 0
+#endif
+
 #include "test_block.h"
 #include "test_blockChange.h"
 #include "test_box.h"
@@ -35,8 +40,11 @@
 #include "test_matrix4x4.h"
 #include "test_quaternion.h"
 #include "test_rtree.h"
+#include "test_scene.h"
+#include "test_serialization_v6.h"
 #include "test_shape.h"
 #include "test_stream.h"
+#include "test_thread_pool.h"
 #include "test_transaction.h"
 #include "test_transform.h"
 #include "test_utils.h"
@@ -85,6 +93,12 @@ TEST_LIST = {
     {"test_chunk_new", test_chunk_new},
     {"test_chunk_Block", test_chunk_Block},
     {"test_chunk_needs_display", test_chunk_needs_display},
+    {"test_chunk_dense_storage", test_chunk_dense_storage},
+#if CUBZH_TESTS_BENCHMARKS
+    {"test_chunk_storage_benchmark", test_chunk_storage_benchmark},
+#endif
+    {"test_chunk_copy_on_write", test_chunk_copy_on_write},
+    {"test_chunk_copy_concurrent", test_chunk_copy_concurrent},
 
     // config
     {"test_upper_power_of_two", test_upper_power_of_two},
@@ -219,6 +233,7 @@ TEST_LIST = {
     {"light_node_get_coords", test_light_node_get_coords},
     {"light_node_queue_push", test_light_node_queue_push},
     {"light_node_queue_pop", test_light_node_queue_pop},
+    {"light_node_queue_grow", test_light_node_queue_grow},
     {"light_removal_node_queue_new", test_light_removal_node_queue_new},
     {"light_removal_node_queue_push", test_light_removal_node_queue_push},
     {"light_removal_node_queue_pop", test_light_removal_node_queue_pop},
@@ -296,6 +311,27 @@ TEST_LIST = {
     {"rtree_node_get_groups", test_rtree_node_get_groups},
     {"rtree_node_get_collides_with", test_rtree_node_get_collides_with},
     {"rtree_create_and_insert", test_rtree_create_and_insert},
+#if CUBZH_TESTS_BENCHMARKS
+    {"rtree_benchmark", test_rtree_benchmark},
+#endif
+    {"rtree_refresh_collision_masks", test_rtree_refresh_collision_masks},
+    {"rtree_bulk_load", test_rtree_bulk_load},
+
+    // scene
+    {"scene_register_collision_couple", test_scene_register_collision_couple},
+    {"scene_cast_rays_batch", test_scene_cast_rays_batch},
+#if CUBZH_TESTS_BENCHMARKS
+    {"scene_physics_falling_boxes_benchmark", test_scene_physics_falling_boxes_benchmark},
+#endif
+#if CUBZH_TESTS_BENCHMARKS
+    {"scene_physics_sliding_boxes_benchmark", test_scene_physics_sliding_boxes_benchmark},
+#endif
+    {"scene_physics_islands", test_scene_physics_islands},
+    {"scene_physics_islands_triggers", test_scene_physics_islands_triggers},
+    {"scene_idle_branches", test_scene_idle_branches},
+
+    // serialization_v6
+    {"serialization_v6_shape_blocks", test_serialization_v6_shape_blocks},
 
     // shape
     {"shape_make", test_shape_make},
@@ -309,6 +345,23 @@ TEST_LIST = {
     {"shape_get_model_aabb", test_shape_get_model_aabb},
     {"shape_set_fullname", test_shape_set_fullname},
     {"shape_get_fullname", test_shape_get_fullname},
+    {"shape_greedy_meshing", test_shape_greedy_meshing},
+    {"shape_parallel_meshing", test_shape_parallel_meshing},
+    {"shape_parallel_baked_lighting", test_shape_parallel_baked_lighting},
+    {"shape_fill_blocks_from_grid", test_shape_fill_blocks_from_grid},
+    {"shape_ray_cast", test_shape_ray_cast},
+#if CUBZH_TESTS_BENCHMARKS
+    {"shape_ray_cast_benchmark", test_shape_ray_cast_benchmark},
+#endif
+#if CUBZH_TESTS_BENCHMARKS
+    {"shape_make_copy_benchmark", test_shape_make_copy_benchmark},
+#endif
+    {"shape_mesh_sharing", test_shape_mesh_sharing},
+    {"shape_mesh_sharing_index", test_shape_mesh_sharing_index},
+    {"shape_mesh_sharing_concurrent", test_shape_mesh_sharing_concurrent},
+#if CUBZH_TESTS_BENCHMARKS
+    {"shape_mesh_sharing_benchmark", test_shape_mesh_sharing_benchmark},
+#endif
     {"test_shape_addblock_1", test_shape_addblock_1},
     // {"test_shape_addblock_2", test_shape_addblock_2},
     {"test_shape_addblock_3", test_shape_addblock_3},
@@ -327,6 +380,10 @@ TEST_LIST = {
     {"stream_set_cursor_position", test_stream_set_cursor_position},
     {"stream_reached_the_end", test_stream_reached_the_end},
 
+    // thread pool
+    {"thread_pool_parallel_for", test_thread_pool_parallel_for},
+    {"thread_pool_concurrent_callers", test_thread_pool_concurrent_callers},
+
     // transaction
     {"transaction_new", test_transaction_new},
     {"transaction_getCurrentBlockAt", test_transaction_getCurrentBlockAt},
@@ -366,6 +423,9 @@ TEST_LIST = {
     {"vertex_buffer_get_max_count", test_vertex_buffer_get_max_length},
     {"vertex_buffer_set_lighting_enabled", test_vertex_buffer_set_lighting_enabled},
     {"vertex_buffer_get_lighting_enabled", test_vertex_buffer_get_lighting_enabled},
+    {"vertex_attributes_encode_compact", test_vertex_attributes_encode_compact},
+    {"vertex_attributes_decode_float", test_vertex_attributes_decode_float},
+    {"vertex_buffer_write_layout", test_vertex_buffer_write_layout},
 
     // weakptr
     {"weakptr_new", test_weakptr_new},
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <time.h>
+
 #include "rtree.h"
 #include "transform.h"
 
@@ -13,21 +15,14 @@
 // rtree_get_height
 // rtree_get_root
 // rtree_node_get_children_count
-// rtree_node_get_children_iterator
+// rtree_node_get_child
 // rtree_node_get_leaf_ptr
 // rtree_node_is_leaf
-// rtree_node_set_collision_masks
 // rtree_recurse
-// rtree_insert
-// rtree_remove
 // rtree_find_and_remove
-// rtree_refresh_collision_masks
 // rtree_query_overlap_func
-// rtree_query_overlap_box
 // rtree_query_cast_all_func
-// rtree_query_cast_all_ray
 // rtree_query_cast_all_box_step_func
-// rtree_query_cast_all_box
 // rtree_utils_broadphase_steps
 // debug_rtree_get_insert_calls
 // debug_rtree_get_split_calls
@@ -104,3 +99,393 @@ void test_rtree_create_and_insert(void) {
     rtree_free(r);
     transform_release(t);
 }
+
+#define TEST_RTREE_NB_LEAVES 10000
+#define TEST_RTREE_NB_FRAMES 10
+#define TEST_RTREE_WORLD_SIZE 1000.0f
+
+static float _test_rtree_random(uint32_t *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return (float)(*seed >> 8) / (float)(1u << 24);
+}
+
+static void _test_rtree_random_box(uint32_t *seed, Box *b) {
+    b->min.x = _test_rtree_random(seed) * TEST_RTREE_WORLD_SIZE;
+    b->min.y = _test_rtree_random(seed) * TEST_RTREE_WORLD_SIZE * .1f;
+    b->min.z = _test_rtree_random(seed) * TEST_RTREE_WORLD_SIZE;
+    b->max.x = b->min.x + 1.0f + _test_rtree_random(seed) * 4.0f;
+    b->max.y = b->min.y + 1.0f + _test_rtree_random(seed) * 4.0f;
+    b->max.z = b->min.z + 1.0f + _test_rtree_random(seed) * 4.0f;
+}
+
+/// counts leaves overlapping given box w/o using the tree
+static size_t _test_rtree_count_overlaps(const Box *boxes,
+                                         const size_t n,
+                                         const Box *aabb,
+                                         const float3 *epsilon) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += box_collide_epsilon3(&boxes[i], aabb, epsilon);
+    }
+    return count;
+}
+
+// moves 10k leaves over a few frames, w/ overlap & cast queries in between, check results against
+// brute force and report timings, visible w/ --verbose=3
+void test_rtree_benchmark(void) {
+    Rtree *r = rtree_new(RTREE_NODE_MIN_CAPACITY, RTREE_NODE_MAX_CAPACITY);
+    Box *boxes = (Box *)malloc(TEST_RTREE_NB_LEAVES * sizeof(Box));
+    RtreeNode **leaves = (RtreeNode **)malloc(TEST_RTREE_NB_LEAVES * sizeof(RtreeNode *));
+    TEST_ASSERT(boxes != NULL && leaves != NULL);
+
+    const float3 epsilon = {EPSILON_COLLISION, EPSILON_COLLISION, EPSILON_COLLISION};
+    FifoList *overlaps = fifo_list_new();
+    DoublyLinkedList *casts = doubly_linked_list_new();
+    uint32_t seed = 1;
+    clock_t start;
+    double insertMs = 0.0, updateMs = 0.0, overlapMs = 0.0, castMs = 0.0;
+    size_t nbOverlaps = 0, nbCasts = 0;
+
+    start = clock();
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+        _test_rtree_random_box(&seed, &boxes[i]);
+        leaves[i] = rtree_create_and_insert(r, &boxes[i], 1, 1, (void *)(uintptr_t)(i + 1));
+    }
+    insertMs += (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    for (int frame = 0; frame < TEST_RTREE_NB_FRAMES; ++frame) {
+        // most leaves move a little, a few are teleported
+        start = clock();
+        for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+            if (i % 100 == frame) {
+                _test_rtree_random_box(&seed, &boxes[i]);
+            } else {
+                const float3 v = {_test_rtree_random(&seed) - .5f,
+                                  _test_rtree_random(&seed) - .5f,
+                                  _test_rtree_random(&seed) - .5f};
+                float3_op_add(&boxes[i].min, &v);
+                float3_op_add(&boxes[i].max, &v);
+            }
+            rtree_update(r, leaves[i], &boxes[i]);
+        }
+        updateMs += (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+        // broadphase of each leaf
+        start = clock();
+        for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+            nbOverlaps += rtree_query_overlap_box(r, &boxes[i], 1, 1, NULL, overlaps, &epsilon);
+            while (fifo_list_pop(overlaps) != NULL) {}
+        }
+        overlapMs += (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+        // rays & boxes cast across the world
+        start = clock();
+        for (int i = 0; i < 50; ++i) {
+            const float3 origin = {0.0f, _test_rtree_random(&seed) * 100.0f, (float)i * 20.0f};
+            const float3 dir = {1.0f, 0.0f, 0.0f};
+            Ray *ray = ray_new(&origin, &dir);
+            nbCasts += rtree_query_cast_all_ray(r, ray, 1, 1, NULL, casts);
+            doubly_linked_list_flush(casts, free);
+            ray_free(ray);
+
+            const Box b = {origin, {origin.x + 2.0f, origin.y + 2.0f, origin.z + 2.0f}};
+            nbCasts += rtree_query_cast_all_box(r,
+                                                &b,
+                                                &dir,
+                                                TEST_RTREE_WORLD_SIZE,
+                                                1,
+                                                1,
+                                                NULL,
+                                                casts,
+                                                &epsilon);
+            doubly_linked_list_flush(casts, free);
+        }
+        castMs += (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    }
+
+    TEST_CASE_("ms: insert %.1f, update %.1f, overlap %.1f, cast %.1f",
+               insertMs,
+               updateMs,
+               overlapMs,
+               castMs);
+    TEST_CHECK(nbOverlaps >= TEST_RTREE_NB_LEAVES * TEST_RTREE_NB_FRAMES);
+    TEST_CHECK(nbCasts > 0);
+
+    // queries match brute force, w/ a few leaves removed
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; i += 10) {
+        rtree_remove(r, leaves[i], true);
+        boxes[i] = (Box){{-100.0f, -100.0f, -100.0f}, {-100.0f, -100.0f, -100.0f}};
+    }
+    Box query;
+    RtreeNode *localLeaves[4];
+    RtreeLeaves leavesQuery;
+    rtree_leaves_init(&leavesQuery, localLeaves, 4);
+    for (int i = 0; i < 200; ++i) {
+        _test_rtree_random_box(&seed, &query);
+        query.max.x += 50.0f;
+        query.max.z += 50.0f;
+        const size_t count = _test_rtree_count_overlaps(boxes,
+                                                        TEST_RTREE_NB_LEAVES,
+                                                        &query,
+                                                        &epsilon);
+        TEST_CHECK(rtree_query_overlap_box(r, &query, 1, 1, NULL, NULL, &epsilon) == count);
+
+        // same hits in the same order w/ a leaves array, growing past its local storage
+        rtree_leaves_reset(&leavesQuery);
+        TEST_CHECK(rtree_query_overlap_box_leaves(r, &query, 1, 1, NULL, &leavesQuery, &epsilon) ==
+                   count);
+        TEST_CHECK(rtree_query_overlap_box(r, &query, 1, 1, NULL, overlaps, &epsilon) == count);
+        for (size_t j = 0; j < leavesQuery.count; ++j) {
+            TEST_CHECK(leavesQuery.items[j] == fifo_list_pop(overlaps));
+        }
+    }
+    rtree_leaves_free(&leavesQuery);
+
+    // cast results array match list results, once sorted
+    RtreeCastResult localCasts[4];
+    RtreeCastResults castsQuery;
+    RtreeCastResult *castHit;
+    DoublyLinkedListNode *n;
+    const float3 dir = {0.0f, 0.0f, 1.0f};
+    for (int i = 0; i < 20; ++i) {
+        const float3 origin = {(float)i * 50.0f, _test_rtree_random(&seed) * 100.0f, 0.0f};
+        const Box b = {origin, {origin.x + 2.0f, origin.y + 2.0f, origin.z + 2.0f}};
+        rtree_cast_results_init(&castsQuery, localCasts, 4);
+        const size_t count = rtree_query_cast_all_box(r,
+                                                      &b,
+                                                      &dir,
+                                                      TEST_RTREE_WORLD_SIZE,
+                                                      1,
+                                                      1,
+                                                      NULL,
+                                                      casts,
+                                                      &epsilon);
+        TEST_CHECK(rtree_query_cast_all_box_results(r,
+                                                    &b,
+                                                    &dir,
+                                                    TEST_RTREE_WORLD_SIZE,
+                                                    1,
+                                                    1,
+                                                    &castsQuery,
+                                                    &epsilon) == count);
+        doubly_linked_list_sort_ascending(casts, rtree_utils_result_sort_func);
+        rtree_cast_results_sort(&castsQuery);
+        n = doubly_linked_list_first(casts);
+        for (size_t j = 0; j < castsQuery.count && n != NULL; ++j) {
+            castHit = (RtreeCastResult *)doubly_linked_list_node_pointer(n);
+            TEST_CHECK(castsQuery.items[j].rtreeLeaf == castHit->rtreeLeaf);
+            TEST_CHECK(castsQuery.items[j].distance == castHit->distance);
+            n = doubly_linked_list_node_next(n);
+        }
+        doubly_linked_list_flush(casts, free);
+        rtree_cast_results_free(&castsQuery);
+    }
+
+    fifo_list_free(overlaps, NULL);
+    doubly_linked_list_free(casts);
+    free(boxes);
+    free(leaves);
+    rtree_free(r);
+}
+
+/// checks that each branch masks match its children masks, returns the node masks
+static bool _test_rtree_check_masks(const RtreeNode *rn, uint16_t *groups, uint16_t *collidesWith) {
+    if (rtree_node_is_leaf(rn)) {
+        *groups = rtree_node_get_groups(rn);
+        *collidesWith = rtree_node_get_collides_with(rn);
+        return true;
+    }
+    bool valid = true;
+    uint16_t childGroups, childCollidesWith;
+    *groups = PHYSICS_GROUP_NONE;
+    *collidesWith = PHYSICS_GROUP_NONE;
+    for (uint8_t i = 0; i < rtree_node_get_children_count(rn); ++i) {
+        valid = _test_rtree_check_masks(rtree_node_get_child(rn, i),
+                                        &childGroups,
+                                        &childCollidesWith) &&
+                valid;
+        *groups |= childGroups;
+        *collidesWith |= childCollidesWith;
+    }
+    return valid && *groups == rtree_node_get_groups(rn) &&
+           *collidesWith == rtree_node_get_collides_with(rn);
+}
+
+// collision masks changes are applied to branches once refreshed, w/o visiting unchanged paths
+void test_rtree_refresh_collision_masks(void) {
+    Rtree *r = rtree_new(RTREE_NODE_MIN_CAPACITY, RTREE_NODE_MAX_CAPACITY);
+    RtreeNode **leaves = (RtreeNode **)malloc(TEST_RTREE_NB_LEAVES * sizeof(RtreeNode *));
+    TEST_ASSERT(leaves != NULL);
+
+    uint32_t seed = 3;
+    Box b;
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+        _test_rtree_random_box(&seed, &b);
+        leaves[i] = rtree_create_and_insert(r,
+                                            &b,
+                                            (uint16_t)(1 << (i % 8)),
+                                            (uint16_t)(1 << ((i + 1) % 8)),
+                                            (void *)(uintptr_t)(i + 1));
+    }
+    uint16_t groups, collidesWith;
+    rtree_refresh_collision_masks(r);
+    TEST_CHECK(_test_rtree_check_masks(rtree_get_root(r), &groups, &collidesWith));
+    TEST_CHECK(groups == 0xFF && collidesWith == 0xFF);
+
+    // one leaf changes, then a whole group
+    rtree_node_set_collision_masks(leaves[42], 1 << 9, 1 << 10);
+    rtree_refresh_collision_masks(r);
+    TEST_CHECK(_test_rtree_check_masks(rtree_get_root(r), &groups, &collidesWith));
+    TEST_CHECK(groups == (0xFF | 1 << 9) && collidesWith == (0xFF | 1 << 10));
+
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; i += 8) {
+        rtree_node_set_collision_masks(leaves[i], 1 << 1, 1 << 2);
+    }
+    rtree_node_set_collision_masks(leaves[42], 1 << 1, 1 << 2);
+    rtree_refresh_collision_masks(r);
+    TEST_CHECK(_test_rtree_check_masks(rtree_get_root(r), &groups, &collidesWith));
+    TEST_CHECK(groups == 0xFE && collidesWith == 0xFD);
+
+    // masks stay valid through updates & removals
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+        _test_rtree_random_box(&seed, &b);
+        if (i % 3 == 0) {
+            rtree_node_set_collision_masks(leaves[i], 1 << 3, 1 << 3);
+        }
+        if (i % 10 == 0) {
+            rtree_remove(r, leaves[i], true);
+        } else {
+            rtree_update(r, leaves[i], &b);
+        }
+    }
+    rtree_refresh_collision_masks(r);
+    TEST_CHECK(_test_rtree_check_masks(rtree_get_root(r), &groups, &collidesWith));
+
+    // refresh cost follows changes, not the number of leaves
+    const clock_t start = clock();
+    for (int i = 0; i < 10000; ++i) {
+        rtree_node_set_collision_masks(leaves[1 + (i % 9) * 1000], 1 << (i % 8), 1 << (i % 8));
+        rtree_refresh_collision_masks(r);
+    }
+    const double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    TEST_CHECK(_test_rtree_check_masks(rtree_get_root(r), &groups, &collidesWith));
+    TEST_CASE_("%d leaves: %.5fms/refresh w/ 1 change", TEST_RTREE_NB_LEAVES, ms / 10000);
+
+    free(leaves);
+    rtree_free(r);
+}
+
+/// checks that branches are within capacity & contain their children, and that leaves are all at
+/// the tree height level
+static bool _test_rtree_check_nodes(const Rtree *r, const RtreeNode *rn, const uint16_t level) {
+    const uint8_t count = rtree_node_get_children_count(rn);
+    bool valid = rn == rtree_get_root(r) ||
+                 (count >= RTREE_NODE_MIN_CAPACITY && count <= RTREE_NODE_MAX_CAPACITY);
+    const Box *aabb = rtree_node_get_aabb(rn);
+    const RtreeNode *child;
+    const Box *childAabb;
+    for (uint8_t i = 0; i < count; ++i) {
+        child = rtree_node_get_child(rn, i);
+        childAabb = rtree_node_get_aabb(child);
+        valid = valid && box_contains_epsilon(aabb, &childAabb->min, EPSILON_ZERO) &&
+                box_contains_epsilon(aabb, &childAabb->max, EPSILON_ZERO);
+        if (rtree_node_is_leaf(child)) {
+            valid = valid && level == rtree_get_height(r);
+        } else {
+            valid = _test_rtree_check_nodes(r, child, level + 1) && valid;
+        }
+    }
+    return valid;
+}
+
+// builds a tree w/ bulk-loads & another one w/ insertions from the same 10k leaves, check results
+// against brute force and report timings, visible w/ --verbose=3
+void test_rtree_bulk_load(void) {
+    Rtree *inserted = rtree_new(RTREE_NODE_MIN_CAPACITY, RTREE_NODE_MAX_CAPACITY);
+    Rtree *loaded = rtree_new(RTREE_NODE_MIN_CAPACITY, RTREE_NODE_MAX_CAPACITY);
+    Box *boxes = (Box *)malloc(TEST_RTREE_NB_LEAVES * sizeof(Box));
+    RtreeNode **leaves = (RtreeNode **)malloc(TEST_RTREE_NB_LEAVES * sizeof(RtreeNode *));
+    TEST_ASSERT(boxes != NULL && leaves != NULL);
+
+    const float3 epsilon = {EPSILON_COLLISION, EPSILON_COLLISION, EPSILON_COLLISION};
+    uint32_t seed = 7;
+    clock_t start;
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+        _test_rtree_random_box(&seed, &boxes[i]);
+    }
+
+    start = clock();
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+        rtree_create_and_insert(inserted, &boxes[i], 1, 1, (void *)(uintptr_t)(i + 1));
+    }
+    const double insertMs = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    // empty tree is built bottom-up, then a small batch is inserted, then a large batch rebuilds
+    const size_t batch1 = TEST_RTREE_NB_LEAVES / 4, batch2 = TEST_RTREE_NB_LEAVES / 20;
+    start = clock();
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+        leaves[i] = rtree_create_leaf(loaded, &boxes[i], 1, 1, (void *)(uintptr_t)(i + 1));
+    }
+    TEST_CHECK(rtree_bulk_load(loaded, leaves, batch1));
+    TEST_CHECK(rtree_get_nb_leaves(loaded) == batch1);
+    TEST_CHECK(rtree_bulk_load(loaded, leaves + batch1, batch2));
+    TEST_CHECK(rtree_bulk_load(loaded,
+                               leaves + batch1 + batch2,
+                               TEST_RTREE_NB_LEAVES - batch1 - batch2));
+    const double loadMs = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    TEST_CHECK(rtree_get_nb_leaves(inserted) == TEST_RTREE_NB_LEAVES);
+    TEST_CHECK(rtree_get_nb_leaves(loaded) == TEST_RTREE_NB_LEAVES);
+    TEST_CHECK(rtree_get_height(loaded) <= rtree_get_height(inserted));
+    TEST_CHECK(_test_rtree_check_nodes(loaded, rtree_get_root(loaded), 1));
+    uint16_t groups, collidesWith;
+    rtree_refresh_collision_masks(loaded);
+    TEST_CHECK(_test_rtree_check_masks(rtree_get_root(loaded), &groups, &collidesWith));
+
+    // broadphase of each leaf, on both trees
+    size_t insertedHits = 0, loadedHits = 0;
+    start = clock();
+    for (int frame = 0; frame < TEST_RTREE_NB_FRAMES; ++frame) {
+        for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+            insertedHits +=
+                rtree_query_overlap_box(inserted, &boxes[i], 1, 1, NULL, NULL, &epsilon);
+        }
+    }
+    const double insertedOverlapMs = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    start = clock();
+    for (int frame = 0; frame < TEST_RTREE_NB_FRAMES; ++frame) {
+        for (int i = 0; i < TEST_RTREE_NB_LEAVES; ++i) {
+            loadedHits += rtree_query_overlap_box(loaded, &boxes[i], 1, 1, NULL, NULL, &epsilon);
+        }
+    }
+    const double loadedOverlapMs = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    TEST_CHECK(insertedHits == loadedHits);
+
+    TEST_CASE_("ms: insert %.1f, bulk-load %.1f, overlap %.1f vs %.1f",
+               insertMs,
+               loadMs,
+               insertedOverlapMs,
+               loadedOverlapMs);
+
+    // rebuilt w/ a few leaves removed, queries match brute force
+    for (int i = 0; i < TEST_RTREE_NB_LEAVES; i += 10) {
+        rtree_remove(loaded, leaves[i], true);
+        boxes[i] = (Box){{-100.0f, -100.0f, -100.0f}, {-100.0f, -100.0f, -100.0f}};
+    }
+    TEST_CHECK(rtree_rebuild(loaded));
+    TEST_CHECK(rtree_get_nb_leaves(loaded) == TEST_RTREE_NB_LEAVES - TEST_RTREE_NB_LEAVES / 10);
+    TEST_CHECK(_test_rtree_check_nodes(loaded, rtree_get_root(loaded), 1));
+    Box query;
+    for (int i = 0; i < 200; ++i) {
+        _test_rtree_random_box(&seed, &query);
+        query.max.x += 50.0f;
+        query.max.z += 50.0f;
+        TEST_CHECK(rtree_query_overlap_box(loaded, &query, 1, 1, NULL, NULL, &epsilon) ==
+                   _test_rtree_count_overlaps(boxes, TEST_RTREE_NB_LEAVES, &query, &epsilon));
+    }
+
+    free(boxes);
+    free(leaves);
+    rtree_free(inserted);
+    rtree_free(loaded);
+}
@@ -0,0 +1,819 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  test_scene.h
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include <time.h>
+
+#include "scene.h"
+#include "thread_pool.h"
+
+#define TEST_SCENE_NB_TRANSFORMS 60
+#define TEST_SCENE_NB_RAYS 300
+#define TEST_SCENE_NB_FALLING_BOXES 256
+#define TEST_SCENE_NB_PHYSICS_STEPS 180
+#define TEST_SCENE_NB_SLIDING_BOXES 4096
+#define TEST_SCENE_NB_SLIDING_STEPS 60
+#define TEST_SCENE_NB_ISLANDS_BOXES 320
+#define TEST_SCENE_NB_ISLANDS_STEPS 90
+#define TEST_SCENE_NB_ISLANDS_EVENTS 65536
+#define TEST_SCENE_NB_IDLE_GROUPS 64
+#define TEST_SCENE_NB_IDLE_PROPS 64
+#define TEST_SCENE_NB_IDLE_BOXES 16
+#define TEST_SCENE_NB_IDLE_STEPS 120
+
+// heap allocations are counted by wrapping the glibc allocator, not w/ sanitizers that do the same
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define TEST_SCENE_COUNT_ALLOCATIONS true
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+static size_t _test_scene_allocations = 0;
+void *malloc(size_t size) {
+    _test_scene_allocations++;
+    return __libc_malloc(size);
+}
+void *calloc(size_t n, size_t size) {
+    _test_scene_allocations++;
+    return __libc_calloc(n, size);
+}
+void *realloc(void *ptr, size_t size) {
+    _test_scene_allocations++;
+    return __libc_realloc(ptr, size);
+}
+#else
+#define TEST_SCENE_COUNT_ALLOCATIONS false
+static size_t _test_scene_allocations = 0;
+#endif
+
+static bool _test_scene_is_couple(const int i, const int j) {
+    return (i + j) % 3 == 0;
+}
+
+// check collision couples status through frames: begin, discard when registered twice in the same
+// frame in any order, tick in the next frames, and end when not registered during a frame
+void test_scene_register_collision_couple(void) {
+    Scene *sc = scene_new(NULL);
+    TEST_ASSERT(sc != NULL);
+
+    Transform *transforms[TEST_SCENE_NB_TRANSFORMS];
+    for (int i = 0; i < TEST_SCENE_NB_TRANSFORMS; ++i) {
+        transforms[i] = transform_make(PointTransform);
+    }
+
+    float3 normal;
+    for (int i = 0; i < TEST_SCENE_NB_TRANSFORMS; ++i) {
+        for (int j = i + 1; j < TEST_SCENE_NB_TRANSFORMS; ++j) {
+            if (_test_scene_is_couple(i, j)) {
+                float3_set(&normal, (float)i, (float)j, 0.0f);
+                TEST_CHECK(scene_register_collision_couple(sc,
+                                                           transforms[i],
+                                                           transforms[j],
+                                                           &normal) ==
+                           CollisionCoupleStatus_Begin);
+            }
+        }
+    }
+    for (int i = 0; i < TEST_SCENE_NB_TRANSFORMS; ++i) {
+        for (int j = i + 1; j < TEST_SCENE_NB_TRANSFORMS; ++j) {
+            if (_test_scene_is_couple(i, j)) {
+                float3_set(&normal, 0.0f, 0.0f, 1.0f);
+                TEST_CHECK(scene_register_collision_couple(sc,
+                                                           transforms[j],
+                                                           transforms[i],
+                                                           &normal) ==
+                           CollisionCoupleStatus_Discard);
+                TEST_CHECK(normal.x == (float)i && normal.y == (float)j);
+            }
+        }
+    }
+
+    // next frame, only couples w/ an even first transform are registered again
+    scene_refresh(sc, 0, NULL);
+    for (int i = 0; i < TEST_SCENE_NB_TRANSFORMS; i += 2) {
+        for (int j = i + 1; j < TEST_SCENE_NB_TRANSFORMS; ++j) {
+            if (_test_scene_is_couple(i, j)) {
+                TEST_CHECK(scene_register_collision_couple(sc,
+                                                           transforms[i],
+                                                           transforms[j],
+                                                           &normal) ==
+                           CollisionCoupleStatus_Tick);
+                TEST_CHECK(normal.x == (float)i && normal.y == (float)j);
+            }
+        }
+    }
+
+    // other couples ended
+    scene_refresh(sc, 0, NULL);
+    for (int i = 0; i < TEST_SCENE_NB_TRANSFORMS; ++i) {
+        for (int j = i + 1; j < TEST_SCENE_NB_TRANSFORMS; ++j) {
+            if (_test_scene_is_couple(i, j)) {
+                TEST_CHECK(scene_register_collision_couple(sc,
+                                                           transforms[i],
+                                                           transforms[j],
+                                                           &normal) ==
+                           (i % 2 == 0 ? CollisionCoupleStatus_Tick
+                                       : CollisionCoupleStatus_Begin));
+            }
+        }
+    }
+
+    // a couple involving a freed transform isn't valid anymore, even if its ID is recycled
+    transform_release(transforms[0]);
+    transforms[0] = transform_make(PointTransform);
+    TEST_CHECK(scene_register_collision_couple(sc, transforms[0], transforms[3], &normal) ==
+               CollisionCoupleStatus_Begin);
+    TEST_CHECK(scene_register_collision_couple(sc, transforms[3], transforms[6], &normal) ==
+               CollisionCoupleStatus_Discard);
+
+    for (int i = 0; i < TEST_SCENE_NB_TRANSFORMS; ++i) {
+        transform_release(transforms[i]);
+    }
+    scene_refresh(sc, 0, NULL);
+    scene_free(sc);
+}
+
+static float _test_scene_random(uint32_t *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return (float)(*seed >> 8) / (float)(1u << 24);
+}
+
+/// block fields are only relevant for block hits
+static bool _test_scene_cast_results_equal(const CastResult *r1, const CastResult *r2) {
+    if (r1->type != r2->type || r1->hitTr != r2->hitTr || r1->distance != r2->distance) {
+        return false;
+    }
+    return r1->type != Hit_Block ||
+           (r1->block == r2->block && r1->blockCoords.x == r2->blockCoords.x &&
+            r1->blockCoords.y == r2->blockCoords.y && r1->blockCoords.z == r2->blockCoords.z &&
+            r1->faceTouched == r2->faceTouched);
+}
+
+// check that batched ray casts return the same hits as casting each ray, w/ static, rotated,
+// dynamic & per-block colliders, and when split across workers
+void test_scene_cast_rays_batch(void) {
+    Scene *sc = scene_new(NULL);
+    TEST_ASSERT(sc != NULL);
+
+    uint32_t seed = 11;
+    RigidBody *rb;
+    Transform *transforms[TEST_SCENE_NB_TRANSFORMS];
+    for (int i = 0; i < TEST_SCENE_NB_TRANSFORMS; ++i) {
+        transforms[i] = transform_make(PointTransform);
+        transform_set_position(transforms[i],
+                               _test_scene_random(&seed) * 100.0f,
+                               _test_scene_random(&seed) * 20.0f,
+                               _test_scene_random(&seed) * 100.0f);
+        if (i % 3 == 0) {
+            transform_set_rotation_euler(transforms[i], 0.0f, _test_scene_random(&seed), 0.0f);
+        }
+        transform_ensure_rigidbody(transforms[i],
+                                   i % 5 == 0 ? RigidbodyMode_Dynamic : RigidbodyMode_Static,
+                                   PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   PHYSICS_GROUP_NONE,
+                                   &rb);
+        const float size = 1.0f + _test_scene_random(&seed) * 4.0f;
+        const Box collider = {{-size, -size, -size}, {size, size, size}};
+        rigidbody_set_collider(rb, &collider, true);
+        transform_set_parent(transforms[i], scene_get_root(sc), false);
+    }
+
+    Shape *map = shape_make();
+    shape_set_palette(map, color_palette_new(color_atlas_new()), false);
+    for (SHAPE_COORDS_INT_T x = 0; x < 100; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < 100; ++z) {
+            if ((x * 7 + z * 3) % 11 != 0) {
+                shape_add_block(map, 1, x, 0, z, false);
+            }
+        }
+    }
+    Transform *mapTr = shape_get_root_transform(map);
+    transform_ensure_rigidbody(mapTr,
+                               RigidbodyMode_StaticPerBlock,
+                               PHYSICS_GROUP_DEFAULT_MAP,
+                               PHYSICS_GROUP_NONE,
+                               &rb);
+    transform_set_position(mapTr, 0.0f, -2.0f, 0.0f);
+    transform_set_parent(mapTr, scene_get_root(sc), false);
+
+    scene_refresh(sc, 0, NULL);
+
+    Ray *rays[TEST_SCENE_NB_RAYS];
+    for (int i = 0; i < TEST_SCENE_NB_RAYS; ++i) {
+        const float3 origin = {_test_scene_random(&seed) * 140.0f - 20.0f,
+                               _test_scene_random(&seed) * 40.0f,
+                               _test_scene_random(&seed) * 140.0f - 20.0f};
+        const float3 dir = {_test_scene_random(&seed) - .5f,
+                            _test_scene_random(&seed) - .8f,
+                            _test_scene_random(&seed) - .5f};
+        rays[i] = i == 7 ? NULL : ray_new(&origin, &dir);
+    }
+
+    DoublyLinkedList *filterOut = doubly_linked_list_new();
+    doubly_linked_list_push_last(filterOut, transforms[1]);
+    doubly_linked_list_push_last(filterOut, transforms[5]);
+
+    const uint16_t groups = PHYSICS_GROUP_DEFAULT_MAP | PHYSICS_GROUP_DEFAULT_OBJECT;
+    CastResult expected[TEST_SCENE_NB_RAYS], results[TEST_SCENE_NB_RAYS];
+    size_t nbHits = 0, nbBlockHits = 0;
+    for (int i = 0; i < TEST_SCENE_NB_RAYS; ++i) {
+        const HitType type = scene_cast_ray(sc, rays[i], groups, filterOut, &expected[i]);
+        if (type != Hit_None) {
+            nbHits++;
+        }
+        if (type == Hit_Block) {
+            nbBlockHits++;
+        }
+    }
+    TEST_CHECK(nbBlockHits > 10 && nbHits - nbBlockHits > 10);
+
+    ThreadPool *pool = thread_pool_new(2);
+    ThreadPool *pools[2] = {NULL, pool};
+    for (int p = 0; p < 2; ++p) {
+        TEST_CHECK(scene_cast_rays_batch(sc,
+                                         (const Ray *const *)rays,
+                                         TEST_SCENE_NB_RAYS,
+                                         groups,
+                                         filterOut,
+                                         pools[p],
+                                         results) == nbHits);
+        for (int i = 0; i < TEST_SCENE_NB_RAYS; ++i) {
+            TEST_CHECK(_test_scene_cast_results_equal(&results[i], &expected[i]));
+            TEST_MSG("ray %d", i);
+        }
+    }
+    TEST_CHECK(scene_cast_rays_batch(sc,
+                                     (const Ray *const *)rays,
+                                     TEST_SCENE_NB_RAYS,
+                                     PHYSICS_GROUP_NONE,
+                                     NULL,
+                                     NULL,
+                                     results) == 0);
+    TEST_CHECK(results[0].type == Hit_None);
+
+    thread_pool_free(pool);
+    doubly_linked_list_free(filterOut);
+    for (int i = 0; i < TEST_SCENE_NB_RAYS; ++i) {
+        ray_free(rays[i]);
+    }
+    for (int i = 0; i < TEST_SCENE_NB_TRANSFORMS; ++i) {
+        transform_release(transforms[i]);
+    }
+    shape_free(map);
+    scene_free(sc);
+}
+
+// physics stress benchmark: boxes falling onto a per-block map, the physics step should not
+// allocate once its scratch storage has grown during the first frames
+void test_scene_physics_falling_boxes_benchmark(void) {
+    Scene *sc = scene_new(NULL);
+    TEST_ASSERT(sc != NULL);
+    const float gravity = -30.0f;
+    scene_set_constant_acceleration(sc, NULL, &gravity, NULL);
+
+    Shape *map = shape_make();
+    shape_set_palette(map, color_palette_new(color_atlas_new()), false);
+    for (SHAPE_COORDS_INT_T x = 0; x < 64; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < 64; ++z) {
+            shape_add_block(map, 1, x, 0, z, false);
+        }
+    }
+    RigidBody *rb;
+    Transform *mapTr = shape_get_root_transform(map);
+    transform_ensure_rigidbody(mapTr,
+                               RigidbodyMode_StaticPerBlock,
+                               PHYSICS_GROUP_DEFAULT_MAP,
+                               PHYSICS_GROUP_NONE,
+                               &rb);
+    transform_set_parent(mapTr, scene_get_root(sc), false);
+
+    uint32_t seed = 7;
+    const Box collider = {{-0.5f, 0.0f, -0.5f}, {0.5f, 1.0f, 0.5f}};
+    Transform *boxes[TEST_SCENE_NB_FALLING_BOXES];
+    for (int i = 0; i < TEST_SCENE_NB_FALLING_BOXES; ++i) {
+        boxes[i] = transform_make(PointTransform);
+        transform_set_position(boxes[i],
+                               (float)(i % 16) * 4.0f + 2.0f,
+                               2.0f + _test_scene_random(&seed) * 20.0f,
+                               (float)(i / 16) * 4.0f + 2.0f);
+        transform_ensure_rigidbody(boxes[i],
+                                   RigidbodyMode_Dynamic,
+                                   PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   PHYSICS_GROUP_DEFAULT_MAP | PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   &rb);
+        rigidbody_set_collider(rb, &collider, true);
+        transform_set_parent(boxes[i], scene_get_root(sc), false);
+    }
+
+    // first frames let scratch storage grow
+    const TICK_DELTA_SEC_T dt = 1.0 / 60.0;
+    scene_refresh(sc, dt, NULL);
+    scene_refresh(sc, dt, NULL);
+
+    const size_t allocations = _test_scene_allocations;
+    const clock_t start = clock();
+    for (int i = 0; i < TEST_SCENE_NB_PHYSICS_STEPS; ++i) {
+        scene_refresh(sc, dt, NULL);
+    }
+    const double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    const double allocationsPerStep = (double)(_test_scene_allocations - allocations) /
+                                      TEST_SCENE_NB_PHYSICS_STEPS;
+
+    // all boxes landed on the map
+    for (int i = 0; i < TEST_SCENE_NB_FALLING_BOXES; ++i) {
+        TEST_CHECK(float_isEqual(transform_get_position(boxes[i], false)->y, 1.0f, 0.05f));
+        TEST_MSG("box %d at y=%f", i, (double)transform_get_position(boxes[i], false)->y);
+    }
+    if (TEST_SCENE_COUNT_ALLOCATIONS) {
+        TEST_CHECK(allocationsPerStep == 0.0);
+        TEST_CASE_("%d boxes: %.3fms/step, %.1f allocs/step",
+                   TEST_SCENE_NB_FALLING_BOXES,
+                   ms / TEST_SCENE_NB_PHYSICS_STEPS,
+                   allocationsPerStep);
+    } else {
+        TEST_CASE_("%d boxes: %.3fms/step, allocs/step n/a",
+                   TEST_SCENE_NB_FALLING_BOXES,
+                   ms / TEST_SCENE_NB_PHYSICS_STEPS);
+    }
+
+    for (int i = 0; i < TEST_SCENE_NB_FALLING_BOXES; ++i) {
+        transform_release(boxes[i]);
+    }
+    shape_free(map);
+    scene_free(sc);
+}
+
+// physics stress benchmark: thousands of bodies sliding on a per-block map, w/o ever sleeping
+void test_scene_physics_sliding_boxes_benchmark(void) {
+    Scene *sc = scene_new(NULL);
+    TEST_ASSERT(sc != NULL);
+    const float gravity = -30.0f;
+    scene_set_constant_acceleration(sc, NULL, &gravity, NULL);
+
+    Shape *map = shape_make();
+    shape_set_palette(map, color_palette_new(color_atlas_new()), false);
+    for (SHAPE_COORDS_INT_T x = 0; x < 160; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < 80; ++z) {
+            shape_add_block(map, 1, x, 0, z, false);
+        }
+    }
+    RigidBody *rb;
+    Transform *mapTr = shape_get_root_transform(map);
+    transform_ensure_rigidbody(mapTr,
+                               RigidbodyMode_StaticPerBlock,
+                               PHYSICS_GROUP_DEFAULT_MAP,
+                               PHYSICS_GROUP_NONE,
+                               &rb);
+    transform_set_parent(mapTr, scene_get_root(sc), false);
+
+    const Box collider = {{-0.25f, 0.0f, -0.25f}, {0.25f, 0.5f, 0.25f}};
+    const float3 motion = {1.0f, 0.0f, 0.0f};
+    Transform *boxes[TEST_SCENE_NB_SLIDING_BOXES];
+    for (int i = 0; i < TEST_SCENE_NB_SLIDING_BOXES; ++i) {
+        boxes[i] = transform_make(PointTransform);
+        transform_set_position(boxes[i], (float)(i % 64) + 0.5f, 1.0f, (float)(i / 64) + 0.5f);
+        transform_ensure_rigidbody(boxes[i],
+                                   RigidbodyMode_Dynamic,
+                                   PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   PHYSICS_GROUP_DEFAULT_MAP | PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   &rb);
+        rigidbody_set_collider(rb, &collider, true);
+        rigidbody_set_motion(rb, &motion);
+        transform_set_parent(boxes[i], scene_get_root(sc), false);
+    }
+
+    const TICK_DELTA_SEC_T dt = 1.0 / 60.0;
+    scene_refresh(sc, dt, NULL);
+
+    const clock_t start = clock();
+    for (int i = 0; i < TEST_SCENE_NB_SLIDING_STEPS; ++i) {
+        scene_refresh(sc, dt, NULL);
+    }
+    const double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    // all boxes moved along w/ their motion, on the map
+    for (int i = 0; i < TEST_SCENE_NB_SLIDING_BOXES; ++i) {
+        const float3 *pos = transform_get_position(boxes[i], false);
+        TEST_CHECK(pos->x > (float)(i % 64) + 1.0f && float_isEqual(pos->y, 1.0f, 0.05f));
+        TEST_MSG("box %d at (%f, %f)", i, (double)pos->x, (double)pos->y);
+    }
+    TEST_CASE_("%d boxes: %.3fms/step",
+               TEST_SCENE_NB_SLIDING_BOXES,
+               ms / TEST_SCENE_NB_SLIDING_STEPS);
+
+    for (int i = 0; i < TEST_SCENE_NB_SLIDING_BOXES; ++i) {
+        transform_release(boxes[i]);
+    }
+    shape_free(map);
+    scene_free(sc);
+}
+
+typedef struct {
+    Transform **boxes;
+    int *events; // type, self & other box index (-1 for the map) for each callback
+    int nbEvents;
+    char pad[4];
+} _TestSceneIslandsRun;
+
+static int _test_scene_box_index(const _TestSceneIslandsRun *run, const Transform *t) {
+    for (int i = 0; i < TEST_SCENE_NB_ISLANDS_BOXES; ++i) {
+        if (run->boxes[i] == t) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void _test_scene_collision_func(CollisionCallbackType type,
+                                       Transform *self,
+                                       RigidBody *selfRb,
+                                       Transform *other,
+                                       RigidBody *otherRb,
+                                       float3 wNormal,
+                                       void *callbackData) {
+    _TestSceneIslandsRun *run = (_TestSceneIslandsRun *)callbackData;
+    if (run->nbEvents < TEST_SCENE_NB_ISLANDS_EVENTS) {
+        run->events[run->nbEvents * 3] = (int)type;
+        run->events[run->nbEvents * 3 + 1] = _test_scene_box_index(run, self);
+        run->events[run->nbEvents * 3 + 2] = _test_scene_box_index(run, other);
+        run->nbEvents++;
+    }
+}
+
+/// steps boxes falling on a map, either far apart or packed & pushing each other, w/ collision
+/// callbacks on every other box ; then stores final positions in 'positions'
+static double _test_scene_islands_run(ThreadPool *pool,
+                                      const bool packed,
+                                      float3 *positions,
+                                      _TestSceneIslandsRun *run) {
+    Scene *sc = scene_new(NULL);
+    const float gravity = -30.0f;
+    scene_set_constant_acceleration(sc, NULL, &gravity, NULL);
+    scene_set_physics_pool(sc, pool);
+
+    Shape *map = shape_make();
+    shape_set_palette(map, color_palette_new(color_atlas_new()), false);
+    for (SHAPE_COORDS_INT_T x = 0; x < 80; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < 80; ++z) {
+            shape_add_block(map, 1, x, 0, z, false);
+        }
+    }
+    RigidBody *rb;
+    Transform *mapTr = shape_get_root_transform(map);
+    transform_ensure_rigidbody(mapTr,
+                               RigidbodyMode_StaticPerBlock,
+                               PHYSICS_GROUP_DEFAULT_MAP,
+                               PHYSICS_GROUP_NONE,
+                               &rb);
+    transform_set_parent(mapTr, scene_get_root(sc), false);
+
+    uint32_t seed = 11;
+    const Box collider = {{-0.5f, 0.0f, -0.5f}, {0.5f, 1.0f, 0.5f}};
+    const float3 right = {4.0f, 0.0f, 0.0f}, left = {-4.0f, 0.0f, 0.0f};
+    const float spacing = packed ? 1.5f : 4.0f;
+    for (int i = 0; i < TEST_SCENE_NB_ISLANDS_BOXES; ++i) {
+        run->boxes[i] = transform_make(PointTransform);
+        transform_set_position(run->boxes[i],
+                               (float)(i % 20) * spacing + 4.0f,
+                               2.0f + _test_scene_random(&seed) * (packed ? 4.0f : 20.0f),
+                               (float)(i / 20) * spacing + 4.0f);
+        transform_ensure_rigidbody(run->boxes[i],
+                                   RigidbodyMode_Dynamic,
+                                   PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   PHYSICS_GROUP_DEFAULT_MAP | PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   &rb);
+        rigidbody_set_collider(rb, &collider, true);
+        if (packed) {
+            rigidbody_set_motion(rb, i % 2 == 0 ? &right : &left);
+        }
+        if (i % 2 == 0) {
+            rigidbody_toggle_collision_callback(rb, CollisionCallbackType_Begin, true);
+            rigidbody_toggle_collision_callback(rb, CollisionCallbackType_Tick, true);
+        }
+        transform_set_parent(run->boxes[i], scene_get_root(sc), false);
+    }
+
+    const TICK_DELTA_SEC_T dt = 1.0 / 60.0;
+    run->nbEvents = 0;
+    const clock_t start = clock();
+    for (int i = 0; i < TEST_SCENE_NB_ISLANDS_STEPS; ++i) {
+        scene_refresh(sc, dt, run);
+    }
+    const double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    for (int i = 0; i < TEST_SCENE_NB_ISLANDS_BOXES; ++i) {
+        positions[i] = *transform_get_position(run->boxes[i], false);
+        transform_release(run->boxes[i]);
+    }
+    shape_free(map);
+    scene_free(sc);
+
+    return ms / TEST_SCENE_NB_ISLANDS_STEPS;
+}
+
+// check that stepping contact islands in parallel gives the same results & callbacks order for any
+// number of workers, and the same as the serial step when rigidbodies are independent
+void test_scene_physics_islands(void) {
+    rigidbody_set_collision_callback(_test_scene_collision_func);
+
+    Transform *boxes[TEST_SCENE_NB_ISLANDS_BOXES];
+    float3 *positions = (float3 *)malloc(3 * TEST_SCENE_NB_ISLANDS_BOXES * sizeof(float3));
+    int *events = (int *)malloc(3 * TEST_SCENE_NB_ISLANDS_EVENTS * 3 * sizeof(int));
+    TEST_ASSERT(positions != NULL && events != NULL);
+
+    _TestSceneIslandsRun runs[3];
+    for (int i = 0; i < 3; ++i) {
+        runs[i].boxes = boxes;
+        runs[i].events = &events[i * TEST_SCENE_NB_ISLANDS_EVENTS * 3];
+    }
+    ThreadPool *pools[3] = {NULL, thread_pool_new(1), thread_pool_new(3)};
+    double ms[3];
+
+    for (int p = 0; p < 2; ++p) {
+        const bool packed = p == 1;
+        for (int i = 0; i < 3; ++i) {
+            ms[i] = _test_scene_islands_run(pools[i],
+                                            packed,
+                                            &positions[i * TEST_SCENE_NB_ISLANDS_BOXES],
+                                            &runs[i]);
+        }
+
+        // serial step is the reference for independent rigidbodies only
+        for (int i = packed ? 2 : 1; i < 3; ++i) {
+            const int ref = packed ? 1 : 0;
+            TEST_CHECK(memcmp(&positions[i * TEST_SCENE_NB_ISLANDS_BOXES],
+                              &positions[ref * TEST_SCENE_NB_ISLANDS_BOXES],
+                              TEST_SCENE_NB_ISLANDS_BOXES * sizeof(float3)) == 0);
+            TEST_MSG("%s: positions differ w/ pool %d", packed ? "packed" : "apart", i);
+            TEST_CHECK(runs[i].nbEvents == runs[ref].nbEvents &&
+                       memcmp(runs[i].events,
+                              runs[ref].events,
+                              (size_t)runs[i].nbEvents * 3 * sizeof(int)) == 0);
+            TEST_MSG("%s: callbacks differ w/ pool %d", packed ? "packed" : "apart", i);
+        }
+        TEST_CHECK(runs[0].nbEvents > 0 && runs[0].nbEvents < TEST_SCENE_NB_ISLANDS_EVENTS);
+
+        // all boxes landed on the map
+        for (int i = 0; i < 3 * TEST_SCENE_NB_ISLANDS_BOXES; ++i) {
+            TEST_CHECK(positions[i].y > 0.95f && positions[i].y < 2.5f);
+            TEST_MSG("box %d at y=%f", i, (double)positions[i].y);
+        }
+
+        TEST_CASE_("%s: %.3f serial, %.3f 1 worker, %.3f 3 workers (ms/step)",
+                   packed ? "packed" : "apart",
+                   ms[0],
+                   ms[1],
+                   ms[2]);
+    }
+
+    rigidbody_set_collision_callback(NULL);
+    thread_pool_free(pools[1]);
+    thread_pool_free(pools[2]);
+    free(positions);
+    free(events);
+}
+
+typedef struct {
+    int frame;
+    int beginFrame, endFrame;
+    char pad[4];
+} _TestSceneTriggerRun;
+
+static void _test_scene_trigger_func(CollisionCallbackType type,
+                                     Transform *self,
+                                     RigidBody *selfRb,
+                                     Transform *other,
+                                     RigidBody *otherRb,
+                                     float3 wNormal,
+                                     void *callbackData) {
+    _TestSceneTriggerRun *run = (_TestSceneTriggerRun *)callbackData;
+    if (type == CollisionCallbackType_Begin && run->beginFrame < 0) {
+        run->beginFrame = run->frame;
+    } else if (type == CollisionCallbackType_End && run->endFrame < 0) {
+        run->endFrame = run->frame;
+    }
+}
+
+/// drops a box through a trigger placed before or after it in hierarchy order
+static void _test_scene_trigger_run(ThreadPool *pool,
+                                    const bool triggerFirst,
+                                    _TestSceneTriggerRun *run) {
+    Scene *sc = scene_new(NULL);
+    const float gravity = -30.0f;
+    scene_set_constant_acceleration(sc, NULL, &gravity, NULL);
+    scene_set_physics_pool(sc, pool);
+
+    const Box collider = {{-0.5f, 0.0f, -0.5f}, {0.5f, 1.0f, 0.5f}};
+    RigidBody *rb;
+    Transform *trigger = transform_make(PointTransform);
+    transform_set_position(trigger, 0.0f, 4.0f, 0.0f);
+    transform_ensure_rigidbody(trigger,
+                               RigidbodyMode_Trigger,
+                               PHYSICS_GROUP_DEFAULT_OBJECT,
+                               PHYSICS_GROUP_DEFAULT_OBJECT,
+                               &rb);
+    rigidbody_set_collider(rb, &collider, true);
+    rigidbody_toggle_collision_callback(rb, CollisionCallbackType_Begin, true);
+    rigidbody_toggle_collision_callback(rb, CollisionCallbackType_End, true);
+
+    Transform *box = transform_make(PointTransform);
+    transform_set_position(box, 0.0f, 8.0f, 0.0f);
+    transform_ensure_rigidbody(box,
+                               RigidbodyMode_Dynamic,
+                               PHYSICS_GROUP_DEFAULT_OBJECT,
+                               PHYSICS_GROUP_DEFAULT_OBJECT,
+                               &rb);
+    rigidbody_set_collider(rb, &collider, true);
+
+    transform_set_parent(triggerFirst ? trigger : box, scene_get_root(sc), false);
+    transform_set_parent(triggerFirst ? box : trigger, scene_get_root(sc), false);
+
+    run->beginFrame = -1;
+    run->endFrame = -1;
+    for (run->frame = 0; run->frame < 60; ++run->frame) {
+        scene_refresh(sc, 1.0 / 60.0, run);
+    }
+
+    transform_release(trigger);
+    transform_release(box);
+    scene_free(sc);
+}
+
+// w/ a physics pool, triggers are ticked after dynamic rigidbodies moved whatever their order in
+// the hierarchy, same as a trigger placed after them in the serial step
+void test_scene_physics_islands_triggers(void) {
+    rigidbody_set_collision_callback(_test_scene_trigger_func);
+    ThreadPool *pool = thread_pool_new(2);
+
+    _TestSceneTriggerRun ref, run;
+    _test_scene_trigger_run(NULL, false, &ref);
+    TEST_CHECK(ref.beginFrame > 0 && ref.endFrame > ref.beginFrame);
+    TEST_MSG("serial: enter at frame %d, exit at frame %d", ref.beginFrame, ref.endFrame);
+
+    for (int i = 0; i < 2; ++i) {
+        _test_scene_trigger_run(pool, i == 0, &run);
+        TEST_CHECK(run.beginFrame == ref.beginFrame && run.endFrame == ref.endFrame);
+        TEST_MSG("trigger %s: enter at frame %d, exit at frame %d, expected %d, %d",
+                 i == 0 ? "first" : "last",
+                 run.beginFrame,
+                 run.endFrame,
+                 ref.beginFrame,
+                 ref.endFrame);
+    }
+
+    // the serial step sees the box leave one frame late if the trigger is ticked first
+    _test_scene_trigger_run(NULL, true, &run);
+    TEST_CHECK(run.beginFrame == ref.beginFrame && run.endFrame == ref.endFrame + 1);
+
+    rigidbody_set_collision_callback(NULL);
+    thread_pool_free(pool);
+}
+
+// a large static map & sleeping rigidbodies are skipped by the scene refresh, until woken up
+void test_scene_idle_branches(void) {
+    Scene *sc = scene_new(NULL);
+    TEST_ASSERT(sc != NULL);
+    const float gravity = -30.0f;
+    scene_set_constant_acceleration(sc, NULL, &gravity, NULL);
+
+    Shape *map = shape_make();
+    shape_set_palette(map, color_palette_new(color_atlas_new()), false);
+    for (SHAPE_COORDS_INT_T x = 0; x < 32; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < 32; ++z) {
+            shape_add_block(map, 1, x, 0, z, false);
+        }
+    }
+    RigidBody *rb;
+    Transform *mapTr = shape_get_root_transform(map);
+    transform_ensure_rigidbody(mapTr,
+                               RigidbodyMode_StaticPerBlock,
+                               PHYSICS_GROUP_DEFAULT_MAP,
+                               PHYSICS_GROUP_NONE,
+                               &rb);
+    transform_set_parent(mapTr, scene_get_root(sc), false);
+
+    // static props, grouped under a few transforms
+    const Box collider = {{-0.5f, 0.0f, -0.5f}, {0.5f, 1.0f, 0.5f}};
+    Transform *groups[TEST_SCENE_NB_IDLE_GROUPS];
+    Transform *prop = NULL;
+    for (int i = 0; i < TEST_SCENE_NB_IDLE_GROUPS; ++i) {
+        groups[i] = transform_make(PointTransform);
+        transform_set_position(groups[i], (float)i * 4.0f, 0.0f, 100.0f);
+        for (int j = 0; j < TEST_SCENE_NB_IDLE_PROPS; ++j) {
+            prop = transform_make(PointTransform);
+            transform_set_local_position(prop, 0.0f, 0.0f, (float)j * 2.0f);
+            transform_ensure_rigidbody(prop,
+                                       RigidbodyMode_Static,
+                                       PHYSICS_GROUP_DEFAULT_OBJECT,
+                                       PHYSICS_GROUP_NONE,
+                                       &rb);
+            rigidbody_set_collider(rb, &collider, true);
+            transform_set_parent(prop, groups[i], false);
+            transform_release(prop);
+        }
+        transform_set_parent(groups[i], scene_get_root(sc), false);
+    }
+
+    // dynamic boxes falling onto the map
+    Transform *boxes[TEST_SCENE_NB_IDLE_BOXES];
+    for (int i = 0; i < TEST_SCENE_NB_IDLE_BOXES; ++i) {
+        boxes[i] = transform_make(PointTransform);
+        transform_set_position(boxes[i],
+                               (float)(i % 4) * 8.0f + 2.5f,
+                               2.0f + (float)i,
+                               (float)(i / 4) * 8.0f + 2.5f);
+        transform_ensure_rigidbody(boxes[i],
+                                   RigidbodyMode_Dynamic,
+                                   PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   PHYSICS_GROUP_DEFAULT_MAP | PHYSICS_GROUP_DEFAULT_OBJECT,
+                                   &rb);
+        rigidbody_set_collider(rb, &collider, true);
+        transform_set_parent(boxes[i], scene_get_root(sc), false);
+    }
+
+    const size_t total = scene_get_nb_transforms(sc);
+    TEST_CHECK(total == 3 + TEST_SCENE_NB_IDLE_GROUPS * (1 + TEST_SCENE_NB_IDLE_PROPS) +
+                            TEST_SCENE_NB_IDLE_BOXES);
+
+    // first frame visits everything, then only falling boxes until they sleep
+    const TICK_DELTA_SEC_T dt = 1.0 / 60.0;
+    scene_refresh(sc, dt, NULL);
+    TEST_CHECK(scene_get_nb_visited_transforms(sc) == total);
+    scene_refresh(sc, dt, NULL);
+    TEST_CHECK(scene_get_nb_visited_transforms(sc) == 1 + TEST_SCENE_NB_IDLE_BOXES);
+    TEST_MSG("visited %zu", scene_get_nb_visited_transforms(sc));
+
+    size_t visited = 0;
+    const clock_t start = clock();
+    for (int i = 0; i < TEST_SCENE_NB_IDLE_STEPS; ++i) {
+        scene_refresh(sc, dt, NULL);
+        visited += scene_get_nb_visited_transforms(sc);
+    }
+    const double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    // all boxes landed on the map & sleep, only the root is visited
+    for (int i = 0; i < TEST_SCENE_NB_IDLE_BOXES; ++i) {
+        TEST_CHECK(float_isEqual(transform_get_position(boxes[i], false)->y, 1.0f, 0.05f));
+        TEST_MSG("box %d at y=%f", i, (double)transform_get_position(boxes[i], false)->y);
+    }
+    TEST_CHECK(scene_get_nb_visited_transforms(sc) == 1);
+    TEST_CHECK(scene_get_nb_idle_branches(sc) == transform_get_children_count(scene_get_root(sc)));
+    TEST_CASE_("%zu transforms: %.1f visited, %.4fms/step",
+               total,
+               (double)visited / TEST_SCENE_NB_IDLE_STEPS,
+               ms / TEST_SCENE_NB_IDLE_STEPS);
+
+    // moving a prop wakes up its group only
+    transform_set_local_position(prop, 0.0f, 1.0f, 0.0f);
+    scene_refresh(sc, dt, NULL);
+    TEST_CHECK(scene_get_nb_visited_transforms(sc) == 3);
+    TEST_CHECK(float_isEqual(rtree_node_get_aabb(rigidbody_get_rtree_leaf(transform_get_rigidbody(
+                                                     prop)))
+                                 ->min.y,
+                             1.0f,
+                             EPSILON_ZERO));
+    scene_refresh(sc, dt, NULL);
+    TEST_CHECK(scene_get_nb_visited_transforms(sc) == 1);
+
+    // setting velocity wakes up a sleeping box
+    const float3 up = {0.0f, 10.0f, 0.0f};
+    rigidbody_set_velocity(transform_get_rigidbody(boxes[0]), &up);
+    scene_refresh(sc, dt, NULL);
+    TEST_CHECK(scene_get_nb_visited_transforms(sc) == 2);
+    TEST_CHECK(transform_get_position(boxes[0], false)->y > 1.05f);
+
+    // removing a block below a sleeping box wakes it up, w/ the map
+    const float3 *pos = transform_get_position(boxes[1], false);
+    TEST_CHECK(shape_remove_block_as_transaction(map,
+                                                 sc,
+                                                 (SHAPE_COORDS_INT_T)pos->x,
+                                                 0,
+                                                 (SHAPE_COORDS_INT_T)pos->z));
+    for (int i = 0; i < 10; ++i) {
+        scene_refresh(sc, dt, NULL);
+    }
+    TEST_CHECK(transform_get_position(boxes[1], false)->y < 0.9f);
+    TEST_MSG("box 1 at y=%f", (double)transform_get_position(boxes[1], false)->y);
+
+    // changing gravity wakes up everything
+    const float antigravity = 30.0f;
+    scene_set_constant_acceleration(sc, NULL, &antigravity, NULL);
+    scene_refresh(sc, dt, NULL);
+    TEST_CHECK(scene_get_nb_visited_transforms(sc) == total);
+    for (int i = 2; i < TEST_SCENE_NB_IDLE_BOXES; ++i) {
+        TEST_CHECK(transform_get_position(boxes[i], false)->y > 1.0f);
+        TEST_MSG("box %d at y=%f", i, (double)transform_get_position(boxes[i], false)->y);
+    }
+
+    for (int i = 0; i < TEST_SCENE_NB_IDLE_GROUPS; ++i) {
+        transform_release(groups[i]);
+    }
+    for (int i = 0; i < TEST_SCENE_NB_IDLE_BOXES; ++i) {
+        transform_release(boxes[i]);
+    }
+    shape_free(map);
+    scene_free(sc);
+}
@@ -0,0 +1,109 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  test_serialization_v6.h
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include "color_atlas.h"
+#include "color_palette.h"
+#include "serialization.h"
+#include "serialization_v6.h"
+#include "shape.h"
+#include "stream.h"
+
+// functions that are NOT tested:
+// serialization_v6_save_shape
+// serialization_v6_get_preview_data
+
+// saves & loads back given shape, then checks that all blocks match w/ the same colors
+static void _test_serialization_v6_round_trip(Shape *s, ColorAtlas *atlas) {
+    void *buffer = NULL;
+    uint32_t size = 0;
+    TEST_ASSERT(serialization_save_shape_as_buffer(s, NULL, NULL, 0, &buffer, &size));
+
+    LoadShapeSettings settings = {false, true};
+    Shape *loaded = serialization_load_shape(stream_new_buffer_read((const char *)buffer, size),
+                                             NULL,
+                                             atlas,
+                                             &settings,
+                                             false);
+    TEST_ASSERT(loaded != NULL);
+    TEST_CHECK(shape_get_nb_blocks(loaded) == shape_get_nb_blocks(s));
+
+    SHAPE_COORDS_INT3_T min, max;
+    shape_get_model_aabb_2(s, &min, &max);
+    const ColorPalette *p1 = shape_get_palette(s);
+    const ColorPalette *p2 = shape_get_palette(loaded);
+    bool match = true;
+    for (SHAPE_COORDS_INT_T x = min.x; x < max.x; ++x) {
+        for (SHAPE_COORDS_INT_T y = min.y; y < max.y; ++y) {
+            for (SHAPE_COORDS_INT_T z = min.z; z < max.z; ++z) {
+                const Block *b1 = shape_get_block(s, x, y, z);
+                const Block *b2 = shape_get_block(loaded,
+                                                  (SHAPE_COORDS_INT_T)(x - min.x),
+                                                  (SHAPE_COORDS_INT_T)(y - min.y),
+                                                  (SHAPE_COORDS_INT_T)(z - min.z));
+                if (block_is_solid(b1) != block_is_solid(b2)) {
+                    match = false;
+                } else if (block_is_solid(b1)) {
+                    const RGBAColor c1 = color_palette_get_color(p1, block_get_color_index(b1));
+                    const RGBAColor c2 = color_palette_get_color(p2, block_get_color_index(b2));
+                    match = match && memcmp(&c1, &c2, sizeof(RGBAColor)) == 0;
+                }
+            }
+        }
+    }
+    TEST_CHECK(match);
+
+    shape_free(loaded);
+    free(buffer);
+}
+
+// check that sparse shapes (written w/ run-length encoding if enabled) and noisy shapes (written
+// as a dense grid) both load back identically
+void test_serialization_v6_shape_blocks(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    TEST_ASSERT(atlas != NULL);
+
+    // disabled by default, readers that predate it would load an empty shape
+    TEST_CHECK(serialization_v6_is_shape_blocks_rle_enabled() == false);
+
+    // sparse: a few blocks & a long row, in a large bounding box
+    Shape *sparse = shape_make();
+    shape_set_palette(sparse, color_palette_new(atlas), false);
+    shape_add_block(sparse, 1, 0, 0, 0, true);
+    shape_add_block(sparse, 2, 200, 60, 150, true);
+    shape_add_block(sparse, 3, 37, 12, 149, true);
+    for (SHAPE_COORDS_INT_T z = 0; z < 150; ++z) {
+        shape_add_block(sparse, (SHAPE_COLOR_INDEX_INT_T)(4 + z / 50), 100, 30, z, true);
+    }
+    _test_serialization_v6_round_trip(sparse, atlas);
+    serialization_v6_set_shape_blocks_rle_enabled(true);
+    _test_serialization_v6_round_trip(sparse, atlas);
+    serialization_v6_set_shape_blocks_rle_enabled(false);
+    shape_free(sparse);
+
+    // noisy: every block differs from the previous one
+    Shape *noisy = shape_make();
+    shape_set_palette(noisy, color_palette_new(atlas), false);
+    for (SHAPE_COORDS_INT_T x = 0; x < 10; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < 10; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 10; ++z) {
+                shape_add_block(noisy,
+                                (SHAPE_COLOR_INDEX_INT_T)(1 + (x + y + z) % 2),
+                                x,
+                                y,
+                                z,
+                                true);
+            }
+        }
+    }
+    serialization_v6_set_shape_blocks_rle_enabled(true);
+    _test_serialization_v6_round_trip(noisy, atlas);
+    serialization_v6_set_shape_blocks_rle_enabled(false);
+    shape_free(noisy);
+
+    color_atlas_free(atlas);
+}
@@ -7,10 +7,17 @@
 
 #pragma once
 
+#include <float.h>
+#include <time.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
 #include "acutest.h"
 
 #include "scene.h"
 #include "shape.h"
+#include "thread_pool.h"
 #include "transform.h"
 
 // functions that are NOT tested:
@@ -38,7 +45,6 @@
 // shape_expand_box
 // shape_make_space_for_block
 // shape_make_space
-// shape_refresh_vertices
 // shape_refresh_all_vertices
 // shape_get_first_vertex_buffer
 // shape_new_chunk_iterator
@@ -94,7 +100,6 @@
 // shape_set_physics_simulation_mode
 // shape_set_physics_properties
 // shape_box_cast
-// shape_ray_cast
 // shape_point_overlap
 // shape_box_overlap
 // shape_is_hidden
@@ -311,6 +316,412 @@ void test_shape_get_fullname(void) {
     shape_free((Shape *const)s);
 }
 
+// check that a flat plane of a single color is merged into 1 quad per side, and that
+// the number of visible faces is unchanged
+void test_shape_greedy_meshing(void) {
+    Shape *s = shape_make();
+    size_t nbFaces = 0, nbQuads = 0;
+    {
+        ColorAtlas *atlas = color_atlas_new();
+        TEST_ASSERT(atlas != NULL);
+        shape_set_palette(s, color_palette_new(atlas), false);
+    }
+    for (SHAPE_COORDS_INT_T x = 0; x < CHUNK_SIZE; ++x) {
+        for (SHAPE_COORDS_INT_T z = 0; z < CHUNK_SIZE; ++z) {
+            shape_add_block(s, 1, x, 0, z, true);
+        }
+    }
+    TEST_CHECK(shape_uses_greedy_meshing(s) == false);
+
+    shape_refresh_vertices(s);
+    shape_get_meshing_stats(s, &nbFaces, &nbQuads);
+    TEST_CHECK(nbFaces == 2 * CHUNK_SIZE_SQR + 4 * CHUNK_SIZE);
+    TEST_CHECK(nbQuads == nbFaces);
+
+    shape_set_greedy_meshing(s, true);
+    TEST_CHECK(shape_uses_greedy_meshing(s));
+
+    shape_refresh_vertices(s);
+    shape_get_meshing_stats(s, &nbFaces, &nbQuads);
+    TEST_CHECK(nbFaces == 2 * CHUNK_SIZE_SQR + 4 * CHUNK_SIZE);
+    TEST_CHECK(nbQuads == FACE_COUNT);
+
+    // a block of another color splits the top & bottom faces
+    shape_paint_block(s, 2, 5, 0, 5);
+    shape_refresh_vertices(s);
+    shape_get_meshing_stats(s, &nbFaces, &nbQuads);
+    TEST_CHECK(nbQuads > FACE_COUNT);
+    TEST_CHECK(nbQuads < nbFaces);
+
+    shape_free((Shape *const)s);
+}
+
+// check that meshing chunks on worker threads writes the same vertex buffers as meshing
+// them on the calling thread
+void test_shape_parallel_meshing(void) {
+    Shape *shapes[2];
+    for (int i = 0; i < 2; ++i) {
+        shapes[i] = shape_make();
+        ColorAtlas *atlas = color_atlas_new();
+        TEST_ASSERT(atlas != NULL);
+        shape_set_palette(shapes[i], color_palette_new(atlas), false);
+
+        for (SHAPE_COORDS_INT_T x = 0; x < 40; ++x) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 40; ++z) {
+                for (SHAPE_COORDS_INT_T y = 0; y < (x * 7 + z * 13) % 24; ++y) {
+                    shape_add_block(shapes[i],
+                                    (SHAPE_COLOR_INDEX_INT_T)(1 + (x + y + z) % 3),
+                                    x,
+                                    y,
+                                    z,
+                                    true);
+                }
+            }
+        }
+    }
+
+    shape_set_meshing_workers(0);
+    shape_refresh_vertices(shapes[0]);
+    shape_set_meshing_workers(3);
+    shape_refresh_vertices(shapes[1]);
+    shape_set_meshing_workers(-1);
+
+    for (int transparent = 0; transparent < 2; ++transparent) {
+        const VertexBuffer *vb1 = shape_get_first_vertex_buffer(shapes[0], transparent);
+        const VertexBuffer *vb2 = shape_get_first_vertex_buffer(shapes[1], transparent);
+        while (vb1 != NULL && vb2 != NULL) {
+            TEST_CHECK(vertex_buffer_get_count(vb1) == vertex_buffer_get_count(vb2));
+            TEST_CHECK(memcmp(vertex_buffer_get_draw_buffer(vb1),
+                              vertex_buffer_get_draw_buffer(vb2),
+                              vertex_buffer_get_count(vb1) * DRAWBUFFER_VERTICES_BYTES) == 0);
+            vb1 = vertex_buffer_get_next(vb1);
+            vb2 = vertex_buffer_get_next(vb2);
+        }
+        TEST_CHECK(vb1 == NULL && vb2 == NULL);
+    }
+
+    shape_free(shapes[0]);
+    shape_free(shapes[1]);
+}
+
+// check that baking lighting on worker threads, in regions, gives the same result as baking it on
+// the calling thread
+void test_shape_parallel_baked_lighting(void) {
+    Shape *shapes[2];
+    SHAPE_COLOR_INDEX_INT_T ground, glass, lamp;
+    for (int i = 0; i < 2; ++i) {
+        shapes[i] = shape_make();
+        ColorAtlas *atlas = color_atlas_new();
+        TEST_ASSERT(atlas != NULL);
+        shape_set_palette(shapes[i], color_palette_new(atlas), false);
+        ColorPalette *palette = shape_get_palette(shapes[i]);
+        TEST_ASSERT(color_palette_check_and_add_default_color_2021(palette, 1, &ground));
+        TEST_ASSERT(color_palette_check_and_add_color(palette,
+                                                      (RGBAColor){100, 150, 255, 100},
+                                                      &glass,
+                                                      false));
+        TEST_ASSERT(color_palette_check_and_add_color(palette,
+                                                      (RGBAColor){255, 200, 50, 255},
+                                                      &lamp,
+                                                      false));
+        color_palette_set_emissive(palette, lamp, true);
+
+        // 3x3 regions of ground w/ caves, glass roofs & lamps
+        for (SHAPE_COORDS_INT_T x = 0; x < 150; ++x) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 150; ++z) {
+                const SHAPE_COORDS_INT_T h = (SHAPE_COORDS_INT_T)(4 + (x * 7 + z * 13) % 9);
+                for (SHAPE_COORDS_INT_T y = 0; y < h; ++y) {
+                    if (y > 0 && y < h - 2 && x % 40 < 24 && z % 40 < 24) {
+                        continue;
+                    }
+                    shape_add_block(shapes[i], x % 17 == 0 ? glass : ground, x, y, z, false);
+                }
+                if (x % 40 == 12 && z % 40 == 12) {
+                    shape_add_block(shapes[i], lamp, x, 1, z, false);
+                }
+                if (x % 50 < 30 && z % 50 == 0) {
+                    shape_add_block(shapes[i], ground, x, 30, z, false);
+                }
+            }
+        }
+    }
+
+    shape_set_meshing_workers(0);
+    shape_compute_baked_lighting(shapes[0]);
+    shape_set_meshing_workers(3);
+    shape_compute_baked_lighting(shapes[1]);
+    shape_set_meshing_workers(-1);
+
+    SHAPE_COORDS_INT3_T min, max;
+    shape_get_model_aabb_2(shapes[0], &min, &max);
+    const size_t size = (size_t)(max.x - min.x) * (size_t)(max.y - min.y) *
+                        (size_t)(max.z - min.z) * sizeof(VERTEX_LIGHT_STRUCT_T);
+    VERTEX_LIGHT_STRUCT_T *blob1 = shape_create_lighting_data_blob(shapes[0], NULL);
+    VERTEX_LIGHT_STRUCT_T *blob2 = shape_create_lighting_data_blob(shapes[1], NULL);
+    TEST_ASSERT(blob1 != NULL && blob2 != NULL);
+    TEST_CHECK(memcmp(blob1, blob2, size) == 0);
+
+    // baking on a pool given by the caller
+    ThreadPool *pool = thread_pool_new(2);
+    shape_compute_baked_lighting_on_pool(shapes[1], pool);
+    thread_pool_free(pool);
+    VERTEX_LIGHT_STRUCT_T *blob3 = shape_create_lighting_data_blob(shapes[1], NULL);
+    TEST_ASSERT(blob3 != NULL);
+    TEST_CHECK(memcmp(blob1, blob3, size) == 0);
+
+    free(blob1);
+    free(blob2);
+    free(blob3);
+    shape_free(shapes[0]);
+    shape_free(shapes[1]);
+}
+
+static float _test_shape_random(uint32_t *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return (float)(*seed >> 8) / (float)(1u << 24);
+}
+
+/// random ray from around the shape, aiming at a point inside it
+static Ray *_test_shape_random_ray(uint32_t *seed) {
+    const float3 origin = {_test_shape_random(seed) * 160.0f - 40.0f,
+                           _test_shape_random(seed) * 100.0f - 20.0f,
+                           _test_shape_random(seed) * 160.0f - 40.0f};
+    float3 target = {_test_shape_random(seed) * 80.0f,
+                     _test_shape_random(seed) * 60.0f,
+                     _test_shape_random(seed) * 80.0f};
+    float3_op_substract(&target, &origin);
+    return ray_new(&origin, &target);
+}
+
+static Shape *_test_shape_make_ray_cast_target(void) {
+    Shape *s = shape_make();
+    ColorAtlas *atlas = color_atlas_new();
+    shape_set_palette(s, color_palette_new(atlas), false);
+
+    // sparse blocks, w/ a few empty chunks
+    uint32_t seed = 7;
+    for (SHAPE_COORDS_INT_T x = 0; x < 80; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < 60; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 80; ++z) {
+                if ((x / 16 + y / 16 + z / 16) % 4 != 3 && _test_shape_random(&seed) < .02f) {
+                    shape_add_block(s, 1, x, y, z, false);
+                }
+            }
+        }
+    }
+    Transform *t = shape_get_root_transform(s);
+    transform_set_position(t, 10.0f, -5.0f, 3.0f);
+    transform_set_rotation_euler(t, .3f, 1.1f, -.2f);
+    transform_refresh(t, false, true);
+
+    return s;
+}
+
+/// casts random rays & compares w/ the closest block found by checking all blocks
+/// @return number of hits
+static int _test_shape_check_ray_casts(const Shape *s, uint32_t seed) {
+    Transform *t = shape_get_root_transform(s);
+    Matrix4x4 invModel, model;
+    transform_utils_get_model_wtl(t, &invModel);
+    transform_utils_get_model_ltw(t, &model);
+
+    int nbHits = 0;
+    float d, worldDistance;
+    float3 localImpact;
+    Block *block;
+    SHAPE_COORDS_INT3_T coords;
+    for (int i = 0; i < 200; ++i) {
+        Ray *worldRay = _test_shape_random_ray(&seed);
+        if (i % 20 == 0) {
+            // axis-aligned rays too
+            float3 axis = float3_zero;
+            ((float *)&axis)[(i / 20) % 3] = i % 40 == 0 ? 1.0f : -1.0f;
+            Ray *axisRay = ray_new(worldRay->origin, &axis);
+            ray_free(worldRay);
+            worldRay = axisRay;
+        }
+        Ray *modelRay = ray_transform(worldRay, &invModel);
+
+        // closest block along the ray
+        float closest = FLT_MAX;
+        SHAPE_COORDS_INT3_T closestCoords = {0, 0, 0};
+        for (SHAPE_COORDS_INT_T x = 0; x < 80; ++x) {
+            for (SHAPE_COORDS_INT_T y = 0; y < 60; ++y) {
+                for (SHAPE_COORDS_INT_T z = 0; z < 80; ++z) {
+                    if (block_is_solid(shape_get_block(s, x, y, z)) == false) {
+                        continue;
+                    }
+                    const float3 ldf = {x, y, z}, rtb = {x + 1.0f, y + 1.0f, z + 1.0f};
+                    if (ray_intersect_with_box(modelRay, &ldf, &rtb, &d) && d < closest) {
+                        closest = d;
+                        closestCoords = (SHAPE_COORDS_INT3_T){x, y, z};
+                    }
+                }
+            }
+        }
+
+        const bool hit = shape_ray_cast(t,
+                                        s,
+                                        worldRay,
+                                        &worldDistance,
+                                        &localImpact,
+                                        &block,
+                                        &coords);
+        TEST_CHECK(hit == (closest < FLT_MAX));
+        if (hit) {
+            ++nbHits;
+            TEST_CHECK(block != NULL && block->colorIndex == 1);
+            TEST_CHECK(coords.x == closestCoords.x && coords.y == closestCoords.y &&
+                       coords.z == closestCoords.z);
+
+            float3 expected;
+            ray_impact_point(modelRay, closest, &expected);
+            TEST_CHECK(float3_isEqual(&localImpact, &expected, EPSILON_ZERO));
+
+            float3 worldImpact;
+            matrix4x4_op_multiply_vec_point(&worldImpact, &expected, &model);
+            float3_op_substract(&worldImpact, worldRay->origin);
+            TEST_CHECK(
+                float_isEqual(worldDistance, float3_length(&worldImpact), EPSILON_COLLISION));
+        }
+
+        ray_free(modelRay);
+        ray_free(worldRay);
+    }
+    return nbHits;
+}
+
+// check that ray casts hit the closest block along the ray, comparing w/ all blocks
+void test_shape_ray_cast(void) {
+    Shape *s = _test_shape_make_ray_cast_target();
+    TEST_CHECK(_test_shape_check_ray_casts(s, 3) > 30);
+
+    // w/o rotation, axis-aligned rays are also axis-aligned in model space
+    Transform *t = shape_get_root_transform(s);
+    transform_set_rotation_euler(t, 0.0f, 0.0f, 0.0f);
+    transform_refresh(t, false, true);
+    TEST_CHECK(_test_shape_check_ray_casts(s, 4) > 30);
+
+    shape_free(s);
+}
+
+// report ray cast timings, visible w/ --verbose=3
+void test_shape_ray_cast_benchmark(void) {
+    Shape *s = _test_shape_make_ray_cast_target();
+    Transform *t = shape_get_root_transform(s);
+
+    Ray *rays[100];
+    uint32_t seed = 5;
+    for (int i = 0; i < 100; ++i) {
+        rays[i] = _test_shape_random_ray(&seed);
+    }
+
+    int nbHits = 0;
+    Block *block;
+    const clock_t start = clock();
+    for (int i = 0; i < 10000; ++i) {
+        nbHits += shape_ray_cast(t, s, rays[i % 100], NULL, NULL, &block, NULL);
+    }
+    const double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    TEST_CASE_("10k ray casts: %.2fms, %d hits", ms, nbHits);
+    TEST_CHECK(nbHits > 0);
+
+    for (int i = 0; i < 100; ++i) {
+        ray_free(rays[i]);
+    }
+    shape_free(s);
+}
+
+// fills shapes w/ same blocks, from a grid & block by block, and compares them
+void test_shape_fill_blocks_from_grid(void) {
+    const uint16_t w = 40, h = 30, d = 50;
+    SHAPE_COLOR_INDEX_INT_T *grid = (SHAPE_COLOR_INDEX_INT_T *)malloc((size_t)w * h * d);
+    TEST_ASSERT(grid != NULL);
+
+    Shape *shapes[2];
+    SHAPE_COLOR_INDEX_INT_T colors[3];
+    for (int i = 0; i < 2; ++i) {
+        shapes[i] = shape_make();
+        ColorAtlas *atlas = color_atlas_new();
+        TEST_ASSERT(atlas != NULL);
+        shape_set_palette(shapes[i], color_palette_new(atlas), false);
+        for (SHAPE_COLOR_INDEX_INT_T c = 0; c < 3; ++c) {
+            TEST_ASSERT(color_palette_check_and_add_default_color_2021(shape_get_palette(shapes[i]),
+                                                                       c + 1,
+                                                                       &colors[c]));
+        }
+        // existing block is kept
+        shape_add_block(shapes[i], colors[2], 3, 0, 3, false);
+    }
+
+    size_t expected = 0;
+    SHAPE_COLOR_INDEX_INT_T *cursor = grid;
+    for (SHAPE_COORDS_INT_T x = 0; x < w; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < h; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < d; ++z) {
+                if (x > 0 && y < (x * 7 + z * 13) % 24) {
+                    *cursor = colors[(x + y + z) % 3];
+                    if (shape_add_block(shapes[1], *cursor, x, y, z, false)) {
+                        ++expected;
+                    }
+                } else {
+                    *cursor = SHAPE_COLOR_INDEX_AIR_BLOCK;
+                }
+                ++cursor;
+            }
+        }
+    }
+
+    TEST_CHECK(shape_fill_blocks_from_grid(shapes[0], grid, w, h, d) == expected);
+    TEST_CHECK(shape_get_nb_blocks(shapes[0]) == shape_get_nb_blocks(shapes[1]));
+    TEST_CHECK(shape_get_nb_chunks(shapes[0]) == shape_get_nb_chunks(shapes[1]));
+
+    int3 size1, size2;
+    shape_get_bounding_box_size(shapes[0], &size1);
+    shape_get_bounding_box_size(shapes[1], &size2);
+    TEST_CHECK(size1.x == size2.x && size1.y == size2.y && size1.z == size2.z);
+
+    for (SHAPE_COLOR_INDEX_INT_T c = 0; c < 3; ++c) {
+        TEST_CHECK(color_palette_get_color_use_count(shape_get_palette(shapes[0]), colors[c]) ==
+                   color_palette_get_color_use_count(shape_get_palette(shapes[1]), colors[c]));
+    }
+
+    const Block *b1, *b2;
+    for (SHAPE_COORDS_INT_T x = 0; x < w; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < h; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < d; ++z) {
+                b1 = shape_get_block(shapes[0], x, y, z);
+                b2 = shape_get_block(shapes[1], x, y, z);
+                TEST_CHECK((b1 == NULL) == (b2 == NULL));
+                if (b1 != NULL && b2 != NULL) {
+                    TEST_CHECK(b1->colorIndex == b2->colorIndex);
+                }
+            }
+        }
+    }
+
+    // all touched chunks were refreshed
+    shape_refresh_vertices(shapes[0]);
+    shape_refresh_vertices(shapes[1]);
+    for (int transparent = 0; transparent < 2; ++transparent) {
+        const VertexBuffer *vb1 = shape_get_first_vertex_buffer(shapes[0], transparent);
+        const VertexBuffer *vb2 = shape_get_first_vertex_buffer(shapes[1], transparent);
+        uint32_t count1 = 0, count2 = 0;
+        for (; vb1 != NULL; vb1 = vertex_buffer_get_next(vb1)) {
+            count1 += vertex_buffer_get_count(vb1);
+        }
+        for (; vb2 != NULL; vb2 = vertex_buffer_get_next(vb2)) {
+            count2 += vertex_buffer_get_count(vb2);
+        }
+        TEST_CHECK(count1 == count2);
+    }
+
+    free(grid);
+    shape_free(shapes[0]);
+    shape_free(shapes[1]);
+}
+
 //
 // history : used
 // palette : used
@@ -551,3 +962,354 @@ void test_shape_addblock_3(void) {
     shape_free((Shape *const)sh);
     scene_free(sc);
 }
+
+/// heap in use, if it can be measured on this platform
+static size_t _test_shape_heap_usage(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// check that copies are independent from the source & from each other once edited, and report
+// copies timing & memory, visible w/ --verbose=3
+void test_shape_make_copy_benchmark(void) {
+    Shape *src = shape_make();
+    shape_set_palette(src, color_palette_new(color_atlas_new()), false);
+    for (SHAPE_COORDS_INT_T x = 0; x < 32; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < 32; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 32; ++z) {
+                if ((x + y + z) % 3 != 0 || y < 4) {
+                    shape_add_block(src, 1, x, y, z, false);
+                }
+            }
+        }
+    }
+    shape_compute_baked_lighting(src);
+    const size_t nbChunks = shape_get_nb_chunks(src);
+
+    Shape *copies[1000];
+    size_t heap = _test_shape_heap_usage();
+    const clock_t start = clock();
+    for (int i = 0; i < 1000; ++i) {
+        copies[i] = shape_make_copy(src);
+    }
+    const double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    const size_t copiesHeap = _test_shape_heap_usage() - heap;
+
+    // first write in each chunk of each copy
+    heap = _test_shape_heap_usage();
+    for (int i = 0; i < 1000; ++i) {
+        for (SHAPE_COORDS_INT_T x = 0; x < 32; x += CHUNK_SIZE) {
+            for (SHAPE_COORDS_INT_T y = 0; y < 32; y += CHUNK_SIZE) {
+                for (SHAPE_COORDS_INT_T z = 0; z < 32; z += CHUNK_SIZE) {
+                    shape_paint_block(copies[i], 2, x, y + 1, z);
+                }
+            }
+        }
+    }
+    const size_t writesHeap = _test_shape_heap_usage() - heap;
+
+    TEST_CASE_("1k copies: %.2fms, %zuKB, +%zuKB on write", ms, copiesHeap >> 10, writesHeap >> 10);
+    TEST_CHECK(nbChunks == 8);
+    TEST_CHECK(shape_get_nb_blocks(copies[0]) == shape_get_nb_blocks(src));
+    TEST_CHECK(shape_get_block(src, 0, 1, 0)->colorIndex == 1);
+    TEST_CHECK(shape_get_block(copies[0], 0, 1, 0)->colorIndex == 2);
+
+    // copy of an edited copy, edited again
+    Shape *copy = shape_make_copy(copies[0]);
+    shape_remove_block(copy, 0, 1, 0);
+    TEST_CHECK(block_is_solid(shape_get_block(copies[0], 0, 1, 0)));
+    TEST_CHECK(block_is_solid(shape_get_block(copy, 0, 1, 0)) == false);
+    shape_free(copy);
+
+    shape_free(src);
+    for (int i = 0; i < 1000; ++i) {
+        shape_free(copies[i]);
+    }
+}
+
+static Shape *_test_shape_make_mesh_sharing_source(void) {
+    Shape *s = shape_make();
+    ColorPalette *palette = color_palette_new(color_atlas_new());
+    for (uint8_t i = 0; i < 3; ++i) {
+        color_palette_check_and_add_color(palette, (RGBAColor){i, i, i, 255}, NULL, false);
+    }
+    shape_set_palette(s, palette, false);
+    for (SHAPE_COORDS_INT_T x = 0; x < 32; ++x) {
+        for (SHAPE_COORDS_INT_T y = 0; y < 32; ++y) {
+            for (SHAPE_COORDS_INT_T z = 0; z < 32; ++z) {
+                if ((x + y + z) % 3 != 0 || y < 4) {
+                    shape_add_block(s, (SHAPE_COLOR_INDEX_INT_T)(1 + (x + z) % 2), x, y, z, false);
+                }
+            }
+        }
+    }
+    return s;
+}
+
+static size_t _test_shape_vertex_buffers_size(const Shape *s) {
+    size_t size = 0;
+    for (int transparent = 0; transparent < 2; ++transparent) {
+        const VertexBuffer *vb = shape_get_first_vertex_buffer(s, transparent);
+        while (vb != NULL) {
+            size += vertex_buffer_get_max_count(vb) * DRAWBUFFER_VERTICES_BYTES;
+            vb = vertex_buffer_get_next(vb);
+        }
+    }
+    return size;
+}
+
+// check that copies of a shape w/ mesh sharing draw its vertex buffers until they, their palette,
+// or the shape are modified, and that they share a mesh again once meshed on their own
+void test_shape_mesh_sharing(void) {
+    Shape *src = _test_shape_make_mesh_sharing_source();
+    shape_compute_baked_lighting(src);
+    shape_toggle_mesh_sharing(src, true);
+    TEST_CHECK(shape_uses_mesh_sharing(src));
+    shape_refresh_vertices(src);
+    TEST_CHECK(shape_is_mesh_instance(src) == false);
+    TEST_CHECK(shape_get_mesh_instances_count(src) == 1);
+
+    VertexBuffer *vb = shape_get_first_vertex_buffer(src, false);
+    TEST_ASSERT(vb != NULL);
+
+    Shape *copies[4];
+    for (int i = 0; i < 4; ++i) {
+        copies[i] = shape_make_copy(src);
+        Transform *t = shape_get_root_transform(copies[i]);
+        transform_set_local_position(t, (float)(i + 1), 0.0f, 0.0f);
+        transform_refresh(t, false, true);
+        shape_refresh_vertices(copies[i]);
+
+        TEST_CHECK(shape_uses_mesh_sharing(copies[i]));
+        TEST_CHECK(shape_get_palette(copies[i]) != shape_get_palette(src));
+        TEST_CHECK(shape_is_mesh_instance(copies[i]));
+        TEST_CHECK(shape_get_mesh_owner(copies[i]) == src);
+        TEST_CHECK(shape_get_first_vertex_buffer(copies[i], false) == vb);
+    }
+    TEST_CHECK(shape_get_mesh_instances_count(copies[0]) == 5);
+
+    transform_refresh(shape_get_root_transform(src), false, true);
+    Matrix4x4 models[5];
+    TEST_CHECK(shape_get_mesh_instances_models(src, models, 5) == 5);
+    TEST_CHECK(models[0].x4y1 == 0.0f);
+    TEST_CHECK(models[4].x4y1 == 4.0f);
+    TEST_CHECK(shape_get_mesh_instances_models(src, models, 2) == 2);
+    TEST_CHECK(shape_get_mesh_instances_models(copies[0], models, 5) == 0);
+
+    // a modified instance meshes its own vertex buffers
+    shape_remove_block(copies[0], 0, 0, 0);
+    TEST_CHECK(shape_is_mesh_instance(copies[0]) == false);
+    shape_refresh_vertices(copies[0]);
+    TEST_CHECK(shape_get_first_vertex_buffer(copies[0], false) != NULL);
+    TEST_CHECK(shape_get_first_vertex_buffer(copies[0], false) != vb);
+    TEST_CHECK(shape_get_mesh_instances_count(src) == 4);
+
+    // so does an instance whose palette changes, w/o affecting the owner's colors
+    ColorPalette *palette = shape_get_palette(copies[3]);
+    const RGBAColor srcColor = color_palette_get_color(shape_get_palette(src), 1);
+    color_palette_set_color(palette, 1, (RGBAColor){12, 34, 56, 255});
+    shape_refresh_vertices(copies[3]);
+    TEST_CHECK(shape_is_mesh_instance(copies[3]) == false);
+    TEST_CHECK(shape_get_first_vertex_buffer(copies[3], false) != vb);
+    RGBAColor color = color_palette_get_color(shape_get_palette(src), 1);
+    TEST_CHECK(colors_are_equal(&color, &srcColor));
+    TEST_CHECK(shape_get_mesh_instances_count(src) == 3);
+
+    // a modified owner keeps its vertex buffers, its instances mesh their own & the first one
+    // refreshed shares them w/ the others
+    shape_paint_block(src, 2, 1, 1, 1);
+    TEST_CHECK(shape_is_mesh_instance(copies[1]) == false);
+    TEST_CHECK(shape_is_mesh_instance(copies[2]) == false);
+    shape_refresh_vertices(src);
+    TEST_CHECK(shape_get_first_vertex_buffer(src, false) == vb);
+    shape_refresh_vertices(copies[1]);
+    shape_refresh_vertices(copies[2]);
+    TEST_CHECK(shape_is_mesh_instance(copies[1]) == false);
+    TEST_CHECK(shape_get_first_vertex_buffer(copies[1], false) != NULL);
+    TEST_CHECK(shape_get_first_vertex_buffer(copies[1], false) != vb);
+    TEST_CHECK(shape_get_mesh_owner(copies[2]) == copies[1]);
+
+    // same when the owner's palette changes colors, or when it is freed
+    color_palette_set_color(shape_get_palette(copies[1]), 1, (RGBAColor){65, 43, 21, 255});
+    shape_refresh_vertices(copies[2]);
+    TEST_CHECK(shape_is_mesh_instance(copies[2]) == false);
+    TEST_CHECK(shape_get_first_vertex_buffer(copies[2], false) != NULL);
+
+    Shape *copy = shape_make_copy(copies[2]);
+    shape_refresh_vertices(copy);
+    TEST_CHECK(shape_get_mesh_owner(copy) == copies[2]);
+    shape_free(copies[2]);
+    TEST_CHECK(shape_is_mesh_instance(copy) == false);
+    shape_refresh_vertices(copy);
+    TEST_CHECK(shape_get_first_vertex_buffer(copy, false) != NULL);
+    copies[2] = copy;
+
+    // shapes meshed on their own are still refreshed incrementally
+    shape_remove_block(copies[2], 0, 0, 0);
+    shape_refresh_vertices(copies[2]);
+    size_t nbFaces[2], nbQuads[2];
+    shape_get_meshing_stats(copies[0], &nbFaces[0], &nbQuads[0]);
+    shape_get_meshing_stats(copies[2], &nbFaces[1], &nbQuads[1]);
+    TEST_CHECK(nbFaces[0] > 0);
+    TEST_CHECK(nbFaces[0] == nbFaces[1]);
+    TEST_CHECK(nbQuads[0] == nbQuads[1]);
+
+    // disabling mesh sharing keeps own vertex buffers
+    vb = shape_get_first_vertex_buffer(copies[2], false);
+    shape_toggle_mesh_sharing(copies[2], false);
+    TEST_CHECK(shape_get_first_vertex_buffer(copies[2], false) == vb);
+
+    shape_free(src);
+    for (int i = 0; i < 4; ++i) {
+        shape_free(copies[i]);
+    }
+}
+
+static Shape *_test_shape_make_mesh_sharing_small(ColorPalette *palette,
+                                                  const SHAPE_COORDS_INT_T x,
+                                                  const SHAPE_COLOR_INDEX_INT_T color) {
+    Shape *s = shape_make();
+    shape_set_palette(s, palette, true);
+    shape_toggle_mesh_sharing(s, true);
+    shape_add_block(s, 1, 0, 0, 0, false);
+    shape_add_block(s, color, x, 1, 0, false);
+    shape_refresh_vertices(s);
+    return s;
+}
+
+// check that shapes built separately share a mesh only if their content is identical, w/ enough
+// owners to grow the shared meshes index & remove some of them
+void test_shape_mesh_sharing_index(void) {
+    ColorAtlas *atlas = color_atlas_new();
+    ColorPalette *palette = color_palette_new(atlas);
+
+    Shape *owners[100];
+    for (int i = 0; i < 100; ++i) {
+        owners[i] = _test_shape_make_mesh_sharing_small(palette, (SHAPE_COORDS_INT_T)i, 2);
+        TEST_CHECK(shape_is_mesh_instance(owners[i]) == false);
+    }
+
+    Shape *twin = _test_shape_make_mesh_sharing_small(palette, 42, 2);
+    TEST_CHECK(shape_get_mesh_owner(twin) == owners[42]);
+    shape_free(twin);
+
+    Shape *other = _test_shape_make_mesh_sharing_small(palette, 42, 3);
+    TEST_CHECK(shape_is_mesh_instance(other) == false);
+    shape_free(other);
+
+    for (int i = 0; i < 100; i += 2) {
+        shape_free(owners[i]);
+    }
+    twin = _test_shape_make_mesh_sharing_small(palette, 51, 2);
+    TEST_CHECK(shape_get_mesh_owner(twin) == owners[51]);
+    shape_free(twin);
+    twin = _test_shape_make_mesh_sharing_small(palette, 50, 2);
+    TEST_CHECK(shape_is_mesh_instance(twin) == false);
+    shape_free(twin);
+
+    for (int i = 1; i < 100; i += 2) {
+        shape_free(owners[i]);
+    }
+    color_palette_release(palette);
+    color_atlas_free(atlas);
+}
+
+#define TEST_SHAPE_NB_CONCURRENT_SHAPES 16
+
+static void _test_shape_refresh_job(void *ctx, const size_t idx) {
+    shape_refresh_vertices(((Shape **)ctx)[idx]);
+}
+
+static void _test_shape_toggle_or_refresh_job(void *ctx, const size_t idx) {
+    Shape *s = ((Shape **)ctx)[idx];
+    if (idx % 2 == 0) {
+        shape_toggle_mesh_sharing(s, false);
+    } else {
+        shape_refresh_vertices(s);
+    }
+}
+
+// check that shapes w/ mesh sharing can be refreshed, and stop sharing, from several threads at once
+void test_shape_mesh_sharing_concurrent(void) {
+    ThreadPool *pool = thread_pool_new(3);
+    Shape *shapes[TEST_SHAPE_NB_CONCURRENT_SHAPES];
+    shapes[0] = _test_shape_make_mesh_sharing_source();
+    shape_toggle_mesh_sharing(shapes[0], true);
+    for (int i = 1; i < TEST_SHAPE_NB_CONCURRENT_SHAPES; ++i) {
+        shapes[i] = shape_make_copy(shapes[0]);
+    }
+
+    // shapes meshed at the same time may each register their own mesh
+    thread_pool_parallel_for(pool, TEST_SHAPE_NB_CONCURRENT_SHAPES, _test_shape_refresh_job, shapes);
+    size_t nbShapes = 0;
+    for (int i = 0; i < TEST_SHAPE_NB_CONCURRENT_SHAPES; ++i) {
+        TEST_CHECK(shape_get_first_vertex_buffer(shapes[i], false) != NULL);
+        Shape *owner = shape_get_mesh_owner(shapes[i]);
+        TEST_CHECK(shape_is_mesh_instance(owner) == false);
+        if (owner == shapes[i]) {
+            nbShapes += shape_get_mesh_instances_count(owner);
+        }
+    }
+    TEST_CHECK(nbShapes == TEST_SHAPE_NB_CONCURRENT_SHAPES);
+
+    // owners stopping to share release their instances while these are refreshed
+    thread_pool_parallel_for(pool,
+                             TEST_SHAPE_NB_CONCURRENT_SHAPES,
+                             _test_shape_toggle_or_refresh_job,
+                             shapes);
+    for (int i = 0; i < TEST_SHAPE_NB_CONCURRENT_SHAPES; ++i) {
+        shape_refresh_vertices(shapes[i]);
+        TEST_CHECK(shape_get_first_vertex_buffer(shapes[i], false) != NULL);
+        TEST_CHECK(shape_is_mesh_instance(shape_get_mesh_owner(shapes[i])) == false);
+    }
+
+    for (int i = 0; i < TEST_SHAPE_NB_CONCURRENT_SHAPES; ++i) {
+        shape_free(shapes[i]);
+    }
+    thread_pool_free(pool);
+}
+
+void test_shape_mesh_sharing_benchmark(void) {
+    clock_t start;
+    double ms[2];
+    size_t size[2];
+    for (int sharing = 0; sharing < 2; ++sharing) {
+        Shape *src = _test_shape_make_mesh_sharing_source();
+        shape_toggle_mesh_sharing(src, sharing);
+
+        Shape *copies[50];
+        for (int i = 0; i < 50; ++i) {
+            copies[i] = shape_make_copy(src);
+        }
+
+        start = clock();
+        shape_refresh_vertices(src);
+        for (int i = 0; i < 50; ++i) {
+            shape_refresh_vertices(copies[i]);
+        }
+        ms[sharing] = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+        size[sharing] = _test_shape_vertex_buffers_size(src);
+        for (int i = 0; i < 50; ++i) {
+            if (shape_is_mesh_instance(copies[i]) == false) {
+                size[sharing] += _test_shape_vertex_buffers_size(copies[i]);
+            }
+        }
+        TEST_CHECK(shape_is_mesh_instance(copies[49]) == sharing);
+
+        shape_free(src);
+        for (int i = 0; i < 50; ++i) {
+            shape_free(copies[i]);
+        }
+    }
+
+    TEST_CASE_("50 copies: %.1fms, %zuMB -> %.1fms, %zuMB",
+               ms[0],
+               size[0] >> 20,
+               ms[1],
+               size[1] >> 20);
+    TEST_CHECK(size[1] < size[0]);
+}
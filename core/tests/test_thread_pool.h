@@ -0,0 +1,86 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  test_thread_pool.h
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include "thread_pool.h"
+
+static void _test_thread_pool_square_job(void *ctx, const size_t idx) {
+    uint32_t *results = (uint32_t *)ctx;
+    results[idx] = (uint32_t)(idx * idx);
+}
+
+// check that each job runs exactly once, w/ & without workers, and that a pool can run
+// several batches
+void test_thread_pool_parallel_for(void) {
+    TEST_CHECK(thread_pool_get_nb_cores() >= 1);
+
+    uint32_t results[1000];
+    for (uint8_t nbWorkers = 0; nbWorkers <= 4; nbWorkers += 2) {
+        ThreadPool *pool = thread_pool_new(nbWorkers);
+        TEST_ASSERT(pool != NULL);
+        TEST_CHECK(thread_pool_get_nb_workers(pool) == nbWorkers);
+
+        for (int batch = 0; batch < 10; ++batch) {
+            memset(results, 0, sizeof(results));
+            thread_pool_parallel_for(pool, 1000, _test_thread_pool_square_job, results);
+
+            bool ok = true;
+            for (size_t i = 0; i < 1000; ++i) {
+                ok = ok && results[i] == (uint32_t)(i * i);
+            }
+            TEST_CHECK(ok);
+        }
+
+        thread_pool_free(pool);
+    }
+
+    // no pool runs jobs on calling thread
+    memset(results, 0, sizeof(results));
+    thread_pool_parallel_for(NULL, 10, _test_thread_pool_square_job, results);
+    TEST_CHECK(results[9] == 81);
+}
+
+typedef struct {
+    ThreadPool *shared;
+    uint32_t (*results)[500];
+} _TestThreadPoolCallers;
+
+static void _test_thread_pool_caller_job(void *ctx, const size_t idx) {
+    _TestThreadPoolCallers *callers = (_TestThreadPoolCallers *)ctx;
+    thread_pool_parallel_for(callers->shared,
+                             500,
+                             _test_thread_pool_square_job,
+                             callers->results[idx]);
+}
+
+// check that batches submitted concurrently to the same pool are all fully run before their
+// callers return, callers being jobs of another pool
+void test_thread_pool_concurrent_callers(void) {
+    static uint32_t results[8][500];
+    memset(results, 0, sizeof(results));
+
+    ThreadPool *callersPool = thread_pool_new(7);
+    ThreadPool *shared = thread_pool_new(3);
+    TEST_ASSERT(callersPool != NULL && shared != NULL);
+
+    _TestThreadPoolCallers callers = {shared, results};
+    for (int run = 0; run < 20; ++run) {
+        thread_pool_parallel_for(callersPool, 8, _test_thread_pool_caller_job, &callers);
+
+        bool ok = true;
+        for (size_t c = 0; c < 8; ++c) {
+            for (size_t i = 0; i < 500; ++i) {
+                ok = ok && results[c][i] == (uint32_t)(i * i);
+            }
+        }
+        TEST_CHECK(ok);
+        memset(results, 0, sizeof(results));
+    }
+
+    thread_pool_free(shared);
+    thread_pool_free(callersPool);
+}
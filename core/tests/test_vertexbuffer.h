@@ -155,3 +155,111 @@ void test_vertex_buffer_get_lighting_enabled(void) {
 
     vertex_buffer_set_lighting_enabled(previous_value);
 }
+
+// check that all attributes survive a round trip through the compact layout, including the
+// largest values each field can hold
+void test_vertex_attributes_encode_compact(void) {
+    DecodedVertexAttributes d;
+    const VERTEX_LIGHT_STRUCT_T light = {15, 1, 8, 15};
+    CompactVertexAttributes v = vertex_attributes_encode_compact(CHUNK_SIZE,
+                                                                 0,
+                                                                 7,
+                                                                 ATLAS_COLOR_INDEX_MAX_COUNT,
+                                                                 FACE_BACK_CTC,
+                                                                 3,
+                                                                 light);
+    TEST_CHECK(sizeof(CompactVertexAttributes) == 8);
+
+    vertex_attributes_decode_compact(&v, &d);
+    TEST_CHECK(d.x == (float)CHUNK_SIZE);
+    TEST_CHECK(d.y == 0.0f);
+    TEST_CHECK(d.z == 7.0f);
+    TEST_CHECK(d.color == ATLAS_COLOR_INDEX_MAX_COUNT);
+    TEST_CHECK(d.face == FACE_BACK_CTC);
+    TEST_CHECK(d.ao == 3);
+    TEST_CHECK(d.light.ambient == 15);
+    TEST_CHECK(d.light.red == 1);
+    TEST_CHECK(d.light.green == 8);
+    TEST_CHECK(d.light.blue == 15);
+
+    v = vertex_attributes_encode_compact(3,
+                                         CHUNK_SIZE,
+                                         0,
+                                         42,
+                                         FACE_RIGHT_CTC,
+                                         0,
+                                         (VERTEX_LIGHT_STRUCT_T){0, 0, 0, 0});
+    vertex_attributes_decode_compact(&v, &d);
+    TEST_CHECK(d.x == 3.0f);
+    TEST_CHECK(d.y == (float)CHUNK_SIZE);
+    TEST_CHECK(d.z == 0.0f);
+    TEST_CHECK(d.color == 42);
+    TEST_CHECK(d.face == FACE_RIGHT_CTC);
+    TEST_CHECK(d.ao == 0);
+    TEST_CHECK(d.light.ambient == 0 && d.light.red == 0 && d.light.green == 0);
+    TEST_CHECK(d.light.blue == 0);
+}
+
+// check that the float layout metadata is unpacked the same way as shaders do
+void test_vertex_attributes_decode_float(void) {
+    DecodedVertexAttributes d;
+    const FloatVertexAttributes v = {-4.0f,
+                                     12.0f,
+                                     300.0f,
+                                     1234.0f,
+                                     (float)(2 + FACE_TOP_CTC * 4 + 9 * 32 + 3 * 512 + 15 * 8192 +
+                                             1 * 131072)};
+
+    vertex_attributes_decode_float(&v, &d);
+    TEST_CHECK(d.x == -4.0f);
+    TEST_CHECK(d.y == 12.0f);
+    TEST_CHECK(d.z == 300.0f);
+    TEST_CHECK(d.color == 1234);
+    TEST_CHECK(d.ao == 2);
+    TEST_CHECK(d.face == FACE_TOP_CTC);
+    TEST_CHECK(d.light.ambient == 9);
+    TEST_CHECK(d.light.red == 3);
+    TEST_CHECK(d.light.green == 15);
+    TEST_CHECK(d.light.blue == 1);
+}
+
+// check that a single block is written as 6 faces enclosing the block, whichever the layout
+void test_vertex_buffer_write_layout(void) {
+    Shape *s = shape_make();
+    ColorAtlas *atlas = color_atlas_new();
+    TEST_ASSERT(atlas != NULL);
+    shape_set_palette(s, color_palette_new(atlas), false);
+    shape_add_block(s, 1, CHUNK_SIZE + 1, 2, 3, true);
+    shape_refresh_vertices(s);
+
+    // block may be written in the opaque or transparent buffer depending on its color
+    DecodedVertexAttributes d;
+    uint32_t count = 0;
+    uint8_t faces = 0;
+    for (int transparent = 0; transparent < 2; ++transparent) {
+        const VertexBuffer *vb = shape_get_first_vertex_buffer(s, transparent);
+        if (vb == NULL) {
+            continue;
+        }
+        const VertexAttributes *data = vertex_buffer_get_draw_buffer(vb);
+        for (uint32_t i = 0; i < vertex_buffer_get_count(vb); ++i) {
+#if VERTEX_BUFFER_COMPACT_ATTRIBUTES
+            vertex_attributes_decode_compact(&data[i], &d);
+            // compact positions are relative to the origin of the block's chunk
+            d.x += (float)CHUNK_SIZE;
+#else
+            vertex_attributes_decode_float(&data[i], &d);
+#endif
+            TEST_CHECK(d.x == (float)(CHUNK_SIZE + 1) || d.x == (float)(CHUNK_SIZE + 2));
+            TEST_CHECK(d.y == 2.0f || d.y == 3.0f);
+            TEST_CHECK(d.z == 3.0f || d.z == 4.0f);
+            TEST_CHECK(d.face < FACE_COUNT);
+            faces |= (uint8_t)(1 << d.face);
+        }
+        count += vertex_buffer_get_count(vb);
+    }
+    TEST_CHECK(count == FACE_COUNT * DRAWBUFFER_VERTICES_PER_FACE);
+    TEST_CHECK(faces == 0x3F);
+
+    shape_free(s);
+}
@@ -0,0 +1,144 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  xptools/test_channel.hpp
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Channel.hpp"
+
+#define TEST_CHANNEL_NB_MSGS 1000000
+#define TEST_CHANNEL_BATCH 64
+
+typedef struct {
+    int producer;
+    int idx;
+} _TestChannelMsg;
+
+typedef std::shared_ptr<_TestChannelMsg> _TestChannelMsg_SharedPtr;
+
+static double _test_channel_ns_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// uncontended cost per message, for one push+pop at a time & for batches popped at once
+template <typename C>
+static void _test_channel_single_thread(C& channel, double& pushPopNs, double& batchNs) {
+    const _TestChannelMsg_SharedPtr msg = std::make_shared<_TestChannelMsg>();
+    _TestChannelMsg_SharedPtr popped;
+    bool ok = true;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TEST_CHANNEL_NB_MSGS; ++i) {
+        channel.push(msg);
+        ok = channel.pop(popped) && ok;
+    }
+    pushPopNs = _test_channel_ns_since(start) / TEST_CHANNEL_NB_MSGS;
+
+    std::vector<_TestChannelMsg_SharedPtr> msgs;
+    msgs.reserve(TEST_CHANNEL_BATCH);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TEST_CHANNEL_NB_MSGS; i += TEST_CHANNEL_BATCH) {
+        for (int j = 0; j < TEST_CHANNEL_BATCH; ++j) {
+            channel.push(msg);
+        }
+        ok = channel.popAll(msgs) == TEST_CHANNEL_BATCH && ok;
+        msgs.clear();
+    }
+    batchNs = _test_channel_ns_since(start) / TEST_CHANNEL_NB_MSGS;
+
+    TEST_CHECK(ok);
+}
+
+// messages/s from producer threads to the calling thread, checks that each producer's messages
+// are popped in order
+template <typename C>
+static double _test_channel_producers(C& channel, int nbProducers) {
+    const int nbMsgsPerProducer = TEST_CHANNEL_NB_MSGS / nbProducers;
+    std::vector<int> next(static_cast<size_t>(nbProducers), 0);
+    std::vector<std::thread> producers;
+    bool ordered = true;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int p = 0; p < nbProducers; ++p) {
+        producers.push_back(std::thread([&channel, p, nbMsgsPerProducer]() {
+            for (int i = 0; i < nbMsgsPerProducer; ++i) {
+                channel.pushMove(std::make_shared<_TestChannelMsg>(_TestChannelMsg{p, i}));
+            }
+        }));
+    }
+    std::vector<_TestChannelMsg_SharedPtr> msgs;
+    int nbPopped = 0;
+    while (nbPopped < nbMsgsPerProducer * nbProducers) {
+        if (channel.popAll(msgs) == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (const _TestChannelMsg_SharedPtr& msg : msgs) {
+            ordered = ordered && msg->idx == next[static_cast<size_t>(msg->producer)];
+            next[static_cast<size_t>(msg->producer)] = msg->idx + 1;
+        }
+        nbPopped += static_cast<int>(msgs.size());
+        msgs.clear();
+    }
+    const double ns = _test_channel_ns_since(start);
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    TEST_CHECK(ordered);
+    return nbPopped * 1000.0 / ns;
+}
+
+// mutex Channel vs lock-free ring channels, w/ shared_ptr messages
+void test_channel_benchmark(void) {
+    double pushPopNs, batchNs;
+    {
+        vx::Channel<_TestChannelMsg_SharedPtr> channel;
+        _test_channel_single_thread(channel, pushPopNs, batchNs);
+        TEST_CASE_("mutex ns/msg: push+pop %.1f, %d pushes+popAll %.1f",
+                   pushPopNs, TEST_CHANNEL_BATCH, batchNs);
+    }
+    {
+        vx::MPSCChannel<_TestChannelMsg_SharedPtr> channel;
+        _test_channel_single_thread(channel, pushPopNs, batchNs);
+        TEST_CASE_("mpsc ns/msg: push+pop %.1f, %d pushes+popAll %.1f",
+                   pushPopNs, TEST_CHANNEL_BATCH, batchNs);
+    }
+    {
+        vx::SPSCChannel<_TestChannelMsg_SharedPtr> channel;
+        _test_channel_single_thread(channel, pushPopNs, batchNs);
+        TEST_CASE_("spsc ns/msg: push+pop %.1f, %d pushes+popAll %.1f",
+                   pushPopNs, TEST_CHANNEL_BATCH, batchNs);
+    }
+
+    double mutex1, mutex4, mpsc1, mpsc4, spsc1;
+    {
+        vx::Channel<_TestChannelMsg_SharedPtr> channel;
+        mutex1 = _test_channel_producers(channel, 1);
+        mutex4 = _test_channel_producers(channel, 4);
+    }
+    {
+        vx::MPSCChannel<_TestChannelMsg_SharedPtr> channel;
+        mpsc1 = _test_channel_producers(channel, 1);
+        mpsc4 = _test_channel_producers(channel, 4);
+    }
+    {
+        vx::SPSCChannel<_TestChannelMsg_SharedPtr> channel;
+        spsc1 = _test_channel_producers(channel, 1);
+    }
+    TEST_CASE_("M msg/s, 1 producer: mutex %.1f, mpsc %.1f, spsc %.1f", mutex1, mpsc1, spsc1);
+    TEST_CASE_("M msg/s, 4 producers: mutex %.1f, mpsc %.1f", mutex4, mpsc4);
+
+    // tiny ring, most messages go through the overflow queue
+    {
+        vx::MPSCChannel<_TestChannelMsg_SharedPtr> channel(4);
+        _test_channel_producers(channel, 4);
+    }
+}
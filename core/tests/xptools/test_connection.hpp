@@ -0,0 +1,93 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  xptools/test_connection.hpp
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Connection.hpp"
+
+#define TEST_CONNECTION_NB_MSGS 200000
+
+// receives a message the way WS connections used to: fragments appended to a string,
+// then copied into an allocation decoded as a Payload
+static vx::Connection::Payload_SharedPtr _test_connection_receive_copy(std::string& received,
+                                                                       const char *bytes,
+                                                                       size_t len,
+                                                                       size_t nbFragments) {
+    const size_t fragmentLen = len / nbFragments;
+    for (size_t f = 0; f < nbFragments; ++f) {
+        received.append(bytes + f * fragmentLen, f == nbFragments - 1 ? len - f * fragmentLen : fragmentLen);
+    }
+    char *copy = static_cast<char *>(malloc(received.size()));
+    memcpy(copy, received.c_str(), received.size());
+    vx::Connection::Payload_SharedPtr p = vx::Connection::Payload::decode(copy, received.size());
+    received.clear();
+    return p;
+}
+
+// receives a message the way WS connections do: fragments appended to a pooled buffer,
+// adopted (or copied out if small) by the decoded Payload
+static vx::Connection::Payload_SharedPtr _test_connection_receive_pooled(vx::BufferPool::Buffer& received,
+                                                                         const char *bytes,
+                                                                         size_t len,
+                                                                         size_t nbFragments) {
+    const size_t fragmentLen = len / nbFragments;
+    for (size_t f = 0; f < nbFragments; ++f) {
+        vx::BufferPool::shared()->append(received,
+                                         bytes + f * fragmentLen,
+                                         f == nbFragments - 1 ? len - f * fragmentLen : fragmentLen);
+    }
+    vx::Connection::Payload_SharedPtr p = vx::Connection::Payload::decode(received);
+    vx::BufferPool::shared()->release(received);
+    return p;
+}
+
+// messages/s assembling & decoding received messages, then releasing their Payload
+void test_connection_receive_benchmark(void) {
+    const size_t sizes[4] = {64, 1024, 16 * 1024, 16 * 1024};
+    const size_t nbFragments[4] = {1, 1, 1, 4};
+
+    for (int s = 0; s < 4; ++s) {
+        // a Payload w/o metadata: includes byte followed by content
+        std::vector<char> bytes(sizes[s], 'x');
+        bytes[0] = vx::Connection::Payload::Includes::None;
+        bool ok = true;
+
+        std::string copyBuffer;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < TEST_CONNECTION_NB_MSGS; ++i) {
+            vx::Connection::Payload_SharedPtr p = _test_connection_receive_copy(copyBuffer,
+                                                                                bytes.data(),
+                                                                                sizes[s],
+                                                                                nbFragments[s]);
+            ok = ok && p != nullptr && p->contentSize() == sizes[s] - 1;
+        }
+        const double copyS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        vx::BufferPool::Buffer pooledBuffer = {nullptr, 0, 0, false};
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < TEST_CONNECTION_NB_MSGS; ++i) {
+            vx::Connection::Payload_SharedPtr p = _test_connection_receive_pooled(pooledBuffer,
+                                                                                  bytes.data(),
+                                                                                  sizes[s],
+                                                                                  nbFragments[s]);
+            ok = ok && p != nullptr && p->contentSize() == sizes[s] - 1;
+        }
+        const double pooledS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        TEST_CASE_("%zu B, %zu frag(s), M msg/s: copy %.2f, pooled %.2f",
+                   sizes[s],
+                   nbFragments[s],
+                   TEST_CONNECTION_NB_MSGS / copyS / 1000000.0,
+                   TEST_CONNECTION_NB_MSGS / pooledS / 1000000.0);
+        TEST_CHECK(ok);
+    }
+}
@@ -0,0 +1,32 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  xptools/test_list.cpp
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+// xptools benchmarks, only built w/ -DCUBZH_TESTS_BENCHMARKS=ON, see README
+
+#include "acutest.h"
+
+#include "test_channel.hpp"
+#include "test_connection.hpp"
+#include "test_local_connection.hpp"
+#include "test_operation_queue.hpp"
+
+TEST_LIST = {
+
+    // channel
+    {"channel_benchmark", test_channel_benchmark},
+
+    // connection
+    {"connection_receive_benchmark", test_connection_receive_benchmark},
+
+    // local connection
+    {"local_connection_ping_pong_benchmark", test_local_connection_ping_pong_benchmark},
+
+    // operation queue
+    {"operation_queue_dispatch_benchmark", test_operation_queue_dispatch_benchmark},
+    {"operation_queue_timers_benchmark", test_operation_queue_timers_benchmark},
+
+    {NULL, NULL} /* zeroed record marking the end of the list */
+};
@@ -0,0 +1,83 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  xptools/test_local_connection.hpp
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "LocalConnection.hpp"
+
+#define TEST_LOCAL_CONNECTION_NB_ROUND_TRIPS 10000
+
+// sends back everything it receives
+class _TestLocalConnectionEcho final : public vx::ConnectionDelegate {
+public:
+    void connectionDidEstablish(vx::Connection& conn) override {}
+    void connectionDidReceive(vx::Connection& conn,
+                              const vx::Connection::Payload_SharedPtr& payload) override {
+        conn.pushPayloadToWrite(payload);
+    }
+    void connectionDidClose(vx::Connection& conn) override {}
+};
+
+// counts received payloads
+class _TestLocalConnectionCounter final : public vx::ConnectionDelegate {
+public:
+    _TestLocalConnectionCounter() : received(0) {}
+    void connectionDidEstablish(vx::Connection& conn) override {}
+    void connectionDidReceive(vx::Connection& conn,
+                              const vx::Connection::Payload_SharedPtr& payload) override {
+        received.fetch_add(1);
+    }
+    void connectionDidClose(vx::Connection& conn) override {}
+    std::atomic<int> received;
+};
+
+// round trips between a client & a server connected through a pair of local connections,
+// the server echoing each payload
+void test_local_connection_ping_pong_benchmark(void) {
+    vx::LocalConnection_SharedPtr client = std::make_shared<vx::LocalConnection>();
+    vx::LocalConnection_SharedPtr server = std::make_shared<vx::LocalConnection>();
+    client->setPeerConnection(server);
+    server->setPeerConnection(client);
+
+    std::shared_ptr<_TestLocalConnectionCounter> counter =
+        std::make_shared<_TestLocalConnectionCounter>();
+    std::shared_ptr<_TestLocalConnectionEcho> echo = std::make_shared<_TestLocalConnectionEcho>();
+    client->setDelegate(counter);
+    server->setDelegate(echo);
+    client->connect();
+    TEST_ASSERT(client->getStatus() == vx::Connection::Status::OK);
+    TEST_ASSERT(server->getStatus() == vx::Connection::Status::OK);
+
+    std::vector<double> roundTripsUs;
+    roundTripsUs.reserve(TEST_LOCAL_CONNECTION_NB_ROUND_TRIPS);
+    for (int i = 0; i < TEST_LOCAL_CONNECTION_NB_ROUND_TRIPS; ++i) {
+        char *content = static_cast<char *>(calloc(16, 1));
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        client->pushPayloadToWrite(vx::Connection::Payload::create(content, 16));
+        while (counter->received.load() <= i) {
+            std::this_thread::yield();
+        }
+        roundTripsUs.push_back(std::chrono::duration<double, std::micro>(
+                                   std::chrono::steady_clock::now() - start).count());
+    }
+
+    client->close();
+    TEST_CHECK(server->isClosed());
+
+    std::sort(roundTripsUs.begin(), roundTripsUs.end());
+    TEST_CASE_("us: p50 %.1f, p99 %.1f, max %.1f",
+               roundTripsUs[roundTripsUs.size() / 2],
+               roundTripsUs[roundTripsUs.size() * 99 / 100],
+               roundTripsUs.back());
+    TEST_CHECK(counter->received.load() == TEST_LOCAL_CONNECTION_NB_ROUND_TRIPS);
+}
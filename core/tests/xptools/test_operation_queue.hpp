@@ -0,0 +1,138 @@
+// -------------------------------------------------------------
+//  Cubzh Core Unit Tests
+//  xptools/test_operation_queue.hpp
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "OperationQueue.hpp"
+
+#define TEST_OPERATION_QUEUE_NB_OPS 100000
+#define TEST_OPERATION_QUEUE_NB_LATENCY_OPS 1000
+
+typedef std::chrono::steady_clock _TestOperationQueueClock;
+
+static double _test_operation_queue_us_since(_TestOperationQueueClock::time_point start) {
+    return std::chrono::duration<double, std::micro>(_TestOperationQueueClock::now() - start).count();
+}
+
+// throughput of small operations dispatched to the background queue, and latency from
+// dispatch to start of operations dispatched one at a time
+void test_operation_queue_dispatch_benchmark(void) {
+    vx::OperationQueue *queue = vx::OperationQueue::getBackground();
+    std::atomic<int> done(0);
+
+    _TestOperationQueueClock::time_point start = _TestOperationQueueClock::now();
+    for (int i = 0; i < TEST_OPERATION_QUEUE_NB_OPS; ++i) {
+        queue->dispatch([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+    }
+    while (done.load() < TEST_OPERATION_QUEUE_NB_OPS) {
+        std::this_thread::yield();
+    }
+    const double throughputUs = _test_operation_queue_us_since(start);
+
+    double latencyUs = 0.0, maxLatencyUs = 0.0;
+    for (int i = 0; i < TEST_OPERATION_QUEUE_NB_LATENCY_OPS; ++i) {
+        std::atomic<bool> started(false);
+        double opLatencyUs = 0.0;
+        const _TestOperationQueueClock::time_point dispatched = _TestOperationQueueClock::now();
+        queue->dispatch([&started, &opLatencyUs, dispatched]() {
+            opLatencyUs = _test_operation_queue_us_since(dispatched);
+            started.store(true);
+        });
+        while (started.load() == false) {
+            std::this_thread::yield();
+        }
+        latencyUs += opLatencyUs;
+        maxLatencyUs = opLatencyUs > maxLatencyUs ? opLatencyUs : maxLatencyUs;
+    }
+
+    TEST_CASE_("%d ops: %.0f ops/s, latency: avg %.1fus, max %.1fus",
+               TEST_OPERATION_QUEUE_NB_OPS,
+               TEST_OPERATION_QUEUE_NB_OPS * 1000000.0 / throughputUs,
+               latencyUs / TEST_OPERATION_QUEUE_NB_LATENCY_OPS,
+               maxLatencyUs);
+
+    // 3 producers, operations dispatching more operations, priority & scheduled operations
+    vx::OperationQueue *slow = vx::OperationQueue::getSlowBackground();
+    std::atomic<int> stressDone(0);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 3; ++p) {
+        producers.push_back(std::thread([slow, &stressDone]() {
+            for (int i = 0; i < 1000; ++i) {
+                slow->dispatch([slow, &stressDone]() {
+                    slow->dispatch([&stressDone]() { stressDone.fetch_add(1); });
+                    stressDone.fetch_add(1);
+                });
+                slow->dispatchFirst([&stressDone]() { stressDone.fetch_add(1); });
+                if (i % 100 == 0) {
+                    slow->schedule([&stressDone]() { stressDone.fetch_add(1); }, 1);
+                }
+            }
+        }));
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    const int stressExpected = 3 * (1000 * 3 + 10);
+    start = _TestOperationQueueClock::now();
+    while (stressDone.load() < stressExpected && _test_operation_queue_us_since(start) < 5000000.0) {
+        std::this_thread::yield();
+    }
+    TEST_CHECK(stressDone.load() == stressExpected);
+}
+
+#define TEST_OPERATION_QUEUE_NB_TIMERS 50000
+#define TEST_OPERATION_QUEUE_NB_DELAYS 100
+
+// timers spread over a few distinct delays (many due at the same time), half of them cancelled,
+// all remaining ones must fire
+void test_operation_queue_timers_benchmark(void) {
+    vx::OperationQueue *queue = vx::OperationQueue::getBackground();
+    std::vector<vx::OperationQueue::TimerID> ids(TEST_OPERATION_QUEUE_NB_TIMERS);
+    std::atomic<int> fired(0);
+    std::atomic<int64_t> maxLateUs(0);
+
+    _TestOperationQueueClock::time_point start = _TestOperationQueueClock::now();
+    for (int i = 0; i < TEST_OPERATION_QUEUE_NB_TIMERS; ++i) {
+        const uint64_t ms = 100 + static_cast<uint64_t>(i % TEST_OPERATION_QUEUE_NB_DELAYS);
+        const _TestOperationQueueClock::time_point due = _TestOperationQueueClock::now() +
+                                                         std::chrono::milliseconds(ms);
+        ids[i] = queue->schedule([&fired, &maxLateUs, due]() {
+            const int64_t lateUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                       _TestOperationQueueClock::now() - due).count();
+            int64_t max = maxLateUs.load();
+            while (lateUs > max && maxLateUs.compare_exchange_weak(max, lateUs) == false) {}
+            fired.fetch_add(1);
+        }, ms);
+    }
+    const double scheduleUs = _test_operation_queue_us_since(start);
+
+    start = _TestOperationQueueClock::now();
+    bool cancelled = true;
+    for (int i = 0; i < TEST_OPERATION_QUEUE_NB_TIMERS; i += 2) {
+        cancelled = queue->cancel(ids[i]) && cancelled;
+    }
+    const double cancelUs = _test_operation_queue_us_since(start);
+    TEST_CHECK(cancelled);
+
+    const int expected = TEST_OPERATION_QUEUE_NB_TIMERS / 2;
+    start = _TestOperationQueueClock::now();
+    while (fired.load() < expected && _test_operation_queue_us_since(start) < 5000000.0) {
+        std::this_thread::yield();
+    }
+    // cancelled timers must not fire either
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    TEST_CASE_("ms: schedule %.1f, cancel half %.1f, max late %.2f",
+               scheduleUs / 1000.0,
+               cancelUs / 1000.0,
+               static_cast<double>(maxLateUs.load()) / 1000.0);
+    TEST_CHECK(fired.load() == expected);
+}
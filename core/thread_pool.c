@@ -0,0 +1,272 @@
+// -------------------------------------------------------------
+//  Cubzh Core
+//  thread_pool.c
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#include "thread_pool.h"
+
+// C
+#include <stdlib.h>
+
+// Core
+#include "cclog.h"
+
+#if defined(__VX_PLATFORM_WINDOWS)
+
+#include <windows.h>
+
+typedef HANDLE _Thread;
+typedef CRITICAL_SECTION _Lock;
+typedef CONDITION_VARIABLE _Cond;
+
+#define _lock_init(l) InitializeCriticalSection(l)
+#define _lock_destroy(l) DeleteCriticalSection(l)
+#define _lock(l) EnterCriticalSection(l)
+#define _unlock(l) LeaveCriticalSection(l)
+#define _cond_init(c) InitializeConditionVariable(c)
+#define _cond_destroy(c)
+#define _cond_wait(c, l) SleepConditionVariableCS(c, l, INFINITE)
+#define _cond_broadcast(c) WakeAllConditionVariable(c)
+
+#else // non-Windows platforms
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_t _Thread;
+typedef pthread_mutex_t _Lock;
+typedef pthread_cond_t _Cond;
+
+#define _lock_init(l) pthread_mutex_init(l, NULL)
+#define _lock_destroy(l) pthread_mutex_destroy(l)
+#define _lock(l) pthread_mutex_lock(l)
+#define _unlock(l) pthread_mutex_unlock(l)
+#define _cond_init(c) pthread_cond_init(c, NULL)
+#define _cond_destroy(c) pthread_cond_destroy(c)
+#define _cond_wait(c, l) pthread_cond_wait(c, l)
+#define _cond_broadcast(c) pthread_cond_broadcast(c)
+
+#endif // defined(__VX_PLATFORM_WINDOWS)
+
+/// Jobs of a single thread_pool_parallel_for call, lives on the caller's stack
+typedef struct {
+    thread_pool_job_func func;
+    void *ctx;
+    size_t count;
+    // next job index to be taken, and number of jobs done
+    size_t next;
+    size_t done;
+} _ThreadPoolBatch;
+
+struct _ThreadPool {
+    _Thread *threads;
+    // batch being run, NULL between batches
+    _ThreadPoolBatch *current;
+    // incremented for each batch, lets workers tell a new batch from a spurious wake up
+    uint32_t batchID;
+
+    // guards current batch & stop
+    _Lock lock;
+    // held by the caller for a whole batch, serializes concurrent callers
+    _Lock submitLock;
+    // signaled when a batch starts, or when the pool is freed
+    _Cond wakeCond;
+    // signaled when the last job of a batch is done
+    _Cond doneCond;
+
+    uint8_t nbWorkers;
+    bool stop;
+
+    char pad[2];
+};
+
+#if defined(__VX_PLATFORM_WINDOWS)
+static SRWLOCK _sharedLock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t _sharedLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// MARK: - Private functions -
+
+/// Takes & runs jobs until there are none left in given batch, lock must be held
+static void _thread_pool_run_jobs(ThreadPool *pool, _ThreadPoolBatch *batch) {
+    size_t idx;
+    while (batch->next < batch->count) {
+        idx = batch->next++;
+        _unlock(&pool->lock);
+        batch->func(batch->ctx, idx);
+        _lock(&pool->lock);
+        if (++batch->done == batch->count) {
+            _cond_broadcast(&pool->doneCond);
+        }
+    }
+}
+
+#if defined(__VX_PLATFORM_WINDOWS)
+static DWORD WINAPI _thread_pool_worker(LPVOID arg) {
+#else
+static void *_thread_pool_worker(void *arg) {
+#endif
+    ThreadPool *pool = (ThreadPool *)arg;
+    uint32_t batchID = 0;
+
+    _lock(&pool->lock);
+    while (true) {
+        while (pool->stop == false && (pool->current == NULL || pool->batchID == batchID)) {
+            _cond_wait(&pool->wakeCond, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        batchID = pool->batchID;
+        _thread_pool_run_jobs(pool, pool->current);
+    }
+    _unlock(&pool->lock);
+
+#if defined(__VX_PLATFORM_WINDOWS)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+// MARK: - Public functions -
+
+uint8_t thread_pool_get_nb_cores(void) {
+    long nbCores;
+#if defined(__VX_PLATFORM_WASM)
+    nbCores = 1;
+#elif defined(__VX_PLATFORM_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    nbCores = (long)info.dwNumberOfProcessors;
+#else
+    nbCores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (nbCores < 1) {
+        return 1;
+    }
+    return nbCores > UINT8_MAX ? UINT8_MAX : (uint8_t)nbCores;
+}
+
+ThreadPool *thread_pool_new(const uint8_t nbWorkers) {
+    ThreadPool *pool = (ThreadPool *)malloc(sizeof(ThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->current = NULL;
+    pool->batchID = 0;
+    pool->stop = false;
+    _lock_init(&pool->lock);
+    _lock_init(&pool->submitLock);
+    _cond_init(&pool->wakeCond);
+    _cond_init(&pool->doneCond);
+
+    pool->nbWorkers = 0;
+    pool->threads = NULL;
+#if !defined(__VX_PLATFORM_WASM)
+    if (nbWorkers > 0) {
+        pool->threads = (_Thread *)malloc(nbWorkers * sizeof(_Thread));
+    }
+    if (pool->threads != NULL) {
+        for (uint8_t i = 0; i < nbWorkers; ++i) {
+#if defined(__VX_PLATFORM_WINDOWS)
+            pool->threads[i] = CreateThread(NULL, 0, _thread_pool_worker, pool, 0, NULL);
+            const bool ok = pool->threads[i] != NULL;
+#else
+            const bool ok = pthread_create(&pool->threads[i], NULL, _thread_pool_worker, pool) ==
+                            0;
+#endif
+            if (ok == false) {
+                cclog_error("thread_pool_new: failed to create worker %d", i);
+                break;
+            }
+            pool->nbWorkers++;
+        }
+    }
+#endif
+
+    return pool;
+}
+
+void thread_pool_free(ThreadPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    // waits for a running batch to be done, its jobs may still be using workers
+    _lock(&pool->submitLock);
+    _lock(&pool->lock);
+    pool->stop = true;
+    _cond_broadcast(&pool->wakeCond);
+    _unlock(&pool->lock);
+    _unlock(&pool->submitLock);
+
+    for (uint8_t i = 0; i < pool->nbWorkers; ++i) {
+#if defined(__VX_PLATFORM_WINDOWS)
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+#else
+        pthread_join(pool->threads[i], NULL);
+#endif
+    }
+    free(pool->threads);
+
+    _cond_destroy(&pool->doneCond);
+    _cond_destroy(&pool->wakeCond);
+    _lock_destroy(&pool->submitLock);
+    _lock_destroy(&pool->lock);
+    free(pool);
+}
+
+uint8_t thread_pool_get_nb_workers(const ThreadPool *pool) {
+    return pool->nbWorkers;
+}
+
+void thread_pool_parallel_for(ThreadPool *pool,
+                              const size_t count,
+                              thread_pool_job_func func,
+                              void *ctx) {
+    if (count == 0) {
+        return;
+    }
+    if (pool == NULL || pool->nbWorkers == 0 || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(ctx, i);
+        }
+        return;
+    }
+
+    _ThreadPoolBatch batch = {func, ctx, count, 0, 0};
+
+    _lock(&pool->submitLock);
+    _lock(&pool->lock);
+    pool->current = &batch;
+    pool->batchID++;
+    _cond_broadcast(&pool->wakeCond);
+
+    _thread_pool_run_jobs(pool, &batch);
+    while (batch.done < batch.count) {
+        _cond_wait(&pool->doneCond, &pool->lock);
+    }
+    pool->current = NULL;
+    _unlock(&pool->lock);
+    _unlock(&pool->submitLock);
+}
+
+void thread_pool_shared_lock(void) {
+#if defined(__VX_PLATFORM_WINDOWS)
+    AcquireSRWLockExclusive(&_sharedLock);
+#else
+    pthread_mutex_lock(&_sharedLock);
+#endif
+}
+
+void thread_pool_shared_unlock(void) {
+#if defined(__VX_PLATFORM_WINDOWS)
+    ReleaseSRWLockExclusive(&_sharedLock);
+#else
+    pthread_mutex_unlock(&_sharedLock);
+#endif
+}
@@ -0,0 +1,47 @@
+// -------------------------------------------------------------
+//  Cubzh Core
+//  thread_pool.h
+//  Created on October 16, 2026.
+// -------------------------------------------------------------
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Fixed set of worker threads used to split CPU-bound work, e.g. chunk meshing. Workers sleep
+/// while there is nothing to do. On platforms without threads (wasm), a pool has no workers and
+/// all jobs run on the calling thread
+typedef struct _ThreadPool ThreadPool;
+
+/// A job receives the context given to thread_pool_parallel_for & its index in [0, count)
+typedef void (*thread_pool_job_func)(void *ctx, const size_t idx);
+
+/// Number of logical cores available, at least 1
+uint8_t thread_pool_get_nb_cores(void);
+
+ThreadPool *thread_pool_new(const uint8_t nbWorkers);
+void thread_pool_free(ThreadPool *pool);
+uint8_t thread_pool_get_nb_workers(const ThreadPool *pool);
+
+/// Runs func for each index in [0, count) & returns once all jobs are done. The calling thread
+/// takes jobs too, jobs order isn't guaranteed. Concurrent callers on the same pool run their
+/// batches one after the other. Must not be called from one of the pool's own jobs
+void thread_pool_parallel_for(ThreadPool *pool,
+                              const size_t count,
+                              thread_pool_job_func func,
+                              void *ctx);
+
+/// Process-wide lock, usable before any pool exists. Guards pools shared through globals, from
+/// their lazy creation to their release
+void thread_pool_shared_lock(void);
+void thread_pool_shared_unlock(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -45,6 +45,8 @@
 #define TRANSFORM_FLAG_ANIMATIONS 8
 // helper to debug a specific transform
 #define TRANSFORM_FLAG_DEBUG 16
+// flag used by the scene to skip branches w/ nothing to refresh or simulate, see scene_refresh
+#define TRANSFORM_FLAG_IDLE_BRANCH 32
 
 #if DEBUG_TRANSFORM
 static int debug_transform_refresh_calls = 0;
@@ -344,6 +346,9 @@ bool transform_ensure_rigidbody(Transform *t,
     bool isNew = false;
     if (t->rigidBody == NULL) {
         t->rigidBody = rigidbody_new(mode, groups, collidesWith);
+        if (t->rigidBody != NULL) {
+            rigidbody_set_transform(t->rigidBody, t);
+        }
         isNew = true;
     } else {
         rigidbody_set_simulation_mode(t->rigidBody, mode);
@@ -363,6 +368,9 @@ bool transform_ensure_rigidbody_copy(Transform *t, const Transform *other) {
 
     if (t->rigidBody == NULL) {
         t->rigidBody = rigidbody_new_copy(other->rigidBody);
+        if (t->rigidBody != NULL) {
+            rigidbody_set_transform(t->rigidBody, t);
+        }
     } else {
         rigidbody_set_collider(t->rigidBody, rigidbody_get_collider(other->rigidBody), false);
         rigidbody_set_constant_acceleration(t->rigidBody,
@@ -478,6 +486,9 @@ bool transform_set_parent(Transform *t, Transform *parent, bool keepWorld) {
     t->parent = parent;
     doubly_linked_list_push_last(parent->children, t);
     parent->childrenCount++;
+
+    // new parent branch has to be refreshed w/ this transform
+    transform_set_idle_branch(parent, false);
     return true;
 }
 
@@ -567,6 +578,23 @@ void transform_set_hidden_branch(Transform *t, bool value) {
     _transform_toggle_flag(t, TRANSFORM_FLAG_HIDDEN_BRANCH, value);
 }
 
+bool transform_is_idle_branch(Transform *t) {
+    return _transform_get_flag(t, TRANSFORM_FLAG_IDLE_BRANCH);
+}
+
+void transform_set_idle_branch(Transform *t, bool value) {
+    if (value) {
+        _transform_toggle_flag(t, TRANSFORM_FLAG_IDLE_BRANCH, true);
+        return;
+    }
+
+    // an idle branch cannot contain an active transform, wake up ancestors until an active one
+    while (t != NULL && _transform_get_flag(t, TRANSFORM_FLAG_IDLE_BRANCH)) {
+        _transform_toggle_flag(t, TRANSFORM_FLAG_IDLE_BRANCH, false);
+        t = t->parent;
+    }
+}
+
 bool transform_is_hidden_self(Transform *t) {
     return _transform_get_flag(t, TRANSFORM_FLAG_HIDDEN_SELF);
 }
@@ -1216,6 +1244,7 @@ static void _transform_set_dirty(Transform *const t, const uint8_t flag, bool ke
     } else {
         t->dirty |= (flag | TRANSFORM_DIRTY_CACHE);
     }
+    transform_set_idle_branch(t, false);
 }
 
 static void _transform_reset_dirty(Transform *const t, const uint8_t flag) {
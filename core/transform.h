@@ -126,6 +126,10 @@ TransformType transform_get_type(const Transform *t);
 bool transform_recurse(Transform *t, pointer_transform_recurse_func f, void *ptr, bool deepFirst);
 bool transform_is_hidden_branch(Transform *t);
 void transform_set_hidden_branch(Transform *t, bool value);
+/// An idle branch has nothing to refresh or simulate, it is flagged & then skipped by the scene
+/// refresh until woken up by any change, which also wakes up all idle ancestors
+bool transform_is_idle_branch(Transform *t);
+void transform_set_idle_branch(Transform *t, bool value);
 bool transform_is_hidden_self(Transform *t);
 void transform_set_hidden_self(Transform *t, bool value);
 bool transform_is_hidden(Transform *t);
@@ -14,6 +14,7 @@
 #include "chunk.h"
 #include "config.h"
 #include "filo_list_uint32.h"
+#include "thread_pool.h"
 
 #ifdef DEBUG
 #define VERTEX_BUFFER_DEBUG 1
@@ -28,24 +29,32 @@
 // when implementing renderers (like Swift/Metal renderer)
 // Giving each vertex buffer a proper ID is useful to know when
 // they need to be referenced/unreferenced
+// Shapes may be meshed on several threads, IDs are guarded by thread_pool_shared_lock
 static uint32_t vertex_buffer_next_id = 0;
 static FiloListUInt32 *vertex_buffer_destroyed_ids = NULL;
 
 static uint32_t vertex_buffer_get_new_id(void) {
+    thread_pool_shared_lock();
     uint32_t i = vertex_buffer_next_id;
-    vertex_buffer_next_id++; // TODO: mutex
+    vertex_buffer_next_id++;
+    thread_pool_shared_unlock();
     return i;
 }
 
 static void vertex_buffer_add_destroyed_id(uint32_t id) {
+    thread_pool_shared_lock();
     if (vertex_buffer_destroyed_ids == NULL) {
         vertex_buffer_destroyed_ids = filo_list_uint32_new();
     }
     filo_list_uint32_push(vertex_buffer_destroyed_ids, id);
+    thread_pool_shared_unlock();
 }
 
 bool vertex_buffer_pop_destroyed_id(uint32_t *id) {
-    return filo_list_uint32_pop(vertex_buffer_destroyed_ids, id);
+    thread_pool_shared_lock();
+    const bool popped = filo_list_uint32_pop(vertex_buffer_destroyed_ids, id);
+    thread_pool_shared_unlock();
+    return popped;
 }
 
 struct _VertexBufferMemArea {
@@ -725,6 +734,59 @@ VertexAttributes *_vertex_buffer_data_add_ptr(VertexAttributes *ptr, size_t coun
     return ptr;
 }
 
+//---------------------
+// MARK: Vertex encoding
+//---------------------
+
+CompactVertexAttributes vertex_attributes_encode_compact(const CHUNK_COORDS_INT_T x,
+                                                         const CHUNK_COORDS_INT_T y,
+                                                         const CHUNK_COORDS_INT_T z,
+                                                         const ATLAS_COLOR_INDEX_INT_T color,
+                                                         const FACE_INDEX_INT_T face,
+                                                         const uint8_t ao,
+                                                         const VERTEX_LIGHT_STRUCT_T light) {
+    vx_assert(x >= 0 && x <= CHUNK_SIZE && y >= 0 && y <= CHUNK_SIZE && z >= 0 && z <= CHUNK_SIZE);
+    vx_assert(color <= ATLAS_COLOR_INDEX_MAX_COUNT);
+
+    const uint32_t packedLight = (uint32_t)light.ambient | (uint32_t)light.red << 4 |
+                                 (uint32_t)light.green << 8 | (uint32_t)light.blue << 12;
+
+    CompactVertexAttributes v;
+    v.posLight = ((uint32_t)x & 0x1F) | ((uint32_t)y & 0x1F) << 5 | ((uint32_t)z & 0x1F) << 10 |
+                 packedLight << 15;
+    v.colorMeta = (color & 0x1FFFF) | ((uint32_t)face & 0x07) << 17 | ((uint32_t)ao & 0x03) << 20;
+    return v;
+}
+
+void vertex_attributes_decode_compact(const CompactVertexAttributes *v,
+                                      DecodedVertexAttributes *out) {
+    out->x = (float)(v->posLight & 0x1F);
+    out->y = (float)(v->posLight >> 5 & 0x1F);
+    out->z = (float)(v->posLight >> 10 & 0x1F);
+    out->light.ambient = TO_UINT4(v->posLight >> 15);
+    out->light.red = TO_UINT4(v->posLight >> 19);
+    out->light.green = TO_UINT4(v->posLight >> 23);
+    out->light.blue = TO_UINT4(v->posLight >> 27);
+    out->color = v->colorMeta & 0x1FFFF;
+    out->face = (FACE_INDEX_INT_T)(v->colorMeta >> 17 & 0x07);
+    out->ao = (uint8_t)(v->colorMeta >> 20 & 0x03);
+}
+
+void vertex_attributes_decode_float(const FloatVertexAttributes *v, DecodedVertexAttributes *out) {
+    const uint32_t metadata = (uint32_t)v->metadata;
+
+    out->x = v->x;
+    out->y = v->y;
+    out->z = v->z;
+    out->color = (ATLAS_COLOR_INDEX_INT_T)v->color;
+    out->ao = (uint8_t)(metadata & 0x03);
+    out->face = (FACE_INDEX_INT_T)(metadata >> 2 & 0x07);
+    out->light.ambient = TO_UINT4(metadata >> 5);
+    out->light.red = TO_UINT4(metadata >> 9);
+    out->light.green = TO_UINT4(metadata >> 13);
+    out->light.blue = TO_UINT4(metadata >> 17);
+}
+
 //---------------------
 // MARK: VertexBufferMemArea
 //---------------------
@@ -967,6 +1029,38 @@ void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
                                          VERTEX_LIGHT_STRUCT_T vlight2,
                                          VERTEX_LIGHT_STRUCT_T vlight3,
                                          VERTEX_LIGHT_STRUCT_T vlight4) {
+    vertex_buffer_mem_area_writer_write_quad(vbmaw,
+                                             x,
+                                             y,
+                                             z,
+                                             1.0f,
+                                             1.0f,
+                                             1.0f,
+                                             color,
+                                             faceIndex,
+                                             ao,
+                                             vLighting,
+                                             vlight1,
+                                             vlight2,
+                                             vlight3,
+                                             vlight4);
+}
+
+void vertex_buffer_mem_area_writer_write_quad(VertexBufferMemAreaWriter *vbmaw,
+                                              float x,
+                                              float y,
+                                              float z,
+                                              float width,
+                                              float height,
+                                              float depth,
+                                              ATLAS_COLOR_INDEX_INT_T color,
+                                              FACE_INDEX_INT_T faceIndex,
+                                              FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
+                                              bool vLighting,
+                                              VERTEX_LIGHT_STRUCT_T vlight1,
+                                              VERTEX_LIGHT_STRUCT_T vlight2,
+                                              VERTEX_LIGHT_STRUCT_T vlight3,
+                                              VERTEX_LIGHT_STRUCT_T vlight4) {
 
     // check if no vbma assigned or the end of the memory area has been reached
     if (vbmaw->vbma == NULL || vbmaw->writtenCount == vbmaw->vbma->count) {
@@ -1127,12 +1221,6 @@ void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
     // Local indices in vbma from its cursor pointers
     const uint32_t vbma_idxVertices = vbmaw->writtenCount;
 
-    // For metadata packing,
-    // - AO index (2 bits)
-    // - face index (3 bits)
-    // - vertex lighting SRGB (4 bits each)
-    const uint8_t packed_faceIndex = (uint8_t)(faceIndex * 4);
-    float packed_srgb1, packed_srgb2, packed_srgb3, packed_srgb4;
     if (vLighting) {
         // Dim global lighting ambient value with AO
         vlight1.ambient = TO_UINT4(
@@ -1143,69 +1231,114 @@ void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
             maximum(0, (uint8_t)(vlight3.ambient * 0.9f + 0.1f) - AO_GRADIENT[ao.ao3]));
         vlight4.ambient = TO_UINT4(
             maximum(0, (uint8_t)(vlight4.ambient * 0.9f + 0.1f) - AO_GRADIENT[ao.ao4]));
-
-        packed_srgb1 = vlight1.ambient * 32 + vlight1.red * 512 + vlight1.green * 8192 +
-                       vlight1.blue * 131072;
-        packed_srgb2 = vlight2.ambient * 32 + vlight2.red * 512 + vlight2.green * 8192 +
-                       vlight2.blue * 131072;
-        packed_srgb3 = vlight3.ambient * 32 + vlight3.red * 512 + vlight3.green * 8192 +
-                       vlight3.blue * 131072;
-        packed_srgb4 = vlight4.ambient * 32 + vlight4.red * 512 + vlight4.green * 8192 +
-                       vlight4.blue * 131072;
     } else {
-        packed_srgb1 = packed_srgb2 = packed_srgb3 = packed_srgb4 = 0.0f;
+        vlight1 = vlight2 = vlight3 = vlight4 = (VERTEX_LIGHT_STRUCT_T){0, 0, 0, 0};
     }
-    const float v1_metadata = (float)(ao.ao1 + packed_faceIndex + packed_srgb1);
-    const float v2_metadata = (float)(ao.ao2 + packed_faceIndex + packed_srgb2);
-    const float v3_metadata = (float)(ao.ao3 + packed_faceIndex + packed_srgb3);
-    const float v4_metadata = (float)(ao.ao4 + packed_faceIndex + packed_srgb4);
 
-    // Vertex attributes
-    VertexAttributes v1, v2, v3, v4;
+    // Vertices positions
+    float3 p1, p2, p3, p4;
     switch (faceIndex) {
         case FACE_RIGHT_CTC: {
-            v1 = (VertexAttributes){x + 1.0f, y + 1.0f, z, (float)color, v1_metadata};
-            v2 = (VertexAttributes){x + 1.0f, y, z, (float)color, v2_metadata};
-            v3 = (VertexAttributes){x + 1.0f, y, z + 1.0f, (float)color, v3_metadata};
-            v4 = (VertexAttributes){x + 1.0f, y + 1.0f, z + 1.0f, (float)color, v4_metadata};
+            p1 = (float3){x + width, y + height, z};
+            p2 = (float3){x + width, y, z};
+            p3 = (float3){x + width, y, z + depth};
+            p4 = (float3){x + width, y + height, z + depth};
             break;
         }
         case FACE_LEFT_CTC: {
-            v1 = (VertexAttributes){x, y, z, (float)color, v1_metadata};
-            v2 = (VertexAttributes){x, y + 1.0f, z, (float)color, v2_metadata};
-            v3 = (VertexAttributes){x, y + 1.0f, z + 1.0f, (float)color, v3_metadata};
-            v4 = (VertexAttributes){x, y, z + 1.0f, (float)color, v4_metadata};
+            p1 = (float3){x, y, z};
+            p2 = (float3){x, y + height, z};
+            p3 = (float3){x, y + height, z + depth};
+            p4 = (float3){x, y, z + depth};
             break;
         }
         case FACE_TOP_CTC: {
-            v1 = (VertexAttributes){x + 1.0f, y + 1.0f, z, (float)color, v1_metadata};
-            v2 = (VertexAttributes){x + 1.0f, y + 1.0f, z + 1.0f, (float)color, v2_metadata};
-            v3 = (VertexAttributes){x, y + 1.0f, z + 1.0f, (float)color, v3_metadata};
-            v4 = (VertexAttributes){x, y + 1.0f, z, (float)color, v4_metadata};
+            p1 = (float3){x + width, y + height, z};
+            p2 = (float3){x + width, y + height, z + depth};
+            p3 = (float3){x, y + height, z + depth};
+            p4 = (float3){x, y + height, z};
             break;
         }
         case FACE_DOWN_CTC: {
-            v1 = (VertexAttributes){x, y, z, (float)color, v1_metadata};
-            v2 = (VertexAttributes){x, y, z + 1.0f, (float)color, v2_metadata};
-            v3 = (VertexAttributes){x + 1.0f, y, z + 1.0f, (float)color, v3_metadata};
-            v4 = (VertexAttributes){x + 1.0f, y, z, (float)color, v4_metadata};
+            p1 = (float3){x, y, z};
+            p2 = (float3){x, y, z + depth};
+            p3 = (float3){x + width, y, z + depth};
+            p4 = (float3){x + width, y, z};
             break;
         }
         case FACE_FRONT_CTC: {
-            v1 = (VertexAttributes){x, y, z + 1.0f, (float)color, v1_metadata};
-            v2 = (VertexAttributes){x, y + 1.0f, z + 1.0f, (float)color, v2_metadata};
-            v3 = (VertexAttributes){x + 1.0f, y + 1.0f, z + 1.0f, (float)color, v3_metadata};
-            v4 = (VertexAttributes){x + 1.0f, y, z + 1.0f, (float)color, v4_metadata};
+            p1 = (float3){x, y, z + depth};
+            p2 = (float3){x, y + height, z + depth};
+            p3 = (float3){x + width, y + height, z + depth};
+            p4 = (float3){x + width, y, z + depth};
             break;
         }
-        case FACE_BACK_CTC: {
-            v1 = (VertexAttributes){x, y + 1.0f, z, (float)color, v1_metadata};
-            v2 = (VertexAttributes){x, y, z, (float)color, v2_metadata};
-            v3 = (VertexAttributes){x + 1.0f, y, z, (float)color, v3_metadata};
-            v4 = (VertexAttributes){x + 1.0f, y + 1.0f, z, (float)color, v4_metadata};
+        case FACE_BACK_CTC:
+        default: {
+            p1 = (float3){x, y + height, z};
+            p2 = (float3){x, y, z};
+            p3 = (float3){x + width, y, z};
+            p4 = (float3){x + width, y + height, z};
             break;
         }
     }
+
+    // Vertex attributes
+    VertexAttributes v1, v2, v3, v4;
+#if VERTEX_BUFFER_COMPACT_ATTRIBUTES
+    const SHAPE_COORDS_INT3_T o = chunk_get_origin(vbmaw->c);
+    v1 = vertex_attributes_encode_compact((CHUNK_COORDS_INT_T)(p1.x - o.x),
+                                          (CHUNK_COORDS_INT_T)(p1.y - o.y),
+                                          (CHUNK_COORDS_INT_T)(p1.z - o.z),
+                                          color,
+                                          faceIndex,
+                                          ao.ao1,
+                                          vlight1);
+    v2 = vertex_attributes_encode_compact((CHUNK_COORDS_INT_T)(p2.x - o.x),
+                                          (CHUNK_COORDS_INT_T)(p2.y - o.y),
+                                          (CHUNK_COORDS_INT_T)(p2.z - o.z),
+                                          color,
+                                          faceIndex,
+                                          ao.ao2,
+                                          vlight2);
+    v3 = vertex_attributes_encode_compact((CHUNK_COORDS_INT_T)(p3.x - o.x),
+                                          (CHUNK_COORDS_INT_T)(p3.y - o.y),
+                                          (CHUNK_COORDS_INT_T)(p3.z - o.z),
+                                          color,
+                                          faceIndex,
+                                          ao.ao3,
+                                          vlight3);
+    v4 = vertex_attributes_encode_compact((CHUNK_COORDS_INT_T)(p4.x - o.x),
+                                          (CHUNK_COORDS_INT_T)(p4.y - o.y),
+                                          (CHUNK_COORDS_INT_T)(p4.z - o.z),
+                                          color,
+                                          faceIndex,
+                                          ao.ao4,
+                                          vlight4);
+#else
+    // For metadata packing,
+    // - AO index (2 bits)
+    // - face index (3 bits)
+    // - vertex lighting SRGB (4 bits each)
+    const uint8_t packed_faceIndex = (uint8_t)(faceIndex * 4);
+    const float packed_srgb1 = vlight1.ambient * 32 + vlight1.red * 512 + vlight1.green * 8192 +
+                               vlight1.blue * 131072;
+    const float packed_srgb2 = vlight2.ambient * 32 + vlight2.red * 512 + vlight2.green * 8192 +
+                               vlight2.blue * 131072;
+    const float packed_srgb3 = vlight3.ambient * 32 + vlight3.red * 512 + vlight3.green * 8192 +
+                               vlight3.blue * 131072;
+    const float packed_srgb4 = vlight4.ambient * 32 + vlight4.red * 512 + vlight4.green * 8192 +
+                               vlight4.blue * 131072;
+    const float v1_metadata = (float)(ao.ao1 + packed_faceIndex + packed_srgb1);
+    const float v2_metadata = (float)(ao.ao2 + packed_faceIndex + packed_srgb2);
+    const float v3_metadata = (float)(ao.ao3 + packed_faceIndex + packed_srgb3);
+    const float v4_metadata = (float)(ao.ao4 + packed_faceIndex + packed_srgb4);
+
+    v1 = (VertexAttributes){p1.x, p1.y, p1.z, (float)color, v1_metadata};
+    v2 = (VertexAttributes){p2.x, p2.y, p2.z, (float)color, v2_metadata};
+    v3 = (VertexAttributes){p3.x, p3.y, p3.z, (float)color, v3_metadata};
+    v4 = (VertexAttributes){p4.x, p4.y, p4.z, (float)color, v4_metadata};
+#endif
     if (aoShift) {
         vbmaw->cursor[vbma_idxVertices] = v1;
         vbmaw->cursor[vbma_idxVertices + 1] = v2;
@@ -24,10 +24,31 @@ typedef struct _Chunk Chunk;
 // MARK: Draw buffers size per face
 //---------------------
 
+// Default layout, 20 bytes per vertex: position in shape space, atlas color index & metadata
+// packing AO (2 bits), face index (3 bits) and vertex light (4 bits per channel)
 struct {
     float x, y, z, color;
     float metadata;
-} typedef VertexAttributes;
+} typedef FloatVertexAttributes;
+
+// Compact layout, 8 bytes per vertex, see VERTEX_BUFFER_COMPACT_ATTRIBUTES,
+// - position: 5-bit coordinates relative to the chunk origin, in [0, CHUNK_SIZE]
+// - light: ambient, red, green, blue (4 bits each)
+// - color: atlas color index (17 bits)
+// - face index (3 bits) & AO index (2 bits)
+// Bits layout,
+// - posLight: x (0-4), y (5-9), z (10-14), light (15-30)
+// - colorMeta: color (0-16), face (17-19), AO (20-21)
+struct {
+    uint32_t posLight;
+    uint32_t colorMeta;
+} typedef CompactVertexAttributes;
+
+#if VERTEX_BUFFER_COMPACT_ATTRIBUTES
+typedef CompactVertexAttributes VertexAttributes;
+#else
+typedef FloatVertexAttributes VertexAttributes;
+#endif
 
 #define DRAWBUFFER_VERTICES_BYTES sizeof(VertexAttributes)
 #define DRAWBUFFER_VERTICES_PER_FACE 4
@@ -69,8 +90,52 @@ void vertex_buffer_mem_area_writer_write(VertexBufferMemAreaWriter *vbmaw,
                                          VERTEX_LIGHT_STRUCT_T vlight3,
                                          VERTEX_LIGHT_STRUCT_T vlight4);
 
+/// Writes a face spanning several blocks, as produced by greedy meshing. Sizes are given in
+/// blocks along each axis, the size along the face normal should be 1
+void vertex_buffer_mem_area_writer_write_quad(VertexBufferMemAreaWriter *vbmaw,
+                                              float x,
+                                              float y,
+                                              float z,
+                                              float width,
+                                              float height,
+                                              float depth,
+                                              ATLAS_COLOR_INDEX_INT_T color,
+                                              FACE_INDEX_INT_T index,
+                                              FACE_AMBIENT_OCCLUSION_STRUCT_T ao,
+                                              bool vLighting,
+                                              VERTEX_LIGHT_STRUCT_T vlight1,
+                                              VERTEX_LIGHT_STRUCT_T vlight2,
+                                              VERTEX_LIGHT_STRUCT_T vlight3,
+                                              VERTEX_LIGHT_STRUCT_T vlight4);
+
 void vertex_buffer_mem_area_writer_done(VertexBufferMemAreaWriter *vbmaw);
 
+//---------------------
+// MARK: Vertex encoding
+//---------------------
+
+/// Vertex attributes unpacked from either layout, mostly useful for tests & debugging
+struct {
+    float x, y, z;
+    ATLAS_COLOR_INDEX_INT_T color;
+    VERTEX_LIGHT_STRUCT_T light;
+    FACE_INDEX_INT_T face;
+    uint8_t ao;
+} typedef DecodedVertexAttributes;
+
+CompactVertexAttributes vertex_attributes_encode_compact(const CHUNK_COORDS_INT_T x,
+                                                         const CHUNK_COORDS_INT_T y,
+                                                         const CHUNK_COORDS_INT_T z,
+                                                         const ATLAS_COLOR_INDEX_INT_T color,
+                                                         const FACE_INDEX_INT_T face,
+                                                         const uint8_t ao,
+                                                         const VERTEX_LIGHT_STRUCT_T light);
+/// Position is decoded relative to the chunk origin
+void vertex_attributes_decode_compact(const CompactVertexAttributes *v,
+                                      DecodedVertexAttributes *out);
+/// Position is decoded in shape space
+void vertex_attributes_decode_float(const FloatVertexAttributes *v, DecodedVertexAttributes *out);
+
 // a vb may optionally write to a lighting buffer ie. if it belongs to the map shape w/ octree
 VertexBuffer *vertex_buffer_new(bool transparent);
 VertexBuffer *vertex_buffer_new_with_max_count(uint32_t n, bool transparent);
@@ -10,13 +10,116 @@
 // C++
 #include <chrono>
 #include <cstring>
+#include <thread>
 
 #include "vxlog.h"
 
 #define PAYLOAD_DIFF_NOT_POSSIBLE UINT32_MAX
 
+// max number of buffers kept by the pool, extra ones are freed on release
+#define BUFFER_POOL_MAX_BUFFERS 64
+// buffers bigger than this are freed on release, not to retain memory after a large message
+#define BUFFER_POOL_MAX_RETAINED_CAPACITY (256 * 1024)
+// capacity of new buffers, to avoid growing them for most messages
+#define BUFFER_POOL_MIN_CAPACITY 4096
+// a decoded Payload copies its bytes instead of adopting the buffer if they fill less than
+// 1/ratio of it, small messages kept around would otherwise retain a full buffer each
+#define BUFFER_POOL_COPY_OUT_RATIO 4
+
 using namespace vx;
 
+//
+// BufferPool
+//
+
+BufferPool *BufferPool::shared() {
+    static BufferPool *pool = new BufferPool();
+    return pool;
+}
+
+BufferPool::BufferPool() :
+_buffers(),
+_buffersLocked(false) {
+    // reserved, so that _buffers never allocates while locked
+    _buffers.reserve(BUFFER_POOL_MAX_BUFFERS);
+}
+
+void BufferPool::_lock() {
+    while (_buffersLocked.exchange(true, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void BufferPool::_unlock() {
+    _buffersLocked.store(false, std::memory_order_release);
+}
+
+bool BufferPool::append(Buffer& buffer, const char *bytes, size_t len) {
+    if (buffer.failed) {
+        return false;
+    }
+    if (buffer.bytes == nullptr) {
+        _lock();
+        if (_buffers.empty() == false) {
+            buffer = _buffers.back();
+            _buffers.pop_back();
+        }
+        _unlock();
+        if (buffer.bytes == nullptr) {
+            const size_t capacity = len > BUFFER_POOL_MIN_CAPACITY ? len : BUFFER_POOL_MIN_CAPACITY;
+            buffer.bytes = static_cast<char*>(malloc(capacity));
+            if (buffer.bytes == nullptr) {
+                buffer.capacity = 0;
+                buffer.failed = true;
+                return false;
+            }
+            buffer.capacity = capacity;
+        }
+        buffer.size = 0;
+    }
+    
+    if (buffer.size + len > buffer.capacity) {
+        size_t capacity = buffer.capacity * 2;
+        if (capacity < buffer.size + len) {
+            capacity = buffer.size + len;
+        }
+        char *grown = static_cast<char*>(realloc(buffer.bytes, capacity));
+        if (grown == nullptr) {
+            buffer.failed = true;
+            return false;
+        }
+        buffer.bytes = grown;
+        buffer.capacity = capacity;
+    }
+    
+    if (len > 0) {
+        memcpy(buffer.bytes + buffer.size, bytes, len);
+        buffer.size += len;
+    }
+    return true;
+}
+
+void BufferPool::release(Buffer& buffer) {
+    buffer.failed = false;
+    if (buffer.bytes == nullptr) { return; }
+    
+    bool retained = false;
+    if (buffer.capacity <= BUFFER_POOL_MAX_RETAINED_CAPACITY) {
+        _lock();
+        if (_buffers.size() < BUFFER_POOL_MAX_BUFFERS) {
+            _buffers.push_back(buffer);
+            retained = true;
+        }
+        _unlock();
+    }
+    if (retained == false) {
+        free(buffer.bytes);
+    }
+    buffer.bytes = nullptr;
+    buffer.size = 0;
+    buffer.capacity = 0;
+}
+
 //
 // Payload
 //
@@ -47,32 +150,70 @@ Connection::Payload_SharedPtr Connection::Payload::decode(char *bytes, size_t le
     if (len < 1) return nullptr;
     
     Payload *p = new Payload();
-    
     p->_decoded = bytes;
-    char *cursor = p->_decoded;
+    p->_decode(len);
     
-    memcpy(&p->_includes, cursor, sizeof(uint8_t));
+    return Payload_SharedPtr(p);
+}
+
+Connection::Payload_SharedPtr Connection::Payload::decode(BufferPool::Buffer& buffer) {
+    
+    if (buffer.bytes == nullptr) return nullptr;
+    if (buffer.size < 1) return nullptr;
+    if (buffer.failed) return nullptr;
+    
+    Payload *p = new Payload();
+    
+    // small messages are copied, the buffer goes back to the pool right away
+    char *copy = nullptr;
+    if (buffer.size <= buffer.capacity / BUFFER_POOL_COPY_OUT_RATIO) {
+        copy = static_cast<char*>(malloc(buffer.size));
+    }
+    if (copy != nullptr) {
+        memcpy(copy, buffer.bytes, buffer.size);
+        p->_decoded = copy;
+        p->_decode(buffer.size);
+        BufferPool::shared()->release(buffer);
+    } else {
+        p->_decoded = buffer.bytes;
+        p->_decodedCapacity = buffer.capacity;
+        p->_decode(buffer.size);
+        
+        // bytes now owned by Payload
+        buffer.bytes = nullptr;
+        buffer.size = 0;
+        buffer.capacity = 0;
+    }
+    
+    return Payload_SharedPtr(p);
+}
+
+void Connection::Payload::_decode(size_t len) {
+    
+    char *cursor = _decoded;
+    
+    memcpy(&_includes, cursor, sizeof(uint8_t));
     cursor += sizeof(uint8_t);
     
-    if (p->_includes & Includes::PayloadID) {
-        memcpy(&p->_id, cursor, sizeof(IDType));
+    if (_includes & Includes::PayloadID) {
+        memcpy(&_id, cursor, sizeof(IDType));
         cursor += sizeof(IDType);
     }
     
-    if (p->_includes & Includes::CreatedAt) {
-        memcpy(&p->_createdAt, cursor, sizeof(uint64_t));
+    if (_includes & Includes::CreatedAt) {
+        memcpy(&_createdAt, cursor, sizeof(uint64_t));
         cursor += sizeof(uint64_t);
     }
     
-    if (p->_includes & Includes::TravelHistory) {
+    if (_includes & Includes::TravelHistory) {
         
-        p->_steps = std::vector<Step>();
+        _steps = std::vector<Step>();
         uint8_t nbSteps = 0;
         memcpy(&nbSteps, cursor, sizeof(uint8_t));
         cursor += sizeof(uint8_t);
+        _steps.reserve(nbSteps);
         
         uint8_t nameSize;
-        char nameBuf[256];
         
         for (uint8_t i = 0; i < nbSteps; ++i) {
             Step s;
@@ -81,23 +222,19 @@ Connection::Payload_SharedPtr Connection::Payload::decode(char *bytes, size_t le
             memcpy(&nameSize, cursor, sizeof(uint8_t));
             cursor += sizeof(uint8_t);
             
-            memcpy(nameBuf, cursor, nameSize);
+            s.name.assign(cursor, nameSize);
             cursor += nameSize;
-            nameBuf[nameSize] = '\0';
-            s.name = std::string(nameBuf);
             
             memcpy(&s.diff, cursor, sizeof(uint32_t));
             cursor += sizeof(uint32_t);
             
-            p->_steps.push_back(s);
+            _steps.push_back(std::move(s));
         }
     }
     
     // content starts where cursor is
-    p->_content = cursor;
-    p->_len = len - (cursor - bytes);
-    
-    return Payload_SharedPtr(p);
+    _content = cursor;
+    _len = len - static_cast<size_t>(cursor - _decoded);
 }
 
 Connection::Payload_SharedPtr Connection::Payload::copy(const Payload_SharedPtr& p) {
@@ -132,6 +269,7 @@ Connection::Payload::Payload(char* bytes, size_t len, uint8_t includes) {
     _includes = includes;
     _content = bytes;
     _decoded = nullptr;
+    _decodedCapacity = 0;
     _len = len;
     _metadataSizeCache = 0;
     _metadata = nullptr;
@@ -205,6 +343,7 @@ Connection::Payload::Payload() {
     _includes = Includes::None;
     _content = nullptr;
     _decoded = nullptr;
+    _decodedCapacity = 0;
     _len = 0;
     _metadataSizeCache = 0;
     _metadata = nullptr;
@@ -214,7 +353,11 @@ Connection::Payload::Payload() {
 
 Connection::Payload::~Payload() {
     if (_content != nullptr) {
-        if (_decoded != nullptr) {
+        if (_decodedCapacity > 0) {
+            BufferPool::Buffer buffer = { _decoded, 0, _decodedCapacity, false };
+            BufferPool::shared()->release(buffer);
+            _decoded = nullptr;
+        } else if (_decoded != nullptr) {
             free(_decoded);
             _decoded = nullptr;
         } else {
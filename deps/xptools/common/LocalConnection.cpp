@@ -20,7 +20,9 @@ _status(Connection::Status::IDLE),
 _statusMutex(),
 _thread(),
 _threadShouldExit(false),
-_threadShouldExitMutex(),
+_receivedBytes(),
+_receivedBytesMutex(),
+_receivedBytesCondition(),
 _peerConnection() {
     _thread = std::thread(&LocalConnection::_threadFunction, this);
 }
@@ -38,7 +40,11 @@ void LocalConnection::pushReceivedBytes(const Payload_SharedPtr& payload) {
         vxlog_warning("[LocalConnection::write] pushing received bytes to a closed connection");
         return;
     }
-    _receivedBytes.push(payload);
+    {
+        std::lock_guard<std::mutex> lock(_receivedBytesMutex);
+        _receivedBytes.push(payload);
+    }
+    _receivedBytesCondition.notify_one();
 }
 
 Connection::Status LocalConnection::getStatus() {
@@ -136,33 +142,38 @@ void LocalConnection::closeOnError() {
 }
     
 void LocalConnection::_threadFunction() {
-    Payload_SharedPtr payload = nullptr;
+    std::queue<Payload_SharedPtr> payloads;
     while (true) {
         {
-            std::lock_guard<std::mutex> lock(_threadShouldExitMutex);
+            std::unique_lock<std::mutex> lock(_receivedBytesMutex);
+            _receivedBytesCondition.wait(lock, [this]() {
+                return this->_threadShouldExit || this->_receivedBytes.empty() == false;
+            });
             if (this->_threadShouldExit == true) {
                 return;
             }
+            // take everything received so far, delegate is called without holding the lock
+            std::swap(payloads, _receivedBytes);
         }
-        if (_receivedBytes.pop(payload)) {
-            std::shared_ptr<ConnectionDelegate> delegate = getDelegate().lock();
+        std::shared_ptr<ConnectionDelegate> delegate = getDelegate().lock();
+        while (payloads.empty() == false) {
             if (delegate != nullptr) {
-                delegate->connectionDidReceive(*this, payload);
-                payload = nullptr;
+                delegate->connectionDidReceive(*this, payloads.front());
             } else {
                 vxlog_warning("[LocalConnection::_threadFunction] bytes are dropped");
             }
+            payloads.pop();
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 }
 
 void LocalConnection::_stopThread() {
     if (_thread.joinable()) {
         {
-            std::lock_guard<std::mutex> lock(_threadShouldExitMutex);
+            std::lock_guard<std::mutex> lock(_receivedBytesMutex);
             this->_threadShouldExit = true;
         }
+        _receivedBytesCondition.notify_one();
         _thread.join();
         vxlog_debug("[LocalConnection::_stopThread] %p", this);
     }
@@ -7,14 +7,32 @@
 
 #include "OperationQueue.hpp"
 
-#include <queue>
+#include <algorithm>
 #include <thread>
 
-#define MAX_OPERATIONS_PER_CYCLE 10
-#define SLEEP_TIME_BETWEEN_CYCLES 16 // in ms
+// background queue workers, one core is left to the main thread
+#define BACKGROUND_MAX_WORKERS 8
+// slow operations are mostly waiting (disk, network), they don't need a core each
+#define SLOW_BACKGROUND_WORKERS 2
+// cancelled timers are removed from the heap once they make up half of it, past this size
+#define TIMERS_COMPACTION_MIN_SIZE 64
 
 using namespace vx;
 
+namespace {
+/// async queue & worker index of the calling thread, tasks it dispatches go to its own queue
+thread_local OperationQueue *currentQueue = nullptr;
+thread_local size_t currentWorker = 0;
+
+/// heap comparator, the top timer is due first, in scheduling order for a same due time
+struct TimerIsLater {
+    template <typename T>
+    bool operator()(const T& t1, const T& t2) const {
+        return t1.due > t2.due || (t1.due == t2.due && t1.id > t2.id);
+    }
+};
+}
+
 OperationQueue *OperationQueue::getMain() {
     if (_mainQueue == nullptr) {
         _mainQueue = new OperationQueue(Type::sync);
@@ -31,102 +49,133 @@ OperationQueue *OperationQueue::getServerMain() {
 
 OperationQueue *OperationQueue::getBackground() {
     if (_backgroundQueue == nullptr) {
-        _backgroundQueue = new OperationQueue(Type::async);
+        const size_t nbCores = std::thread::hardware_concurrency();
+        size_t nbWorkers = nbCores > 1 ? nbCores - 1 : 1;
+        nbWorkers = std::min(nbWorkers, static_cast<size_t>(BACKGROUND_MAX_WORKERS));
+        _backgroundQueue = new OperationQueue(Type::async, nbWorkers);
     }
     return _backgroundQueue;
 }
 
 OperationQueue *OperationQueue::getSlowBackground() {
     if (_slowBackgroundQueue == nullptr) {
-        _slowBackgroundQueue = new OperationQueue(Type::async);
+        _slowBackgroundQueue = new OperationQueue(Type::async, SLOW_BACKGROUND_WORKERS);
     }
     return _slowBackgroundQueue;
 }
 
-OperationQueue::OperationQueue(Type type) :
+OperationQueue *OperationQueue::getSerialBackground() {
+    if (_serialBackgroundQueue == nullptr) {
+        _serialBackgroundQueue = new OperationQueue(Type::async, 1);
+    }
+    return _serialBackgroundQueue;
+}
+
+OperationQueue::OperationQueue(Type type, size_t nbWorkers) :
 _queue(),
-_queueScheduled() {
+_timers(),
+_activeTimers(),
+_nextTimerID(1),
+_workers(),
+_nbWorkers(type == Type::async ? std::max(nbWorkers, static_cast<size_t>(1)) : 0),
+_nextWorker(0),
+_nbPending(0),
+_nbSleeping(0),
+_stopping(false) {
     _type = type;
     _state = State::idle;
-    // create a thread object that doesn't represent an execution thread
-    _thread = std::thread();
+    if (_nbWorkers > 0) {
+        _workers.reset(new Worker[_nbWorkers]);
+    }
 }
 
 OperationQueue::~OperationQueue() {
-    
+    {
+        const std::lock_guard<std::mutex> wakeLocker(_wakeLock);
+        _stopping = true;
+    }
+    _wakeCondition.notify_all();
+    for (size_t i = 0; i < _nbWorkers; ++i) {
+        if (_workers[i].thread.joinable()) {
+            _workers[i].thread.join();
+        }
+    }
 }
 
 /// dispatch and copy
 void OperationQueue::dispatch(const fp_t& op) {
-    {
-        const std::lock_guard<std::mutex> locker(this->_lock);
-        _queue.push_back(op);
-    }
-    this->startThreadIfNeeded();
+    this->dispatch(fp_t(op));
 }
 
 /// dispatch and move
 void OperationQueue::dispatch(fp_t&& op) {
-    {
-        const std::lock_guard<std::mutex> locker(this->_lock);
-        _queue.push_back(std::move(op));
+    if (_type == Type::async) {
+        this->pushOperation(std::move(op));
+        return;
     }
-    this->startThreadIfNeeded();
+    const std::lock_guard<std::mutex> locker(this->_lock);
+    _queue.push_back(std::move(op));
 }
 
 /// dispatch (in front of queue) and copy
 void OperationQueue::dispatchFirst(const fp_t& op) {
-    {
-        const std::lock_guard<std::mutex> locker(this->_lock);
-        _queue.push_front(op);
-    }
-    this->startThreadIfNeeded();
+    this->dispatchFirst(fp_t(op));
 }
 
 /// dispatch (in front of queue) and move
 void OperationQueue::dispatchFirst(fp_t&& op) {
-    {
-        const std::lock_guard<std::mutex> locker(this->_lock);
-        _queue.push_front(std::move(op));
+    if (_type == Type::async) {
+        this->pushPriorityOperation(std::move(op));
+        return;
     }
-    this->startThreadIfNeeded();
+    const std::lock_guard<std::mutex> locker(this->_lock);
+    _queue.push_front(std::move(op));
 }
 
-void OperationQueue::schedule(const fp_t& op, uint64_t ms) {
+OperationQueue::TimerID OperationQueue::schedule(const fp_t& op, uint64_t ms) {
+    return this->schedule(fp_t(op), ms);
+}
+
+OperationQueue::TimerID OperationQueue::schedule(fp_t&& op, uint64_t ms) {
+    TimerID id;
     {
         const std::lock_guard<std::mutex> locker(this->_lock);
-        using namespace std::chrono;
-        system_clock::time_point tp = system_clock::now() + milliseconds(ms);
-        time_t t = system_clock::to_time_t(tp);
-        _queueScheduled[t] = op;
+        id = this->pushTimer(std::move(op), ms);
     }
     this->startThreadIfNeeded();
+    this->wakeWorker();
+    return id;
 }
 
-void OperationQueue::schedule(const fp_t&& op, uint64_t ms) {
-    {
-        const std::lock_guard<std::mutex> locker(this->_lock);
-        using namespace std::chrono;
-        uint64_t now = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-        uint64_t date = now + ms;
-        _queueScheduled[date] = std::move(op);
+bool OperationQueue::cancel(TimerID id) {
+    const std::lock_guard<std::mutex> locker(this->_lock);
+    if (_activeTimers.erase(id) == 0) {
+        return false;
     }
-    this->startThreadIfNeeded();
+    // drop cancelled timers when they make up most of the heap
+    if (_timers.size() > TIMERS_COMPACTION_MIN_SIZE && _activeTimers.size() * 2 < _timers.size()) {
+        _timers.erase(std::remove_if(_timers.begin(),
+                                     _timers.end(),
+                                     [this](const Timer& t) {
+                                         return _activeTimers.count(t.id) == 0;
+                                     }),
+                      _timers.end());
+        std::make_heap(_timers.begin(), _timers.end(), TimerIsLater());
+    }
+    return true;
 }
 
 void OperationQueue::callFirstDispatchedBlocks(size_t n) {
+    if (_type == Type::async) {
+        return; // async queues are drained by their workers
+    }
     bool skipScheduled = false;
     while (n > 0) {
         std::unique_lock<std::mutex> lock(_lock); // constructor does lock mutex
 
-        if (skipScheduled == false && _queueScheduled.empty() == false) {
-            using namespace std::chrono;
-            uint64_t now = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-            
-            std::pair<uint64_t,fp_t> entry = *(_queueScheduled.begin());
-            if (entry.first <= now) {
-                fp_t op = entry.second;
-                _queueScheduled.erase(_queueScheduled.begin());
+        if (skipScheduled == false) {
+            fp_t op;
+            if (this->popDueTimer(std::chrono::steady_clock::now(), op)) {
                 // unlock before calling op()
                 // because op() could need to add something in the queue
                 lock.unlock();
@@ -169,69 +218,182 @@ OperationQueue *OperationQueue::_backgroundQueue = nullptr;
 ///
 OperationQueue *OperationQueue::_slowBackgroundQueue = nullptr;
 
+///
+OperationQueue *OperationQueue::_serialBackgroundQueue = nullptr;
+
 ///
 void OperationQueue::startThreadIfNeeded() {
     if (_type != Type::async) {
         return; // only async operation queues can have a thread
     }
+    // workers are started once, dispatching only has to lock until then
+    if (_state.load(std::memory_order_acquire) == State::runningInBackground) {
+        return;
+    }
     const std::lock_guard<std::mutex> locker(_lock);
-    if (_state != State::runningInBackground) {
-        _state = State::runningInBackground;
-        if (_thread.joinable()) {
-            _thread.join();
+    if (_state.load(std::memory_order_relaxed) != State::runningInBackground) {
+        for (size_t i = 0; i < _nbWorkers; ++i) {
+            _workers[i].thread = std::thread(&OperationQueue::threadFunction, this, i);
         }
-        _thread = std::thread(&OperationQueue::threadFunction, this);
-    } // else thread is already running
+        _state.store(State::runningInBackground, std::memory_order_release);
+    } // else workers are already running
 }
 
 ///
-void OperationQueue::threadFunction() {
-    std::unique_lock<std::mutex> locker(_lock, std::defer_lock);
-    uint64_t now;
-    std::queue<fp_t> operations;
-    std::map<uint64_t,fp_t>::iterator itScheduled;
-    std::pair<uint64_t,fp_t> opScheduled;
-    fp_t op;
-    int n;
-
-    while (true) {
-        n = 0;
-        locker.lock();
+OperationQueue::TimerID OperationQueue::pushTimer(fp_t&& op, uint64_t ms) {
+    const TimerID id = _nextTimerID++;
+    Timer t;
+    t.due = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    t.id = id;
+    t.op = std::move(op);
+    _timers.push_back(std::move(t));
+    std::push_heap(_timers.begin(), _timers.end(), TimerIsLater());
+    _activeTimers.insert(id);
+    return id;
+}
 
-        if (_queue.empty() && _queueScheduled.empty()) {
-            _state = State::idle;
-            locker.unlock();
-            break;
+///
+bool OperationQueue::popDueTimer(std::chrono::steady_clock::time_point now, fp_t& op) {
+    while (_timers.empty() == false && _timers.front().due <= now) {
+        std::pop_heap(_timers.begin(), _timers.end(), TimerIsLater());
+        const bool active = _activeTimers.erase(_timers.back().id) > 0;
+        if (active) {
+            op = std::move(_timers.back().op);
+        }
+        _timers.pop_back();
+        if (active) {
+            return true;
         }
+    }
+    return false;
+}
+
+///
+bool OperationQueue::getNextTimerDue(std::chrono::steady_clock::time_point& due) {
+    while (_timers.empty() == false && _activeTimers.count(_timers.front().id) == 0) {
+        std::pop_heap(_timers.begin(), _timers.end(), TimerIsLater());
+        _timers.pop_back();
+    }
+    if (_timers.empty()) {
+        return false;
+    }
+    due = _timers.front().due;
+    return true;
+}
+
+///
+void OperationQueue::pushOperation(fp_t&& op) {
+    this->startThreadIfNeeded();
 
-        if (_queueScheduled.empty() == false) {
-            // TODO: _queueScheduled -> std::list<std::pair<uint64_t,fp_t>>
-            now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-            itScheduled = _queueScheduled.begin();
+    const size_t worker = currentQueue == this ? currentWorker : _nextWorker++ % _nbWorkers;
+    {
+        const std::lock_guard<std::mutex> locker(_workers[worker].lock);
+        _workers[worker].queue.push_back(std::move(op));
+    }
+    ++_nbPending;
+    this->wakeWorker();
+}
 
-            opScheduled = *(itScheduled);
+///
+void OperationQueue::pushPriorityOperation(fp_t&& op) {
+    this->startThreadIfNeeded();
 
-            if (opScheduled.first <= now) {
-                operations.push(opScheduled.second);
-                ++n;
-                _queueScheduled.erase(itScheduled);
-            }
+    {
+        const std::lock_guard<std::mutex> locker(_lock);
+        _queue.push_front(std::move(op));
+    }
+    ++_nbPending;
+    this->wakeWorker();
+}
+
+///
+void OperationQueue::wakeWorker() {
+    // a worker only goes to sleep while holding the wake lock, after checking for pending tasks:
+    // taking the lock here ensures it is either already waiting, or will see the new task
+    bool sleeping;
+    {
+        const std::lock_guard<std::mutex> wakeLocker(_wakeLock);
+        sleeping = _nbSleeping > 0;
+    }
+    if (sleeping) {
+        _wakeCondition.notify_one();
+    }
+}
+
+///
+bool OperationQueue::popOperation(size_t worker, fp_t& op) {
+    {
+        const std::lock_guard<std::mutex> locker(_lock);
+
+        if (this->popDueTimer(std::chrono::steady_clock::now(), op)) {
+            return true;
         }
-        
-        while (_queue.empty() == false && n < MAX_OPERATIONS_PER_CYCLE) {
-            operations.push(_queue.front());
-            ++n;
+
+        if (_nbPending == 0) {
+            return false;
+        }
+
+        if (_queue.empty() == false) {
+            op = std::move(_queue.front());
             _queue.pop_front();
+            --_nbPending;
+            return true;
         }
+    }
+
+    // own queue first, then steal from the others
+    for (size_t i = 0; i < _nbWorkers; ++i) {
+        Worker& w = _workers[(worker + i) % _nbWorkers];
+        const std::lock_guard<std::mutex> locker(w.lock);
+        if (w.queue.empty() == false) {
+            if (i == 0) {
+                op = std::move(w.queue.front());
+                w.queue.pop_front();
+            } else {
+                op = std::move(w.queue.back());
+                w.queue.pop_back();
+            }
+            --_nbPending;
+            return true;
+        }
+    }
+    return false;
+}
+
+///
+void OperationQueue::threadFunction(size_t worker) {
+    currentQueue = this;
+    currentWorker = worker;
 
-        locker.unlock();
+    fp_t op;
+    bool hasScheduled;
+    std::chrono::steady_clock::time_point nextScheduled;
 
-        while (operations.empty() == false) {
-            op = operations.front();
-            operations.pop();
+    while (true) {
+        if (this->popOperation(worker, op)) {
             op();
+            op = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> wakeLocker(_wakeLock);
+        if (_stopping) {
+            break;
+        }
+        if (_nbPending > 0) {
+            continue; // a task was dispatched since popOperation
+        }
+        {
+            const std::lock_guard<std::mutex> locker(_lock);
+            hasScheduled = this->getNextTimerDue(nextScheduled);
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(SLEEP_TIME_BETWEEN_CYCLES));
+        ++_nbSleeping;
+        if (hasScheduled) {
+            _wakeCondition.wait_until(wakeLocker, nextScheduled);
+        } else {
+            _wakeCondition.wait(wakeLocker);
+        }
+        --_nbSleeping;
     }
 }
@@ -45,7 +45,7 @@ _wsi(nullptr),
 _wsi(0),
 #endif
 _wsiMutex(),
-_receivedBytesBuffer(),
+_receivedBytesBuffer({nullptr, 0, 0, false}),
 _isWriting(false),
 _isWritingMutex(),
 _payloadsToWrite(),
@@ -64,6 +64,7 @@ WSConnection::~WSConnection() {
     // free all payloads waiting, if there are any
     _payloadsToWrite.clear();
     _payloadBeingWritten = nullptr;
+    BufferPool::shared()->release(_receivedBytesBuffer);
     
 #ifdef __VX_USE_LIBWEBSOCKETS
 #else // EMSCRIPTEN
@@ -189,7 +190,7 @@ void WSConnection::reset() {
     _payloadBeingWritten = nullptr;
     _written = 0;
     
-    _receivedBytesBuffer.clear();
+    BufferPool::shared()->release(_receivedBytesBuffer);
     
 #ifdef __VX_USE_LIBWEBSOCKETS
     setWsi(nullptr);
@@ -317,21 +318,18 @@ Connection::Payload_SharedPtr WSConnection::_getPayloadToWrite() {
 void WSConnection::receivedBytes(char *bytes,
                                  const size_t len,
                                  const bool isFinalFragment) {
-    // append received bytes
-    if (len > 0) {
-        _receivedBytesBuffer.append(bytes, len);
+    // append received bytes, assembled in a pooled buffer adopted by the decoded Payload
+    if (len > 0 && BufferPool::shared()->append(_receivedBytesBuffer, bytes, len) == false) {
+        // message is dropped at its final fragment, see Payload::decode
+        vxlog_error("[WSConnection::receivedBytes] can't allocate receive buffer");
     }
     
     if (isFinalFragment) {
         // notify delegate
         std::shared_ptr<ConnectionDelegate> delegate = getDelegate().lock();
         if (delegate != nullptr) {
-            char *bytes = reinterpret_cast<char*>(malloc(_receivedBytesBuffer.size()));
-            if (bytes != nullptr) {
-                memcpy(bytes, _receivedBytesBuffer.c_str(), _receivedBytesBuffer.size());
-
-                Payload_SharedPtr pld = Payload::decode(bytes, _receivedBytesBuffer.size());
-                
+            Payload_SharedPtr pld = Payload::decode(_receivedBytesBuffer);
+            if (pld != nullptr) {
                 pld->step("WSConnection::receivedBytes");
                 
                 delegate->connectionDidReceive(*this, pld);
@@ -339,7 +337,8 @@ void WSConnection::receivedBytes(char *bytes,
                 vxlog_error("[WSConnection::receivedBytes] dropped bytes");
             }
         }
-        _receivedBytesBuffer.clear();
+        // no-op if buffer has been adopted by Payload
+        BufferPool::shared()->release(_receivedBytesBuffer);
     }
 }
 
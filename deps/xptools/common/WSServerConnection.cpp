@@ -28,12 +28,14 @@ _server(parentServer),
 _payloadsToWrite(),
 _status(Connection::Status::IDLE),
 _statusMutex(),
-_receivedBytesBuffer(),
+_receivedBytesBuffer({nullptr, 0, 0, false}),
 _isWriting(false),
 _isWritingMutex(),
 _written(0) {}
 
-WSServerConnection::~WSServerConnection() {}
+WSServerConnection::~WSServerConnection() {
+    BufferPool::shared()->release(_receivedBytesBuffer);
+}
 
 // --------------------------------------------------
 // "Connection" interface implementation
@@ -117,28 +119,27 @@ void WSServerConnection::_setWsi(lws *wsi) {
 void WSServerConnection::receivedBytes(char *bytes,
                                        const size_t len,
                                        const bool isFinalFragment) {
-    // append received bytes
-    if (len > 0) {
-        _receivedBytesBuffer.append(bytes, len);
+    // append received bytes, assembled in a pooled buffer adopted by the decoded Payload
+    if (len > 0 && BufferPool::shared()->append(_receivedBytesBuffer, bytes, len) == false) {
+        // message is dropped at its final fragment, see Payload::decode
+        vxlog_error("[WSServerConnection::receivedBytes] can't allocate receive buffer");
     }
     
     if (isFinalFragment) {
         // notify delegate
         std::shared_ptr<ConnectionDelegate> delegate = getDelegate().lock();
         if (delegate != nullptr) {
-            char *bytes = reinterpret_cast<char*>(malloc(_receivedBytesBuffer.size()));
-            if (bytes != nullptr) {
-                memcpy(bytes, _receivedBytesBuffer.c_str(), _receivedBytesBuffer.size());
-                Payload_SharedPtr pld = Payload::decode(bytes, _receivedBytesBuffer.size());
-                
+            Payload_SharedPtr pld = Payload::decode(_receivedBytesBuffer);
+            if (pld != nullptr) {
                 pld->step("WSServerConnection::receivedBytes");
                 
                 delegate->connectionDidReceive(*this, pld);
             } else {
-                vxlog_error("[WSConnection::receivedBytes] dropped bytes");
+                vxlog_error("[WSServerConnection::receivedBytes] dropped bytes");
             }
         }
-        _receivedBytesBuffer.clear();
+        // no-op if buffer has been adopted by Payload
+        BufferPool::shared()->release(_receivedBytesBuffer);
     }
 }
 
@@ -262,7 +262,8 @@ TrackingClient::TrackingClient(const std::string& host,
 
     // default queue used by tracking client
     // this could become configurable.
-    _operationQueue = OperationQueue::getBackground();
+    // events & session state are handled one at a time, in order
+    _operationQueue = OperationQueue::getSerialBackground();
     _operationQueue->schedule([](){
         TrackingClient::shared()._sendKeepAliveEventIfNeeded();
     }, KEEP_ALIVE_DELAY);
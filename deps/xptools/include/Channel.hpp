@@ -8,8 +8,13 @@
 #pragma once
 
 // C++
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace vx {
 
@@ -28,9 +33,12 @@ public:
     ///
     void pushMove(T&& msg);
 
-    /// Returns true when a message has been popped
+    /// Returns true when a message has been popped (moved into msgRef)
     bool pop(T& msgRef);
     
+    /// Moves all pending messages at the end of msgs, returns the number of messages popped
+    size_t popAll(std::vector<T>& msgs);
+    
     void clear();
     
 private:
@@ -40,6 +48,75 @@ private:
     
 };
 
+/// Lock-free ring buffer channel, for use sites with a single consumer thread.
+/// Producers write in a fixed-size ring without locking. When the ring is full, messages
+/// go to a mutex-guarded overflow queue, so pushes never fail or block, and each
+/// producer's messages are still popped in the order they were pushed.
+/// pop, popAll & clear must only be called from the consumer thread.
+/// pop can return false while a producer is in the middle of a push; the message is
+/// available on the next call.
+/// Use SPSCChannel or MPSCChannel aliases below.
+template <typename T, bool MultiProducer>
+class RingChannel final {
+
+public:
+    
+    /// capacity is rounded up to a power of 2
+    explicit RingChannel(size_t capacity = 1024);
+    ~RingChannel();
+    
+    ///
+    void push(T msg);
+    
+    ///
+    void pushMove(T&& msg);
+    
+    /// Returns true when a message has been popped (moved into msgRef)
+    bool pop(T& msgRef);
+    
+    /// Moves all pending messages at the end of msgs, returns the number of messages popped
+    size_t popAll(std::vector<T>& msgs);
+    
+    void clear();
+    
+private:
+    
+    /// sequence == position: cell is free for the producer writing at that position
+    /// sequence == position + 1: cell holds a message for the consumer
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T msg;
+    };
+    
+    /// Returns false if the ring is full, msg isn't moved in that case
+    bool _tryPushRing(T& msg);
+    
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask;
+    char _pad1[64];
+    
+    /// written by producers
+    std::atomic<size_t> _enqueuePos;
+    char _pad2[64];
+    
+    /// consumer only
+    size_t _dequeuePos;
+    char _pad3[64];
+    
+    /// messages pushed while the ring was full
+    std::atomic<size_t> _overflowSize;
+    std::mutex _overflowMutex;
+    std::deque<T> _overflow;
+};
+
+/// Single producer, single consumer
+template <typename T>
+using SPSCChannel = RingChannel<T, false>;
+
+/// Multiple producers, single consumer
+template <typename T>
+using MPSCChannel = RingChannel<T, true>;
+
 // Full definition must be available here for template classes
 
 template <typename T>
@@ -66,11 +143,22 @@ template <typename T>
 bool Channel<T>::pop(T& msgRef) {
     const std::lock_guard<std::mutex> locker(_mutex);
     if (_queue.empty()) { return false; }
-    msgRef = _queue.front();
+    msgRef = std::move(_queue.front());
     _queue.pop();
     return true;
 }
 
+template <typename T>
+size_t Channel<T>::popAll(std::vector<T>& msgs) {
+    const std::lock_guard<std::mutex> locker(_mutex);
+    const size_t n = _queue.size();
+    while (_queue.empty() == false) {
+        msgs.push_back(std::move(_queue.front()));
+        _queue.pop();
+    }
+    return n;
+}
+
 template <typename T>
 void Channel<T>::clear() {
     const std::lock_guard<std::mutex> locker(_mutex);
@@ -78,5 +166,115 @@ void Channel<T>::clear() {
     std::swap( _queue, empty );
 }
 
+template <typename T, bool MultiProducer>
+RingChannel<T, MultiProducer>::RingChannel(size_t capacity) :
+_cells(),
+_mask(0),
+_enqueuePos(0),
+_dequeuePos(0),
+_overflowSize(0),
+_overflowMutex(),
+_overflow() {
+    size_t size = 2;
+    while (size < capacity) { size *= 2; }
+    _cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _mask = size - 1;
+}
+
+template <typename T, bool MultiProducer>
+RingChannel<T, MultiProducer>::~RingChannel() {}
+
+template <typename T, bool MultiProducer>
+bool RingChannel<T, MultiProducer>::_tryPushRing(T& msg) {
+    size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell = &_cells[pos & _mask];
+        const size_t seq = cell->sequence.load(std::memory_order_acquire);
+        if (seq == pos) {
+            if (MultiProducer == false) {
+                _enqueuePos.store(pos + 1, std::memory_order_relaxed);
+                break;
+            } else if (_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                                         std::memory_order_relaxed)) {
+                break;
+            }
+            // pos updated by failed exchange, try again
+        } else if (seq < pos) {
+            // cell not consumed yet since previous lap: ring is full
+            return false;
+        } else {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->msg = std::move(msg);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, bool MultiProducer>
+void RingChannel<T, MultiProducer>::push(T msg) {
+    pushMove(std::move(msg));
+}
+
+template <typename T, bool MultiProducer>
+void RingChannel<T, MultiProducer>::pushMove(T&& msg) {
+    // once messages overflowed, keep pushing there until the consumer drained them,
+    // otherwise this producer's next messages could be popped before previous ones
+    if (_overflowSize.load(std::memory_order_acquire) == 0 && _tryPushRing(msg)) {
+        return;
+    }
+    const std::lock_guard<std::mutex> locker(_overflowMutex);
+    _overflow.push_back(std::move(msg));
+    _overflowSize.fetch_add(1, std::memory_order_release);
+}
+
+template <typename T, bool MultiProducer>
+bool RingChannel<T, MultiProducer>::pop(T& msgRef) {
+    Cell& cell = _cells[_dequeuePos & _mask];
+    if (cell.sequence.load(std::memory_order_acquire) == _dequeuePos + 1) {
+        msgRef = std::move(cell.msg);
+        cell.msg = T();
+        cell.sequence.store(_dequeuePos + _mask + 1, std::memory_order_release);
+        ++_dequeuePos;
+        return true;
+    }
+    
+    if (_overflowSize.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    
+    const std::lock_guard<std::mutex> locker(_overflowMutex);
+    // overflowed messages can only be popped once the ring is empty, including cells
+    // claimed by producers but not written yet (they were pushed before the overflow)
+    if (_enqueuePos.load(std::memory_order_acquire) != _dequeuePos || _overflow.empty()) {
+        return false;
+    }
+    msgRef = std::move(_overflow.front());
+    _overflow.pop_front();
+    _overflowSize.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, bool MultiProducer>
+size_t RingChannel<T, MultiProducer>::popAll(std::vector<T>& msgs) {
+    size_t n = 0;
+    T msg;
+    while (pop(msg)) {
+        msgs.push_back(std::move(msg));
+        ++n;
+    }
+    return n;
+}
+
+template <typename T, bool MultiProducer>
+void RingChannel<T, MultiProducer>::clear() {
+    T msg;
+    while (pop(msg)) {}
+}
+
 
 } // namespace vx
@@ -8,6 +8,7 @@
 #pragma once
 
 // C++
+#include <atomic>
 #include <string>
 #include <memory>
 #include <vector>
@@ -21,6 +22,50 @@ namespace vx {
 // client game <> WSConnection(lws/emscripten) <> [web] <> WSConnection(lws) <> game server
 // client game <> LocalConnection <> LocalConnection <> game server
 
+/// Pool of byte buffers used to assemble received messages.
+/// A Payload decoded from a pooled buffer adopts it (no copy) and gives it back
+/// to the pool when destroyed, so receiving large messages doesn't allocate once warm.
+/// Small messages are copied out instead (see Payload::decode): buffers hold at least
+/// 4 KB, so messages up to 1 KB are always copied.
+/// Thread safe: buffers are acquired on network threads and released wherever
+/// the last reference to the Payload goes away.
+class BufferPool final {
+public:
+    
+    ///
+    typedef struct Buffer {
+        char *bytes;
+        size_t size;
+        size_t capacity;
+        /// set when an append failed, the buffer then misses bytes until released
+        bool failed;
+    } Buffer;
+    
+    /// Never destroyed, Payloads can be released at any time (even at exit)
+    static BufferPool *shared();
+    
+    /// Appends bytes to buffer, acquiring a pooled buffer if it's empty and
+    /// growing it if needed. Returns false if memory can't be allocated, or if
+    /// a previous append failed: buffer is then flagged failed until released.
+    bool append(Buffer& buffer, const char *bytes, size_t len);
+    
+    /// Gives buffer back to the pool (or frees it), buffer is reset.
+    void release(Buffer& buffer);
+    
+private:
+    
+    BufferPool();
+    
+    /// spin lock guarding _buffers, critical sections are a few instructions long
+    /// (a mutex costs more than the malloc it saves for small messages)
+    void _lock();
+    void _unlock();
+    
+    ///
+    std::vector<Buffer> _buffers;
+    std::atomic<bool> _buffersLocked;
+};
+
 class ConnectionDelegate;
 //typedef std::shared_ptr<ConnectionDelegate> ConnectionDelegate_SharedPtr;
 //typedef std::weak_ptr<ConnectionDelegate> ConnectionDelegate_WeakPtr;
@@ -65,6 +110,11 @@ public:
         // used to trigger a meant to fail write operation, in order to close the connection.
         static Payload_SharedPtr createDummy();
         static Payload_SharedPtr decode(char *bytes, size_t len);
+        // adopts pooled buffer's bytes (no copy), buffer is reset. Bytes filling at most
+        // 1/4 of the buffer capacity are copied into an exact allocation instead, and the
+        // buffer goes back to the pool right away: zero-copy only covers large payloads.
+        // Returns nullptr for a failed buffer
+        static Payload_SharedPtr decode(BufferPool::Buffer& buffer);
         static Payload_SharedPtr copy(const Payload_SharedPtr& p);
         
         ~Payload();
@@ -101,6 +151,9 @@ public:
         Payload(char* bytes, size_t len, uint8_t includes = Includes::None);
         Payload();
         
+        // Parses metadata from _decoded, sets _content & _len
+        void _decode(size_t len);
+        
         // Returns next Payload ID (thread safe)
         // Only used when including PayloadID
         static uint16_t _getNextID();
@@ -128,6 +181,10 @@ public:
         // be freed if not NULL instead of _content.
         char *_decoded;
         
+        // Capacity of _decoded when it comes from the BufferPool
+        // (given back to the pool instead of being freed), 0 otherwise.
+        size_t _decodedCapacity;
+        
         // Only used when including CreatedAt
         uint64_t _createdAt; // ms timestamp
         
@@ -8,7 +8,9 @@
 #pragma once
 
 // C++
+#include <condition_variable>
 #include <mutex>
+#include <queue>
 #include <thread>
 
 // vx
@@ -76,13 +78,17 @@ private:
     Status _status;
     std::mutex _statusMutex;
     
-    /// thread processing the received bytes
+    /// thread processing the received bytes, sleeps until bytes are pushed or the thread
+    /// is asked to exit (no polling, a push from the peer is delivered right away)
     std::thread _thread;
     bool _threadShouldExit;
-    std::mutex _threadShouldExitMutex;
     
     /// Bytes received from the other side.
-    Channel<Payload_SharedPtr> _receivedBytes;
+    /// Guarded by _receivedBytesMutex, which is also used for _threadShouldExit
+    /// so the receiving thread can't miss a wake-up.
+    std::queue<Payload_SharedPtr> _receivedBytes;
+    std::mutex _receivedBytesMutex;
+    std::condition_variable _receivedBytesCondition;
     
     /// Weak pointer to the "other side" of the connection stream.
     std::weak_ptr<LocalConnection> _peerConnection;
@@ -8,10 +8,16 @@
 #pragma once
 
 // C++
-#include <future>
-#include <queue>
-#include <map>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 // xptools
 #include "Macros.h"
@@ -37,6 +43,9 @@ public:
 
     ///
     typedef std::function<void(void)> fp_t;
+
+    /// Identifies a scheduled operation, 0 is never used
+    typedef uint64_t TimerID;
     
     ///
     static OperationQueue *getMain();
@@ -44,11 +53,17 @@ public:
     ///
     static OperationQueue *getServerMain();
     
-    ///
+    /// Background queue w/ one worker per core but one (up to 8). Operations run concurrently and
+    /// in no guaranteed order: each worker runs its own operations first, then steals the most
+    /// recently dispatched operations of the others. Use getSerialBackground for ordered work
     static OperationQueue *getBackground();
 
-    ///
+    /// Background queue for operations mostly waiting on disk or network, w/ 2 workers.
+    /// Same concurrency & ordering as getBackground
     static OperationQueue *getSlowBackground();
+
+    /// Background queue w/ a single worker, operations run one at a time in dispatch order
+    static OperationQueue *getSerialBackground();
     
     /// Destructor
     virtual ~OperationQueue();
@@ -59,19 +74,24 @@ public:
     /// dispatch and move
     void dispatch(fp_t&& op);
     
-    /// dispatch and copy, to be triggered in `ms` milliseconds
-    void schedule(const fp_t& op, uint64_t ms);
+    /// dispatch and copy, to be triggered in `ms` milliseconds,
+    /// operations due at the same time are triggered in scheduling order
+    TimerID schedule(const fp_t& op, uint64_t ms);
     
     /// dispatch and move, to be triggered in `ms` milliseconds
-    void schedule(const fp_t&& op, uint64_t ms);
+    TimerID schedule(fp_t&& op, uint64_t ms);
+
+    /// Cancels a scheduled operation, returns false if it was already triggered or cancelled
+    bool cancel(TimerID id);
     
-    /// dispatch (in front of queue) and copy
+    /// dispatch (in front of queue) and copy,
+    /// on async queues, these operations run before any other pending operation
     void dispatchFirst(const fp_t& op);
     
     /// dispatch (in front of queue) and move
     void dispatchFirst(fp_t&& op);
     
-    /// Calls n first blocks to dispatch
+    /// Calls n first blocks to dispatch, on sync queues only
     void callFirstDispatchedBlocks(size_t n);
     
             
@@ -94,34 +114,103 @@ private:
     ///
     static OperationQueue *_slowBackgroundQueue;
 
-    /// Constructor
-    OperationQueue(Type type);
+    ///
+    static OperationQueue *_serialBackgroundQueue;
+
+    /// A worker thread of an async queue, w/ its own tasks queue.
+    /// A worker pops tasks from the front of its queue, and steals from the back
+    /// of other workers queues when its own is empty.
+    struct Worker {
+        std::deque<fp_t> queue;
+        std::mutex lock;
+        std::thread thread;
+    };
+
+    /// Constructor, async queues run their tasks on `nbWorkers` threads
+    OperationQueue(Type type, size_t nbWorkers = 1);
     
-    /// tasks queue
+    /// tasks queue, for async queues: priority tasks, see dispatchFirst
     std::deque<fp_t> _queue;
     
-    /// scheduled tasks queue
-    std::map<uint64_t,fp_t> _queueScheduled;
+    /// A scheduled task, due on the monotonic clock
+    struct Timer {
+        std::chrono::steady_clock::time_point due;
+        TimerID id;
+        fp_t op;
+    };
+
+    /// scheduled tasks, min-heap ordered by due time then by ID
+    std::vector<Timer> _timers;
+
+    /// scheduled tasks not triggered nor cancelled yet, a cancelled task stays
+    /// in the heap until it is popped, or until the heap is compacted
+    std::unordered_set<TimerID> _activeTimers;
+
+    ///
+    TimerID _nextTimerID;
     
     /// mutex for tasks queue
     std::mutex _lock;
     
+    /// async queue workers, started on first dispatch
+    std::unique_ptr<Worker[]> _workers;
+
     ///
-    std::thread _thread;
+    size_t _nbWorkers;
+
+    /// next worker to receive a task dispatched from outside of the workers
+    std::atomic<size_t> _nextWorker;
+
+    /// tasks in workers & priority queues, not yet popped
+    std::atomic<size_t> _nbPending;
+
+    /// idle workers wait on this condition, protected by _wakeLock
+    std::condition_variable _wakeCondition;
+
+    /// must be locked before _lock if both are needed
+    std::mutex _wakeLock;
+
+    ///
+    size_t _nbSleeping;
+
+    ///
+    bool _stopping;
     
     /// queue type
     Type _type;
     
     /// Indicates the current state of the queue.
     /// This is used for managing the background thread
-    /// of certain queues.
-    State _state;
+    /// of certain queues, set once workers are started.
+    std::atomic<State> _state;
     
     ///
     void startThreadIfNeeded();
+
+    /// adds a task to the calling worker queue, or to the next worker queue
+    void pushOperation(fp_t&& op);
+
+    /// adds a task to the priority queue
+    void pushPriorityOperation(fp_t&& op);
+
+    /// wakes up one idle worker if any
+    void wakeWorker();
+
+    /// adds a scheduled task, _lock must be locked
+    TimerID pushTimer(fp_t&& op, uint64_t ms);
+
+    /// pops a task due at given time, _lock must be locked
+    bool popDueTimer(std::chrono::steady_clock::time_point now, fp_t& op);
+
+    /// gets the earliest due time, cancelled tasks on top are dropped, _lock must be locked
+    bool getNextTimerDue(std::chrono::steady_clock::time_point& due);
+
+    /// pops a due scheduled task, a priority task, a task from the worker queue,
+    /// or a task stolen from another worker, in that order
+    bool popOperation(size_t worker, fp_t& op);
     
     ///
-    void threadFunction();
+    void threadFunction(size_t worker);
     
 };
 
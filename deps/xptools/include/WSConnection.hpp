@@ -133,8 +133,8 @@ private:
     ///
     std::mutex _wsiMutex;
     
-    /// buffer for received bytes
-    std::string _receivedBytesBuffer;
+    /// buffer for received bytes (from BufferPool)
+    BufferPool::Buffer _receivedBytesBuffer;
     
     /// `true` means "not currently writing
     bool _isWriting;
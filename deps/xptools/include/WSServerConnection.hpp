@@ -94,8 +94,8 @@ private:
     ///
     WSServer* _server;
     
-    ///
-    Channel<Connection::Payload_SharedPtr> _payloadsToWrite;
+    /// popped by the server's LWS thread only
+    MPSCChannel<Connection::Payload_SharedPtr> _payloadsToWrite;
     
     ///
     Connection::Payload_SharedPtr _payloadBeingWritten;
@@ -104,8 +104,8 @@ private:
     Status _status;
     std::mutex _statusMutex;
     
-    /// buffer for received bytes
-    std::string _receivedBytesBuffer;
+    /// buffer for received bytes (from BufferPool)
+    BufferPool::Buffer _receivedBytesBuffer;
     
     /// `true` means currently writing
     bool _isWriting;
@@ -95,11 +95,11 @@ private:
     ///
     std::vector<lws_token_indexes> _headersToParse;
 
-    /// requests waiting to be sent
-    Channel<HttpRequest_SharedPtr> _httpRequestWaitingQueue;
+    /// requests waiting to be sent (popped by service thread only)
+    MPSCChannel<HttpRequest_SharedPtr> _httpRequestWaitingQueue;
 
-    /// WSConnections requests waiting to be sent
-    Channel<WSConnection_SharedPtr> _wsConnectionWaitingQueue;
+    /// WSConnections requests waiting to be sent (popped by service thread only)
+    MPSCChannel<WSConnection_SharedPtr> _wsConnectionWaitingQueue;
     
     /// WSConnections currently active
     std::vector<WSConnection_WeakPtr> _wsConnectionsActive;